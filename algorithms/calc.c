@@ -107,6 +107,10 @@ extern unsigned calc_flp2        (unsigned);
 extern unsigned calc_popcount_u16(uint16_t);
 extern unsigned calc_popcount_u32(uint32_t);
 extern unsigned calc_popcount_u64(uint64_t);
+extern unsigned calc_ctz_u32     (uint32_t);
+extern unsigned calc_ctz_u64     (uint64_t);
+extern unsigned calc_clz_u32     (uint32_t);
+extern unsigned calc_clz_u64     (uint64_t);
 
 
 // ----------------------------------------------------------------------------------------------- //
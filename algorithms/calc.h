@@ -25,6 +25,8 @@
  * 				calc_clp2(x)          Returns the ceiling power of 2 of x.
  * 				calc_flp2(x)          Returns the floor power of 2 of x.
  * 				calc_popcount(x)      Returns the number of bits set in x.
+ * 				calc_ctz(x)           Returns the number of trailing zero bits in x.
+ * 				calc_clz(x)           Returns the number of leading zero bits in x.
  * 				calc_round(x,n)       Rounds x to the nearest multiple of n.
  * 				calc_mod(a,b)         Calculates a mod b: calc_mod(-1, 360) = 359
  * 				calc_submod(a,b,m)    Calculates (a-b) mod m.
@@ -442,7 +444,9 @@ inline unsigned calc_flp2(unsigned x)
 
 
 /* calc_popcount ********************************************************************************//**
- * @brief		Returns the number of bits set to 1 in the variable. */
+ * @brief		Returns the number of bits set to 1 in the variable. The compiler builtin is only used
+ *				when the target has a popcount instruction. Otherwise GCC calls a libgcc routine which
+ *				is slower than the portable versions below. */
 #define calc_popcount(x) _Generic((x), \
 	int8_t:   calc_popcount_u16(x), \
 	int16_t:  calc_popcount_u16(x), \
@@ -455,6 +459,9 @@ inline unsigned calc_flp2(unsigned x)
 
 inline unsigned calc_popcount_u16(uint16_t x)
 {
+	#if defined(__GNUC__) && defined(__POPCNT__)
+	return (unsigned)__builtin_popcount(x);
+	#else
 	/* Count in parallel */
 	// x = ((x >> 1)  & 0x5555) + (x & 0x5555);
 	// x = ((x >> 2)  & 0x3333) + (x & 0x3333);
@@ -471,10 +478,14 @@ inline unsigned calc_popcount_u16(uint16_t x)
 	}
 
 	return count;
+	#endif
 }
 
 inline unsigned calc_popcount_u32(uint32_t x)
 {
+	#if defined(__GNUC__) && defined(__POPCNT__)
+	return (unsigned)__builtin_popcount(x);
+	#else
 	/* Count in parallel */
 	// x = ((x >> 1)  & 0x55555555) + (x & 0x55555555);
 	// x = ((x >> 2)  & 0x33333333) + (x & 0x33333333);
@@ -492,10 +503,14 @@ inline unsigned calc_popcount_u32(uint32_t x)
 	}
 
 	return count;
+	#endif
 }
 
 inline unsigned calc_popcount_u64(uint64_t x)
 {
+	#if defined(__GNUC__) && defined(__POPCNT__)
+	return (unsigned)__builtin_popcountll(x);
+	#else
 	/* Count in parallel */
 	x = ((x >> 1)  & 0x5555555555555555) + (x & 0x5555555555555555);
 	x = ((x >> 2)  & 0x3333333333333333) + (x & 0x3333333333333333);
@@ -514,6 +529,70 @@ inline unsigned calc_popcount_u64(uint64_t x)
 	// }
 
 	// return count;
+	#endif
+}
+
+
+/* calc_ctz *************************************************************************************//**
+ * @brief		Returns the number of trailing zero bits in x, which is the index of the lowest set
+ *				bit. Returns the width of x if x is 0. */
+#define calc_ctz(x) _Generic((x), \
+	uint32_t: calc_ctz_u32(x), \
+	uint64_t: calc_ctz_u64(x))
+
+inline unsigned calc_ctz_u32(uint32_t x)
+{
+	#if defined(__GNUC__)
+	return x ? (unsigned)__builtin_ctz(x) : 32;
+	#else
+	return x ? calc_popcount_u32((x & -x) - 1) : 32;
+	#endif
+}
+
+inline unsigned calc_ctz_u64(uint64_t x)
+{
+	#if defined(__GNUC__)
+	return x ? (unsigned)__builtin_ctzll(x) : 64;
+	#else
+	return x ? calc_popcount_u64((x & -x) - 1) : 64;
+	#endif
+}
+
+
+/* calc_clz *************************************************************************************//**
+ * @brief		Returns the number of leading zero bits in x, which is the width of x minus one minus
+ *				the index of the highest set bit. Returns the width of x if x is 0. */
+#define calc_clz(x) _Generic((x), \
+	uint32_t: calc_clz_u32(x), \
+	uint64_t: calc_clz_u64(x))
+
+inline unsigned calc_clz_u32(uint32_t x)
+{
+	#if defined(__GNUC__)
+	return x ? (unsigned)__builtin_clz(x) : 32;
+	#else
+	x |= x >> 1;
+	x |= x >> 2;
+	x |= x >> 4;
+	x |= x >> 8;
+	x |= x >> 16;
+	return 32 - calc_popcount_u32(x);
+	#endif
+}
+
+inline unsigned calc_clz_u64(uint64_t x)
+{
+	#if defined(__GNUC__)
+	return x ? (unsigned)__builtin_clzll(x) : 64;
+	#else
+	x |= x >> 1;
+	x |= x >> 2;
+	x |= x >> 4;
+	x |= x >> 8;
+	x |= x >> 16;
+	x |= x >> 32;
+	return 64 - calc_popcount_u64(x);
+	#endif
 }
 
 
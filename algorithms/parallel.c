@@ -0,0 +1,293 @@
+/************************************************************************************************//**
+ * @file		parallel.c
+ *
+ * @copyright	Copyright 2022 Kurt Hildebrand.
+ * @license		Licensed under the Apache License, Version 2.0 (the "License"); you may not use this
+ *				file except in compliance with the License. You may obtain a copy of the License at
+ *
+ *				http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *				Unless required by applicable law or agreed to in writing, software distributed under
+ *				the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF
+ *				ANY KIND, either express or implied. See the License for the specific language
+ *				governing permissions and limitations under the License.
+ *
+ ***************************************************************************************************/
+#include <stdint.h>
+#include <string.h>
+
+#include "parallel.h"
+#include "utils.h"
+
+#if !defined(__STDC_NO_THREADS__)
+#include "scheduler.h"
+#endif
+
+
+/* Private Macros -------------------------------------------------------------------------------- */
+#define PARALLEL_ACC_STRIDE	\
+	((RANGE_PARALLEL_ACC_SIZE + CACHE_LINE_SIZE - 1) / CACHE_LINE_SIZE * CACHE_LINE_SIZE)
+
+
+/* Private Types --------------------------------------------------------------------------------- */
+typedef struct {
+	const Range* range;
+	unsigned     chunk;		/* Number of elements per chunk */
+	void       (*fn)(void*, unsigned, const Range*);
+	void*        ctx;
+} ParallelJob;
+
+
+typedef struct {
+	RangeChunkFn fn;
+	void*        arg;
+} ParallelFor;
+
+
+typedef struct {
+	const Range*     in;
+	Range*           out;
+	RangeTransformFn fn;
+	void*            arg;
+} ParallelTransform;
+
+
+typedef struct {
+	RangeReduceFn fn;
+	void*         arg;
+	unsigned      accsize;
+
+	/* Each partial starts on its own cache line so accumulators of any type are aligned and
+	 * workers do not share lines */
+	_Alignas(CACHE_LINE_SIZE) uint8_t partials[RANGE_PARALLEL_CHUNKS][PARALLEL_ACC_STRIDE];
+} ParallelReduce;
+
+
+/* Private Functions ----------------------------------------------------------------------------- */
+static unsigned parallel_run      (Scheduler*, const Range*, void (*)(void*, unsigned, const Range*),
+                                   void*);
+static void     parallel_chunks   (void*, unsigned, unsigned);
+static void     parallel_for_chunk(void*, unsigned, const Range*);
+static void     parallel_transform(void*, unsigned, const Range*);
+static void     parallel_reduce   (void*, unsigned, const Range*);
+
+
+/* range_parallel_chunk *************************************************************************//**
+ * @brief		Returns the number of elements per chunk used to split the range. */
+unsigned range_parallel_chunk(const Range* r)
+{
+	unsigned count    = range_count(r);
+	unsigned elemsize = range_elemsize(r);
+	unsigned chunk;
+	unsigned a;
+	unsigned b;
+
+	if(count == 0 || elemsize == 0 || count * elemsize < RANGE_PARALLEL_SERIAL)
+	{
+		return count;
+	}
+
+	/* Round up to the smallest number of elements which spans a whole number of cache lines */
+	for(a = elemsize, b = CACHE_LINE_SIZE; b; )
+	{
+		unsigned t = a % b;
+
+		a = b;
+		b = t;
+	}
+
+	unsigned align = CACHE_LINE_SIZE / a;
+
+	chunk = (count + RANGE_PARALLEL_CHUNKS - 1) / RANGE_PARALLEL_CHUNKS;
+	chunk = (chunk + align - 1) / align * align;
+
+	return chunk;
+}
+
+
+/* range_parallel_for ***************************************************************************//**
+ * @brief		Calls fn(arg, chunk) for each chunk of the range.
+ * @param[in]	s: the scheduler to run on. Null to run on the calling thread.
+ * @param[in]	r: the range to process.
+ * @param[in]	fn: function called with each chunk, a slice of r.
+ * @param[in]	arg: argument passed to fn. */
+void range_parallel_for(Scheduler* s, const Range* r, RangeChunkFn fn, void* arg)
+{
+	ParallelFor job = { .fn = fn, .arg = arg };
+
+	parallel_run(s, r, parallel_for_chunk, &job);
+}
+
+
+/* range_parallel_transform *********************************************************************//**
+ * @brief		Calls fn(arg, out[i], in[i]) for each element of the input range. out may be the same
+ *				range as in.
+ * @param[in]	s: the scheduler to run on. Null to run on the calling thread.
+ * @param[out]	out: the output range. Must have as many elements as in.
+ * @param[in]	in: the input range.
+ * @param[in]	fn: function which computes one output element from one input element.
+ * @param[in]	arg: argument passed to fn.
+ * @retval		false if the ranges have different lengths. */
+bool range_parallel_transform(
+	Scheduler* s, Range* out, const Range* in, RangeTransformFn fn, void* arg)
+{
+	ParallelTransform job = { .in = in, .out = out, .fn = fn, .arg = arg };
+
+	if(range_count(out) != range_count(in))
+	{
+		return false;
+	}
+
+	parallel_run(s, in, parallel_transform, &job);
+	return true;
+}
+
+
+/* range_parallel_reduce ************************************************************************//**
+ * @brief		Reduces a range to a single value. Each chunk is folded into a copy of the initial
+ *				accumulator with fn(arg, acc, elem). The partial results are then combined into acc
+ *				in chunk order with combine(arg, acc, partial).
+ * @param[in]	s: the scheduler to run on. Null to run on the calling thread.
+ * @param[in]	r: the range to reduce.
+ * @param[in]	acc: holds the identity value of the reduction on entry and the result on exit.
+ * @param[in]	accsize: the size in bytes of acc. At most RANGE_PARALLEL_ACC_SIZE.
+ * @param[in]	fn: function which folds one element into an accumulator.
+ * @param[in]	combine: function which combines a partial result into an accumulator.
+ * @param[in]	arg: argument passed to fn and combine.
+ * @retval		false if accsize is too large. */
+bool range_parallel_reduce(
+	Scheduler* s, const Range* r, void* acc, unsigned accsize, RangeReduceFn fn,
+	RangeCombineFn combine, void* arg)
+{
+	ParallelReduce job;
+	unsigned       chunks;
+	unsigned       i;
+
+	if(accsize > RANGE_PARALLEL_ACC_SIZE)
+	{
+		return false;
+	}
+
+	job.fn      = fn;
+	job.arg     = arg;
+	job.accsize = accsize;
+
+	for(i = 0; i < RANGE_PARALLEL_CHUNKS; i++)
+	{
+		memcpy(job.partials[i], acc, accsize);
+	}
+
+	chunks = parallel_run(s, r, parallel_reduce, &job);
+
+	for(i = 0; i < chunks; i++)
+	{
+		combine(arg, acc, job.partials[i]);
+	}
+
+	return true;
+}
+
+
+/* parallel_run *********************************************************************************//**
+ * @brief		Calls fn(ctx, i, chunk) for each chunk of the range, on the scheduler if there is more
+ *				than one chunk. Returns the number of chunks. */
+static unsigned parallel_run(
+	Scheduler* s, const Range* r, void (*fn)(void*, unsigned, const Range*), void* ctx)
+{
+	ParallelJob job = {
+		.range = r,
+		.chunk = range_parallel_chunk(r),
+		.fn    = fn,
+		.ctx   = ctx,
+	};
+
+	if(job.chunk == 0)
+	{
+		return 0;
+	}
+
+	unsigned chunks = (range_count(r) + job.chunk - 1) / job.chunk;
+
+	#if !defined(__STDC_NO_THREADS__)
+	if(s && chunks > 1)
+	{
+		scheduler_parallel_for(s, 0, chunks, 1, parallel_chunks, &job);
+		return chunks;
+	}
+	#else
+	(void)s;
+	#endif
+
+	parallel_chunks(&job, 0, chunks);
+	return chunks;
+}
+
+
+/* parallel_chunks ******************************************************************************//**
+ * @brief		Processes the chunks [begin, end) of a job. */
+static void parallel_chunks(void* arg, unsigned begin, unsigned end)
+{
+	ParallelJob* job = arg;
+	unsigned     i;
+
+	for(i = begin; i < end; i++)
+	{
+		unsigned first = range_start(job->range) + i * job->chunk;
+		unsigned last  = first + job->chunk;
+
+		if(last > range_end(job->range))
+		{
+			last = range_end(job->range);
+		}
+
+		Range chunk = make_range_slice(job->range, first, last);
+
+		job->fn(job->ctx, i, &chunk);
+	}
+}
+
+
+/* parallel_for_chunk ***************************************************************************//**
+ * @brief		Chunk body of range_parallel_for. */
+static void parallel_for_chunk(void* ctx, unsigned idx, const Range* chunk)
+{
+	ParallelFor* job = ctx;
+
+	(void)idx;
+	job->fn(job->arg, chunk);
+}
+
+
+/* parallel_transform ***************************************************************************//**
+ * @brief		Chunk body of range_parallel_transform. */
+static void parallel_transform(void* ctx, unsigned idx, const Range* chunk)
+{
+	ParallelTransform* job = ctx;
+	unsigned           i;
+
+	(void)idx;
+
+	for(i = range_start(chunk); i < range_end(chunk); i++)
+	{
+		unsigned offset = i - range_start(job->in);
+
+		job->fn(job->arg, range_offset(job->out, offset), range_at(chunk, i));
+	}
+}
+
+
+/* parallel_reduce ******************************************************************************//**
+ * @brief		Chunk body of range_parallel_reduce. Folds the chunk into its partial result. */
+static void parallel_reduce(void* ctx, unsigned idx, const Range* chunk)
+{
+	ParallelReduce* job = ctx;
+	unsigned        i;
+
+	for(i = range_start(chunk); i < range_end(chunk); i++)
+	{
+		job->fn(job->arg, job->partials[idx], range_at(chunk, i));
+	}
+}
+
+
+/******************************************* END OF FILE *******************************************/
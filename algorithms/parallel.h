@@ -0,0 +1,82 @@
+/************************************************************************************************//**
+ * @file		parallel.h
+ *
+ * @copyright	Copyright 2022 Kurt Hildebrand.
+ * @license		Licensed under the Apache License, Version 2.0 (the "License"); you may not use this
+ *				file except in compliance with the License. You may obtain a copy of the License at
+ *
+ *				http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *				Unless required by applicable law or agreed to in writing, software distributed under
+ *				the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF
+ *				ANY KIND, either express or implied. See the License for the specific language
+ *				governing permissions and limitations under the License.
+ *
+ * @brief		Algorithms which split a Range into chunks and process the chunks on a Scheduler.
+ *
+ *				Chunks are a multiple of CACHE_LINE_SIZE bytes long where the element size allows it,
+ *				so threads do not write to the same cache line of an aligned range. The chunking only
+ *				depends on the length of the range and its element size, never on the number of
+ *				workers, and range_parallel_reduce combines the partial results in chunk order. Runs
+ *				with any number of workers, or with no scheduler, give identical results, even for
+ *				operations such as floating point addition which are not associative.
+ *
+ *				Ranges smaller than RANGE_PARALLEL_SERIAL bytes are processed as one chunk on the
+ *				calling thread. A null scheduler processes every chunk on the calling thread.
+ *
+ ***************************************************************************************************/
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#if __STDC_VERSION__ < 199901L
+#error Compile with C99 or higher for inline support.
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/* Includes -------------------------------------------------------------------------------------- */
+#include <stdbool.h>
+
+#include "range.h"
+
+
+/* Public Macros --------------------------------------------------------------------------------- */
+#ifndef RANGE_PARALLEL_SERIAL
+#define RANGE_PARALLEL_SERIAL		(16384u)	/* Ranges with fewer bytes are not split */
+#endif
+
+#ifndef RANGE_PARALLEL_CHUNKS
+#define RANGE_PARALLEL_CHUNKS		(64u)		/* Maximum number of chunks */
+#endif
+
+#ifndef RANGE_PARALLEL_ACC_SIZE
+#define RANGE_PARALLEL_ACC_SIZE		(64u)		/* Maximum reduction accumulator bytes */
+#endif
+
+
+/* Public Types ---------------------------------------------------------------------------------- */
+typedef struct Scheduler Scheduler;
+
+typedef void (*RangeChunkFn)    (void* arg, const Range* chunk);
+typedef void (*RangeTransformFn)(void* arg, void* out, const void* in);
+typedef void (*RangeReduceFn)   (void* arg, void* acc, const void* elem);
+typedef void (*RangeCombineFn)  (void* arg, void* acc, const void* partial);
+
+
+/* Public Functions ------------------------------------------------------------------------------ */
+unsigned range_parallel_chunk    (const Range*);
+void     range_parallel_for      (Scheduler*, const Range*, RangeChunkFn, void*);
+bool     range_parallel_transform(Scheduler*, Range*, const Range*, RangeTransformFn, void*);
+bool     range_parallel_reduce   (Scheduler*, const Range*, void*, unsigned, RangeReduceFn,
+                                  RangeCombineFn, void*);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // PARALLEL_H
+/******************************************* END OF FILE *******************************************/
@@ -113,6 +113,32 @@ void* ipv6_init(IPPacket* pkt, void* data, unsigned count, unsigned size)
 }
 
 
+/* ipv6_alloc ***********************************************************************************//**
+ * @brief		Initializes an empty packet over a buffer allocated from a packet pool. The pool's
+ *				headroom stays in front of the packet so lower layers can prepend their headers with
+ *				pkt_prepend.
+ * @retval		false if the pool is empty. */
+bool ipv6_alloc(IPPacket* pkt, PacketPool* pool)
+{
+	if(!pkt_alloc(pool, &pkt->buffer))
+	{
+		return false;
+	}
+
+	memset(pkt->fragments, 0, sizeof(pkt->fragments));
+	return true;
+}
+
+
+/* ipv6_free ************************************************************************************//**
+ * @brief		Drops the packet's reference to its pool buffer. See pkt_free.
+ * @retval		true if the buffer was returned to the pool. */
+bool ipv6_free(IPPacket* pkt, PacketPool* pool)
+{
+	return pkt_free(pool, &pkt->buffer);
+}
+
+
 /* ipv6_set_length ******************************************************************************//**
  * @brief		Initializes the length of the packet and returns a pointer to the start of the
  * 				packet's buffer. Call ipv6_parse  after copying data into the reserved bytes. */
@@ -189,6 +215,30 @@ uint16_t ipv6_checksum(const void* data, unsigned len, uint16_t sum)
 }
 
 
+/* ipv6_checksum_chain **************************************************************************//**
+ * @brief		Computes the IPv6 checksum on the data in a buffer chain. Segments may have odd
+ *				lengths. A segment starting at an odd offset is summed on its own and byte swapped,
+ *				which gives the same one's complement sum as summing the data contiguously. */
+uint16_t ipv6_checksum_chain(const BufferChain* c, uint16_t sum)
+{
+	unsigned i;
+	bool     odd = false;
+
+	for(i = 0; i < bufferchain_count(c); i++)
+	{
+		const Buffer* b = bufferchain_segment(c, i);
+		uint16_t temp   = ipv6_checksum(buffer_read(b), buffer_remaining(b), 0);
+
+		temp = odd ? (uint16_t)((temp << 8) | (temp >> 8)) : temp;
+		sum += temp;
+		sum += sum < temp;	/* 1's complement addition: add 1 if carry occurs */
+		odd ^= buffer_remaining(b) & 1;
+	}
+
+	return sum;
+}
+
+
 /* ipv6_ptr_start *******************************************************************************//**
  * @brief		Returns a pointer to the start of the IPv6 packet's buffer. */
 void* ipv6_ptr_start(const IPPacket* packet)
@@ -77,8 +77,10 @@ extern "C" {
 #include <string.h>
 
 #include "buffer.h"
+#include "bufferchain.h"
 #include "key.h"
 #include "linked.h"
+#include "packetpool.h"
 
 
 /* Public Macros --------------------------------------------------------------------------------- */
@@ -342,6 +344,8 @@ bool        ipv6_addr_is_multicast (const IPAddress*);
 int         ipv6_addr_compare      (const void*, const void*);
 
 void*       ipv6_init              (IPPacket*, void*, unsigned, unsigned);
+bool        ipv6_alloc             (IPPacket*, PacketPool*);
+bool        ipv6_free              (IPPacket*, PacketPool*);
 void*       ipv6_set_length        (IPPacket*, unsigned);
 void        ipv6_parse             (IPPacket*);
 void        ipv6_clear             (IPPacket*);
@@ -349,6 +353,7 @@ void        ipv6_finalize          (IPPacket*);
 unsigned    ipv6_length            (const IPPacket*);
 unsigned    ipv6_size              (const IPPacket*);
 uint16_t    ipv6_checksum          (const void*, unsigned, uint16_t);
+uint16_t    ipv6_checksum_chain    (const BufferChain*, uint16_t);
 void*       ipv6_ptr_start         (const IPPacket*);
 
 uint8_t     ipv6_version           (const IPPacket*);
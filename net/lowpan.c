@@ -33,6 +33,7 @@ static uint8_t  lowpan_read_type    (const Buffer*, uint8_t*);
 static uint16_t lowpan_read_length  (const Buffer*, uint8_t*, uint8_t);
 
 static bool     lowpan_append_header(Lowpan*, uint8_t, const void*, unsigned);
+static bool     lowpan_push_payload (Lowpan*, IPPacket*, const BufferChain*, unsigned, unsigned);
 
 static uint16_t lowpan_iphc_type              (const Lowpan*);
 static bool     lowpan_is_iphc                (const Lowpan*);
@@ -237,12 +238,35 @@ bool lowpan_ctx_remove(Key id)
  *				Returns 0 if there was an error. */
 unsigned lowpan_compress(IPPacket* packet, Ieee154_Frame* frame)
 {
-	Bits frags = make_bits(&packet->fragments, (ipv6_length(packet) + 7) / 8);
+	return lowpan_compress_chain(packet, 0, frame);
+}
+
+
+/* lowpan_compress_chain ************************************************************************//**
+ * @brief		Compresses an IPv6 packet whose payload continues in a buffer chain. The packet's
+ *				buffer holds the IPv6 header and unfragmentable extension headers and may hold the
+ *				start of the payload. The rest of the payload is read from the chain without being
+ *				copied into the packet. The chain is not modified. See lowpan_compress.
+ * @warning		The IPv6 payload length field is not updated from the chain. It is elided by IPHC.
+ * @param[in]	packet: the packet's headers.
+ * @param[in]	payload: the rest of the packet. May be null.
+ * @param[in]	frame: the frame to compress into.
+ * @return		Returns the total number of IPv6 packet bytes that have been fragmented, counting
+ *				the packet's buffer and the chain. Returns 0 if there was an error. */
+unsigned lowpan_compress_chain(IPPacket* packet, const BufferChain* payload, Ieee154_Frame* frame)
+{
+	unsigned total = ipv6_length(packet) + (payload ? bufferchain_length(payload) : 0);
+	Bits     frags = make_bits(&packet->fragments, (total + 7) / 8);
+
+	if(total > sizeof(packet->fragments) * 64)
+	{
+		return 0;
+	}
 
 	/* Check if all fragments have been sent */
 	if(bits_next_zero(&frags, 0) >= bits_count(&frags))
 	{
-		return ipv6_length(packet);
+		return total;
 	}
 
 	Lowpan lowpan = lowpan_first(frame);
@@ -286,7 +310,7 @@ unsigned lowpan_compress(IPPacket* packet, Ieee154_Frame* frame)
 		/* Check if the packet must be fragmented. The packet must be fragmented if the remaining
 		 * length doesn't fit in the frame or if the packet has been partially sent (indicated by a 1
 		 * in the fragment bitmap beyond the unfragmentable extension headers). */
-		unsigned remaining = buffer_write(&packet->buffer) - buffer_start(&pkt_eh.buffer);
+		unsigned remaining = total - buffer_offsetof(&packet->buffer, buffer_start(&pkt_eh.buffer));
 
 		if(remaining > ieee154_free(frame) || bits_next_one(&frags, frag) < bits_end(&frags))
 		{
@@ -299,9 +323,9 @@ unsigned lowpan_compress(IPPacket* packet, Ieee154_Frame* frame)
 		/* Append as many contiguous, unsent fragments as possible to the frame */
 		while(frag < bits_count(&frags) && bits_value(&frags, frag) == 0)
 		{
-			unsigned length = calc_min_uint(8, ipv6_length(packet) - (frag * 8));
+			unsigned length = calc_min_uint(8, total - (frag * 8));
 
-			if(!buffer_push_mem(&lowpan.buffer, buffer_pop(&packet->buffer, length), length))
+			if(!lowpan_push_payload(&lowpan, packet, payload, frag * 8, length))
 			{
 				break;
 			}
@@ -309,7 +333,7 @@ unsigned lowpan_compress(IPPacket* packet, Ieee154_Frame* frame)
 			bits_set(&frags, frag++);
 		}
 
-		ipv6_frag_eh_finalize(&low_eh, ipv6_length(packet));
+		ipv6_frag_eh_finalize(&low_eh, total);
 	}
 
 	/* Compute the number of sent bytes */
@@ -332,13 +356,43 @@ unsigned lowpan_compress(IPPacket* packet, Ieee154_Frame* frame)
 		 * 		01234567 89012345 67890123 45678901
 		 * 		                              ^ 27 bytes long
 		 * 		1        1        1        1 fragment bit mask */
-		sent -= ((ipv6_length(packet) + 7) / 8) - (ipv6_length(packet) / 8);
+		sent -= ((total + 7) / 8) - (total / 8);
 	}
 
 	return sent;
 }
 
 
+/* lowpan_push_payload **************************************************************************//**
+ * @brief		Appends len bytes of the packet starting at offset to the lowpan buffer. Bytes past the
+ *				end of the packet's buffer are read from the payload chain.
+ * @warning		The packet's read pointer must be at offset if offset is within the packet's buffer. */
+static bool lowpan_push_payload(
+	Lowpan* lowpan, IPPacket* packet, const BufferChain* payload, unsigned offset, unsigned len)
+{
+	unsigned inline_len = ipv6_length(packet);
+	unsigned n          = offset < inline_len ? calc_min_uint(len, inline_len - offset) : 0;
+	uint8_t* dest;
+
+	if(n < len && (!payload || bufferchain_length(payload) < offset + len - inline_len))
+	{
+		return false;
+	}
+
+	if(!(dest = buffer_reserve(&lowpan->buffer, len)))
+	{
+		return false;
+	}
+
+	if(n)
+	{
+		memcpy(dest, buffer_pop(&packet->buffer, n), n);
+	}
+
+	return n == len || bufferchain_read_offset(payload, dest + n, offset + n - inline_len, len - n);
+}
+
+
 /* lowpan_decompress ****************************************************************************//**
  * @brief		Decompresses a lowpan frame to a full IPv6 packet. */
 unsigned lowpan_decompress(IPPacket* packet, Ieee154_Frame* frame)
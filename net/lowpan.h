@@ -633,6 +633,7 @@ extern "C" {
 /* Includes -------------------------------------------------------------------------------------- */
 #include <stdint.h>
 
+#include "bufferchain.h"
 #include "ieee_802_15_4.h"
 #include "ipv6.h"
 
@@ -966,6 +967,7 @@ bool             lowpan_ctx_remove     (Key);
 const IPAddress* lowpan_ctx_search_id  (Key);
 Key              lowpan_ctx_search_addr(const IPAddress*, unsigned, unsigned);
 unsigned         lowpan_compress       (IPPacket*, Ieee154_Frame*);
+unsigned         lowpan_compress_chain (IPPacket*, const BufferChain*, Ieee154_Frame*);
 unsigned         lowpan_decompress     (IPPacket*, Ieee154_Frame*);
 
 #ifdef __cplusplus
@@ -8,11 +8,17 @@
 #include "byteorder.h"
 
 #include "tharness.h"
+#include "test_arena.h"
 #include "test_array.h"
+#include "test_atomicbits.h"
 #include "test_bits.h"
 #include "test_buffer.h"
+#include "test_bufferchain.h"
+#include "test_bufferio.h"
 #include "test_byteorder.h"
 #include "test_calc.h"
+#include "test_deque.h"
+#include "test_hashtable.h"
 #include "test_heap.h"
 #include "test_icmp6.h"
 #include "test_ieee_802_15_4.h"
@@ -22,15 +28,25 @@
 #include "test_linked.h"
 #include "test_list.h"
 #include "test_lowpan.h"
+#include "test_lrucache.h"
+#include "test_magazine.h"
 #include "test_map.h"
+#include "test_mpscqueue.h"
 #include "test_ndp.h"
 #include "test_order.h"
+#include "test_packetpool.h"
+#include "test_parallel.h"
 #include "test_pool.h"
 #include "test_queue.h"
 #include "test_range.h"
+#include "test_recordring.h"
+#include "test_roaring.h"
 #include "test_ringbuffer.h"
+#include "test_scheduler.h"
 #include "test_search.h"
 #include "test_selsort.h"
+#include "test_skiplist.h"
+#include "test_slotmap.h"
 #include "test_stack.h"
 
 #include "range.h"
@@ -54,6 +70,8 @@ int main()
 	test_search();
 	test_calc();
 	test_buffer();
+	test_bufferchain();
+	test_bufferio();
 	test_byteorder();
 	test_insertsort();
 	test_selsort();
@@ -66,8 +84,22 @@ int main()
 	test_heap();
 	test_map();
 	test_pool();
+	test_magazine();
+	test_arena();
+	test_packetpool();
+	test_slotmap();
+	test_deque();
+	test_scheduler();
+	test_parallel();
 	test_queue();
+	test_recordring();
  	test_bits();
+	test_roaring();
+	test_atomicbits();
+	test_skiplist();
+	test_mpscqueue();
+	test_hashtable();
+	test_lrucache();
 
  	test_ipv6();
  	test_icmp6();
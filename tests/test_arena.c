@@ -0,0 +1,150 @@
+/************************************************************************************************//**
+ * @file		test_arena.c
+ *
+ * @copyright	Copyright 2022 Kurt Hildebrand.
+ * @license		Licensed under the Apache License, Version 2.0 (the "License"); you may not use this
+ * 				file except in compliance with the License. You may obtain a copy of the License at
+ *
+ * 				http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * 				Unless required by applicable law or agreed to in writing, software distributed under
+ * 				the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF
+ * 				ANY KIND, either express or implied. See the License for the specific language
+ * 				governing permissions and limitations under the License.
+ *
+ ***************************************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "test_arena.h"
+
+#include "arena.h"
+#include "tharness.h"
+
+
+/* Private Variables ----------------------------------------------------------------------------- */
+static _Alignas(max_align_t) uint8_t arena_mem[256];
+static _Alignas(max_align_t) uint8_t arena_extra[128];
+static _Alignas(max_align_t) uint8_t arena_blocks[4][512];
+static Pool arena_pool;
+
+
+TEST(test_arena_alloc)
+{
+	Arena     a;
+	ArenaMark mark;
+	uint8_t*  p0;
+	uint8_t*  p1;
+	uint8_t*  p2;
+
+	EXPECT(arena_init(&a, arena_mem, 4) == false);
+	EXPECT(arena_init(&a, arena_mem, sizeof(arena_mem)));
+	EXPECT(arena_used(&a) == 0);
+
+	/* Allocations are aligned */
+	p0 = arena_alloc_align(&a, 1, 1);
+	p1 = arena_alloc_align(&a, 4, 4);
+	p2 = arena_alloc(&a, 3);
+
+	EXPECT(p0 && p1 && p2);
+	EXPECT(((uintptr_t)p1 % 4) == 0);
+	EXPECT(((uintptr_t)p2 % ARENA_ALIGN) == 0);
+	EXPECT(p1 > p0 && p2 > p1);
+
+	/* Nested scopes */
+	mark = arena_mark(&a);
+	{
+		ArenaMark inner;
+		uint8_t*  q0 = arena_push(&a, "hello", 6);
+
+		EXPECT(q0 && memcmp(q0, "hello", 6) == 0);
+
+		inner = arena_mark(&a);
+		EXPECT(arena_alloc(&a, 64) != 0);
+		arena_reset_to(&a, inner);
+		EXPECT(arena_alloc_align(&a, 1, 1) == (uint8_t*)inner.ptr);
+	}
+	arena_reset_to(&a, mark);
+	EXPECT(arena_alloc_align(&a, 1, 1) == mark.ptr);
+
+	/* Out of memory without more blocks */
+	EXPECT(arena_alloc(&a, sizeof(arena_mem)) == 0);
+
+	/* Overflow into an added block */
+	EXPECT(arena_add_block(&a, arena_extra, sizeof(arena_extra)));
+	p1 = arena_alloc(&a, 150);
+	p0 = arena_alloc(&a, 100);
+	EXPECT(p1 >= arena_mem && p1 + 150 <= arena_mem + sizeof(arena_mem));
+	EXPECT(p0 >= arena_extra && p0 + 100 <= arena_extra + sizeof(arena_extra));
+
+	/* Resetting back to the first block reuses the chained block */
+	arena_reset_to(&a, mark);
+	EXPECT(arena_alloc(&a, 150) == p1);
+	EXPECT(arena_alloc(&a, 100) == p0);
+
+	arena_clear(&a);
+	EXPECT(arena_used(&a) == 0);
+	EXPECT(arena_alloc_align(&a, 1, 1) == (uint8_t*)(a.first + 1));
+}
+
+
+TEST(test_arena_buffer)
+{
+	uint8_t data[128];
+	Buffer  b;
+	Arena   a;
+	Range   r = make_range(arena_mem, 16, 16);
+
+	buffer_init(&b, data, 0, sizeof(data));
+	buffer_push_mem(&b, "abcd", 4);
+
+	EXPECT(arena_init_buffer(&a, &b));
+	EXPECT((uint8_t*)arena_alloc_align(&a, 1, 1) >= buffer_write(&b));
+	EXPECT(arena_alloc(&a, 128) == 0);
+
+	EXPECT(arena_init_range(&a, &r));
+	EXPECT(arena_alloc(&a, 200) != 0);
+}
+
+
+TEST(test_arena_pool)
+{
+	Arena    a;
+	void*    ptrs[8];
+	unsigned i;
+
+	pool_init(&arena_pool, arena_blocks, 4, sizeof(arena_blocks[0]));
+
+	EXPECT(arena_init(&a, arena_mem, sizeof(arena_mem)));
+	arena_set_pool(&a, &arena_pool);
+
+	/* Each 300 byte allocation needs a block of its own */
+	for(i = 0; i < 5; i++)
+	{
+		ptrs[i] = arena_alloc(&a, 300);
+	}
+
+	EXPECT(ptrs[0] && ptrs[1] && ptrs[2] && ptrs[3]);
+	EXPECT(ptrs[4] == 0);
+	EXPECT(pool_full(&arena_pool));
+	EXPECT(arena_alloc(&a, 1024) == 0);
+
+	/* Clearing returns pool blocks but keeps the caller's block */
+	arena_clear(&a);
+	EXPECT(pool_empty(&arena_pool));
+	EXPECT(a.first == a.last);
+	EXPECT(arena_alloc(&a, 300) != 0);
+	EXPECT(pool_count(&arena_pool) == 1);
+	arena_clear(&a);
+}
+
+
+void test_arena(void)
+{
+	tharness_run(test_arena_alloc);
+	tharness_run(test_arena_buffer);
+	tharness_run(test_arena_pool);
+}
+
+
+/******************************************* END OF FILE *******************************************/
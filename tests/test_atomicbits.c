@@ -0,0 +1,241 @@
+/************************************************************************************************//**
+ * @file		test_order.c
+ *
+ * @copyright	Copyright 2022 Kurt Hildebrand.
+ * @license		Licensed under the Apache License, Version 2.0 (the "License"); you may not use this
+ * 				file except in compliance with the License. You may obtain a copy of the License at
+ *
+ * 				http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * 				Unless required by applicable law or agreed to in writing, software distributed under
+ * 				the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF
+ * 				ANY KIND, either express or implied. See the License for the specific language
+ * 				governing permissions and limitations under the License.
+ *
+ ***************************************************************************************************/
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "test_atomicbits.h"
+
+#include "atomicbits.h"
+#include "tharness.h"
+
+
+/* Private Macros -------------------------------------------------------------------------------- */
+#define LARGE_BITS			(3000)
+#define STRESS_THREADS		(8)
+#define STRESS_ROUNDS		(2000)
+
+
+/* Private Variables ----------------------------------------------------------------------------- */
+static _Atomic uint64_t large_words[ATOMICBITS_WORDS(LARGE_BITS)];
+static AtomicBits       large;
+static _Atomic int      owners[LARGE_BITS];
+static bool             stress_ok[STRESS_THREADS];
+
+
+TEST(test_atomicbits_basic)
+{
+	_Atomic uint64_t words[ATOMICBITS_WORDS(70)];
+	AtomicBits b;
+
+	atomicbits_init(&b, words, 70);
+	EXPECT(atomicbits_count(&b) == 70);
+	EXPECT(atomicbits_ones(&b) == 0);
+
+	EXPECT(atomicbits_test_and_set(&b, 3) == false);
+	EXPECT(atomicbits_test_and_set(&b, 3) == true);
+	EXPECT(atomicbits_test_and_set(&b, 69) == false);
+	EXPECT(atomicbits_test_and_set(&b, 70) == true);
+	EXPECT(atomicbits_value(&b, 3));
+	EXPECT(atomicbits_value(&b, 69));
+	EXPECT(!atomicbits_value(&b, 70));
+	EXPECT(atomicbits_ones(&b) == 2);
+
+	EXPECT(atomicbits_test_and_clear(&b, 3) == true);
+	EXPECT(atomicbits_test_and_clear(&b, 3) == false);
+	EXPECT(atomicbits_test_and_clear(&b, 70) == false);
+	EXPECT(atomicbits_ones(&b) == 1);
+
+	atomicbits_clear_all(&b);
+	EXPECT(atomicbits_ones(&b) == 0);
+}
+
+
+TEST(test_atomicbits_claim)
+{
+	_Atomic uint64_t words[ATOMICBITS_WORDS(70)];
+	AtomicBits b;
+	unsigned i;
+	bool ok = true;
+
+	atomicbits_init(&b, words, 70);
+
+	/* Claims fill the array in order and never return the unused bits of the last word */
+	for(i = 0; i < 70; i++)
+	{
+		ok = atomicbits_claim(&b) == i && ok;
+	}
+
+	EXPECT(ok);
+	EXPECT(atomicbits_claim(&b) == -1u);
+	EXPECT(atomicbits_claim_from(&b, 5) == -1u);
+	EXPECT(atomicbits_ones(&b) == 70);
+
+	/* Claims from a starting point wrap around */
+	EXPECT(atomicbits_test_and_clear(&b, 2));
+	EXPECT(atomicbits_test_and_clear(&b, 66));
+	EXPECT(atomicbits_claim_from(&b, 10) == 66);
+	EXPECT(atomicbits_claim_from(&b, 67) == 2);
+	EXPECT(atomicbits_claim_from(&b, 1000) == -1u);
+
+	/* The search resumes at the word of the last claim */
+	EXPECT(atomicbits_test_and_clear(&b, 1));
+	EXPECT(atomicbits_test_and_clear(&b, 68));
+	EXPECT(atomicbits_claim_from(&b, 67) == 68);
+	EXPECT(atomicbits_claim(&b) == 1);
+}
+
+
+TEST(test_atomicbits_claim_many)
+{
+	_Atomic uint64_t words[ATOMICBITS_WORDS(200)];
+	AtomicBits b;
+
+	atomicbits_init(&b, words, 200);
+
+	EXPECT(atomicbits_claim_many(&b, 0) == -1u);
+	EXPECT(atomicbits_claim_many(&b, 201) == -1u);
+
+	EXPECT(atomicbits_claim_many(&b, 10) == 0);
+	EXPECT(atomicbits_claim_many(&b, 50) == 10);
+	EXPECT(atomicbits_ones(&b) == 60);
+
+	/* A hole too small for the run is skipped. The run then spans two words. */
+	EXPECT(atomicbits_clear_many(&b, 2, 5));
+	EXPECT(atomicbits_claim_many(&b, 8) == 60);
+	EXPECT(atomicbits_claim_many(&b, 5) == 2);
+	EXPECT(atomicbits_claim_many(&b, 100) == 68);
+	EXPECT(atomicbits_claim_many(&b, 100) == -1u);
+	EXPECT(atomicbits_claim_many(&b, 32) == 168);
+	EXPECT(atomicbits_claim_many(&b, 1) == -1u);
+	EXPECT(atomicbits_ones(&b) == 200);
+
+	EXPECT(atomicbits_clear_many(&b, 0, 200));
+	EXPECT(atomicbits_clear_many(&b, 190, 11) == false);
+	EXPECT(atomicbits_claim_many(&b, 200) == 0);
+}
+
+
+static void* atomicbits_stress_thread(void* arg)
+{
+	intptr_t id = (intptr_t)arg;
+	unsigned held[16];
+	unsigned count;
+	unsigned run;
+	unsigned i, j;
+
+	stress_ok[id] = true;
+
+	for(i = 0; i < STRESS_ROUNDS; i++)
+	{
+		/* Claim single bits spread over the array and a run, mark them as ours, and check nobody
+		 * else marked them before releasing them */
+		for(count = 0; count < 12; count++)
+		{
+			held[count] = atomicbits_claim_from(&large, (unsigned)id * (LARGE_BITS / STRESS_THREADS));
+
+			if(held[count] == -1u)
+			{
+				break;
+			}
+		}
+
+		run = atomicbits_claim_many(&large, 1 + i % 70);
+
+		for(j = 0; j < count; j++)
+		{
+			if(atomic_exchange(&owners[held[j]], (int)id + 1) != 0)
+			{
+				stress_ok[id] = false;
+			}
+		}
+
+		for(j = 0; run != -1u && j < 1 + i % 70; j++)
+		{
+			if(atomic_exchange(&owners[run + j], (int)id + 1) != 0)
+			{
+				stress_ok[id] = false;
+			}
+		}
+
+		sched_yield();
+
+		for(j = 0; run != -1u && j < 1 + i % 70; j++)
+		{
+			if(atomic_exchange(&owners[run + j], 0) != (int)id + 1)
+			{
+				stress_ok[id] = false;
+			}
+		}
+
+		for(j = 0; j < count; j++)
+		{
+			if(atomic_exchange(&owners[held[j]], 0) != (int)id + 1 ||
+			   !atomicbits_test_and_clear(&large, held[j]))
+			{
+				stress_ok[id] = false;
+			}
+		}
+
+		if(run != -1u && !atomicbits_clear_many(&large, run, 1 + i % 70))
+		{
+			stress_ok[id] = false;
+		}
+	}
+
+	return 0;
+}
+
+
+TEST(test_atomicbits_threaded)
+{
+	pthread_t threads[STRESS_THREADS];
+	intptr_t  i;
+	intptr_t  created;
+
+	atomicbits_init(&large, large_words, LARGE_BITS);
+
+	for(created = 0; created < STRESS_THREADS; created++)
+	{
+		if(pthread_create(&threads[created], 0, atomicbits_stress_thread, (void*)created) != 0)
+		{
+			break;
+		}
+	}
+
+	EXPECT(created == STRESS_THREADS);
+
+	for(i = 0; i < created; i++)
+	{
+		pthread_join(threads[i], 0);
+		EXPECT(stress_ok[i]);
+	}
+
+	EXPECT(atomicbits_ones(&large) == 0);
+}
+
+
+void test_atomicbits(void)
+{
+	tharness_run(test_atomicbits_basic);
+	tharness_run(test_atomicbits_claim);
+	tharness_run(test_atomicbits_claim_many);
+	tharness_run(test_atomicbits_threaded);
+}
+
+
+/******************************************* END OF FILE *******************************************/
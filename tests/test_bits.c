@@ -188,6 +188,280 @@ TEST(test_bits_next_one)
 }
 
 
+TEST(test_bits_prev_value)
+{
+	/* 0          1          2          3
+ 	 * 01234567 89012345 67890123 45678901 23456789
+	 * 01110010 00111001 11000000 00000000 000xxxxx */
+	EXPECT(bits_prev_one (&bits, 34) == 17);
+	EXPECT(bits_prev_one (&bits, 14) == 12);
+	EXPECT(bits_prev_one (&bits, 3)  == 3);
+	EXPECT(bits_prev_one (&bits, 0)  == -1u);
+	EXPECT(bits_prev_zero(&bits, 3)  == 0);
+	EXPECT(bits_prev_zero(&bits, 17) == 14);
+	EXPECT(bits_prev_zero(&bits, 99) == 34);
+}
+
+
+TEST(test_bits_next_run)
+{
+	/* 0          1          2          3
+ 	 * 01234567 89012345 67890123 45678901 23456789
+	 * 01110010 00111001 11000000 00000000 000xxxxx */
+	EXPECT(bits_next_run(&bits, 0)  == 1);
+	EXPECT(bits_next_run(&bits, 1)  == 3);
+	EXPECT(bits_next_run(&bits, 2)  == 2);
+	EXPECT(bits_next_run(&bits, 18) == 17);
+	EXPECT(bits_next_run(&bits, 34) == 1);
+	EXPECT(bits_next_run(&bits, 35) == 0);
+}
+
+
+TEST(test_bits_search_words)
+{
+	/* Compare the word at a time searches against a bit at a time search over a sparse array whose
+	 * length is not a multiple of the word size. */
+	static uint8_t data[BIT_ARRAY_SIZE(1000)];
+	Bits b;
+	unsigned i, j;
+
+	memset(data, 0, sizeof(data));
+	bits_init(&b, data, 1000);
+	bits_set(&b, 0);
+	bits_set(&b, 63);
+	bits_set(&b, 64);
+	bits_set(&b, 500);
+	bits_set(&b, 999);
+
+	for(i = 0; i < 1000; i++)
+	{
+		unsigned next = -1u;
+		unsigned prev = -1u;
+
+		for(j = i; j < 1000 && next == -1u; j++)
+		{
+			next = bits_value(&b, j) ? j : -1u;
+		}
+
+		for(j = i; j != -1u && prev == -1u; j--)
+		{
+			prev = bits_value(&b, j) ? j : -1u;
+		}
+
+		EXPECT(bits_next_one(&b, i) == next);
+		EXPECT(bits_prev_one(&b, i) == prev);
+	}
+
+	EXPECT(bits_next_zero(&b, 63)  == 65);
+	EXPECT(bits_prev_zero(&b, 64)  == 62);
+	EXPECT(bits_next_run (&b, 65)  == 435);
+	EXPECT(bits_next_run (&b, 501) == 498);
+
+	bits_set_all(&b);
+	EXPECT(bits_next_zero(&b, 0)   == -1u);
+	EXPECT(bits_prev_zero(&b, 999) == -1u);
+	EXPECT(bits_next_run (&b, 1)   == 999);
+}
+
+
+TEST(test_bits_count_words)
+{
+	/* Count across full words, trailing bytes and a partial last byte with garbage unused bits */
+	static uint8_t data[21];
+	Bits b;
+
+	memset(data, 0xFF, sizeof(data));
+	bits_init(&b, data, 163);
+	EXPECT(bits_ones (&b) == 163);
+	EXPECT(bits_zeros(&b) == 0);
+
+	data[0]  = 0x0F;
+	data[9]  = 0x00;
+	data[19] = 0x81;
+	EXPECT(bits_ones (&b) == 163 - 4 - 8 - 6);
+	EXPECT(bits_zeros(&b) == 4 + 8 + 6);
+}
+
+
+TEST(test_bits_bulk)
+{
+	static uint8_t a_data[BIT_ARRAY_SIZE(150)];
+	static uint8_t b_data[BIT_ARRAY_SIZE(150)];
+	static uint8_t c_data[BIT_ARRAY_SIZE(70)];
+	Bits a, b, c;
+	unsigned i;
+
+	memset(a_data, 0, sizeof(a_data));
+	memset(b_data, 0, sizeof(b_data));
+	memset(c_data, 0, sizeof(c_data));
+	bits_init(&a, a_data, 150);
+	bits_init(&b, b_data, 150);
+	bits_init(&c, c_data, 70);
+
+	/* a holds multiples of 2, b holds multiples of 3 */
+	for(i = 0; i < 150; i++)
+	{
+		bits_write(&a, i % 2 == 0, i);
+		bits_write(&b, i % 3 == 0, i);
+	}
+
+	EXPECT(bits_count_and(&a, &b) == 25);
+
+	bits_and(&a, &b);
+	EXPECT(bits_ones(&a) == 25);
+	EXPECT(bits_value(&a, 0) && bits_value(&a, 6) && bits_value(&a, 144));
+	EXPECT(!bits_value(&a, 2) && !bits_value(&a, 3));
+
+	bits_or(&a, &b);
+	EXPECT(memcmp(a_data, b_data, sizeof(a_data)) == 0);
+
+	bits_xor(&a, &b);
+	EXPECT(bits_ones(&a) == 0);
+
+	bits_set_all(&a);
+	bits_andnot(&a, &b);
+	EXPECT(bits_ones(&a) == 100);
+	EXPECT(bits_count_and(&a, &b) == 0);
+
+	/* Shorter source: and clears the tail of the destination, or leaves it alone */
+	bits_set_all(&c);
+	bits_set_all(&a);
+	bits_and(&a, &c);
+	EXPECT(bits_ones(&a) == 70);
+	EXPECT(bits_next_one(&a, 70) == -1u);
+
+	bits_or(&a, &b);
+	EXPECT(bits_ones(&a) == 70 + 26);
+
+	/* Longer source: bits past the end of the destination are ignored */
+	bits_clear_all(&c);
+	bits_or(&c, &b);
+	EXPECT(bits_ones(&c) == 24);
+	EXPECT(c_data[sizeof(c_data) - 1] >> (70 % 8) == 0);
+	EXPECT(bits_count_and(&b, &c) == 24);
+}
+
+
+TEST(test_bits_bulk_tail)
+{
+	uint8_t d_data[2];
+	uint8_t s_data[2];
+	Bits    d, s;
+
+	/* Equal lengths: storage bits past the end of d are left alone */
+	d_data[0] = 0xF0;
+	s_data[0] = 0xF3;
+	bits_init(&d, d_data, 4);
+	bits_init(&s, s_data, 4);
+	bits_or(&d, &s);
+	EXPECT(d_data[0] == 0xF3);
+	bits_xor(&d, &s);
+	EXPECT(d_data[0] == 0xF0);
+	bits_and(&d, &s);
+	EXPECT(d_data[0] == 0xF0);
+
+	/* Shorter source sharing the last byte: and clears d's bits 12..15, the rest ignore s's
+	 * storage bits past its end */
+	memset(d_data, 0xFF, sizeof(d_data));
+	memset(s_data, 0xFF, sizeof(s_data));
+	bits_init(&d, d_data, 16);
+	bits_init(&s, s_data, 12);
+	bits_and(&d, &s);
+	EXPECT(d_data[0] == 0xFF && d_data[1] == 0x0F);
+
+	bits_andnot(&d, &s);
+	EXPECT(d_data[0] == 0x00 && d_data[1] == 0x00);
+
+	bits_or(&d, &s);
+	EXPECT(d_data[0] == 0xFF && d_data[1] == 0x0F);
+
+	bits_xor(&d, &s);
+	EXPECT(d_data[0] == 0x00 && d_data[1] == 0x00);
+
+	/* Longer source: d's storage bits past its end are left alone */
+	d_data[1] = 0xE0;
+	bits_init(&d, d_data, 13);
+	bits_init(&s, s_data, 16);
+	bits_or(&d, &s);
+	EXPECT(d_data[0] == 0xFF && d_data[1] == 0xFF);
+	bits_andnot(&d, &s);
+	EXPECT(d_data[0] == 0x00 && d_data[1] == 0xE0);
+}
+
+
+TEST(test_bits_rank_select)
+{
+	static uint8_t  data[BIT_ARRAY_SIZE(5000)];
+	static uint64_t index[BITS_INDEX_WORDS(5000)];
+	BitsIndex ix;
+	Bits      b;
+	uint32_t  x = 12345;
+	unsigned  i, ones;
+	bool      ok = true;
+
+	/* Dense and sparse stretches so blocks and superblocks see different counts */
+	memset(data, 0, sizeof(data));
+	bits_init(&b, data, 5000);
+
+	for(i = 0; i < 5000; i++)
+	{
+		x = x * 1664525u + 1013904223u;
+		bits_write(&b, (x >> 16) % (i < 2000 ? 2 : 17) == 0, i);
+	}
+
+	bits_index_init(&ix, &b, index);
+
+	for(i = 0, ones = 0; i < 5000; i++)
+	{
+		ok = bits_rank(&ix, i) == ones && ok;
+
+		if(bits_value(&b, i))
+		{
+			ok = bits_select(&ix, ones) == i && ok;
+			ones++;
+		}
+	}
+
+	EXPECT(ok);
+	EXPECT(ones == bits_ones(&b));
+	EXPECT(bits_rank(&ix, 5000) == ones);
+	EXPECT(bits_rank(&ix, -1u) == ones);
+	EXPECT(bits_select(&ix, ones) == -1u);
+
+	/* Updates rebuild from the lowest changed superblock */
+	bits_set_many(&b, 4000, 600);
+	bits_clear(&b, 3000);
+	bits_index_update(&ix, 4000);
+	bits_index_update(&ix, 3000);
+
+	for(i = 0, ones = 0, ok = true; i < 5000; i++)
+	{
+		ok = bits_rank(&ix, i) == ones && ok;
+
+		if(bits_value(&b, i))
+		{
+			ok = bits_select(&ix, ones) == i && ok;
+			ones++;
+		}
+	}
+
+	EXPECT(ok);
+	EXPECT(ones == bits_ones(&b));
+
+	bits_set_all(&b);
+	bits_index_update(&ix, 0);
+	EXPECT(bits_rank(&ix, 4999) == 4999);
+	EXPECT(bits_select(&ix, 4999) == 4999);
+	EXPECT(bits_select(&ix, 5000) == -1u);
+
+	/* Empty bit array */
+	bits_init(&b, 0, 0);
+	bits_index_init(&ix, &b, index);
+	EXPECT(bits_rank(&ix, 0) == 0);
+	EXPECT(bits_select(&ix, 0) == -1u);
+}
+
+
 void test_bits(void)
 {
 //	memset(bits_data, 0, sizeof(bits_data));
@@ -208,6 +482,13 @@ void test_bits(void)
 	tharness_run(test_bits_count);
 	tharness_run(test_bits_next_zero);
 	tharness_run(test_bits_next_one);
+	tharness_run(test_bits_prev_value);
+	tharness_run(test_bits_next_run);
+	tharness_run(test_bits_search_words);
+	tharness_run(test_bits_count_words);
+	tharness_run(test_bits_bulk);
+	tharness_run(test_bits_bulk_tail);
+	tharness_run(test_bits_rank_select);
 }
 
 
@@ -0,0 +1,197 @@
+/************************************************************************************************//**
+ * @file		test_bufferchain.c
+ *
+ * @copyright	Copyright 2022 Kurt Hildebrand.
+ * @license		Licensed under the Apache License, Version 2.0 (the "License"); you may not use this
+ * 				file except in compliance with the License. You may obtain a copy of the License at
+ *
+ * 				http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * 				Unless required by applicable law or agreed to in writing, software distributed under
+ * 				the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF
+ * 				ANY KIND, either express or implied. See the License for the specific language
+ * 				governing permissions and limitations under the License.
+ *
+ ***************************************************************************************************/
+#include <string.h>
+#include <sys/uio.h>
+
+#include "test_bufferchain.h"
+
+#include "bufferchain.h"
+#include "tharness.h"
+
+
+/* Private Functions ----------------------------------------------------------------------------- */
+static void make_chain(void);
+
+
+/* Private Variables ----------------------------------------------------------------------------- */
+static uint8_t     data_a[16];
+static uint8_t     data_b[8];
+static uint8_t     data_c[16];
+static Buffer      segments[4];
+static BufferChain chain;
+
+
+TEST(test_bufferchain_init)
+{
+	Buffer b = make_buffer(data_a, 0, sizeof(data_a));
+
+	EXPECT(!bufferchain_init(&chain, 0, 4));
+	EXPECT(!bufferchain_init(&chain, segments, 0));
+	EXPECT( bufferchain_init(&chain, segments, 2));
+	EXPECT(bufferchain_empty(&chain));
+	EXPECT(bufferchain_count(&chain) == 0);
+	EXPECT(bufferchain_size(&chain) == 2);
+	EXPECT(bufferchain_segment(&chain, 0) == 0);
+	EXPECT(bufferchain_peek(&chain, 1) == 0);
+	EXPECT(bufferchain_reserve_head(&chain, 1) == 0);
+	EXPECT(!bufferchain_push_mem(&chain, "x", 1));
+
+	EXPECT(bufferchain_append(&chain, &b));
+	EXPECT(bufferchain_prepend(&chain, &b));
+	EXPECT(!bufferchain_append(&chain, &b));
+	EXPECT(bufferchain_count(&chain) == 2);
+}
+
+
+TEST(test_bufferchain_push)
+{
+	uint8_t  in[40];
+	uint8_t  out[40];
+	unsigned i;
+
+	for(i = 0; i < sizeof(in); i++)
+	{
+		in[i] = i;
+	}
+
+	make_chain();
+
+	/* 16 + 8 + 16 bytes of room. The first push fills a and part of b. */
+	EXPECT(bufferchain_push_mem(&chain, in, 20));
+	EXPECT(bufferchain_length(&chain) == 20);
+	EXPECT(buffer_remaining(bufferchain_segment(&chain, 0)) == 16);
+	EXPECT(buffer_remaining(bufferchain_segment(&chain, 1)) == 4);
+
+	EXPECT(!bufferchain_push_mem(&chain, &in[20], 21));
+	EXPECT(bufferchain_length(&chain) == 20);
+	EXPECT(bufferchain_push_mem(&chain, &in[20], 20));
+	EXPECT(bufferchain_length(&chain) == 40);
+	EXPECT(!bufferchain_push_mem(&chain, in, 1));
+
+	EXPECT(bufferchain_peek_mem(&chain, out, 40));
+	EXPECT(memcmp(in, out, 40) == 0);
+	EXPECT(!bufferchain_peek_mem(&chain, out, 41));
+
+	EXPECT(bufferchain_read_offset(&chain, out, 14, 12));
+	EXPECT(memcmp(&in[14], out, 12) == 0);
+	EXPECT(!bufferchain_read_offset(&chain, out, 30, 11));
+}
+
+
+TEST(test_bufferchain_pop)
+{
+	uint8_t  out[40];
+	uint8_t* ptr;
+
+	/* Contiguous pops only succeed within a segment */
+	ptr = bufferchain_pop(&chain, 10);
+	EXPECT(ptr == data_a && ptr[9] == 9);
+	EXPECT(bufferchain_peek(&chain, 7) == 0);
+	EXPECT(bufferchain_peek(&chain, 6) == &data_a[10]);
+
+	/* Copying pops span segments and skip empty segments */
+	EXPECT(bufferchain_pop_mem(&chain, out, 8));
+	EXPECT(out[0] == 10 && out[7] == 17);
+	EXPECT(bufferchain_length(&chain) == 22);
+	EXPECT(bufferchain_peek(&chain, 6) == &data_b[2]);
+
+	EXPECT(!bufferchain_pop_mem(&chain, out, 23));
+	EXPECT(bufferchain_pop_mem(&chain, 0, 6));
+	EXPECT(*(uint8_t*)bufferchain_peek(&chain, 1) == 24);
+	EXPECT(bufferchain_pop_mem(&chain, out, 16));
+	EXPECT(out[0] == 24 && out[15] == 39);
+	EXPECT(bufferchain_empty(&chain));
+	EXPECT(bufferchain_pop(&chain, 1) == 0);
+}
+
+
+TEST(test_bufferchain_head)
+{
+	Buffer   header;
+	uint8_t  hdr_data[4] = { 0xA0, 0xA1, 0xA2, 0xA3 };
+	uint8_t  out[8];
+	uint8_t* ptr;
+
+	make_chain();
+	bufferchain_push_mem(&chain, "payload", 7);
+
+	/* The first segment has no headroom until data is popped from it */
+	EXPECT(bufferchain_reserve_head(&chain, 1) == 0);
+	bufferchain_pop_mem(&chain, 0, 3);
+	EXPECT(!bufferchain_push_head(&chain, hdr_data, 4));
+	EXPECT(bufferchain_push_head(&chain, hdr_data, 3));
+	EXPECT(bufferchain_peek_mem(&chain, out, 7));
+	EXPECT(memcmp(out, "\xA0\xA1\xA2load", 7) == 0);
+
+	ptr = bufferchain_reserve_head(&chain, 0);
+	EXPECT(ptr == data_a);
+
+	/* A separate header segment can be prepended instead */
+	header = make_buffer(hdr_data, 4, 4);
+	EXPECT(bufferchain_prepend(&chain, &header));
+	EXPECT(bufferchain_length(&chain) == 11);
+	EXPECT(bufferchain_peek_mem(&chain, out, 8));
+	EXPECT(memcmp(out, "\xA0\xA1\xA2\xA3\xA0\xA1\xA2l", 8) == 0);
+}
+
+
+TEST(test_bufferchain_iovec)
+{
+	struct iovec iov[4];
+
+	make_chain();
+	bufferchain_push_mem(&chain, "0123456789ABCDEFghij", 20);
+
+	/* The empty third segment is skipped */
+	EXPECT(bufferchain_iovec(&chain, iov, 4) == 2);
+	EXPECT(iov[0].iov_base == data_a && iov[0].iov_len == 16);
+	EXPECT(iov[1].iov_base == data_b && iov[1].iov_len == 4);
+	EXPECT(bufferchain_iovec(&chain, iov, 1) == 0);
+
+	bufferchain_pop_mem(&chain, 0, 17);
+	EXPECT(bufferchain_iovec(&chain, iov, 1) == 1);
+	EXPECT(iov[0].iov_base == &data_b[1] && iov[0].iov_len == 3);
+}
+
+
+void test_bufferchain(void)
+{
+	tharness_run(test_bufferchain_init);
+	tharness_run(test_bufferchain_push);
+	tharness_run(test_bufferchain_pop);
+	tharness_run(test_bufferchain_head);
+	tharness_run(test_bufferchain_iovec);
+}
+
+
+/* make_chain ***********************************************************************************//**
+ * @brief		Builds a chain of three empty segments of 16, 8 and 16 bytes. */
+static void make_chain(void)
+{
+	Buffer b;
+
+	bufferchain_init(&chain, segments, 4);
+
+	b = make_buffer(data_a, 0, sizeof(data_a));
+	bufferchain_append(&chain, &b);
+	b = make_buffer(data_b, 0, sizeof(data_b));
+	bufferchain_append(&chain, &b);
+	b = make_buffer(data_c, 0, sizeof(data_c));
+	bufferchain_append(&chain, &b);
+}
+
+
+/******************************************* END OF FILE *******************************************/
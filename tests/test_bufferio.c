@@ -0,0 +1,255 @@
+/************************************************************************************************//**
+ * @file		test_bufferio.c
+ *
+ * @copyright	Copyright 2022 Kurt Hildebrand.
+ * @license		Licensed under the Apache License, Version 2.0 (the "License"); you may not use this
+ * 				file except in compliance with the License. You may obtain a copy of the License at
+ *
+ * 				http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * 				Unless required by applicable law or agreed to in writing, software distributed under
+ * 				the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF
+ * 				ANY KIND, either express or implied. See the License for the specific language
+ * 				governing permissions and limitations under the License.
+ *
+ ***************************************************************************************************/
+#define _GNU_SOURCE
+
+#include <fcntl.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "test_bufferio.h"
+
+#include "bufferio.h"
+#include "tharness.h"
+
+
+/* Private Variables ----------------------------------------------------------------------------- */
+static uint8_t data_a[16];
+static uint8_t data_b[8];
+static uint8_t data_c[16];
+static uint8_t large[2][1 << 19];
+static uint8_t drain[1 << 20];
+
+
+TEST(test_bufferio_stream)
+{
+	int    fds[2];
+	Buffer out;
+	Buffer in;
+
+	EXPECT(socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0);
+
+	memcpy(data_a, "0123456789", 10);
+	out = make_buffer(data_a, 10, sizeof(data_a));
+	in  = make_buffer(data_b, 0,  sizeof(data_b));
+
+	/* Only the unread bytes are written */
+	buffer_read_seek(&out, 2);
+	EXPECT(buffer_write_fd(&out, fds[0]) == 8);
+	EXPECT(buffer_remaining(&out) == 0);
+	EXPECT(buffer_write_fd(&out, fds[0]) == 0);
+
+	/* A read is limited to the tailroom */
+	EXPECT(buffer_read_fd(&in, fds[1]) == 8);
+	EXPECT(buffer_length(&in) == 8);
+	EXPECT(buffer_tailroom(&in) == 0);
+	EXPECT(memcmp(data_b, "23456789", 8) == 0);
+
+	/* End of file */
+	close(fds[0]);
+	buffer_clear(&in);
+	EXPECT(buffer_read_fd(&in, fds[1]) == 0);
+	EXPECT(buffer_length(&in) == 0);
+	close(fds[1]);
+}
+
+
+TEST(test_bufferio_vector)
+{
+	int    fds[2];
+	Buffer out[3];
+	Buffer in[3];
+
+	EXPECT(socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0);
+
+	memcpy(data_a, "abcdef", 6);
+	memcpy(data_b, "ghij",   4);
+	memcpy(data_c, "klmnop", 6);
+	out[0] = make_buffer(data_a, 6, sizeof(data_a));
+	out[1] = make_buffer(data_b, 0, sizeof(data_b));
+	out[2] = make_buffer(data_c, 6, sizeof(data_c));
+
+	/* The empty middle buffer contributes nothing */
+	EXPECT(buffer_writev(out, 3, fds[0]) == 12);
+	EXPECT(buffer_remaining(&out[0]) == 0);
+	EXPECT(buffer_remaining(&out[2]) == 0);
+
+	out[1] = make_buffer(data_b, 4, sizeof(data_b));
+	EXPECT(buffer_writev(&out[1], 1, fds[0]) == 4);
+
+	/* The bytes fill each buffer before the next */
+	memset(data_a, 0, sizeof(data_a));
+	memset(data_c, 0, sizeof(data_c));
+	in[0] = make_buffer(data_a, 0, 5);
+	in[1] = make_buffer(data_c, 0, 4);
+	in[2] = make_buffer(&data_c[4], 0, 12);
+
+	EXPECT(buffer_readv(in, 3, fds[1]) == 16);
+	EXPECT(buffer_length(&in[0]) == 5);
+	EXPECT(buffer_length(&in[1]) == 4);
+	EXPECT(buffer_length(&in[2]) == 7);
+	EXPECT(memcmp(data_a, "abcde", 5) == 0);
+	EXPECT(memcmp(data_c, "fklmnopghij", 11) == 0);
+
+	close(fds[0]);
+	close(fds[1]);
+}
+
+
+TEST(test_bufferio_partial)
+{
+	int      fds[2];
+	Buffer   out[2];
+	long     n;
+	long     total;
+	unsigned i;
+
+	EXPECT(socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0);
+	EXPECT(fcntl(fds[0], F_SETFL, O_NONBLOCK) == 0);
+
+	for(i = 0; i < sizeof(large[0]); i++)
+	{
+		large[0][i] = i;
+		large[1][i] = i * 7;
+	}
+
+	out[0] = make_buffer(large[0], sizeof(large[0]), sizeof(large[0]));
+	out[1] = make_buffer(large[1], sizeof(large[1]), sizeof(large[1]));
+
+	/* The socket cannot hold 1 MB so the write is partial. The read pointers advance by exactly
+	 * the bytes written. */
+	n = buffer_writev(out, 2, fds[0]);
+	EXPECT(n > 0 && n < (long)(2 * sizeof(large[0])));
+	EXPECT(buffer_length(&out[0]) + buffer_length(&out[1])
+		- buffer_remaining(&out[0]) - buffer_remaining(&out[1]) == (unsigned)n);
+
+	/* Alternate between draining and writing until every byte has arrived in order */
+	total = 0;
+	while(total < (long)sizeof(drain))
+	{
+		Buffer in = make_buffer(&drain[total], 0, sizeof(drain) - total);
+
+		EXPECT((n = buffer_read_fd(&in, fds[1])) > 0);
+		if(n <= 0)
+		{
+			break;
+		}
+
+		total += n;
+		buffer_writev(out, 2, fds[0]);
+	}
+
+	EXPECT(total == (long)sizeof(drain));
+	EXPECT(buffer_remaining(&out[0]) == 0);
+	EXPECT(buffer_remaining(&out[1]) == 0);
+	EXPECT(memcmp(drain, large[0], sizeof(large[0])) == 0);
+	EXPECT(memcmp(&drain[sizeof(large[0])], large[1], sizeof(large[1])) == 0);
+
+	close(fds[0]);
+	close(fds[1]);
+}
+
+
+TEST(test_bufferio_datagram)
+{
+	int    fds[2];
+	Buffer out[3];
+	Buffer in[4];
+
+	EXPECT(socketpair(AF_UNIX, SOCK_DGRAM, 0, fds) == 0);
+
+	memcpy(data_a, "first",  5);
+	memcpy(data_b, "second", 6);
+	memcpy(data_c, "third",  5);
+	out[0] = make_buffer(data_a, 5, sizeof(data_a));
+	out[1] = make_buffer(data_b, 6, sizeof(data_b));
+	out[2] = make_buffer(data_c, 5, sizeof(data_c));
+
+	EXPECT(buffer_sendmmsg(out, 3, fds[0], 0) == 3);
+	EXPECT(buffer_remaining(&out[0]) == 0);
+	EXPECT(buffer_remaining(&out[1]) == 0);
+	EXPECT(buffer_remaining(&out[2]) == 0);
+
+	/* Message boundaries are kept. A short tailroom truncates the datagram. */
+	in[0] = make_buffer(large[0], 0, 16);
+	in[1] = make_buffer(large[0] + 16, 0, 3);
+	in[2] = make_buffer(large[0] + 32, 0, 16);
+	in[3] = make_buffer(large[0] + 48, 0, 16);
+
+	EXPECT(buffer_recvmmsg(in, 4, fds[1], MSG_DONTWAIT) == 3);
+	EXPECT(buffer_length(&in[0]) == 5 && memcmp(large[0], "first", 5) == 0);
+	EXPECT(buffer_length(&in[1]) == 3 && memcmp(large[0] + 16, "sec", 3) == 0);
+	EXPECT(buffer_length(&in[2]) == 5 && memcmp(large[0] + 32, "third", 5) == 0);
+	EXPECT(buffer_length(&in[3]) == 0);
+
+	/* Nothing left to receive */
+	EXPECT(buffer_recvmmsg(in, 4, fds[1], MSG_DONTWAIT) == -1);
+
+	close(fds[0]);
+	close(fds[1]);
+}
+
+
+TEST(test_bufferio_chain)
+{
+	int         fds[2];
+	Buffer      segments[3];
+	BufferChain chain;
+	Buffer      b;
+	uint8_t     out[20];
+
+	EXPECT(socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0);
+
+	bufferchain_init(&chain, segments, 3);
+	b = make_buffer(data_a, 0, sizeof(data_a));
+	bufferchain_append(&chain, &b);
+	b = make_buffer(data_b, 0, sizeof(data_b));
+	bufferchain_append(&chain, &b);
+	b = make_buffer(data_c, 0, sizeof(data_c));
+	bufferchain_append(&chain, &b);
+
+	EXPECT(write(fds[0], "0123456789ABCDEFghijklmnopqrst", 30) == 30);
+
+	/* A read continues after the data already in the chain */
+	bufferchain_push_mem(&chain, "xy", 2);
+	EXPECT(bufferchain_read_fd(&chain, fds[1]) == 30);
+	EXPECT(bufferchain_length(&chain) == 32);
+	EXPECT(bufferchain_pop_mem(&chain, 0, 2));
+
+	/* A write drains the chain from the front */
+	EXPECT(bufferchain_write_fd(&chain, fds[0]) == 30);
+	EXPECT(bufferchain_length(&chain) == 0);
+	EXPECT(read(fds[1], out, sizeof(out)) == 20);
+	EXPECT(memcmp(out, "0123456789ABCDEFghij", 20) == 0);
+	EXPECT(read(fds[1], out, sizeof(out)) == 10);
+	EXPECT(memcmp(out, "klmnopqrst", 10) == 0);
+
+	close(fds[0]);
+	close(fds[1]);
+}
+
+
+void test_bufferio(void)
+{
+	tharness_run(test_bufferio_stream);
+	tharness_run(test_bufferio_vector);
+	tharness_run(test_bufferio_partial);
+	tharness_run(test_bufferio_datagram);
+	tharness_run(test_bufferio_chain);
+}
+
+
+/******************************************* END OF FILE *******************************************/
@@ -0,0 +1,179 @@
+/************************************************************************************************//**
+ * @file		test_deque.c
+ *
+ * @copyright	Copyright 2022 Kurt Hildebrand.
+ * @license		Licensed under the Apache License, Version 2.0 (the "License"); you may not use this
+ * 				file except in compliance with the License. You may obtain a copy of the License at
+ *
+ * 				http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * 				Unless required by applicable law or agreed to in writing, software distributed under
+ * 				the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF
+ * 				ANY KIND, either express or implied. See the License for the specific language
+ * 				governing permissions and limitations under the License.
+ *
+ ***************************************************************************************************/
+#include <pthread.h>
+#include <sched.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "test_deque.h"
+
+#include "deque.h"
+#include "tharness.h"
+
+
+/* Private Macros -------------------------------------------------------------------------------- */
+#define DEQUE_THIEVES		(3)
+#define DEQUE_ITEMS			(20000)
+
+
+/* Private Variables ----------------------------------------------------------------------------- */
+static _Atomic(void*)   deque_slots[64];
+static Deque            deque;
+static _Atomic unsigned deque_seen[DEQUE_ITEMS + 1];
+static _Atomic bool     deque_done;
+
+
+TEST(test_deque_basic)
+{
+	uintptr_t i;
+
+	EXPECT(deque_init(&deque, deque_slots, 48) == false);
+	EXPECT(deque_init_range(&deque, make_range(deque_slots, 64, sizeof(deque_slots[0]))));
+	EXPECT(deque_empty(&deque));
+	EXPECT(deque_pop(&deque) == 0);
+	EXPECT(deque_steal(&deque) == 0);
+
+	for(i = 1; i <= 64; i++)
+	{
+		EXPECT(deque_push(&deque, (void*)i));
+	}
+
+	EXPECT(deque_push(&deque, (void*)65) == false);
+	EXPECT(deque_count(&deque) == 64);
+
+	/* Owner pops LIFO, thieves steal FIFO */
+	EXPECT(deque_pop(&deque)   == (void*)64);
+	EXPECT(deque_steal(&deque) == (void*)1);
+	EXPECT(deque_steal(&deque) == (void*)2);
+	EXPECT(deque_pop(&deque)   == (void*)63);
+
+	for(i = 3; i <= 62; i++)
+	{
+		EXPECT(deque_steal(&deque) == (void*)i);
+	}
+
+	EXPECT(deque_pop(&deque) == 0);
+	EXPECT(deque_steal(&deque) == 0);
+	EXPECT(deque_empty(&deque));
+
+	/* Wrap around */
+	for(i = 1; i <= 40; i++)
+	{
+		EXPECT(deque_push(&deque, (void*)i));
+	}
+
+	EXPECT(deque_pop(&deque) == (void*)40);
+	EXPECT(deque_count(&deque) == 39);
+}
+
+
+static void* deque_thief(void* arg)
+{
+	(void)arg;
+
+	while(!atomic_load(&deque_done) || !deque_empty(&deque))
+	{
+		uintptr_t item = (uintptr_t)deque_steal(&deque);
+
+		if(item)
+		{
+			atomic_fetch_add(&deque_seen[item], 1);
+		}
+		else
+		{
+			sched_yield();
+		}
+	}
+
+	return 0;
+}
+
+
+TEST(test_deque_steal)
+{
+	pthread_t thieves[DEQUE_THIEVES];
+	uintptr_t i;
+	uintptr_t created;
+	unsigned  twice = 0;
+	unsigned  lost  = 0;
+
+	deque_init(&deque, deque_slots, 64);
+	atomic_store(&deque_done, false);
+
+	for(i = 0; i <= DEQUE_ITEMS; i++)
+	{
+		atomic_store(&deque_seen[i], 0);
+	}
+
+	for(created = 0; created < DEQUE_THIEVES; created++)
+	{
+		if(pthread_create(&thieves[created], 0, deque_thief, 0) != 0)
+		{
+			break;
+		}
+	}
+
+	EXPECT(created == DEQUE_THIEVES);
+
+	/* The owner pushes every item and pops some back, racing the thieves for the last items */
+	for(i = 1; i <= DEQUE_ITEMS; i++)
+	{
+		while(!deque_push(&deque, (void*)i))
+		{
+			sched_yield();
+		}
+
+		if(i % 3 == 0)
+		{
+			uintptr_t item = (uintptr_t)deque_pop(&deque);
+
+			if(item)
+			{
+				atomic_fetch_add(&deque_seen[item], 1);
+			}
+		}
+	}
+
+	atomic_store(&deque_done, true);
+
+	for(i = 0; i < created; i++)
+	{
+		pthread_join(thieves[i], 0);
+	}
+
+	/* Every item is taken exactly once */
+	for(i = 1; i <= DEQUE_ITEMS; i++)
+	{
+		unsigned seen = atomic_load(&deque_seen[i]);
+
+		twice += seen > 1;
+		lost  += seen == 0;
+	}
+
+	EXPECT(twice == 0);
+	EXPECT(lost  == 0);
+}
+
+
+void test_deque(void)
+{
+	tharness_run(test_deque_basic);
+	tharness_run(test_deque_steal);
+}
+
+
+/******************************************* END OF FILE *******************************************/
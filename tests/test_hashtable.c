@@ -0,0 +1,263 @@
+/************************************************************************************************//**
+ * @file		test_hashtable.c
+ *
+ * @copyright	Copyright 2022 Kurt Hildebrand.
+ * @license		Licensed under the Apache License, Version 2.0 (the "License"); you may not use this
+ * 				file except in compliance with the License. You may obtain a copy of the License at
+ *
+ * 				http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * 				Unless required by applicable law or agreed to in writing, software distributed under
+ * 				the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF
+ * 				ANY KIND, either express or implied. See the License for the specific language
+ * 				governing permissions and limitations under the License.
+ *
+ ***************************************************************************************************/
+#include <string.h>
+
+#include "test_hashtable.h"
+
+#include "hashtable.h"
+#include "tharness.h"
+#include "utils.h"
+
+
+/* Private Macros -------------------------------------------------------------------------------- */
+#define ITEM_COUNT	(1000)
+
+
+/* Private Types --------------------------------------------------------------------------------- */
+typedef struct {
+	uint32_t key;
+	unsigned order;
+	Link     link;
+} Item;
+
+
+/* Private Functions ----------------------------------------------------------------------------- */
+static uint32_t hash_key     (uint32_t);
+static uint32_t hash_item    (const void*);
+static int      compare_key  (const void*, const void*);
+static bool     all_found    (const HashTable*, unsigned, unsigned);
+static bool     visits_once  (const HashTable*);
+
+
+/* Private Variables ----------------------------------------------------------------------------- */
+static Item          items[ITEM_COUNT];
+static Link*         buckets_a[1024];
+static Link*         buckets_b[1024];
+static HashTable     table;
+static unsigned char visited[ITEM_COUNT];
+
+
+TEST(test_hashtable_init)
+{
+	EXPECT(!hashtable_init(&table, buckets_a, 0,  hash_item, compare_key));
+	EXPECT(!hashtable_init(&table, buckets_a, 12, hash_item, compare_key));
+	EXPECT(!hashtable_init(&table, 0,         16, hash_item, compare_key));
+	EXPECT( hashtable_init(&table, buckets_a, 16, hash_item, compare_key));
+	EXPECT(hashtable_empty(&table));
+	EXPECT(hashtable_size(&table) == 16);
+	EXPECT(!hashtable_resizing(&table));
+	EXPECT(hashtable_first(&table) == 0);
+	EXPECT(hashtable_find(&table, hash_key(5), &(uint32_t){ 5 }) == 0);
+}
+
+
+TEST(test_hashtable_insert)
+{
+	unsigned i;
+
+	hashtable_init(&table, buckets_a, 256, hash_item, compare_key);
+
+	for(i = 0; i < ITEM_COUNT; i++)
+	{
+		items[i].key   = i * 7;
+		items[i].order = i;
+		EXPECT(hashtable_insert(&table, &items[i].link) == &items[i].link);
+	}
+
+	EXPECT(hashtable_count(&table) == ITEM_COUNT);
+	EXPECT(all_found(&table, 0, ITEM_COUNT));
+	EXPECT(hashtable_find(&table, hash_key(3), &(uint32_t){ 3 }) == 0);
+	EXPECT(visits_once(&table));
+}
+
+
+TEST(test_hashtable_remove)
+{
+	Link*    ptr;
+	Link*    next;
+	unsigned i;
+	bool     ok = true;
+
+	/* Remove odd items while iterating */
+	HASHTABLE_FOREACH(&table, ptr, next)
+	{
+		if(CONTAINER_OF(ptr, Item, link)->order % 2)
+		{
+			hashtable_remove(&table, ptr);
+		}
+	}
+
+	EXPECT(hashtable_count(&table) == ITEM_COUNT / 2);
+
+	for(i = 0; i < ITEM_COUNT; i++)
+	{
+		void* found = hashtable_find(&table, hash_key(items[i].key), &items[i].key);
+		ok = (found == (i % 2 ? 0 : &items[i].link)) && ok;
+	}
+
+	EXPECT(ok);
+	EXPECT(visits_once(&table));
+}
+
+
+TEST(test_hashtable_duplicates)
+{
+	Link*    node;
+	unsigned i;
+	uint32_t key = 42;
+
+	hashtable_init(&table, buckets_a, 16, hash_item, compare_key);
+
+	for(i = 0; i < 10; i++)
+	{
+		items[i].key   = i % 2 ? key : i;
+		items[i].order = i;
+		hashtable_insert(&table, &items[i].link);
+	}
+
+	/* Equal keys are found in insertion order */
+	node = hashtable_find(&table, hash_key(key), &key);
+
+	for(i = 1; i < 10; i += 2)
+	{
+		EXPECT(node == &items[i].link);
+		node = hashtable_find_next(&table, node, &key);
+	}
+
+	EXPECT(node == 0);
+}
+
+
+TEST(test_hashtable_resize)
+{
+	Link**   spare = buckets_b;
+	unsigned i;
+	bool     ok = true;
+
+	/* Double the table whenever it fills. Every item must stay reachable mid-resize. */
+	hashtable_init(&table, buckets_a, 8, hash_item, compare_key);
+
+	for(i = 0; i < ITEM_COUNT; i++)
+	{
+		items[i].key   = i * 13 + 1;
+		items[i].order = i;
+		hashtable_insert(&table, &items[i].link);
+
+		if(hashtable_count(&table) == hashtable_size(&table))
+		{
+			Link** current = table.buckets;
+
+			ok = hashtable_resize(&table, spare, 2 * hashtable_size(&table)) && ok;
+			ok = !hashtable_resize(&table, current, 4 * hashtable_size(&table)) && ok;
+			spare = current;
+		}
+
+		ok = all_found(&table, i - i / 8, i + 1) && ok;
+	}
+
+	EXPECT(ok);
+	EXPECT(hashtable_size(&table) == 1024);
+	EXPECT(hashtable_count(&table) == ITEM_COUNT);
+	EXPECT(visits_once(&table));
+	EXPECT(all_found(&table, 0, ITEM_COUNT));
+
+	/* Shrink part way and check lookups and iteration before finishing */
+	EXPECT(hashtable_migrate(&table, -1u));
+	EXPECT(hashtable_resize(&table, spare, 64));
+	EXPECT(!hashtable_migrate(&table, 300));
+	EXPECT(hashtable_resizing(&table));
+	EXPECT(all_found(&table, 0, ITEM_COUNT));
+	EXPECT(visits_once(&table));
+
+	EXPECT(hashtable_migrate(&table, -1u));
+	EXPECT(!hashtable_resizing(&table));
+	EXPECT(hashtable_size(&table) == 64);
+	EXPECT(all_found(&table, 0, ITEM_COUNT));
+	EXPECT(visits_once(&table));
+}
+
+
+void test_hashtable(void)
+{
+	tharness_run(test_hashtable_init);
+	tharness_run(test_hashtable_insert);
+	tharness_run(test_hashtable_remove);
+	tharness_run(test_hashtable_duplicates);
+	tharness_run(test_hashtable_resize);
+}
+
+
+static uint32_t hash_key(uint32_t key)
+{
+	return key * 0x9E3779B1u;
+}
+
+
+static uint32_t hash_item(const void* a)
+{
+	return hash_key(CONTAINER_OF(a, Item, link)->key);
+}
+
+
+static int compare_key(const void* key, const void* b)
+{
+	return compare_u32(key, &CONTAINER_OF(b, Item, link)->key);
+}
+
+
+/* all_found ************************************************************************************//**
+ * @brief		Returns true if items first through last - 1 are found by key. */
+static bool all_found(const HashTable* t, unsigned first, unsigned last)
+{
+	unsigned i;
+
+	for(i = first; i < last; i++)
+	{
+		if(hashtable_find(t, hash_key(items[i].key), &items[i].key) != &items[i].link)
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+
+/* visits_once **********************************************************************************//**
+ * @brief		Returns true if iterating the table visits every node exactly once. */
+static bool visits_once(const HashTable* t)
+{
+	Link*    ptr;
+	Link*    next;
+	unsigned count = 0;
+
+	memset(visited, 0, sizeof(visited));
+
+	HASHTABLE_FOREACH(t, ptr, next)
+	{
+		if(visited[CONTAINER_OF(ptr, Item, link)->order]++)
+		{
+			return false;
+		}
+
+		count++;
+	}
+
+	return count == hashtable_count(t);
+}
+
+
+/******************************************* END OF FILE *******************************************/
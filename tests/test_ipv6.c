@@ -63,6 +63,33 @@ TEST(test_ipv6_checksum)
 }
 
 
+TEST(test_ipv6_checksum_chain)
+{
+	uint8_t     data[61];
+	Buffer      segments[4];
+	Buffer      b;
+	BufferChain chain;
+	unsigned    i;
+	unsigned    cuts[] = { 0, 7, 8, 30, 61 };
+
+	for(i = 0; i < sizeof(data); i++)
+	{
+		data[i] = (uint8_t)(i * 37 + 11);
+	}
+
+	/* Segments of odd and even lengths starting at odd and even offsets */
+	bufferchain_init(&chain, segments, 4);
+
+	for(i = 0; i < 4; i++)
+	{
+		b = make_buffer(&data[cuts[i]], cuts[i+1] - cuts[i], cuts[i+1] - cuts[i]);
+		bufferchain_append(&chain, &b);
+	}
+
+	EXPECT(ipv6_checksum_chain(&chain, 0x1234) == ipv6_checksum(data, sizeof(data), 0x1234));
+}
+
+
 TEST(test_ipv6_init)
 {
 	ipv6_init (&packet, ipv6_packet_data, 0, sizeof(ipv6_packet_data));
@@ -71,6 +98,36 @@ TEST(test_ipv6_init)
 }
 
 
+TEST(test_ipv6_alloc)
+{
+	static _Alignas(max_align_t) uint8_t mem[2][PKTPOOL_ELEMSIZE(IPV6_MTU + 32)];
+	PacketPool pool;
+	IPPacket   a;
+	IPPacket   b;
+	IPPacket   c;
+	uint8_t*   start;
+
+	EXPECT(pktpool_init(&pool, mem, 2, IPV6_MTU + 32, 32, 0));
+	EXPECT(ipv6_alloc(&a, &pool));
+	EXPECT(ipv6_alloc(&b, &pool));
+	EXPECT(!ipv6_alloc(&c, &pool));
+
+	/* The header is written after the headroom and a lower layer prepends in front of it */
+	ipv6_clear(&a);
+	EXPECT(ipv6_set_src(&a, &src));
+	EXPECT(ipv6_version(&a) == 6);
+	EXPECT(pkt_headroom(&pool, &a.buffer) == 32);
+
+	start = buffer_start(&a.buffer);
+	EXPECT(pkt_prepend(&pool, &a.buffer, 4) == start - 4);
+	EXPECT(memcmp(start + 8, &src, sizeof(src)) == 0);
+
+	EXPECT(ipv6_free(&a, &pool));
+	EXPECT(ipv6_free(&b, &pool));
+	EXPECT(pktpool_count(&pool) == 0);
+}
+
+
 TEST(test_ipv6_set)
 {
 	IPAddress* ptr;
@@ -532,7 +589,9 @@ void test_ipv6()
 	IPOption option;
 
 	tharness_run(test_ipv6_checksum);
+	tharness_run(test_ipv6_checksum_chain);
 	tharness_run(test_ipv6_init);
+	tharness_run(test_ipv6_alloc);
 	tharness_run(test_ipv6_set);
 	tharness_run(test_ipv6_ext_hdr);
 	tharness_run(test_ipv6_option);
@@ -243,6 +243,103 @@ TEST(test_linked_compare_insert)
 }
 
 
+TEST(test_linked_sort)
+{
+	IntLink  temps[200];
+	IntLink* p1;
+	IntLink* p2;
+	unsigned i;
+	bool     ok = true;
+
+	/* Empty and single node lists */
+	linked_init(&linked);
+	linked_sort(&linked, compare_links);
+	EXPECT(linked_empty(linked));
+
+	temps[0].data = 1;
+	linked_append(&linked, &temps[0].link);
+	linked_sort(&linked, compare_links);
+	EXPECT(linked_first(linked) == &temps[0].link);
+	EXPECT(linked_last(linked) == &temps[0].link);
+
+	/* Many duplicate keys. data2 records the original order to check stability. */
+	linked_init(&linked);
+
+	for(i = 0; i < sizeof(temps) / sizeof(temps[0]); i++)
+	{
+		temps[i].data  = rand() % 20;
+		temps[i].data2 = i;
+		linked_append(&linked, &temps[i].link);
+	}
+
+	linked_sort(&linked, compare_links);
+	show_linked(&linked);
+
+	EXPECT(linked_count(linked) == sizeof(temps) / sizeof(temps[0]));
+
+	p1 = linked_first(linked);
+	p2 = linked_next(linked, &p1->link);
+
+	while(p2)
+	{
+		ok = (p1->data < p2->data || (p1->data == p2->data && p1->data2 < p2->data2)) && ok;
+		ok = (p2->link.prev == &p1->link) && ok;
+		p1 = p2;
+		p2 = linked_next(linked, &p2->link);
+	}
+
+	EXPECT(ok);
+	EXPECT(linked_last(linked) == &p1->link);
+	EXPECT(p1->link.next == linked);
+}
+
+
+TEST(test_linked_merge)
+{
+	IntLink  temps[10];
+	Link*    other;
+	IntLink* p;
+	unsigned i;
+	int      keys[]   = { 0, 2, 4, 6, 8, 1, 2, 5, 8, 9 };
+	int      expect[] = { 0, 1, 2, 2, 4, 5, 6, 8, 8, 9 };
+	bool     ok = true;
+
+	linked_init(&linked);
+	linked_init(&other);
+
+	/* Evens go to the first list, the rest to the second. Equal keys from the first list come
+	 * first after the merge. */
+
+	for(i = 0; i < sizeof(temps) / sizeof(temps[0]); i++)
+	{
+		temps[i].data  = keys[i];
+		temps[i].data2 = i;
+		linked_append(i < 5 ? &linked : &other, &temps[i].link);
+	}
+
+	linked_merge(&linked, &other, compare_links);
+	show_linked(&linked);
+
+	EXPECT(linked_empty(other));
+	EXPECT(linked_count(linked) == 10);
+
+	for(i = 0, p = linked_first(linked); p; i++, p = linked_next(linked, &p->link))
+	{
+		ok = p->data == expect[i] && ok;
+	}
+
+	EXPECT(ok);
+	EXPECT(((IntLink*)linked_next(linked, &temps[1].link))->data2 == 6);
+	EXPECT(((IntLink*)linked_last(linked))->data == 9);
+
+	/* Merging into an empty list takes the other list */
+	linked_merge(&other, &linked, compare_links);
+	EXPECT(linked_empty(linked));
+	EXPECT(linked_count(other) == 10);
+	EXPECT(linked_first(other) == &temps[0].link);
+}
+
+
 void test_linked_container(void)
 {
 	Int3Link temps[] = {
@@ -291,6 +388,8 @@ void test_linked(void)
 	tharness_run(test_linked_pop_front);
 	tharness_run(test_linked_pop_back);
 	tharness_run(test_linked_compare_insert);
+	tharness_run(test_linked_sort);
+	tharness_run(test_linked_merge);
 	tharness_run(test_linked_container);
 }
 
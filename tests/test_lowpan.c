@@ -2149,6 +2149,63 @@ TEST(test_lowpan_compress_with_eh)
 }
 
 
+TEST(test_lowpan_compress_chain)
+{
+	const uint8_t expected_frame[] = {
+		0x41,0xED,0x88,0x99,0xAA,0xBB,0xCC,0xDD,0xEE,0xFF,0x00,0x11,0x22,0x33,0x44,0x55,
+		0x66,0x77,0x68,0x08,0x0D,0xF0,0x82,0x3A,0xFF,0x00,0x11,0x22,0x33,0x44,0x55,0x66,
+		0x77,0x88,0x99,0xAA,0xBB,0xCC,0xDD,0xEE,0xFF,0xFF,0xEE,0xDD,0xCC,0xBB,0xAA,0x99,
+		0x88,0x77,0x66,0x55,0x44,0x33,0x22,0x11,0x00,0x86,0x00,0x6E,0xD0,0x40,0x00,0x00,
+		0x1E,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x03,0x04,0x40,0xE0,0x00,0x01,0x51,
+		0x80,0x00,0x00,0x38,0x40,0x00,0x00,0x00,0x00,0xFD,0x00,0x00,0x00,0x00,0x00,0x00,
+		0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,
+	};
+
+	uint8_t orig[256] = {
+		0x60,0x0D,0xF0,0x82,0x00,0x30,0x3A,0xFF,
+		0x00,0x11,0x22,0x33,0x44,0x55,0x66,0x77,
+		0x88,0x99,0xAA,0xBB,0xCC,0xDD,0xEE,0xFF,
+		0xFF,0xEE,0xDD,0xCC,0xBB,0xAA,0x99,0x88,
+		0x77,0x66,0x55,0x44,0x33,0x22,0x11,0x00,
+		0x86,0x00,0x6E,0xD0,0x40,0x00,0x00,0x1E,
+		0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,
+		0x03,0x04,0x40,0xE0,0x00,0x01,0x51,0x80,
+		0x00,0x00,0x38,0x40,0x00,0x00,0x00,0x00,
+		0xFD,0x00,0x00,0x00,0x00,0x00,0x00,0x00,
+		0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,
+	};
+
+	Buffer      segments[2];
+	Buffer      head;
+	Buffer      tail;
+	BufferChain payload;
+	unsigned    split;
+
+	/* The packet's buffer holds the header and the first split - 40 payload bytes. The rest of
+	 * the payload is split across two segments. The frame must match the contiguous packet. */
+	for(split = 40; split <= 48; split += 8)
+	{
+		ipv6_init(&lowpan_packet, orig, split, sizeof(orig));
+		memset(&lowpan_packet.fragments, 0, sizeof(lowpan_packet.fragments));
+
+		head = make_buffer(&orig[split],      13,         13);
+		tail = make_buffer(&orig[split + 13], 75 - split, 75 - split);
+
+		bufferchain_init  (&payload, segments, 2);
+		bufferchain_append(&payload, &head);
+		bufferchain_append(&payload, &tail);
+
+		ieee154_data_frame_init(&lowpan_frame, lowpan_frame_data, sizeof(lowpan_frame_data));
+		ieee154_set_addr(&lowpan_frame, 0, ieee154_dest, 8, 0, ieee154_src, 8);
+
+		EXPECT(lowpan_compress_chain(&lowpan_packet, &payload, &lowpan_frame) == 88);
+		EXPECT(ieee154_length(&lowpan_frame) == sizeof(expected_frame));
+		EXPECT(memcmp(expected_frame, lowpan_frame_data, ieee154_length(&lowpan_frame)) == 0);
+		EXPECT(bufferchain_length(&payload) == 88 - split);
+	}
+}
+
+
 
 // TEST(test_lowpan_compress_small)
 // {
@@ -2447,6 +2504,7 @@ void test_lowpan(void)
 
 	tharness_run(test_lowpan_compress_without_eh);
 	tharness_run(test_lowpan_compress_with_eh);
+	tharness_run(test_lowpan_compress_chain);
 
 	/* Todo: test compression of large packets that require fragmentation */
 
@@ -0,0 +1,233 @@
+/************************************************************************************************//**
+ * @file		test_lrucache.c
+ *
+ * @copyright	Copyright 2022 Kurt Hildebrand.
+ * @license		Licensed under the Apache License, Version 2.0 (the "License"); you may not use this
+ * 				file except in compliance with the License. You may obtain a copy of the License at
+ *
+ * 				http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * 				Unless required by applicable law or agreed to in writing, software distributed under
+ * 				the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF
+ * 				ANY KIND, either express or implied. See the License for the specific language
+ * 				governing permissions and limitations under the License.
+ *
+ ***************************************************************************************************/
+#include <stdlib.h>
+
+#include "test_lrucache.h"
+
+#include "lrucache.h"
+#include "tharness.h"
+#include "utils.h"
+
+
+/* Private Macros -------------------------------------------------------------------------------- */
+#define CAPACITY	(16u)
+#define KEYS		(64u)
+
+
+/* Private Types --------------------------------------------------------------------------------- */
+typedef struct {
+	uint32_t key;
+	LruLink  lru;
+	bool     cached;
+} Entry;
+
+
+/* Private Functions ----------------------------------------------------------------------------- */
+static uint32_t hash_key   (uint32_t);
+static uint32_t hash_entry (const void*);
+static int      compare_key(const void*, const void*);
+static void     on_evict   (void*, LruLink*);
+static Entry*   lookup     (uint32_t);
+
+
+/* Private Variables ----------------------------------------------------------------------------- */
+static Entry    entries[KEYS];
+static Link*    buckets[CAPACITY];
+static LruCache cache;
+static unsigned evicted;
+
+
+TEST(test_lrucache_init)
+{
+	EXPECT(!lrucache_init(&cache, buckets, CAPACITY, 0,        hash_entry, compare_key));
+	EXPECT(!lrucache_init(&cache, buckets, 12,       CAPACITY, hash_entry, compare_key));
+	EXPECT( lrucache_init(&cache, buckets, CAPACITY, CAPACITY, hash_entry, compare_key));
+	lrucache_on_evict(&cache, on_evict, &evicted);
+
+	EXPECT(lrucache_empty(&cache));
+	EXPECT(lrucache_capacity(&cache) == CAPACITY);
+	EXPECT(lrucache_oldest(&cache) == 0);
+	EXPECT(!lrucache_evict(&cache));
+	EXPECT(lookup(1) == 0);
+	EXPECT(lrucache_stats(&cache).misses == 1);
+}
+
+
+TEST(test_lrucache_put)
+{
+	unsigned i;
+	bool     ok = true;
+
+	for(i = 0; i < KEYS; i++)
+	{
+		entries[i].key    = i;
+		entries[i].cached = false;
+	}
+
+	evicted = 0;
+	lrucache_reset_stats(&cache);
+
+	for(i = 0; i < CAPACITY; i++)
+	{
+		ok = lrucache_put(&cache, &entries[i].lru) == &entries[i].lru && ok;
+		entries[i].cached = true;
+	}
+
+	EXPECT(ok);
+	EXPECT(lrucache_full(&cache));
+	EXPECT(evicted == 0);
+	EXPECT(lookup(3) == &entries[3]);
+	EXPECT(lookup(CAPACITY) == 0);
+	EXPECT(lrucache_peek(&cache, hash_key(5), &entries[5].key) == &entries[5].lru);
+	EXPECT(lrucache_stats(&cache).hits   == 1);
+	EXPECT(lrucache_stats(&cache).misses == 1);
+
+	/* 0 is the oldest. 3 was used, so 1, 2 and 4 are evicted next. */
+	EXPECT(lrucache_oldest(&cache) == &entries[0].lru);
+
+	for(i = CAPACITY; i < CAPACITY + 4; i++)
+	{
+		lrucache_put(&cache, &entries[i].lru);
+		entries[i].cached = true;
+	}
+
+	EXPECT(evicted == 4);
+	EXPECT(lrucache_count(&cache) == CAPACITY);
+	EXPECT(!entries[0].cached && !entries[1].cached && !entries[2].cached && !entries[4].cached);
+	EXPECT(entries[3].cached && lookup(3) == &entries[3]);
+	EXPECT(lrucache_oldest(&cache) == &entries[5].lru);
+	EXPECT(lrucache_stats(&cache).evictions == 4);
+}
+
+
+TEST(test_lrucache_remove)
+{
+	EXPECT(lrucache_remove(&cache, &entries[5].lru) == &entries[5].lru);
+	EXPECT(lrucache_count(&cache) == CAPACITY - 1);
+	EXPECT(lookup(5) == 0);
+	EXPECT(evicted == 4);
+	EXPECT(lrucache_oldest(&cache) == &entries[6].lru);
+
+	lrucache_clear(&cache);
+	EXPECT(lrucache_empty(&cache));
+	EXPECT(evicted == 4 + CAPACITY - 1);
+}
+
+
+TEST(test_lrucache_random)
+{
+	unsigned stamp[KEYS] = { 0 };
+	unsigned now = 0;
+	unsigned hits = 0;
+	unsigned i, k;
+	bool     ok = true;
+
+	/* Compare against a model which evicts the key with the oldest use stamp */
+	lrucache_init(&cache, buckets, CAPACITY, CAPACITY, hash_entry, compare_key);
+	lrucache_on_evict(&cache, on_evict, &evicted);
+
+	for(k = 0; k < KEYS; k++)
+	{
+		entries[k].cached = false;
+	}
+
+	for(i = 0; i < 20000; i++)
+	{
+		uint32_t key = rand() % (rand() % 4 ? CAPACITY + 4 : KEYS);
+
+		now++;
+
+		if(lookup(key))
+		{
+			ok = entries[key].cached && ok;
+			hits++;
+		}
+		else
+		{
+			unsigned oldest = KEYS;
+
+			ok = !entries[key].cached && ok;
+
+			for(k = 0; k < KEYS; k++)
+			{
+				if(entries[k].cached && (oldest == KEYS || stamp[k] < stamp[oldest]))
+				{
+					oldest = k;
+				}
+			}
+
+			if(lrucache_full(&cache))
+			{
+				ok = lrucache_oldest(&cache) == &entries[oldest].lru && ok;
+			}
+
+			lrucache_put(&cache, &entries[key].lru);
+			entries[key].cached = true;
+		}
+
+		stamp[key] = now;
+	}
+
+	EXPECT(ok);
+	EXPECT(lrucache_stats(&cache).hits == hits);
+	EXPECT(lrucache_stats(&cache).misses == 20000 - hits);
+	EXPECT(lrucache_stats(&cache).evictions == 20000 - hits - CAPACITY);
+}
+
+
+void test_lrucache(void)
+{
+	tharness_run(test_lrucache_init);
+	tharness_run(test_lrucache_put);
+	tharness_run(test_lrucache_remove);
+	tharness_run(test_lrucache_random);
+}
+
+
+static uint32_t hash_key(uint32_t key)
+{
+	return key * 0x9E3779B1u;
+}
+
+
+static uint32_t hash_entry(const void* a)
+{
+	return hash_key(CONTAINER_OF(a, Entry, lru)->key);
+}
+
+
+static int compare_key(const void* key, const void* b)
+{
+	return compare_u32(key, &CONTAINER_OF(b, Entry, lru)->key);
+}
+
+
+static void on_evict(void* arg, LruLink* lru)
+{
+	CONTAINER_OF(lru, Entry, lru)->cached = false;
+	(*(unsigned*)arg)++;
+}
+
+
+static Entry* lookup(uint32_t key)
+{
+	LruLink* lru = lrucache_get(&cache, hash_key(key), &key);
+
+	return lru ? CONTAINER_OF(lru, Entry, lru) : 0;
+}
+
+
+/******************************************* END OF FILE *******************************************/
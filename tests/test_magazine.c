@@ -0,0 +1,196 @@
+/************************************************************************************************//**
+ * @file		test_magazine.c
+ *
+ * @copyright	Copyright 2022 Kurt Hildebrand.
+ * @license		Licensed under the Apache License, Version 2.0 (the "License"); you may not use this
+ * 				file except in compliance with the License. You may obtain a copy of the License at
+ *
+ * 				http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * 				Unless required by applicable law or agreed to in writing, software distributed under
+ * 				the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF
+ * 				ANY KIND, either express or implied. See the License for the specific language
+ * 				governing permissions and limitations under the License.
+ *
+ ***************************************************************************************************/
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "test_magazine.h"
+
+#include "magazine.h"
+#include "tharness.h"
+
+
+/* Private Macros -------------------------------------------------------------------------------- */
+#define MAG_POOL_SIZE		(256)
+#define MAG_THREADS			(4)
+#define MAG_ROUNDS			(20000)
+
+
+/* Private Variables ----------------------------------------------------------------------------- */
+static int              mag_data[MAG_POOL_SIZE];
+static _Atomic uint64_t mag_bitmap[POOL_BITMAP_WORDS(MAG_POOL_SIZE)];
+static Pool             mag_pool;
+static bool             mag_ok[MAG_THREADS];
+static unsigned         mag_hits[MAG_THREADS];
+static unsigned         mag_batches[MAG_THREADS];
+
+
+TEST(test_pool_many)
+{
+	void*    ptrs[MAG_POOL_SIZE];
+	unsigned i;
+
+	pool_init_bitmap(&mag_pool, make_range(mag_data, MAG_POOL_SIZE, sizeof(mag_data[0])), mag_bitmap);
+
+	/* Reserves cross leaf words */
+	EXPECT(pool_reserve_many(&mag_pool, ptrs, 100) == 100);
+	EXPECT(pool_reserve_many(&mag_pool, &ptrs[100], 200) == MAG_POOL_SIZE - 100);
+	EXPECT(pool_full(&mag_pool));
+
+	for(i = 0; i < MAG_POOL_SIZE; i++)
+	{
+		EXPECT(ptrs[i] == &mag_data[i]);
+	}
+
+	EXPECT(pool_release_many(&mag_pool, &ptrs[10], 90) == 90);
+	EXPECT(pool_release_many(&mag_pool, &ptrs[10], 90) == 0);
+	EXPECT(pool_free(&mag_pool) == 90);
+	EXPECT(pool_idx_is_reserved(&mag_pool, 9));
+	EXPECT(pool_idx_is_reserved(&mag_pool, 10) == false);
+	EXPECT(pool_release_many(&mag_pool, ptrs, MAG_POOL_SIZE) == MAG_POOL_SIZE - 90);
+	EXPECT(pool_empty(&mag_pool));
+}
+
+
+TEST(test_magazine_basic)
+{
+	Magazine m;
+	void*    ptrs[MAG_POOL_SIZE];
+	unsigned i;
+
+	pool_init_bitmap(&mag_pool, make_range(mag_data, MAG_POOL_SIZE, sizeof(mag_data[0])), mag_bitmap);
+	magazine_init(&m, &mag_pool);
+
+	/* The first reserve refills half a magazine */
+	ptrs[0] = magazine_reserve(&m);
+	EXPECT(ptrs[0] != 0);
+	EXPECT(m.refills == 1);
+	EXPECT(magazine_count(&m) == MAGAZINE_SIZE / 2 - 1);
+	EXPECT(pool_count(&mag_pool) == MAGAZINE_SIZE / 2);
+
+	/* Released entries are reused first */
+	EXPECT(magazine_release(&m, ptrs[0]));
+	EXPECT(magazine_reserve(&m) == ptrs[0]);
+	EXPECT(magazine_release(&m, ptrs[0]));
+	EXPECT(magazine_release(&m, &i) == false);
+
+	/* Drain the pool through the magazine */
+	for(i = 0; i < MAG_POOL_SIZE; i++)
+	{
+		ptrs[i] = magazine_reserve(&m);
+		EXPECT(ptrs[i] != 0);
+	}
+
+	EXPECT(magazine_reserve(&m) == 0);
+	EXPECT(pool_full(&mag_pool));
+	EXPECT(m.refills == MAG_POOL_SIZE / (MAGAZINE_SIZE / 2));
+
+	/* Release everything. Full magazines flush half back to the pool. */
+	for(i = 0; i < MAG_POOL_SIZE; i++)
+	{
+		EXPECT(magazine_release(&m, ptrs[i]));
+	}
+
+	EXPECT(magazine_count(&m) <= MAGAZINE_SIZE);
+	EXPECT(m.flushes == (MAG_POOL_SIZE - MAGAZINE_SIZE) / (MAGAZINE_SIZE / 2));
+	EXPECT(pool_count(&mag_pool) == magazine_count(&m));
+
+	magazine_drain(&m);
+	EXPECT(magazine_count(&m) == 0);
+	EXPECT(pool_empty(&mag_pool));
+	PRINT_LINE("hits %u refills %u flushes %u", m.hits, m.refills, m.flushes);
+}
+
+
+static void* magazine_thread(void* arg)
+{
+	static _Thread_local Magazine mag;
+
+	intptr_t id = (intptr_t)arg;
+	int*     held[8];
+	unsigned i;
+	unsigned j;
+
+	magazine_init(&mag, &mag_pool);
+	mag_ok[id] = true;
+
+	for(i = 0; i < MAG_ROUNDS; i++)
+	{
+		for(j = 0; j < 8; j++)
+		{
+			while((held[j] = magazine_reserve(&mag)) == 0)
+			{
+				sched_yield();
+			}
+
+			*held[j] = (int)id;
+		}
+
+		for(j = 0; j < 8; j++)
+		{
+			if(*held[j] != (int)id || !magazine_release(&mag, held[j]))
+			{
+				mag_ok[id] = false;
+			}
+		}
+	}
+
+	magazine_drain(&mag);
+	mag_hits[id]    = mag.hits;
+	mag_batches[id] = mag.refills + mag.flushes;
+	return 0;
+}
+
+
+TEST(test_magazine_threaded)
+{
+	pthread_t threads[MAG_THREADS];
+	intptr_t  i;
+	intptr_t  created;
+
+	pool_init_bitmap(&mag_pool, make_range(mag_data, MAG_POOL_SIZE, sizeof(mag_data[0])), mag_bitmap);
+
+	for(created = 0; created < MAG_THREADS; created++)
+	{
+		if(pthread_create(&threads[created], 0, magazine_thread, (void*)created) != 0)
+		{
+			break;
+		}
+	}
+
+	EXPECT(created == MAG_THREADS);
+
+	for(i = 0; i < created; i++)
+	{
+		pthread_join(threads[i], 0);
+		EXPECT(mag_ok[i]);
+		PRINT_LINE("thread %d: hits %u batches %u", (int)i, mag_hits[i], mag_batches[i]);
+	}
+
+	EXPECT(pool_empty(&mag_pool));
+}
+
+
+void test_magazine(void)
+{
+	tharness_run(test_pool_many);
+	tharness_run(test_magazine_basic);
+	tharness_run(test_magazine_threaded);
+}
+
+
+/******************************************* END OF FILE *******************************************/
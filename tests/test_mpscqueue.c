@@ -0,0 +1,224 @@
+/************************************************************************************************//**
+ * @file		test_mpscqueue.c
+ *
+ * @copyright	Copyright 2022 Kurt Hildebrand.
+ * @license		Licensed under the Apache License, Version 2.0 (the "License"); you may not use this
+ * 				file except in compliance with the License. You may obtain a copy of the License at
+ *
+ * 				http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * 				Unless required by applicable law or agreed to in writing, software distributed under
+ * 				the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF
+ * 				ANY KIND, either express or implied. See the License for the specific language
+ * 				governing permissions and limitations under the License.
+ *
+ ***************************************************************************************************/
+#include <pthread.h>
+#include <sched.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "test_mpscqueue.h"
+
+#include "mpscqueue.h"
+#include "tharness.h"
+#include "utils.h"
+
+
+/* Private Macros -------------------------------------------------------------------------------- */
+#define MPSC_PRODUCERS	(4u)
+#define MPSC_COUNT		(20000u)
+#define MPSC_BURST		(32u)
+
+
+/* Private Types --------------------------------------------------------------------------------- */
+typedef struct {
+	unsigned producer;
+	unsigned seq;
+	MpscLink link;
+} Event;
+
+
+/* Private Variables ----------------------------------------------------------------------------- */
+static MpscQueue     queue;
+static Event         events[MPSC_PRODUCERS][MPSC_COUNT];
+static unsigned char seen[MPSC_PRODUCERS][MPSC_COUNT];
+
+
+TEST(test_mpscqueue_push)
+{
+	MpscLink* node;
+	unsigned  i;
+	bool      ok = true;
+
+	mpscqueue_init(&queue);
+	EXPECT(mpscqueue_empty(&queue));
+	EXPECT(mpscqueue_pop(&queue) == 0);
+
+	for(i = 0; i < 10; i++)
+	{
+		events[0][i].seq = i;
+		mpscqueue_push(&queue, &events[0][i].link);
+	}
+
+	EXPECT(!mpscqueue_empty(&queue));
+
+	for(i = 0; i < 10; i++)
+	{
+		node = mpscqueue_pop(&queue);
+		ok   = node && CONTAINER_OF(node, Event, link)->seq == i && ok;
+	}
+
+	EXPECT(ok);
+	EXPECT(mpscqueue_empty(&queue));
+	EXPECT(mpscqueue_pop(&queue) == 0);
+}
+
+
+TEST(test_mpscqueue_refill)
+{
+	MpscLink* node;
+	unsigned  i;
+	bool      ok = true;
+
+	/* Drain the queue completely between pushes so the stub is reinserted every time */
+	mpscqueue_init(&queue);
+
+	for(i = 0; i < 100; i++)
+	{
+		mpscqueue_push(&queue, &events[0][i % 2].link);
+		node = mpscqueue_pop(&queue);
+		ok   = node == &events[0][i % 2].link && mpscqueue_pop(&queue) == 0 && ok;
+		ok   = mpscqueue_empty(&queue) && ok;
+	}
+
+	EXPECT(ok);
+
+	/* Interleave pushes and pops so the consumer repeatedly reaches the most recent node */
+	for(i = 0; i < 100; i++)
+	{
+		mpscqueue_push(&queue, &events[0][(2 * i) % 10].link);
+		mpscqueue_push(&queue, &events[0][(2 * i + 1) % 10].link);
+		ok = mpscqueue_pop(&queue) == &events[0][(2 * i) % 10].link && ok;
+		ok = mpscqueue_pop(&queue) == &events[0][(2 * i + 1) % 10].link && ok;
+	}
+
+	EXPECT(ok);
+	EXPECT(mpscqueue_empty(&queue));
+}
+
+
+TEST(test_mpscqueue_pop_many)
+{
+	MpscLink* nodes[8];
+	unsigned  i;
+
+	mpscqueue_init(&queue);
+	EXPECT(mpscqueue_pop_many(&queue, nodes, 8) == 0);
+
+	for(i = 0; i < 12; i++)
+	{
+		events[0][i].seq = i;
+		mpscqueue_push(&queue, &events[0][i].link);
+	}
+
+	EXPECT(mpscqueue_pop_many(&queue, nodes, 8) == 8);
+	EXPECT(CONTAINER_OF(nodes[0], Event, link)->seq == 0);
+	EXPECT(CONTAINER_OF(nodes[7], Event, link)->seq == 7);
+	EXPECT(mpscqueue_pop_many(&queue, nodes, 8) == 4);
+	EXPECT(CONTAINER_OF(nodes[0], Event, link)->seq == 8);
+	EXPECT(CONTAINER_OF(nodes[3], Event, link)->seq == 11);
+	EXPECT(mpscqueue_empty(&queue));
+}
+
+
+static void* mpsc_producer(void* arg)
+{
+	uintptr_t id = (uintptr_t)arg;
+	unsigned  i;
+
+	for(i = 0; i < MPSC_COUNT; i++)
+	{
+		events[id][i].producer = id;
+		events[id][i].seq      = i;
+		mpscqueue_push(&queue, &events[id][i].link);
+	}
+
+	return 0;
+}
+
+
+TEST(test_mpscqueue_producers)
+{
+	pthread_t threads[MPSC_PRODUCERS];
+	unsigned  last[MPSC_PRODUCERS];
+	unsigned  removed    = 0;
+	unsigned  misordered = 0;
+	bool      exactly_once = true;
+	uintptr_t i, j;
+	uintptr_t created;
+
+	mpscqueue_init(&queue);
+	memset(seen, 0, sizeof(seen));
+
+	for(created = 0; created < MPSC_PRODUCERS; created++)
+	{
+		last[created] = -1u;
+		if(pthread_create(&threads[created], 0, mpsc_producer, (void*)created) != 0)
+		{
+			break;
+		}
+	}
+
+	EXPECT(created == MPSC_PRODUCERS);
+
+	/* Each producer's events must arrive in the order they were pushed */
+	while(removed < created * MPSC_COUNT)
+	{
+		MpscLink* burst[MPSC_BURST];
+		unsigned  count = mpscqueue_pop_many(&queue, burst, MPSC_BURST);
+
+		for(j = 0; j < count; j++)
+		{
+			Event* e = CONTAINER_OF(burst[j], Event, link);
+
+			misordered += (last[e->producer] != -1u && e->seq <= last[e->producer]);
+			last[e->producer] = e->seq;
+			seen[e->producer][e->seq]++;
+		}
+
+		removed += count;
+
+		if(count == 0)
+		{
+			sched_yield();
+		}
+	}
+
+	for(i = 0; i < created; i++)
+	{
+		pthread_join(threads[i], 0);
+
+		for(j = 0; j < MPSC_COUNT; j++)
+		{
+			exactly_once &= (seen[i][j] == 1);
+		}
+	}
+
+	EXPECT(exactly_once);
+	EXPECT(misordered == 0);
+	EXPECT(mpscqueue_empty(&queue));
+	EXPECT(mpscqueue_pop(&queue) == 0);
+}
+
+
+void test_mpscqueue(void)
+{
+	tharness_run(test_mpscqueue_push);
+	tharness_run(test_mpscqueue_refill);
+	tharness_run(test_mpscqueue_pop_many);
+	tharness_run(test_mpscqueue_producers);
+}
+
+
+/******************************************* END OF FILE *******************************************/
@@ -0,0 +1,136 @@
+/************************************************************************************************//**
+ * @file		test_packetpool.c
+ *
+ * @copyright	Copyright 2022 Kurt Hildebrand.
+ * @license		Licensed under the Apache License, Version 2.0 (the "License"); you may not use this
+ * 				file except in compliance with the License. You may obtain a copy of the License at
+ *
+ * 				http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * 				Unless required by applicable law or agreed to in writing, software distributed under
+ * 				the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF
+ * 				ANY KIND, either express or implied. See the License for the specific language
+ * 				governing permissions and limitations under the License.
+ *
+ ***************************************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "test_packetpool.h"
+
+#include "ipv6.h"
+#include "packetpool.h"
+#include "tharness.h"
+
+
+/* Private Macros -------------------------------------------------------------------------------- */
+#define PKT_COUNT		(4)
+#define PKT_SIZE		(IPV6_MTU + 64)
+#define PKT_HEADROOM	(64)
+
+
+/* Private Variables ----------------------------------------------------------------------------- */
+static _Alignas(max_align_t) uint8_t pkt_mem[PKT_COUNT][PKTPOOL_ELEMSIZE(PKT_SIZE)];
+static PacketPool pkt_pool;
+
+
+TEST(test_packetpool_alloc)
+{
+	Buffer   bufs[PKT_COUNT + 1];
+	unsigned i;
+
+	EXPECT(pktpool_init(&pkt_pool, pkt_mem, PKT_COUNT, PKT_SIZE, PKT_SIZE + 1, 0) == false);
+	EXPECT(pktpool_init(&pkt_pool, pkt_mem, PKT_COUNT, PKT_SIZE, PKT_HEADROOM, 0));
+	EXPECT(pktpool_free(&pkt_pool) == PKT_COUNT);
+
+	for(i = 0; i < PKT_COUNT; i++)
+	{
+		EXPECT(pkt_alloc(&pkt_pool, &bufs[i]));
+		EXPECT(pkt_refs(&pkt_pool, &bufs[i]) == 1);
+		EXPECT(pkt_headroom(&pkt_pool, &bufs[i]) == PKT_HEADROOM);
+		EXPECT(pkt_tailroom(&bufs[i]) >= PKT_SIZE - PKT_HEADROOM);
+		EXPECT(buffer_length(&bufs[i]) == 0);
+	}
+
+	EXPECT(pkt_alloc(&pkt_pool, &bufs[PKT_COUNT]) == false);
+
+	for(i = 0; i < PKT_COUNT; i++)
+	{
+		EXPECT(pkt_free(&pkt_pool, &bufs[i]));
+	}
+
+	EXPECT(pktpool_count(&pkt_pool) == 0);
+}
+
+
+TEST(test_packetpool_clone)
+{
+	Buffer a;
+	Buffer b;
+	Buffer c;
+
+	pktpool_init(&pkt_pool, pkt_mem, PKT_COUNT, PKT_SIZE, PKT_HEADROOM, 0);
+
+	EXPECT(pkt_alloc(&pkt_pool, &a));
+	EXPECT(buffer_push_mem(&a, "payload", 7));
+
+	EXPECT(pkt_clone(&pkt_pool, &b, &a));
+	EXPECT(pkt_clone(&pkt_pool, &c, &b));
+	EXPECT(pkt_refs(&pkt_pool, &a) == 3);
+	EXPECT(buffer_start(&b) == buffer_start(&a));
+	EXPECT(memcmp(buffer_start(&c), "payload", 7) == 0);
+
+	/* Clones read independently */
+	EXPECT(buffer_pop(&b, 3) != 0);
+	EXPECT(buffer_remaining(&a) == 7);
+
+	EXPECT(pkt_free(&pkt_pool, &a) == false);
+	EXPECT(pkt_free(&pkt_pool, &b) == false);
+	EXPECT(pktpool_count(&pkt_pool) == 1);
+	EXPECT(pkt_free(&pkt_pool, &c) == true);
+	EXPECT(pktpool_count(&pkt_pool) == 0);
+
+	/* Freeing a buffer that is not from the pool does nothing */
+	uint8_t data[4];
+	buffer_init(&a, data, 0, sizeof(data));
+	EXPECT(pkt_clone(&pkt_pool, &b, &a) == false);
+	EXPECT(pkt_free(&pkt_pool, &a) == false);
+}
+
+
+TEST(test_packetpool_prepend)
+{
+	IPPacket pkt;
+	Buffer   b;
+	uint8_t* payload;
+	uint8_t* hdr;
+
+	pktpool_init(&pkt_pool, pkt_mem, PKT_COUNT, PKT_SIZE, PKT_HEADROOM, 0);
+
+	/* Build the packet payload first, then prepend the IPv6 header in place */
+	EXPECT(pkt_alloc(&pkt_pool, &b));
+	EXPECT(ipv6_init(&pkt, buffer_start(&b), 0, buffer_size(&b)));
+	EXPECT(buffer_push_mem(&pkt.buffer, "data", 4));
+	payload = buffer_start(&pkt.buffer);
+
+	hdr = pkt_prepend(&pkt_pool, &pkt.buffer, IPV6_HDR_LENGTH);
+	EXPECT(hdr == payload - IPV6_HDR_LENGTH);
+	EXPECT(buffer_length(&pkt.buffer) == IPV6_HDR_LENGTH + 4);
+	EXPECT(memcmp(hdr + IPV6_HDR_LENGTH, "data", 4) == 0);
+	EXPECT(pkt_headroom(&pkt_pool, &pkt.buffer) == PKT_HEADROOM - IPV6_HDR_LENGTH);
+	EXPECT(pkt_prepend(&pkt_pool, &pkt.buffer, PKT_HEADROOM) == 0);
+
+	EXPECT(pkt_free(&pkt_pool, &pkt.buffer));
+	EXPECT(pktpool_count(&pkt_pool) == 0);
+}
+
+
+void test_packetpool(void)
+{
+	tharness_run(test_packetpool_alloc);
+	tharness_run(test_packetpool_clone);
+	tharness_run(test_packetpool_prepend);
+}
+
+
+/******************************************* END OF FILE *******************************************/
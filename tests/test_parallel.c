@@ -0,0 +1,246 @@
+/************************************************************************************************//**
+ * @file		test_parallel.c
+ *
+ * @copyright	Copyright 2022 Kurt Hildebrand.
+ * @license		Licensed under the Apache License, Version 2.0 (the "License"); you may not use this
+ * 				file except in compliance with the License. You may obtain a copy of the License at
+ *
+ * 				http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * 				Unless required by applicable law or agreed to in writing, software distributed under
+ * 				the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF
+ * 				ANY KIND, either express or implied. See the License for the specific language
+ * 				governing permissions and limitations under the License.
+ *
+ ***************************************************************************************************/
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "test_parallel.h"
+
+#include "parallel.h"
+#include "scheduler.h"
+#include "tharness.h"
+
+
+/* Private Macros -------------------------------------------------------------------------------- */
+#define PARALLEL_WORKERS	(4)
+#define PARALLEL_SIZE		(100000)
+
+
+/* Private Types --------------------------------------------------------------------------------- */
+typedef struct {
+	double   sum;
+	uint64_t count;
+} ParallelStats;
+
+
+/* Private Variables ----------------------------------------------------------------------------- */
+static Scheduler        parallel_sched;
+static _Atomic unsigned parallel_misaligned;
+static bool             parallel_ready;
+static float            parallel_in[PARALLEL_SIZE];
+static float            parallel_out[PARALLEL_SIZE];
+static uint8_t          parallel_small[100];
+
+
+static void parallel_scale(void* arg, void* out, const void* in)
+{
+	*(float*)out = *(const float*)in * *(const float*)arg;
+}
+
+
+static void parallel_sum(void* arg, void* acc, const void* elem)
+{
+	(void)arg;
+	*(float*)acc += *(const float*)elem;
+}
+
+
+static void parallel_add(void* arg, void* acc, const void* partial)
+{
+	(void)arg;
+	*(float*)acc += *(const float*)partial;
+}
+
+
+static void parallel_stats(void* arg, void* acc, const void* elem)
+{
+	ParallelStats* stats = acc;
+
+	(void)arg;
+	if((uintptr_t)acc % _Alignof(ParallelStats) != 0)
+	{
+		parallel_misaligned++;
+	}
+
+	stats->sum += *(const float*)elem;
+	stats->count++;
+}
+
+
+static void parallel_merge(void* arg, void* acc, const void* partial)
+{
+	ParallelStats*       stats = acc;
+	const ParallelStats* other = partial;
+
+	(void)arg;
+	stats->sum   += other->sum;
+	stats->count += other->count;
+}
+
+
+static void parallel_fill(void* arg, const Range* chunk)
+{
+	unsigned i;
+
+	for(i = range_start(chunk); i < range_end(chunk); i++)
+	{
+		*(float*)range_at(chunk, i) = (float)(uintptr_t)arg;
+	}
+}
+
+
+static void parallel_count(void* arg, const Range* chunk)
+{
+	*(unsigned*)arg += range_count(chunk);
+}
+
+
+TEST(test_parallel_init)
+{
+	parallel_ready = scheduler_init(&parallel_sched, PARALLEL_WORKERS);
+	EXPECT(parallel_ready);
+}
+
+
+TEST(test_parallel_chunk)
+{
+	Range r = make_range(parallel_in, PARALLEL_SIZE, sizeof(float));
+	Range s = make_range(parallel_small, sizeof(parallel_small), 1);
+	Range t = make_range(parallel_in, PARALLEL_SIZE, 12);
+	unsigned count = 0;
+
+	EXPECT(range_parallel_chunk(&s) == sizeof(parallel_small));
+	EXPECT((range_parallel_chunk(&r) * sizeof(float)) % CACHE_LINE_SIZE == 0);
+	EXPECT((range_parallel_chunk(&t) * 12) % CACHE_LINE_SIZE == 0);
+	EXPECT((PARALLEL_SIZE + range_parallel_chunk(&r) - 1) / range_parallel_chunk(&r) <=
+		RANGE_PARALLEL_CHUNKS);
+
+	/* Small ranges run as one chunk on the calling thread */
+	range_parallel_for(&parallel_sched, &s, parallel_count, &count);
+	EXPECT(count == sizeof(parallel_small));
+}
+
+
+TEST(test_parallel_for)
+{
+	Range    r   = make_range(parallel_in, PARALLEL_SIZE, sizeof(float));
+	unsigned bad = 0;
+	unsigned i;
+
+	range_parallel_for(&parallel_sched, &r, parallel_fill, (void*)(uintptr_t)3);
+
+	for(i = 0; i < PARALLEL_SIZE; i++)
+	{
+		bad += parallel_in[i] != 3.0f;
+	}
+
+	EXPECT(bad == 0);
+}
+
+
+TEST(test_parallel_transform)
+{
+	Range    in    = make_range(parallel_in,  PARALLEL_SIZE, sizeof(float));
+	Range    out   = make_range(parallel_out, PARALLEL_SIZE, sizeof(float));
+	Range    short_out = make_range(parallel_out, 10, sizeof(float));
+	float    scale = 2.0f;
+	unsigned bad   = 0;
+	unsigned i;
+
+	for(i = 0; i < PARALLEL_SIZE; i++)
+	{
+		parallel_in[i] = (float)i;
+	}
+
+	EXPECT(range_parallel_transform(
+		&parallel_sched, &short_out, &in, parallel_scale, &scale) == false);
+	EXPECT(range_parallel_transform(&parallel_sched, &out, &in, parallel_scale, &scale));
+
+	for(i = 0; i < PARALLEL_SIZE; i++)
+	{
+		bad += parallel_out[i] != 2.0f * i;
+	}
+
+	EXPECT(bad == 0);
+}
+
+
+TEST(test_parallel_reduce)
+{
+	Range    r = make_range(parallel_in, PARALLEL_SIZE, sizeof(float));
+	float    serial   = 0;
+	float    parallel = 0;
+	uint8_t  big[RANGE_PARALLEL_ACC_SIZE + 1];
+	unsigned i;
+
+	/* Values chosen so that the float sum depends on the order of additions */
+	for(i = 0; i < PARALLEL_SIZE; i++)
+	{
+		parallel_in[i] = 1.0f / (float)(i + 1) + (i % 7) * 1000.0f;
+	}
+
+	EXPECT(range_parallel_reduce(0, &r, &serial, sizeof(float), parallel_sum, parallel_add, 0));
+	EXPECT(range_parallel_reduce(
+		&parallel_sched, &r, &parallel, sizeof(float), parallel_sum, parallel_add, 0));
+
+	/* Bit identical regardless of scheduling */
+	EXPECT(serial == parallel);
+	PRINT_LINE("sum = %f", serial);
+
+	EXPECT(range_parallel_reduce(0, &r, big, sizeof(big), parallel_sum, parallel_add, 0) == false);
+}
+
+
+TEST(test_parallel_reduce_wide)
+{
+	Range         r     = make_range(parallel_in, PARALLEL_SIZE, sizeof(float));
+	ParallelStats stats = { 0, 0 };
+	unsigned      i;
+
+	/* Whole numbers so the double sum is exact in any order */
+	for(i = 0; i < PARALLEL_SIZE; i++)
+	{
+		parallel_in[i] = (float)(i % 1000);
+	}
+
+	parallel_misaligned = 0;
+	EXPECT(range_parallel_reduce(
+		&parallel_sched, &r, &stats, sizeof(stats), parallel_stats, parallel_merge, 0));
+	EXPECT(stats.count == PARALLEL_SIZE);
+	EXPECT(stats.sum == (double)(PARALLEL_SIZE / 1000) * (999.0 * 1000.0 / 2.0));
+	EXPECT(parallel_misaligned == 0);
+}
+
+
+void test_parallel(void)
+{
+	tharness_run(test_parallel_init);
+	if(!parallel_ready)
+	{
+		return;
+	}
+
+	tharness_run(test_parallel_chunk);
+	tharness_run(test_parallel_for);
+	tharness_run(test_parallel_transform);
+	tharness_run(test_parallel_reduce);
+	tharness_run(test_parallel_reduce_wide);
+
+	scheduler_deinit(&parallel_sched);
+}
+
+
+/******************************************* END OF FILE *******************************************/
@@ -13,6 +13,8 @@
  * 				governing permissions and limitations under the License.
  *
  ***************************************************************************************************/
+#include <pthread.h>
+#include <sched.h>
 #include <stdio.h>
 #include <stdlib.h>
 
@@ -41,6 +43,16 @@ int  pool_data[10];
 Pool pool;
 int* ptrs[10];
 
+#define LARGE_POOL_SIZE		(5000)
+#define STRESS_THREADS		(4)
+#define STRESS_ROUNDS		(2000)
+
+int              large_data[LARGE_POOL_SIZE];
+_Atomic uint64_t large_bitmap[POOL_BITMAP_WORDS(LARGE_POOL_SIZE)];
+Pool             large_pool;
+int*             large_ptrs[LARGE_POOL_SIZE];
+bool             stress_ok[STRESS_THREADS];
+
 
 TEST(test_pool_reserve)
 {
@@ -132,12 +144,140 @@ TEST(test_pool_release)
 }
 
 
+TEST(test_pool_init)
+{
+	int  data[65];
+	Pool p;
+
+	EXPECT(pool_init(&p, data, 0,  sizeof(data[0])) == false);
+	EXPECT(pool_init(&p, data, 65, sizeof(data[0])) == false);
+	EXPECT(pool_init(&p, data, 64, sizeof(data[0])) == true);
+	EXPECT(pool_free(&p) == 64);
+	EXPECT(pool_size(&p) == 64);
+}
+
+
+TEST(test_pool_large)
+{
+	unsigned i;
+
+	EXPECT(pool_init_bitmap(&large_pool,
+		make_range(large_data, LARGE_POOL_SIZE, sizeof(large_data[0])), large_bitmap));
+	EXPECT(pool_free(&large_pool) == LARGE_POOL_SIZE);
+
+	/* Entries are handed out in order */
+	for(i = 0; i < LARGE_POOL_SIZE; i++)
+	{
+		large_ptrs[i] = pool_reserve(&large_pool);
+
+		if(large_ptrs[i] != &large_data[i])
+		{
+			EXPECT(large_ptrs[i] == &large_data[i]);
+			return;
+		}
+	}
+
+	EXPECT(pool_full(&large_pool));
+	EXPECT(pool_reserve(&large_pool) == 0);
+
+	/* Release an entry near the end and check it is found again */
+	EXPECT(pool_release(&large_pool, large_ptrs[4321]));
+	EXPECT(pool_release(&large_pool, large_ptrs[4321]) == false);
+	EXPECT(pool_idx_is_reserved(&large_pool, 4321) == false);
+	EXPECT(pool_reserve(&large_pool) == &large_data[4321]);
+
+	/* Release every other entry */
+	for(i = 0; i < LARGE_POOL_SIZE; i += 2)
+	{
+		EXPECT(pool_release(&large_pool, large_ptrs[i]));
+	}
+
+	EXPECT(pool_free(&large_pool) == LARGE_POOL_SIZE / 2);
+	EXPECT(pool_reserve(&large_pool) == &large_data[0]);
+
+	pool_clear(&large_pool);
+	EXPECT(pool_empty(&large_pool));
+	EXPECT(pool_release(&large_pool, &large_data[LARGE_POOL_SIZE-1]) == false);
+}
+
+
+static void* pool_stress_thread(void* arg)
+{
+	unsigned i;
+	unsigned held = 0;
+	int*     mine[64];
+	intptr_t id   = (intptr_t)arg;
+
+	stress_ok[id] = true;
+
+	for(i = 0; i < STRESS_ROUNDS; i++)
+	{
+		/* Reserve a burst of entries, tag them, and check nobody else holds them */
+		for(held = 0; held < 64; held++)
+		{
+			mine[held] = pool_reserve(&large_pool);
+
+			if(mine[held] == 0)
+			{
+				sched_yield();
+				break;
+			}
+
+			*mine[held] = (int)id;
+		}
+
+		while(held)
+		{
+			held--;
+
+			if(*mine[held] != (int)id || !pool_release(&large_pool, mine[held]))
+			{
+				stress_ok[id] = false;
+			}
+		}
+	}
+
+	return 0;
+}
+
+
+TEST(test_pool_threaded)
+{
+	pthread_t threads[STRESS_THREADS];
+	intptr_t  i;
+	intptr_t  created;
+
+	pool_init_bitmap(&large_pool, make_range(large_data, 200, sizeof(large_data[0])), large_bitmap);
+
+	for(created = 0; created < STRESS_THREADS; created++)
+	{
+		if(pthread_create(&threads[created], 0, pool_stress_thread, (void*)created) != 0)
+		{
+			break;
+		}
+	}
+
+	EXPECT(created == STRESS_THREADS);
+
+	for(i = 0; i < created; i++)
+	{
+		pthread_join(threads[i], 0);
+		EXPECT(stress_ok[i]);
+	}
+
+	EXPECT(pool_empty(&large_pool));
+}
+
+
 void test_pool(void)
 {
 	pool_init(&pool, pool_data, sizeof(pool_data) / sizeof(pool_data[0]), sizeof(pool_data[0]));
 
 	tharness_run(test_pool_reserve);
 	tharness_run(test_pool_release);
+	tharness_run(test_pool_init);
+	tharness_run(test_pool_large);
+	tharness_run(test_pool_threaded);
 }
 
 
@@ -162,21 +302,19 @@ static void show_pool(const Pool* p)
 {
 	unsigned i;
 
-	uint32_t freemask = p->freemask;
-
 	for(i = 0; i < sizeof(pool_data) / sizeof(pool_data[0]); i++)
 	{
 		int* ptr = pool_entry(p, i);
 
 		PRINT("%d: ", i);
 
-		if(freemask & (1 << i))
+		if(pool_idx_is_reserved(p, i))
 		{
-			PRINT("1");
+			PRINT("0");
 		}
 		else
 		{
-			PRINT("0");
+			PRINT("1");
 		}
 
 		PRINT(" %d\n", *ptr);
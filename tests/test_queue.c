@@ -13,25 +13,30 @@
  * 				governing permissions and limitations under the License.
  *
  ***************************************************************************************************/
+#include <pthread.h>
+#include <sched.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <time.h>
 
 #include "tharness.h"
 
+#include "futex.h"
 #include "queue.h"
 
 
 /* Private Functions ----------------------------------------------------------------------------- */
-static void* _Atomic ptrs[32];
-static int   data[32];
-static Queue queue;
+static QueueSlot slots[32];
+static int       data[32];
+static Queue     queue;
 
 
 TEST(test_queue_push)
 {
 	int i;
 
-	queue_init(&queue, ptrs, sizeof(ptrs) / sizeof(ptrs[0]));
+	queue_init(&queue, slots, sizeof(slots) / sizeof(slots[0]));
 
 	/* Enqueue 10 items */
 	for(i = 0; i < 10; i++)
@@ -92,11 +97,316 @@ TEST(test_queue_pop)
 }
 
 
+TEST(test_queue_many)
+{
+	int* in[40];
+	int* out[40];
+	unsigned i;
+
+	queue_init(&queue, slots, sizeof(slots) / sizeof(slots[0]));
+
+	for(i = 0; i < 40; i++)
+	{
+		data[i % 32] = i;
+		in[i] = &data[i % 32];
+	}
+
+	/* Move the indices so that the next batch wraps around the end of the queue */
+	EXPECT(queue_push_many(&queue, in, 20) == 20);
+	EXPECT(queue_get_many(&queue, out, 20) == 20);
+	EXPECT(queue_empty(&queue));
+
+	/* Only 32 of the 40 pointers fit */
+	EXPECT(queue_push_many(&queue, in, 40) == 32);
+	EXPECT(queue_full(&queue));
+	EXPECT(queue_push_many(&queue, in, 1) == 0);
+
+	EXPECT(queue_get_many(&queue, out, 10) == 10);
+	EXPECT(queue_get_many(&queue, &out[10], 40) == 22);
+	EXPECT(queue_get_many(&queue, out, 1) == 0);
+	EXPECT(queue_empty(&queue));
+
+	for(i = 0; i < 32; i++)
+	{
+		EXPECT(out[i] == in[i]);
+	}
+}
+
+
+/* Stress test. Each producer pushes MPMC_COUNT tagged values, either one at a time or in bursts.
+ * Consumers record every value they remove and verify that values from the same producer arrive in
+ * increasing order. */
+#define MPMC_PRODUCERS	(4u)
+#define MPMC_CONSUMERS	(4u)
+#define MPMC_COUNT		(20000u)
+#define MPMC_BURST		(32u)
+
+static QueueSlot        mpmc_slots[1024];
+static Queue            mpmc_queue;
+static unsigned char    mpmc_seen[MPMC_PRODUCERS][MPMC_COUNT];
+static _Atomic unsigned mpmc_removed;
+static _Atomic unsigned mpmc_misordered;
+static bool             mpmc_batch;
+
+static void* mpmc_producer(void* arg)
+{
+	uintptr_t id = (uintptr_t)arg;
+	uintptr_t i;
+
+	for(i = 0; i < MPMC_COUNT; )
+	{
+		void*    burst[MPMC_BURST];
+		unsigned count = mpmc_batch ? MPMC_BURST : 1;
+		unsigned j;
+
+		if(count > MPMC_COUNT - i)
+		{
+			count = MPMC_COUNT - i;
+		}
+
+		/* Values are offset by 1 so that no null pointers are pushed */
+		for(j = 0; j < count; j++)
+		{
+			burst[j] = (void*)(1 + (id * MPMC_COUNT) + i + j);
+		}
+
+		count = mpmc_batch ? queue_push_many(&mpmc_queue, burst, count)
+		                   : queue_push(&mpmc_queue, burst[0]);
+		i += count;
+
+		if(count == 0)
+		{
+			sched_yield();
+		}
+	}
+
+	return 0;
+}
+
+static void* mpmc_consumer(void* arg)
+{
+	uintptr_t last[MPMC_PRODUCERS];
+	unsigned  i;
+
+	(void)arg;
+
+	for(i = 0; i < MPMC_PRODUCERS; i++)
+	{
+		last[i] = -1;
+	}
+
+	while(atomic_load(&mpmc_removed) < MPMC_PRODUCERS * MPMC_COUNT)
+	{
+		void*    burst[MPMC_BURST];
+		unsigned count = mpmc_batch ? queue_get_many(&mpmc_queue, burst, MPMC_BURST)
+		                            : queue_get(&mpmc_queue, &burst[0]);
+
+		for(i = 0; i < count; i++)
+		{
+			uintptr_t value = (uintptr_t)burst[i] - 1;
+			uintptr_t id    = value / MPMC_COUNT;
+			uintptr_t seq   = value % MPMC_COUNT;
+
+			if(last[id] != (uintptr_t)-1 && seq <= last[id])
+			{
+				atomic_fetch_add(&mpmc_misordered, 1);
+			}
+
+			last[id] = seq;
+			mpmc_seen[id][seq]++;
+		}
+
+		atomic_fetch_add(&mpmc_removed, count);
+
+		if(count == 0)
+		{
+			sched_yield();
+		}
+	}
+
+	return 0;
+}
+
+
+static void run_mpmc(bool batch)
+{
+	pthread_t producers[MPMC_PRODUCERS];
+	pthread_t consumers[MPMC_CONSUMERS];
+	struct timespec start, end;
+	uintptr_t nproducers = 0;
+	uintptr_t nconsumers;
+	uintptr_t i, j;
+
+	EXPECT(queue_init(&mpmc_queue, mpmc_slots, sizeof(mpmc_slots) / sizeof(mpmc_slots[0])));
+
+	memset(mpmc_seen, 0, sizeof(mpmc_seen));
+	mpmc_removed    = 0;
+	mpmc_misordered = 0;
+	mpmc_batch      = batch;
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+
+	for(nconsumers = 0; nconsumers < MPMC_CONSUMERS; nconsumers++)
+	{
+		if(pthread_create(&consumers[nconsumers], 0, mpmc_consumer, (void*)nconsumers) != 0)
+		{
+			break;
+		}
+	}
+
+	EXPECT(nconsumers == MPMC_CONSUMERS);
+
+	if(nconsumers == MPMC_CONSUMERS)
+	{
+		for(nproducers = 0; nproducers < MPMC_PRODUCERS; nproducers++)
+		{
+			if(pthread_create(&producers[nproducers], 0, mpmc_producer, (void*)nproducers) != 0)
+			{
+				break;
+			}
+		}
+
+		EXPECT(nproducers == MPMC_PRODUCERS);
+	}
+
+	for(i = 0; i < nproducers; i++)
+	{
+		pthread_join(producers[i], 0);
+	}
+
+	/* Release the consumers and skip the run if any thread could not be created */
+	if(nproducers != MPMC_PRODUCERS)
+	{
+		atomic_store(&mpmc_removed, MPMC_PRODUCERS * MPMC_COUNT);
+	}
+
+	for(i = 0; i < nconsumers; i++)
+	{
+		pthread_join(consumers[i], 0);
+	}
+
+	if(nproducers != MPMC_PRODUCERS)
+	{
+		return;
+	}
+
+	clock_gettime(CLOCK_MONOTONIC, &end);
+
+	/* Every value must have been removed exactly once */
+	bool exactly_once = true;
+
+	for(i = 0; i < MPMC_PRODUCERS; i++)
+	{
+		for(j = 0; j < MPMC_COUNT; j++)
+		{
+			exactly_once &= (mpmc_seen[i][j] == 1);
+		}
+	}
+
+	EXPECT(exactly_once);
+	EXPECT(mpmc_misordered == 0);
+	EXPECT(queue_empty(&mpmc_queue));
+
+	double elapsed = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+
+	PRINT_LINE("%u producers, %u consumers, burst %u: %.1f Mops/s",
+		MPMC_PRODUCERS, MPMC_CONSUMERS, batch ? MPMC_BURST : 1,
+		(MPMC_PRODUCERS * MPMC_COUNT) / elapsed / 1e6);
+}
+
+
+TEST(test_queue_mpmc)
+{
+	run_mpmc(false);
+}
+
+
+TEST(test_queue_mpmc_many)
+{
+	run_mpmc(true);
+}
+
+
+/* Delayed producer and consumer for test_queue_wait */
+#define WAIT_TIMEOUT	(1000000u)	/* Microseconds before a missed wakeup fails the test */
+
+static void* wait_producer(void* arg)
+{
+	struct timespec delay = { .tv_sec = 0, .tv_nsec = 10000000 };
+
+	nanosleep(&delay, 0);
+	queue_push(&queue, arg);
+	return 0;
+}
+
+static void* wait_consumer(void* arg)
+{
+	struct timespec delay = { .tv_sec = 0, .tv_nsec = 10000000 };
+	void* ptr;
+
+	(void)arg;
+
+	nanosleep(&delay, 0);
+	queue_get(&queue, &ptr);
+	return 0;
+}
+
+
+TEST(test_queue_wait)
+{
+	pthread_t thread;
+	int*      ptr;
+	unsigned  i;
+	bool      started;
+
+	queue_init(&queue, slots, sizeof(slots) / sizeof(slots[0]));
+
+	/* Time out on an empty queue */
+	uint64_t start = futex_now();
+	EXPECT(!queue_get_wait(&queue, &ptr, 2000));
+	EXPECT(futex_now() - start >= 2000);
+
+	/* Block until another thread pushes an entry. The timeout only bounds a failed wakeup. */
+	started = pthread_create(&thread, 0, wait_producer, &data[0]) == 0;
+	EXPECT(started);
+
+	if(started)
+	{
+		EXPECT(queue_get_wait(&queue, &ptr, WAIT_TIMEOUT));
+		EXPECT(ptr == &data[0]);
+		pthread_join(thread, 0);
+	}
+
+	/* Fill the queue and time out on a full queue */
+	for(i = 0; i < queue_size(&queue); i++)
+	{
+		EXPECT(queue_push(&queue, &data[i]));
+	}
+
+	EXPECT(!queue_push_wait(&queue, &data[0], 2000));
+
+	/* Block until another thread removes an entry */
+	started = pthread_create(&thread, 0, wait_consumer, 0) == 0;
+	EXPECT(started);
+
+	if(started)
+	{
+		EXPECT(queue_push_wait(&queue, &data[0], WAIT_TIMEOUT));
+		EXPECT(queue_full(&queue));
+		pthread_join(thread, 0);
+	}
+}
+
+
 void test_queue(void)
 {
 	tharness_run(test_queue_push);
 	tharness_run(test_queue_entry);
 	tharness_run(test_queue_pop);
+	tharness_run(test_queue_many);
+	tharness_run(test_queue_mpmc);
+	tharness_run(test_queue_mpmc_many);
+	tharness_run(test_queue_wait);
 }
 
 
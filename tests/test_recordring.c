@@ -0,0 +1,205 @@
+/************************************************************************************************//**
+ * @file		test_recordring.c
+ *
+ * @copyright	Copyright 2022 Kurt Hildebrand.
+ * @license		Licensed under the Apache License, Version 2.0 (the "License"); you may not use this
+ * 				file except in compliance with the License. You may obtain a copy of the License at
+ *
+ * 				http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * 				Unless required by applicable law or agreed to in writing, software distributed under
+ * 				the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF
+ * 				ANY KIND, either express or implied. See the License for the specific language
+ * 				governing permissions and limitations under the License.
+ *
+ ***************************************************************************************************/
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "tharness.h"
+
+#include "recordring.h"
+
+
+/* Private Variables ----------------------------------------------------------------------------- */
+static _Alignas(RR_HEADER_SIZE) uint8_t data[64];
+static RecordRing ring;
+
+
+TEST(test_recordring_init)
+{
+	EXPECT(!rr_init(&ring, data, 48, RR_SINGLE_PRODUCER));
+	EXPECT(!rr_init(&ring, data + 1, 32, RR_SINGLE_PRODUCER));
+	EXPECT(!rr_init(&ring, data, 8, RR_SINGLE_PRODUCER));
+	EXPECT(rr_init(&ring, data, sizeof(data), RR_SINGLE_PRODUCER));
+	EXPECT(rr_empty(&ring));
+	EXPECT(rr_free(&ring) == sizeof(data));
+}
+
+
+TEST(test_recordring_push)
+{
+	RingRecord rec;
+
+	EXPECT(rr_init(&ring, data, sizeof(data), RR_SINGLE_PRODUCER));
+
+	/* 8 + 8, 8 + 16 and 8 + 0 bytes */
+	EXPECT(rr_push(&ring, "abc", 3));
+	EXPECT(rr_push(&ring, "0123456789", 10));
+	EXPECT(rr_push(&ring, "", 0));
+	EXPECT(rr_free(&ring) == 64 - 48);
+	EXPECT(!rr_push(&ring, "too long for the ring", 21));
+
+	EXPECT(rr_peek(&ring, &rec));
+	EXPECT(buffer_length(&rec.buffer) == 3);
+	EXPECT(memcmp(buffer_start(&rec.buffer), "abc", 3) == 0);
+	EXPECT(rr_release(&ring, &rec));
+	EXPECT(!rr_release(&ring, &rec));
+
+	EXPECT(rr_peek(&ring, &rec));
+	EXPECT(buffer_length(&rec.buffer) == 10);
+	EXPECT(memcmp(buffer_start(&rec.buffer), "0123456789", 10) == 0);
+	EXPECT(rr_release(&ring, &rec));
+
+	EXPECT(rr_peek(&ring, &rec));
+	EXPECT(buffer_length(&rec.buffer) == 0);
+	EXPECT(rr_release(&ring, &rec));
+
+	EXPECT(!rr_peek(&ring, &rec));
+	EXPECT(rr_empty(&ring));
+}
+
+
+TEST(test_recordring_wrap)
+{
+	RingRecord rec;
+
+	/* The ring positions are at 48. A 20 byte record needs 8 + 24 bytes, which does not fit before
+	 * the end of the ring, so the payload is placed at the start of the ring. */
+	EXPECT(rr_reserve(&ring, &rec, 20));
+	EXPECT(buffer_start(&rec.buffer) == data);
+	EXPECT(buffer_size(&rec.buffer) == 20);
+	EXPECT(rec.next - rec.head == 16 + 24);
+
+	/* Commit fewer bytes than were reserved */
+	EXPECT(buffer_push_mem(&rec.buffer, "wrapped", 7));
+	EXPECT(rr_empty(&ring));
+	EXPECT(rr_commit(&ring, &rec));
+	EXPECT(!rr_empty(&ring));
+
+	EXPECT(rr_peek(&ring, &rec));
+	EXPECT(buffer_start(&rec.buffer) == data);
+	EXPECT(buffer_length(&rec.buffer) == 7);
+	EXPECT(memcmp(buffer_start(&rec.buffer), "wrapped", 7) == 0);
+	EXPECT(rr_release(&ring, &rec));
+	EXPECT(rr_empty(&ring));
+	EXPECT(rr_free(&ring) == sizeof(data));
+}
+
+
+/* Multi-producer stress test. Each producer pushes records whose length and contents are derived
+ * from the producer id and a sequence number. */
+#define MP_PRODUCERS	(3u)
+#define MP_COUNT		(20000u)
+
+static _Alignas(RR_HEADER_SIZE) uint8_t mp_data[1024];
+static RecordRing mp_ring;
+
+static void* mp_producer(void* arg)
+{
+	uint8_t  id = (uintptr_t)arg;
+	uint32_t i;
+
+	for(i = 0; i < MP_COUNT; i++)
+	{
+		RingRecord rec;
+		unsigned len = 5 + (i % 40);
+
+		while(!rr_reserve(&mp_ring, &rec, len))
+		{
+			sched_yield();
+		}
+
+		buffer_push_u8(&rec.buffer, id);
+		buffer_push_u32(&rec.buffer, i);
+
+		while(buffer_free(&rec.buffer))
+		{
+			buffer_push_u8(&rec.buffer, (uint8_t)(id + i));
+		}
+
+		rr_commit(&mp_ring, &rec);
+	}
+
+	return 0;
+}
+
+
+TEST(test_recordring_multi_producer)
+{
+	pthread_t producers[MP_PRODUCERS];
+	uint32_t  next[MP_PRODUCERS] = { 0 };
+	unsigned  received = 0;
+	bool      valid    = true;
+	uintptr_t created;
+	uintptr_t i;
+
+	EXPECT(rr_init(&mp_ring, mp_data, sizeof(mp_data), RR_MULTI_PRODUCER));
+
+	for(created = 0; created < MP_PRODUCERS; created++)
+	{
+		if(pthread_create(&producers[created], 0, mp_producer, (void*)created) != 0)
+		{
+			break;
+		}
+	}
+
+	EXPECT(created == MP_PRODUCERS);
+
+	while(received < created * MP_COUNT)
+	{
+		RingRecord rec;
+		uint8_t    id  = 0;
+		uint32_t   seq = 0;
+
+		if(!rr_peek(&mp_ring, &rec))
+		{
+			sched_yield();
+			continue;
+		}
+
+		valid &= buffer_pop_mem(&rec.buffer, &id, 1) && id < created;
+		valid &= buffer_pop_mem(&rec.buffer, &seq, 4) && seq == next[id % MP_PRODUCERS]++;
+		valid &= buffer_length(&rec.buffer) == 5 + (seq % 40);
+
+		while(buffer_remaining(&rec.buffer))
+		{
+			valid &= *(uint8_t*)buffer_pop_u8(&rec.buffer) == (uint8_t)(id + seq);
+		}
+
+		EXPECT(rr_release(&mp_ring, &rec));
+		received++;
+	}
+
+	for(i = 0; i < created; i++)
+	{
+		pthread_join(producers[i], 0);
+	}
+
+	EXPECT(valid);
+	EXPECT(rr_empty(&mp_ring));
+}
+
+
+void test_recordring(void)
+{
+	tharness_run(test_recordring_init);
+	tharness_run(test_recordring_push);
+	tharness_run(test_recordring_wrap);
+	tharness_run(test_recordring_multi_producer);
+}
+
+
+/******************************************* END OF FILE *******************************************/
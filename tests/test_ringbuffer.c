@@ -13,11 +13,15 @@
  * 				governing permissions and limitations under the License.
  *
  ***************************************************************************************************/
+#include <pthread.h>
+#include <sched.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <time.h>
 
 #include "tharness.h"
 
+#include "json.h"
 #include "ringbuffer.h"
 
 
@@ -94,12 +98,302 @@ TEST(test_ringbuffer_pop_many)
 }
 
 
+TEST(test_ringbuffer_span)
+{
+	EXPECT(rb_init(&ringbuffer, data, sizeof(data) / sizeof(data[0]), sizeof(data[0])));
+
+	Range first;
+	Range second;
+	unsigned i;
+
+	/* Move the indices close to the end of the array so that the next reservation wraps */
+	int temp[] = { 0, 0, 0, 0, 0, 0 };
+	EXPECT(rb_push_many(&ringbuffer, temp, 6));
+	EXPECT(rb_pop_many(&ringbuffer, 6));
+
+	/* Reserve more entries than are free */
+	EXPECT(rb_reserve_span(&ringbuffer, 10, &first, &second) == 8);
+	EXPECT(range_count(&first)  == 2);
+	EXPECT(range_count(&second) == 6);
+	EXPECT(rb_empty(&ringbuffer));
+
+	for(i = 0; i < range_count(&first); i++)
+	{
+		*(int*)range_offset(&first, i) = i * 10;
+	}
+
+	for(i = 0; i < range_count(&second); i++)
+	{
+		*(int*)range_offset(&second, i) = (i + range_count(&first)) * 10;
+	}
+
+	EXPECT(rb_commit(&ringbuffer, 5));
+	EXPECT(rb_count(&ringbuffer) == 5);
+	EXPECT(rb_commit(&ringbuffer, 3));
+	EXPECT(rb_full(&ringbuffer));
+	EXPECT(!rb_commit(&ringbuffer, 1));
+	EXPECT(rb_reserve_span(&ringbuffer, 1, &first, &second) == 0);
+
+	/* Peek at the entries in two batches */
+	EXPECT(rb_peek_span(&ringbuffer, 3, &first, &second) == 3);
+	EXPECT(range_count(&first)  == 2);
+	EXPECT(range_count(&second) == 1);
+	EXPECT(*(int*)range_offset(&first, 0)  == 0);
+	EXPECT(*(int*)range_offset(&first, 1)  == 10);
+	EXPECT(*(int*)range_offset(&second, 0) == 20);
+	EXPECT(rb_release(&ringbuffer, 3));
+
+	EXPECT(rb_peek_span(&ringbuffer, 8, &first, &second) == 5);
+	EXPECT(range_count(&first)  == 5);
+	EXPECT(range_count(&second) == 0);
+
+	for(i = 0; i < range_count(&first); i++)
+	{
+		EXPECT(*(int*)range_offset(&first, i) == (int)(i + 3) * 10);
+	}
+
+	EXPECT(rb_release(&ringbuffer, 5));
+	EXPECT(!rb_release(&ringbuffer, 1));
+	EXPECT(rb_empty(&ringbuffer));
+}
+
+
+/* Producer thread for test_ringbuffer_spsc. Pushes increasing integers in batches of varying size
+ * using rb_reserve_span and rb_commit. */
+#define SPSC_COUNT	(20000u)
+
+static unsigned   spsc_data[256];
+static RingBuffer spsc_rb;
+
+static void* spsc_producer(void* arg)
+{
+	unsigned next = 0;
+
+	(void)arg;
+
+	while(next < SPSC_COUNT)
+	{
+		Range first;
+		Range second;
+		unsigned i;
+		unsigned count = rb_reserve_span(&spsc_rb, 1 + next % 13, &first, &second);
+
+		if(count > SPSC_COUNT - next)
+		{
+			count = SPSC_COUNT - next;
+		}
+
+		for(i = 0; i < count; i++)
+		{
+			if(i < range_count(&first))
+			{
+				*(unsigned*)range_offset(&first, i) = next + i;
+			}
+			else
+			{
+				*(unsigned*)range_offset(&second, i - range_count(&first)) = next + i;
+			}
+		}
+
+		rb_commit(&spsc_rb, count);
+		next += count;
+
+		if(count == 0)
+		{
+			sched_yield();
+		}
+	}
+
+	return 0;
+}
+
+
+TEST(test_ringbuffer_spsc)
+{
+	pthread_t producer;
+	unsigned  expected = 0;
+	bool      ordered  = true;
+	bool      started;
+
+	EXPECT(rb_init(&spsc_rb, spsc_data, sizeof(spsc_data) / sizeof(spsc_data[0]), sizeof(spsc_data[0])));
+
+	started = pthread_create(&producer, 0, spsc_producer, 0) == 0;
+	EXPECT(started);
+
+	/* Consume entries in place and verify that they arrive in order */
+	while(started && expected < SPSC_COUNT)
+	{
+		Range first;
+		Range second;
+		unsigned i;
+		unsigned count = rb_peek_span(&spsc_rb, 1 + expected % 7, &first, &second);
+
+		for(i = 0; i < range_count(&first); i++)
+		{
+			ordered &= (*(unsigned*)range_offset(&first, i) == expected++);
+		}
+
+		for(i = 0; i < range_count(&second); i++)
+		{
+			ordered &= (*(unsigned*)range_offset(&second, i) == expected++);
+		}
+
+		rb_release(&spsc_rb, count);
+
+		if(count == 0)
+		{
+			sched_yield();
+		}
+	}
+
+	if(started)
+	{
+		pthread_join(producer, 0);
+	}
+
+	EXPECT(ordered);
+	EXPECT(rb_empty(&spsc_rb));
+}
+
+
+/* Delayed producer and consumer for test_ringbuffer_wait */
+#define WAIT_TIMEOUT	(1000000u)	/* Microseconds before a missed wakeup fails the test */
+
+static void* wait_producer(void* arg)
+{
+	struct timespec delay = { .tv_sec = 0, .tv_nsec = 10000000 };
+
+	nanosleep(&delay, 0);
+	rb_push(&ringbuffer, arg);
+	return 0;
+}
+
+static void* wait_consumer(void* arg)
+{
+	struct timespec delay = { .tv_sec = 0, .tv_nsec = 10000000 };
+
+	(void)arg;
+
+	nanosleep(&delay, 0);
+	rb_pop(&ringbuffer);
+	return 0;
+}
+
+
+TEST(test_ringbuffer_wait)
+{
+	pthread_t  thread;
+	static int value = 42;
+	int        temp  = 0;
+	unsigned   i;
+	bool       started;
+
+	EXPECT(rb_init(&ringbuffer, data, sizeof(data) / sizeof(data[0]), sizeof(data[0])));
+
+	/* Time out on an empty ring buffer */
+	uint64_t start = futex_now();
+	EXPECT(!rb_get_wait(&ringbuffer, &temp, 2000));
+	EXPECT(futex_now() - start >= 2000);
+
+	/* Block until the producer pushes an element. The timeout only bounds a failed wakeup. */
+	started = pthread_create(&thread, 0, wait_producer, &value) == 0;
+	EXPECT(started);
+
+	if(started)
+	{
+		EXPECT(rb_get_wait(&ringbuffer, &temp, WAIT_TIMEOUT));
+		EXPECT(temp == 42);
+		pthread_join(thread, 0);
+	}
+
+	/* Fill the ring buffer and time out on a full ring buffer */
+	for(i = 0; i < rb_size(&ringbuffer); i++)
+	{
+		EXPECT(rb_push(&ringbuffer, &i));
+	}
+
+	EXPECT(!rb_push_wait(&ringbuffer, &temp, 2000));
+
+	/* Block until the consumer removes an element */
+	started = pthread_create(&thread, 0, wait_consumer, 0) == 0;
+	EXPECT(started);
+
+	if(started)
+	{
+		EXPECT(rb_push_wait(&ringbuffer, &temp, WAIT_TIMEOUT));
+		EXPECT(rb_full(&ringbuffer));
+		pthread_join(thread, 0);
+	}
+}
+
+
+TEST(test_ringbuffer_mirrored)
+{
+	#if defined(__linux__)
+	RingBuffer rb;
+	Buffer     b;
+	Range      first;
+	Range      second;
+	JsonToken  base;
+	JsonToken  elem;
+
+	EXPECT(!rb_init_mirrored(&rb, 100, 1));
+	EXPECT(!rb_init_mirrored(&rb, 16, 1));
+	EXPECT(rb_init_mirrored(&rb, 4096, 1));
+
+	/* Move the indices to 10 entries before the end of the ring buffer */
+	EXPECT(rb_reserve_span(&rb, 4086, &first, &second) == 4086);
+	EXPECT(rb_commit(&rb, 4086));
+	EXPECT(rb_release(&rb, 4086));
+
+	/* A JSON object which straddles the end of the ring buffer */
+	const char json[] = "{\"key\": \"value\", \"number\": 42}";
+
+	EXPECT(rb_push_many(&rb, json, sizeof(json)));
+
+	/* The first half of the object is at the end of the memory and the second half at the start */
+	EXPECT(memcmp(range_at(rb_range(&rb), 4086), json, 10) == 0);
+	EXPECT(memcmp(range_at(rb_range(&rb), 0), &json[10], sizeof(json) - 10) == 0);
+
+	/* But the whole object is readable in place through the mirror */
+	EXPECT(rb_peek_span(&rb, sizeof(json), &first, &second) == sizeof(json));
+	EXPECT(range_count(&first) == sizeof(json));
+	EXPECT(range_count(&second) == 0);
+
+	EXPECT(rb_peek_buffer(&rb, sizeof(json), &b) == sizeof(json));
+	EXPECT(memcmp(buffer_start(&b), json, sizeof(json)) == 0);
+
+	json_init(&b, &base);
+	EXPECT(json_read(&b, &base, &elem));
+	EXPECT(string_equal(elem.key, MAKE_STRING("key")) && string_equal(elem.value, MAKE_STRING("value")));
+	EXPECT(json_read(&b, &base, &elem));
+	EXPECT(string_equal(elem.key, MAKE_STRING("number")) && string_equal(elem.value, MAKE_STRING("42")));
+
+	EXPECT(rb_release(&rb, sizeof(json)));
+	EXPECT(rb_empty(&rb));
+
+	/* Reserve a buffer which straddles the end of the ring buffer */
+	EXPECT(rb_reserve_buffer(&rb, 100, &b) == 100);
+	EXPECT(buffer_push_mem(&b, "mirrored", 8));
+	EXPECT(rb_commit(&rb, buffer_length(&b)));
+	EXPECT(rb_peek_buffer(&rb, 100, &b) == 8);
+	EXPECT(memcmp(buffer_start(&b), "mirrored", 8) == 0);
+
+	rb_deinit_mirrored(&rb);
+	#endif
+}
+
+
 void test_ringbuffer(void)
 {
 	tharness_run(test_ringbuffer_push);
 	tharness_run(test_ringbuffer_pop);
 	tharness_run(test_ringbuffer_push_many);
 	tharness_run(test_ringbuffer_pop_many);
+	tharness_run(test_ringbuffer_span);
+	tharness_run(test_ringbuffer_spsc);
+	tharness_run(test_ringbuffer_wait);
+	tharness_run(test_ringbuffer_mirrored);
 }
 
 
@@ -0,0 +1,420 @@
+/************************************************************************************************//**
+ * @file		test_roaring.c
+ *
+ * @copyright	Copyright 2022 Kurt Hildebrand.
+ * @license		Licensed under the Apache License, Version 2.0 (the "License"); you may not use this
+ * 				file except in compliance with the License. You may obtain a copy of the License at
+ *
+ * 				http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * 				Unless required by applicable law or agreed to in writing, software distributed under
+ * 				the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF
+ * 				ANY KIND, either express or implied. See the License for the specific language
+ * 				governing permissions and limitations under the License.
+ *
+ ***************************************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "test_roaring.h"
+
+#include "bits.h"
+#include "roaring.h"
+#include "tharness.h"
+
+
+/* Private Macros -------------------------------------------------------------------------------- */
+#define REF_BITS		(1u << 18)		/* Values compared against a flat bit array */
+
+
+/* Private Variables ----------------------------------------------------------------------------- */
+static uint8_t arena_mem[1 << 20];
+static uint8_t ref_a[BIT_ARRAY_SIZE(REF_BITS)];
+static uint8_t ref_b[BIT_ARRAY_SIZE(REF_BITS)];
+static uint8_t ser_mem[1 << 16];
+static Arena   arena;
+
+
+/* Private Functions ----------------------------------------------------------------------------- */
+static void fill           (Roaring*, Bits*, unsigned);
+static bool matches        (const Roaring*, Bits*);
+static bool container_types(const Roaring*, const RoaringType*, unsigned);
+
+
+TEST(test_roaring_basic)
+{
+	Roaring  r;
+	uint32_t v;
+
+	roaring_init(&r, &arena);
+	EXPECT(roaring_empty(&r));
+	EXPECT(!roaring_next(&r, 0, &v));
+
+	EXPECT(roaring_add(&r, 65536));
+	EXPECT(roaring_add(&r, 0));
+	EXPECT(roaring_add(&r, UINT32_MAX));
+	EXPECT(roaring_add(&r, 65535));
+	EXPECT(roaring_add(&r, 65535));
+	EXPECT(roaring_count(&r) == 4);
+	EXPECT(r.count == 3);
+
+	EXPECT(roaring_contains(&r, 0));
+	EXPECT(roaring_contains(&r, 65535));
+	EXPECT(roaring_contains(&r, 65536));
+	EXPECT(roaring_contains(&r, UINT32_MAX));
+	EXPECT(!roaring_contains(&r, 1));
+	EXPECT(!roaring_contains(&r, 65537));
+
+	EXPECT(roaring_rank(&r, 0) == 1);
+	EXPECT(roaring_rank(&r, 65535) == 2);
+	EXPECT(roaring_rank(&r, 70000) == 3);
+	EXPECT(roaring_rank(&r, UINT32_MAX) == 4);
+
+	EXPECT(roaring_next(&r, 1, &v) && v == 65535);
+	EXPECT(roaring_next(&r, 65536, &v) && v == 65536);
+	EXPECT(roaring_next(&r, 65537, &v) && v == UINT32_MAX);
+
+	EXPECT(roaring_remove(&r, 65536));
+	EXPECT(roaring_remove(&r, 65536));
+	EXPECT(r.count == 2);
+	EXPECT(roaring_count(&r) == 3);
+
+	roaring_clear(&r);
+	EXPECT(roaring_empty(&r));
+	EXPECT(!roaring_contains(&r, 0));
+}
+
+
+TEST(test_roaring_containers)
+{
+	Roaring  r;
+	uint32_t v;
+	unsigned i, n;
+	bool     ok = true;
+
+	roaring_init(&r, &arena);
+
+	/* An array container becomes a bitmap once it holds more than ROARING_ARRAY_MAX values */
+	for(i = 0; i < ROARING_ARRAY_MAX; i++)
+	{
+		ok = roaring_add(&r, 0x20000 + 3*i) && ok;
+	}
+
+	EXPECT(ok);
+	EXPECT(r.containers[0].type == ROARING_ARRAY);
+
+	EXPECT(roaring_add(&r, 0x20001));
+	EXPECT(r.containers[0].type == ROARING_BITMAP);
+	EXPECT(roaring_count(&r) == ROARING_ARRAY_MAX + 1);
+	EXPECT(roaring_rank(&r, 0x20003) == 3);
+	EXPECT(roaring_contains(&r, 0x20000 + 3*(ROARING_ARRAY_MAX-1)));
+
+	/* Iterate */
+	for(ok = roaring_next(&r, 0, &v), n = 0; ok; ok = v < UINT32_MAX && roaring_next(&r, v+1, &v))
+	{
+		n++;
+	}
+
+	EXPECT(n == ROARING_ARRAY_MAX + 1);
+
+	/* Ranges of empty chunks become runs */
+	roaring_clear(&r);
+	EXPECT(roaring_add_range(&r, 100, 200000));
+	EXPECT(r.count == 4);
+	EXPECT(roaring_count(&r) == 200000 - 100 + 1);
+	EXPECT(r.containers[0].type == ROARING_RUN);
+	EXPECT(r.containers[1].type == ROARING_RUN && r.containers[1].card == 65536);
+	EXPECT(!roaring_contains(&r, 99));
+	EXPECT(roaring_contains(&r, 100));
+	EXPECT(roaring_contains(&r, 200000));
+	EXPECT(!roaring_contains(&r, 200001));
+	EXPECT(roaring_rank(&r, 65536) == 65536 - 100 + 1);
+	EXPECT(roaring_next(&r, 0, &v) && v == 100);
+	EXPECT(!roaring_next(&r, 200001, &v));
+
+	/* Removing from a run container converts it */
+	EXPECT(roaring_remove(&r, 70000));
+	EXPECT(r.containers[1].type == ROARING_BITMAP);
+	EXPECT(!roaring_contains(&r, 70000));
+	EXPECT(roaring_next(&r, 70000, &v) && v == 70001);
+
+	/* Adding a range to an existing container */
+	EXPECT(roaring_add_range(&r, 0, 10));
+	EXPECT(roaring_count(&r) == 200000 - 100 + 11);
+	EXPECT(roaring_rank(&r, 10) == 11);
+	EXPECT(roaring_add_range(&r, 5, 4));
+	EXPECT(roaring_count(&r) == 200000 - 100 + 11);
+}
+
+
+TEST(test_roaring_optimize)
+{
+	const RoaringType before[] = { ROARING_ARRAY, ROARING_BITMAP, ROARING_BITMAP, ROARING_RUN };
+	const RoaringType after[]  = { ROARING_ARRAY, ROARING_BITMAP, ROARING_RUN,    ROARING_ARRAY };
+	Roaring r;
+	unsigned i;
+	bool ok = true;
+
+	roaring_init(&r, &arena);
+
+	/* Chunk 0: sparse. Chunk 1: dense and scattered. Chunk 2: one long run stored as a bitmap.
+	 * Chunk 3: a small run that is cheaper as an array once broken up. */
+	for(i = 0; i < 10; i++)
+	{
+		ok = roaring_add(&r, i * 1000) && ok;
+	}
+
+	for(i = 0; i < 10000; i++)
+	{
+		ok = roaring_add(&r, 0x10000 + i * 2) && ok;
+		ok = roaring_add(&r, 0x20000 + i) && ok;
+	}
+
+	EXPECT(ok);
+	EXPECT(roaring_add_range(&r, 0x30000, 0x30003));
+	EXPECT(container_types(&r, before, 4));
+
+	EXPECT(roaring_remove(&r, 0x30001));
+	EXPECT(roaring_add(&r, 0x30001));
+	EXPECT(roaring_remove(&r, 0x30002));
+	EXPECT(roaring_optimize(&r));
+	EXPECT(container_types(&r, after, 4));
+	EXPECT(roaring_count(&r) == 10 + 10000 + 10000 + 3);
+	EXPECT(roaring_contains(&r, 0x20000 + 9999));
+	EXPECT(!roaring_contains(&r, 0x20000 + 10000));
+	EXPECT(roaring_rank(&r, 0x20000 + 4999) == 10 + 10000 + 5000);
+}
+
+
+TEST(test_roaring_ops)
+{
+	Roaring a, b, c;
+	Bits    ra, rb;
+	unsigned i;
+
+	bits_init(&ra, ref_a, REF_BITS);
+	bits_init(&rb, ref_b, REF_BITS);
+
+	/* Exercise each pair of container types by combining sets of different densities */
+	for(i = 0; i < 4; i++)
+	{
+		arena_clear(&arena);
+		roaring_init(&a, &arena);
+		roaring_init(&b, &arena);
+		roaring_init(&c, &arena);
+		bits_clear_all(&ra);
+		bits_clear_all(&rb);
+
+		fill(&a, &ra, 1 + i);
+		fill(&b, &rb, 7 + i);
+		EXPECT(matches(&a, &ra));
+		EXPECT(matches(&b, &rb));
+
+		/* c = a */
+		EXPECT(roaring_or(&c, &a));
+		EXPECT(matches(&c, &ra));
+
+		/* c = a & b */
+		EXPECT(roaring_and(&c, &b));
+		bits_and(&ra, &rb);
+		EXPECT(matches(&c, &ra));
+
+		/* c = a | b */
+		EXPECT(roaring_or(&c, &a));
+		EXPECT(roaring_or(&c, &b));
+		fill(&a, &ra, 1 + i);
+		bits_or(&ra, &rb);
+		EXPECT(matches(&c, &ra));
+
+		/* c = (a | b) ^ a = b & ~a */
+		EXPECT(roaring_xor(&c, &a));
+		bits_clear_all(&ra);
+		fill(&a, &ra, 1 + i);
+		bits_xor(&ra, &rb);
+		bits_and(&ra, &rb);
+		EXPECT(matches(&c, &ra));
+
+		/* b = b & ~(b & ~a) = a & b */
+		EXPECT(roaring_andnot(&b, &c));
+		bits_andnot(&rb, &ra);
+		EXPECT(matches(&b, &rb));
+
+		EXPECT(roaring_xor(&a, &a) && roaring_empty(&a));
+	}
+}
+
+
+TEST(test_roaring_serialize)
+{
+	const uint8_t plain[] = {
+		0x3A, 0x30, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00,		/* Cookie, 1 container */
+		0x00, 0x00, 0x02, 0x00,								/* Key 0, 3 values */
+		0x10, 0x00, 0x00, 0x00,								/* Offset 16 */
+		0x01, 0x00, 0x02, 0x00, 0x03, 0x00 };				/* Array */
+	const uint8_t runs[] = {
+		0x3B, 0x30, 0x00, 0x00, 0x01,						/* Cookie, 1 container, run bitset */
+		0x05, 0x00, 0x63, 0x00,								/* Key 5, 100 values */
+		0x01, 0x00, 0x01, 0x00, 0x63, 0x00 };				/* 1 run, values 1 through 100 */
+	Buffer  buf;
+	Roaring r, s;
+	Bits    ra;
+	uint8_t small[8];
+
+	roaring_init(&r, &arena);
+	roaring_init(&s, &arena);
+
+	EXPECT(roaring_add(&r, 3) && roaring_add(&r, 1) && roaring_add(&r, 2));
+	buffer_init(&buf, ser_mem, 0, sizeof(ser_mem));
+	EXPECT(roaring_serialized_size(&r) == sizeof(plain));
+	EXPECT(roaring_serialize(&r, &buf));
+	EXPECT(buffer_length(&buf) == sizeof(plain));
+	EXPECT(memcmp(ser_mem, plain, sizeof(plain)) == 0);
+
+	roaring_clear(&r);
+	EXPECT(roaring_add_range(&r, 0x50001, 0x50064));
+	buffer_init(&buf, ser_mem, 0, sizeof(ser_mem));
+	EXPECT(roaring_serialize(&r, &buf));
+	EXPECT(buffer_length(&buf) == sizeof(runs));
+	EXPECT(memcmp(ser_mem, runs, sizeof(runs)) == 0);
+
+	EXPECT(roaring_deserialize(&s, &buf));
+	EXPECT(buffer_remaining(&buf) == 0);
+	EXPECT(roaring_count(&s) == 100 && roaring_contains(&s, 0x50064) && !roaring_contains(&s, 0x50065));
+
+	/* Too small */
+	buffer_init(&buf, small, 0, sizeof(small));
+	EXPECT(!roaring_serialize(&r, &buf));
+	EXPECT(buffer_length(&buf) == 0);
+
+	/* Round trip a bitmap with every container type */
+	bits_init(&ra, ref_a, REF_BITS);
+	bits_clear_all(&ra);
+	roaring_clear(&r);
+	fill(&r, &ra, 2);
+	EXPECT(roaring_add_range(&r, 0x100000, 0x10FFFF));
+	EXPECT(roaring_add_range(&r, 0x110010, 0x110020));
+
+	buffer_init(&buf, ser_mem, 0, sizeof(ser_mem));
+	EXPECT(roaring_serialize(&r, &buf));
+	EXPECT(buffer_length(&buf) == roaring_serialized_size(&r));
+	EXPECT(roaring_deserialize(&s, &buf));
+	EXPECT(s.count == r.count);
+	EXPECT(roaring_count(&s) == roaring_count(&r));
+	EXPECT(roaring_contains(&s, 0x10ABCD));
+	EXPECT(roaring_rank(&s, 0x110015) == roaring_rank(&r, 0x110015));
+	EXPECT(roaring_xor(&s, &r) && roaring_empty(&s));
+
+	/* Malformed input leaves the buffer and bitmap untouched */
+	buffer_init(&buf, ser_mem, 0, sizeof(ser_mem));
+	EXPECT(buffer_push_mem(&buf, plain, sizeof(plain)));
+	ser_mem[20] = 0x01;
+	EXPECT(!roaring_deserialize(&s, &buf));
+	EXPECT(roaring_empty(&s));
+	EXPECT(buffer_remaining(&buf) == sizeof(plain));
+
+	buffer_init(&buf, ser_mem, 0, sizeof(ser_mem));
+	EXPECT(buffer_push_mem(&buf, plain, sizeof(plain) - 1));
+	EXPECT(!roaring_deserialize(&s, &buf));
+}
+
+
+void test_roaring(void)
+{
+	arena_init(&arena, arena_mem, sizeof(arena_mem));
+
+	tharness_run(test_roaring_basic);
+	tharness_run(test_roaring_containers);
+	tharness_run(test_roaring_optimize);
+
+	tharness_run(test_roaring_ops);
+
+	arena_clear(&arena);
+	tharness_run(test_roaring_serialize);
+}
+
+
+/* fill *****************************************************************************************//**
+ * @brief		Adds the same pseudo random values to a bitmap and a flat bit array. Chunks alternate
+ *				between sparse, dense and runs so that every container type is exercised. */
+static void fill(Roaring* r, Bits* ref, unsigned seed)
+{
+	uint32_t x = seed * 2654435761u;
+	unsigned chunk, i;
+
+	for(chunk = 0; chunk < REF_BITS >> 16; chunk++)
+	{
+		unsigned count = (chunk + seed) % 3 == 0 ? 100 : 8000;
+
+		if((chunk + seed) % 4 == 3)
+		{
+			unsigned first = (chunk << 16) + (seed * 1000);
+			unsigned last  = first + 20000;
+
+			roaring_add_range(r, first, last);
+			bits_set_many(ref, first, last - first + 1);
+			continue;
+		}
+
+		for(i = 0; i < count; i++)
+		{
+			x = x * 1664525u + 1013904223u;
+			roaring_add(r, (chunk << 16) | (x >> 16));
+			bits_set(ref, (chunk << 16) | (x >> 16));
+		}
+	}
+}
+
+
+/* matches **************************************************************************************//**
+ * @brief		Returns true if the bitmap holds exactly the values set in the flat bit array. */
+static bool matches(const Roaring* r, Bits* ref)
+{
+	uint32_t v;
+	unsigned i = bits_next_one(ref, 0);
+	unsigned n = 0;
+	bool     ok;
+
+	if(roaring_count(r) != bits_ones(ref))
+	{
+		return false;
+	}
+
+	for(ok = roaring_next(r, 0, &v); ok; ok = roaring_next(r, v+1, &v))
+	{
+		if(v != i || roaring_rank(r, v) != ++n)
+		{
+			return false;
+		}
+
+		i = bits_next_one(ref, v + 1);
+	}
+
+	return i == -1u;
+}
+
+
+/* container_types ******************************************************************************//**
+ * @brief		Returns true if the containers of the bitmap have the expected types. */
+static bool container_types(const Roaring* r, const RoaringType* types, unsigned count)
+{
+	unsigned i;
+
+	if(r->count != count)
+	{
+		return false;
+	}
+
+	for(i = 0; i < count; i++)
+	{
+		if(r->containers[i].type != types[i])
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+
+/******************************************* END OF FILE *******************************************/
@@ -0,0 +1,199 @@
+/************************************************************************************************//**
+ * @file		test_scheduler.c
+ *
+ * @copyright	Copyright 2022 Kurt Hildebrand.
+ * @license		Licensed under the Apache License, Version 2.0 (the "License"); you may not use this
+ * 				file except in compliance with the License. You may obtain a copy of the License at
+ *
+ * 				http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * 				Unless required by applicable law or agreed to in writing, software distributed under
+ * 				the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF
+ * 				ANY KIND, either express or implied. See the License for the specific language
+ * 				governing permissions and limitations under the License.
+ *
+ ***************************************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "test_scheduler.h"
+
+#include "scheduler.h"
+#include "tharness.h"
+
+
+/* Private Macros -------------------------------------------------------------------------------- */
+#define SCHED_WORKERS		(4)
+#define SCHED_TASKS			(64)
+#define SCHED_FOR_SIZE		(100000)
+#define SCHED_BENCH_SIZE	(4096)
+
+
+/* Private Variables ----------------------------------------------------------------------------- */
+static Scheduler        sched;
+static _Atomic unsigned sched_counter;
+static unsigned         sched_marks[SCHED_FOR_SIZE];
+static _Atomic unsigned sched_sink;
+static bool             sched_ready;
+
+
+static void sched_count(void* arg)
+{
+	atomic_fetch_add((_Atomic unsigned*)arg, 1);
+}
+
+
+static void sched_nested(void* arg)
+{
+	TaskGroup group = { .pending = 0 };
+	Task      tasks[4];
+	unsigned  i;
+
+	(void)arg;
+
+	for(i = 0; i < 4; i++)
+	{
+		scheduler_submit(&sched, &group, &tasks[i], sched_count, &sched_counter);
+	}
+
+	scheduler_wait(&sched, &group);
+}
+
+
+static void sched_mark(void* arg, unsigned begin, unsigned end)
+{
+	unsigned i;
+
+	(void)arg;
+
+	for(i = begin; i < end; i++)
+	{
+		sched_marks[i]++;
+	}
+}
+
+
+/* Cost grows with the index so that equal sized subranges have very uneven run times */
+static void sched_uneven(void* arg, unsigned begin, unsigned end)
+{
+	unsigned i;
+	unsigned j;
+	double   x = 0;
+
+	(void)arg;
+
+	for(i = begin; i < end; i++)
+	{
+		for(j = 0; j < i; j++)
+		{
+			x += (double)j * 0.5;
+		}
+	}
+
+	atomic_fetch_add(&sched_sink, x > 0);
+}
+
+
+static double sched_seconds(void)
+{
+	struct timespec ts;
+
+	timespec_get(&ts, TIME_UTC);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+
+TEST(test_scheduler_init)
+{
+	sched_ready = scheduler_init(&sched, SCHED_WORKERS);
+	EXPECT(sched_ready);
+}
+
+
+TEST(test_scheduler_submit)
+{
+	TaskGroup group = { .pending = 0 };
+	Task      tasks[SCHED_TASKS];
+	unsigned  i;
+
+	atomic_store(&sched_counter, 0);
+
+	for(i = 0; i < SCHED_TASKS; i++)
+	{
+		scheduler_submit(&sched, &group, &tasks[i], sched_count, &sched_counter);
+	}
+
+	scheduler_wait(&sched, &group);
+	EXPECT(atomic_load(&sched_counter) == SCHED_TASKS);
+
+	/* Tasks which submit and wait on their own tasks */
+	atomic_store(&sched_counter, 0);
+
+	for(i = 0; i < SCHED_TASKS; i++)
+	{
+		scheduler_submit(&sched, &group, &tasks[i], sched_nested, 0);
+	}
+
+	scheduler_wait(&sched, &group);
+	EXPECT(atomic_load(&sched_counter) == SCHED_TASKS * 4);
+}
+
+
+TEST(test_scheduler_parallel_for)
+{
+	unsigned i;
+	unsigned bad = 0;
+
+	scheduler_parallel_for(&sched, 0, SCHED_FOR_SIZE, 1000, sched_mark, 0);
+
+	for(i = 0; i < SCHED_FOR_SIZE; i++)
+	{
+		bad += sched_marks[i] != 1;
+	}
+
+	EXPECT(bad == 0);
+
+	/* Empty ranges and a grain of 0 */
+	scheduler_parallel_for(&sched, 10, 10, 1, sched_mark, 0);
+	scheduler_parallel_for(&sched, 0, 100, 0, sched_mark, 0);
+	EXPECT(sched_marks[0] == 2 && sched_marks[99] == 2 && sched_marks[100] == 1);
+}
+
+
+TEST(test_scheduler_benchmark)
+{
+	double start;
+	double serial;
+	double parallel;
+
+	start = sched_seconds();
+	sched_uneven(0, 0, SCHED_BENCH_SIZE);
+	serial = sched_seconds() - start;
+
+	start = sched_seconds();
+	scheduler_parallel_for(&sched, 0, SCHED_BENCH_SIZE, 64, sched_uneven, 0);
+	parallel = sched_seconds() - start;
+
+	PRINT_LINE("uneven parallel_for: serial %.3f ms, %d workers %.3f ms",
+		serial * 1e3, SCHED_WORKERS, parallel * 1e3);
+}
+
+
+void test_scheduler(void)
+{
+	tharness_run(test_scheduler_init);
+	if(!sched_ready)
+	{
+		return;
+	}
+
+	tharness_run(test_scheduler_submit);
+	tharness_run(test_scheduler_parallel_for);
+	tharness_run(test_scheduler_benchmark);
+
+	scheduler_deinit(&sched);
+}
+
+
+/******************************************* END OF FILE *******************************************/
@@ -0,0 +1,329 @@
+/************************************************************************************************//**
+ * @file		test_skiplist.c
+ *
+ * @copyright	Copyright 2022 Kurt Hildebrand.
+ * @license		Licensed under the Apache License, Version 2.0 (the "License"); you may not use this
+ * 				file except in compliance with the License. You may obtain a copy of the License at
+ *
+ * 				http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * 				Unless required by applicable law or agreed to in writing, software distributed under
+ * 				the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF
+ * 				ANY KIND, either express or implied. See the License for the specific language
+ * 				governing permissions and limitations under the License.
+ *
+ ***************************************************************************************************/
+#include <pthread.h>
+#include <sched.h>
+#include <stdlib.h>
+
+#include "test_skiplist.h"
+
+#include "skiplist.h"
+#include "tharness.h"
+#include "utils.h"
+
+
+/* Private Macros -------------------------------------------------------------------------------- */
+#define ITEM_COUNT		(1000)
+#define READERS			(3)
+#define WRITER_ROUNDS	(20000)
+
+
+/* Private Types --------------------------------------------------------------------------------- */
+typedef struct {
+	int      key;
+	int      order;
+	SkipLink link;
+} Item;
+
+
+/* Private Functions ----------------------------------------------------------------------------- */
+static int  compare_items(const void*, const void*);
+static int  compare_key  (const void*, const void*);
+static bool sorted       (const SkipList*);
+
+
+/* Private Variables ----------------------------------------------------------------------------- */
+static Item        items[ITEM_COUNT];
+static SkipList    list;
+static _Atomic int readers_done;
+static bool        readers_ok[READERS];
+
+
+TEST(test_skiplist_empty)
+{
+	int key = 5;
+
+	skiplist_init(&list, compare_items);
+	EXPECT(skiplist_empty(&list));
+	EXPECT(skiplist_count(&list) == 0);
+	EXPECT(skiplist_first(&list) == 0);
+	EXPECT(skiplist_find(&list, &key, compare_key) == 0);
+	EXPECT(skiplist_lower_bound(&list, &key, compare_key) == 0);
+	EXPECT(skiplist_pop_front(&list) == 0);
+	EXPECT(skiplist_insert(&list, 0) == 0);
+	EXPECT(skiplist_remove(&list, 0) == 0);
+}
+
+
+TEST(test_skiplist_insert)
+{
+	unsigned i;
+
+	skiplist_init(&list, compare_items);
+
+	/* Insert the keys 0, 2, 4, ... in a scrambled order */
+	for(i = 0; i < ITEM_COUNT; i++)
+	{
+		items[i].key = 2 * ((i * 389) % ITEM_COUNT);
+		skiplist_node_init(&items[i].link);
+		EXPECT(skiplist_insert(&list, &items[i].link) == &items[i].link);
+	}
+
+	EXPECT(skiplist_count(&list) == ITEM_COUNT);
+	EXPECT(sorted(&list));
+	EXPECT(SKIPLIST_CONTAINER(skiplist_first(&list), Item, link)->key == 0);
+}
+
+
+TEST(test_skiplist_find)
+{
+	Item* item;
+	int   key;
+
+	key  = 500;
+	item = SKIPLIST_CONTAINER(skiplist_find(&list, &key, compare_key), Item, link);
+	EXPECT(item && item->key == 500);
+
+	key = 501;
+	EXPECT(skiplist_find(&list, &key, compare_key) == 0);
+
+	/* Range iteration from the first key not less than 501 */
+	item = SKIPLIST_CONTAINER(skiplist_lower_bound(&list, &key, compare_key), Item, link);
+	EXPECT(item && item->key == 502);
+	item = SKIPLIST_CONTAINER(skiplist_next(&item->link), Item, link);
+	EXPECT(item && item->key == 504);
+
+	key = 2 * ITEM_COUNT;
+	EXPECT(skiplist_lower_bound(&list, &key, compare_key) == 0);
+
+	/* Searching with a node as the key uses the list's comparison */
+	EXPECT(skiplist_find(&list, &items[7].link, 0) == &items[7].link);
+}
+
+
+TEST(test_skiplist_remove)
+{
+	SkipLink* n;
+	unsigned  i;
+	int       key;
+	bool      ok = true;
+
+	/* Remove every item whose key is a multiple of 4 */
+	for(i = 0; i < ITEM_COUNT; i++)
+	{
+		if(items[i].key % 4 == 0)
+		{
+			ok = skiplist_remove(&list, &items[i].link) == &items[i].link && ok;
+			ok = skiplist_remove(&list, &items[i].link) == 0 && ok;
+		}
+	}
+
+	EXPECT(ok);
+	EXPECT(skiplist_count(&list) == ITEM_COUNT / 2);
+	EXPECT(sorted(&list));
+
+	key = 400;
+	EXPECT(skiplist_find(&list, &key, compare_key) == 0);
+	key = 402;
+	EXPECT(skiplist_find(&list, &key, compare_key) != 0);
+
+	n = skiplist_pop_front(&list);
+	EXPECT(SKIPLIST_CONTAINER(n, Item, link)->key == 2);
+	n = skiplist_first(&list);
+	EXPECT(SKIPLIST_CONTAINER(n, Item, link)->key == 6);
+}
+
+
+TEST(test_skiplist_duplicates)
+{
+	unsigned i;
+	Item*    item;
+	int      key = 3;
+	bool     ok = true;
+
+	/* Equal keys keep their insertion order */
+	skiplist_init(&list, compare_items);
+
+	for(i = 0; i < 200; i++)
+	{
+		items[i].key   = i % 5;
+		items[i].order = i;
+		skiplist_insert(&list, &items[i].link);
+	}
+
+	EXPECT(sorted(&list));
+
+	item = SKIPLIST_CONTAINER(skiplist_find(&list, &key, compare_key), Item, link);
+	EXPECT(item == &items[3]);
+
+	/* Remove particular nodes from the middle of a run of equal keys */
+	for(i = 3; i < 200; i += 10)
+	{
+		ok = skiplist_remove(&list, &items[i].link) == &items[i].link && ok;
+	}
+
+	EXPECT(ok);
+	EXPECT(skiplist_count(&list) == 180);
+	EXPECT(sorted(&list));
+
+	item = SKIPLIST_CONTAINER(skiplist_find(&list, &key, compare_key), Item, link);
+	EXPECT(item == &items[8]);
+
+	for(item = SKIPLIST_CONTAINER(skiplist_first(&list), Item, link); item;
+	    item = SKIPLIST_CONTAINER(skiplist_next(&item->link), Item, link))
+	{
+		ok = (item->order % 10 != 3) && ok;
+	}
+
+	EXPECT(ok);
+}
+
+
+static void* skiplist_reader(void* arg)
+{
+	intptr_t id = (intptr_t)arg;
+
+	readers_ok[id] = true;
+
+	while(!atomic_load(&readers_done))
+	{
+		int key = rand() % (2 * ITEM_COUNT);
+		SkipLink* n;
+
+		readers_ok[id] = sorted(&list) && readers_ok[id];
+
+		n = skiplist_lower_bound(&list, &key, compare_key);
+		readers_ok[id] = (!n || SKIPLIST_CONTAINER(n, Item, link)->key >= key) && readers_ok[id];
+	}
+
+	return 0;
+}
+
+
+TEST(test_skiplist_readers)
+{
+	pthread_t threads[READERS];
+	bool      linked[ITEM_COUNT] = { false };
+	uint32_t  x = 1;
+	intptr_t  i;
+	intptr_t  created;
+
+	/* Keys never change, so readers must always see strictly increasing keys while the writer
+	 * removes and reinserts nodes */
+	skiplist_init(&list, compare_items);
+
+	for(i = 0; i < ITEM_COUNT; i++)
+	{
+		items[i].key = 2 * i;
+	}
+
+	atomic_store(&readers_done, 0);
+
+	for(created = 0; created < READERS; created++)
+	{
+		if(pthread_create(&threads[created], 0, skiplist_reader, (void*)created) != 0)
+		{
+			break;
+		}
+	}
+
+	EXPECT(created == READERS);
+
+	for(i = 0; i < WRITER_ROUNDS; i++)
+	{
+		unsigned n;
+
+		x ^= x << 13;
+		x ^= x >> 17;
+		x ^= x << 5;
+		n = x % ITEM_COUNT;
+
+		if(linked[n])
+		{
+			skiplist_remove(&list, &items[n].link);
+		}
+		else
+		{
+			skiplist_insert(&list, &items[n].link);
+		}
+
+		linked[n] = !linked[n];
+	}
+
+	atomic_store(&readers_done, 1);
+
+	for(i = 0; i < created; i++)
+	{
+		pthread_join(threads[i], 0);
+		EXPECT(readers_ok[i]);
+	}
+
+	EXPECT(sorted(&list));
+}
+
+
+void test_skiplist(void)
+{
+	tharness_run(test_skiplist_empty);
+	tharness_run(test_skiplist_insert);
+	tharness_run(test_skiplist_find);
+	tharness_run(test_skiplist_remove);
+	tharness_run(test_skiplist_duplicates);
+	tharness_run(test_skiplist_readers);
+}
+
+
+static int compare_items(const void* a, const void* b)
+{
+	const Item* item_a = CONTAINER_OF(a, Item, link);
+	const Item* item_b = CONTAINER_OF(b, Item, link);
+
+	return (item_a->key > item_b->key) - (item_a->key < item_b->key);
+}
+
+
+static int compare_key(const void* key, const void* b)
+{
+	const Item* item = CONTAINER_OF(b, Item, link);
+
+	return (*(const int*)key > item->key) - (*(const int*)key < item->key);
+}
+
+
+/* sorted ***************************************************************************************//**
+ * @brief		Returns true if keys never decrease from one node to the next. Equal keys must be in
+ *				insertion order. */
+static bool sorted(const SkipList* l)
+{
+	const SkipLink* n;
+	const Item*     prev = 0;
+
+	for(n = skiplist_first(l); n; n = skiplist_next(n))
+	{
+		const Item* item = CONTAINER_OF(n, Item, link);
+
+		if(prev && (prev->key > item->key || (prev->key == item->key && prev->order > item->order)))
+		{
+			return false;
+		}
+
+		prev = item;
+	}
+
+	return true;
+}
+
+
+/******************************************* END OF FILE *******************************************/
@@ -0,0 +1,155 @@
+/************************************************************************************************//**
+ * @file		test_slotmap.c
+ *
+ * @copyright	Copyright 2022 Kurt Hildebrand.
+ * @license		Licensed under the Apache License, Version 2.0 (the "License"); you may not use this
+ * 				file except in compliance with the License. You may obtain a copy of the License at
+ *
+ * 				http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * 				Unless required by applicable law or agreed to in writing, software distributed under
+ * 				the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF
+ * 				ANY KIND, either express or implied. See the License for the specific language
+ * 				governing permissions and limitations under the License.
+ *
+ ***************************************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "test_slotmap.h"
+
+#include "slotmap.h"
+#include "tharness.h"
+
+
+/* Private Macros -------------------------------------------------------------------------------- */
+#define LARGE_MAP_SIZE		(3000)
+
+
+/* Private Variables ----------------------------------------------------------------------------- */
+static int              map_values[LARGE_MAP_SIZE];
+static SlotMapSlot      map_slots[LARGE_MAP_SIZE];
+static _Atomic uint64_t map_bitmap[POOL_BITMAP_WORDS(LARGE_MAP_SIZE)];
+static SlotHandle       map_handles[LARGE_MAP_SIZE];
+static SlotMap          map;
+
+
+TEST(test_slotmap_basic)
+{
+	SlotHandle h[4];
+	int        value;
+	unsigned   i;
+
+	EXPECT(slotmap_init(&map, map_values, 4, sizeof(int), map_slots, 0));
+	EXPECT(slotmap_empty(&map));
+
+	for(i = 0; i < 4; i++)
+	{
+		value = (i + 1) * 10;
+		EXPECT(slotmap_insert(&map, &value, &h[i]) != 0);
+		EXPECT(h[i] != SLOTMAP_NULL);
+	}
+
+	EXPECT(slotmap_full(&map));
+	EXPECT(slotmap_insert(&map, &value, &h[0]) == 0);
+
+	for(i = 0; i < 4; i++)
+	{
+		EXPECT(*(int*)slotmap_get(&map, h[i]) == (int)(i + 1) * 10);
+	}
+
+	/* Removing fills the hole with the last value */
+	EXPECT(slotmap_remove(&map, h[1]));
+	EXPECT(slotmap_remove(&map, h[1]) == false);
+	EXPECT(slotmap_get(&map, h[1]) == 0);
+	EXPECT(slotmap_count(&map) == 3);
+	EXPECT(*(int*)slotmap_at(&map, 1) == 40);
+	EXPECT(slotmap_handle_at(&map, 1) == h[3]);
+	EXPECT(*(int*)slotmap_get(&map, h[3]) == 40);
+
+	/* The slot is reused with a new generation */
+	SlotHandle stale = h[1];
+	value = 99;
+	EXPECT(slotmap_insert(&map, &value, &h[1]) != 0);
+	EXPECT((h[1] & SLOTMAP_INDEX_MASK) == (stale & SLOTMAP_INDEX_MASK));
+	EXPECT(h[1] != stale);
+	EXPECT(slotmap_get(&map, stale) == 0);
+	EXPECT(*(int*)slotmap_get(&map, h[1]) == 99);
+
+	/* Invalid handles */
+	EXPECT(slotmap_get(&map, SLOTMAP_NULL) == 0);
+	EXPECT(slotmap_get(&map, 0xFFFFFFFF) == 0);
+
+	slotmap_clear(&map);
+	EXPECT(slotmap_empty(&map));
+
+	for(i = 0; i < 4; i++)
+	{
+		EXPECT(slotmap_contains(&map, h[i]) == false);
+	}
+}
+
+
+TEST(test_slotmap_large)
+{
+	unsigned i;
+	unsigned live = 0;
+	long     sum  = 0;
+	long     expected = 0;
+
+	EXPECT(slotmap_init(&map, map_values, LARGE_MAP_SIZE, sizeof(int), map_slots, map_bitmap));
+
+	for(i = 0; i < LARGE_MAP_SIZE; i++)
+	{
+		int value = i;
+
+		EXPECT(slotmap_insert(&map, &value, &map_handles[i]));
+	}
+
+	/* Remove every third value */
+	for(i = 0; i < LARGE_MAP_SIZE; i += 3)
+	{
+		EXPECT(slotmap_remove(&map, map_handles[i]));
+	}
+
+	for(i = 0; i < LARGE_MAP_SIZE; i++)
+	{
+		int* value = slotmap_get(&map, map_handles[i]);
+
+		if(i % 3 == 0)
+		{
+			EXPECT(value == 0);
+		}
+		else
+		{
+			EXPECT(value && *value == (int)i);
+			expected += i;
+			live++;
+		}
+	}
+
+	/* Dense iteration visits every live value once */
+	Range values = slotmap_values(&map);
+
+	EXPECT(range_count(&values) == live);
+
+	for(i = 0; i < range_count(&values); i++)
+	{
+		int* value = range_offset(&values, i);
+
+		sum += *value;
+		EXPECT(slotmap_get(&map, slotmap_handle_at(&map, i)) == value);
+	}
+
+	EXPECT(sum == expected);
+}
+
+
+void test_slotmap(void)
+{
+	tharness_run(test_slotmap_basic);
+	tharness_run(test_slotmap_large);
+}
+
+
+/******************************************* END OF FILE *******************************************/
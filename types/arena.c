@@ -0,0 +1,238 @@
+/************************************************************************************************//**
+ * @file		arena.c
+ *
+ * @copyright	Copyright 2022 Kurt Hildebrand.
+ * @license		Licensed under the Apache License, Version 2.0 (the "License"); you may not use this
+ * 				file except in compliance with the License. You may obtain a copy of the License at
+ *
+ * 				http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * 				Unless required by applicable law or agreed to in writing, software distributed under
+ * 				the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF
+ * 				ANY KIND, either express or implied. See the License for the specific language
+ * 				governing permissions and limitations under the License.
+ *
+ ***************************************************************************************************/
+#include "arena.h"
+
+
+/* Inline Function Instances --------------------------------------------------------------------- */
+extern bool      arena_init_buffer(Arena*, const Buffer*);
+extern bool      arena_init_range (Arena*, const Range*);
+extern void      arena_set_pool   (Arena*, Pool*);
+extern void*     arena_alloc      (Arena*, unsigned);
+extern void*     arena_alloc_align(Arena*, unsigned, unsigned);
+extern void*     arena_push       (Arena*, const void*, unsigned);
+extern ArenaMark arena_mark       (const Arena*);
+extern void      arena_reset_to   (Arena*, ArenaMark);
+
+
+/* Private Functions ----------------------------------------------------------------------------- */
+static ArenaBlock* arena_make_block(void*, unsigned);
+static void*       arena_block_alloc(Arena*, ArenaBlock*, uint8_t*, unsigned, unsigned);
+
+
+/* arena_init ***********************************************************************************//**
+ * @brief		Initializes an arena with one block of caller provided memory.
+ * @param[in]	a: the arena to initialize.
+ * @param[in]	mem: memory for the first block. Null to start with no blocks.
+ * @param[in]	size: the number of bytes of mem.
+ * @retval		false if mem is too small to hold a block header. */
+bool arena_init(Arena* a, void* mem, unsigned size)
+{
+	a->first = 0;
+	a->last  = 0;
+	a->block = 0;
+	a->ptr   = 0;
+	a->pool  = 0;
+
+	return mem == 0 || arena_add_block(a, mem, size);
+}
+
+
+/* arena_add_block ******************************************************************************//**
+ * @brief		Appends a block of caller provided memory to the end of the arena's chain.
+ * @retval		false if mem is too small to hold a block header. */
+bool arena_add_block(Arena* a, void* mem, unsigned size)
+{
+	ArenaBlock* block = arena_make_block(mem, size);
+
+	if(!block)
+	{
+		return false;
+	}
+
+	if(a->last)
+	{
+		a->last->next = block;
+	}
+	else
+	{
+		a->first = block;
+	}
+
+	a->last = block;
+
+	if(!a->block)
+	{
+		a->block = block;
+		a->ptr   = (uint8_t*)(block + 1);
+	}
+
+	return true;
+}
+
+
+/* arena_alloc_slow *****************************************************************************//**
+ * @brief		Allocates from the blocks following the current block when the current block is
+ *				full. Called by arena_alloc_align. If no block in the chain has room and the arena
+ *				has a pool, a new block is reserved from the pool. */
+void* arena_alloc_slow(Arena* a, unsigned size, unsigned align)
+{
+	ArenaBlock* block;
+	void*       ptr;
+
+	for(block = a->block ? a->block->next : a->first; block; block = block->next)
+	{
+		if((ptr = arena_block_alloc(a, block, (uint8_t*)(block + 1), size, align)))
+		{
+			return ptr;
+		}
+	}
+
+	if(a->pool)
+	{
+		void* mem = pool_reserve(a->pool);
+
+		if(mem)
+		{
+			if(!arena_add_block(a, mem, pool_elemsize(a->pool)))
+			{
+				pool_release(a->pool, mem);
+				return 0;
+			}
+
+			if((ptr = arena_block_alloc(a, a->last, (uint8_t*)(a->last + 1), size, align)))
+			{
+				return ptr;
+			}
+
+			/* The allocation is larger than a pool block. Leave the block in the chain for
+			 * later allocations. */
+		}
+	}
+
+	return 0;
+}
+
+
+/* arena_clear **********************************************************************************//**
+ * @brief		Frees every allocation. Blocks reserved from the arena's pool are released back to
+ *				the pool. Blocks added with arena_add_block are kept. */
+void arena_clear(Arena* a)
+{
+	ArenaBlock* block = a->first;
+
+	a->first = 0;
+	a->last  = 0;
+	a->block = 0;
+	a->ptr   = 0;
+
+	while(block)
+	{
+		ArenaBlock* next = block->next;
+
+		if(!a->pool || !pool_release(a->pool, block))
+		{
+			block->next = 0;
+
+			if(a->last)
+			{
+				a->last->next = block;
+			}
+			else
+			{
+				a->first = block;
+			}
+
+			a->last = block;
+		}
+
+		block = next;
+	}
+
+	if(a->first)
+	{
+		a->block = a->first;
+		a->ptr   = (uint8_t*)(a->first + 1);
+	}
+}
+
+
+/* arena_used ***********************************************************************************//**
+ * @brief		Returns the number of bytes between the start of the first block and the current
+ *				position, including alignment padding and unused space at the end of skipped
+ *				blocks. */
+unsigned arena_used(const Arena* a)
+{
+	const ArenaBlock* block;
+	unsigned          used = 0;
+
+	for(block = a->first; block && block != a->block; block = block->next)
+	{
+		used += block->end - (const uint8_t*)(block + 1);
+	}
+
+	if(block)
+	{
+		used += a->ptr - (const uint8_t*)(block + 1);
+	}
+
+	return used;
+}
+
+
+/* arena_make_block *****************************************************************************//**
+ * @brief		Places a block header at the start of mem, aligned for the header. Returns null if
+ *				the memory is too small. */
+static ArenaBlock* arena_make_block(void* mem, unsigned size)
+{
+	uintptr_t start = (uintptr_t)mem;
+	uintptr_t end   = start + size;
+	uintptr_t hdr   = (start + (_Alignof(ArenaBlock) - 1)) & ~(uintptr_t)(_Alignof(ArenaBlock) - 1);
+
+	if(!mem || hdr + sizeof(ArenaBlock) > end)
+	{
+		return 0;
+	}
+	else
+	{
+		ArenaBlock* block = (ArenaBlock*)hdr;
+
+		block->next = 0;
+		block->end  = (uint8_t*)end;
+		return block;
+	}
+}
+
+
+/* arena_block_alloc ****************************************************************************//**
+ * @brief		Allocates from ptr in a block and makes the block current if the allocation fits. */
+static void* arena_block_alloc(Arena* a, ArenaBlock* block, uint8_t* ptr, unsigned size, unsigned align)
+{
+	uintptr_t aligned = ((uintptr_t)ptr + (align - 1)) & ~(uintptr_t)(align - 1);
+
+	if(aligned <= (uintptr_t)block->end && size <= (uintptr_t)block->end - aligned)
+	{
+		a->block = block;
+		a->ptr   = (uint8_t*)aligned + size;
+		return (void*)aligned;
+	}
+	else
+	{
+		return 0;
+	}
+}
+
+
+/******************************************* END OF FILE *******************************************/
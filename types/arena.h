@@ -0,0 +1,177 @@
+/************************************************************************************************//**
+ * @file		arena.h
+ *
+ * @copyright	Copyright 2022 Kurt Hildebrand.
+ * @license		Licensed under the Apache License, Version 2.0 (the "License"); you may not use this
+ * 				file except in compliance with the License. You may obtain a copy of the License at
+ *
+ * 				http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * 				Unless required by applicable law or agreed to in writing, software distributed under
+ * 				the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF
+ * 				ANY KIND, either express or implied. See the License for the specific language
+ * 				governing permissions and limitations under the License.
+ *
+ * @brief		Bump pointer allocator over caller provided memory. Objects are allocated by moving a
+ *				pointer forward and are never freed individually. Instead, arena_mark records the
+ *				current position and arena_reset_to frees everything allocated after it at once.
+ *
+ *				An arena is a chain of blocks. Each block stores an ArenaBlock header at its start.
+ *				When an allocation does not fit in the current block, the arena moves on to the next
+ *				block in the chain. Blocks are added with arena_add_block or, if the arena has a
+ *				pool, reserved from the pool on demand. Blocks are kept in the chain after a reset so
+ *				they can be reused.
+ *
+ ***************************************************************************************************/
+#ifndef ARENA_H
+#define ARENA_H
+
+#if __STDC_VERSION__ < 199901L
+#error Compile with C99 or higher!
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/* Includes -------------------------------------------------------------------------------------- */
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "buffer.h"
+#include "pool.h"
+#include "range.h"
+
+
+/* Public Macros --------------------------------------------------------------------------------- */
+#define ARENA_ALIGN		(_Alignof(max_align_t))		/* Default alignment of arena_alloc */
+
+
+/* Public Types ---------------------------------------------------------------------------------- */
+typedef struct ArenaBlock {
+	struct ArenaBlock* next;
+	uint8_t*           end;
+} ArenaBlock;
+
+
+typedef struct {
+	ArenaBlock* first;
+	ArenaBlock* last;
+	ArenaBlock* block;		/* Block currently being allocated from */
+	uint8_t*    ptr;		/* Next free byte in the current block */
+	Pool*       pool;		/* Optional source of additional blocks */
+} Arena;
+
+
+typedef struct {
+	ArenaBlock* block;
+	uint8_t*    ptr;
+} ArenaMark;
+
+
+/* Public Functions ------------------------------------------------------------------------------ */
+       bool      arena_init       (Arena*, void*, unsigned);
+inline bool      arena_init_buffer(Arena*, const Buffer*);
+inline bool      arena_init_range (Arena*, const Range*);
+inline void      arena_set_pool   (Arena* a, Pool* p) { a->pool = p; }
+       bool      arena_add_block  (Arena*, void*, unsigned);
+inline void*     arena_alloc      (Arena*, unsigned);
+inline void*     arena_alloc_align(Arena*, unsigned, unsigned);
+       void*     arena_alloc_slow (Arena*, unsigned, unsigned);
+inline void*     arena_push       (Arena*, const void*, unsigned);
+inline ArenaMark arena_mark       (const Arena*);
+inline void      arena_reset_to   (Arena*, ArenaMark);
+       void      arena_clear      (Arena*);
+       unsigned  arena_used       (const Arena*);
+
+
+/* arena_init_buffer ****************************************************************************//**
+ * @brief		Initializes an arena over the free space of a buffer, the bytes between the buffer's
+ *				write pointer and its end. The buffer itself is not modified. */
+inline bool arena_init_buffer(Arena* a, const Buffer* b)
+{
+	return arena_init(a, buffer_write(b), buffer_free(b));
+}
+
+
+/* arena_init_range *****************************************************************************//**
+ * @brief		Initializes an arena over the memory of a range. */
+inline bool arena_init_range(Arena* a, const Range* r)
+{
+	return arena_init(a, range_offset(r, 0), range_count(r) * range_elemsize(r));
+}
+
+
+/* arena_alloc **********************************************************************************//**
+ * @brief		Allocates size bytes aligned for any type.
+ * @return		Pointer to the allocated memory. Null if the arena is out of memory. */
+inline void* arena_alloc(Arena* a, unsigned size)
+{
+	return arena_alloc_align(a, size, ARENA_ALIGN);
+}
+
+
+/* arena_alloc_align ****************************************************************************//**
+ * @brief		Allocates size bytes aligned to align bytes.
+ * @param[in]	a: the arena to allocate from.
+ * @param[in]	size: the number of bytes to allocate.
+ * @param[in]	align: the alignment of the allocation. Must be a power of two.
+ * @return		Pointer to the allocated memory. Null if the arena is out of memory. */
+inline void* arena_alloc_align(Arena* a, unsigned size, unsigned align)
+{
+	uintptr_t ptr = ((uintptr_t)a->ptr + (align - 1)) & ~(uintptr_t)(align - 1);
+
+	if(a->block && ptr <= (uintptr_t)a->block->end && size <= (uintptr_t)a->block->end - ptr)
+	{
+		a->ptr = (uint8_t*)ptr + size;
+		return (void*)ptr;
+	}
+	else
+	{
+		return arena_alloc_slow(a, size, align);
+	}
+}
+
+
+/* arena_push ***********************************************************************************//**
+ * @brief		Allocates a copy of size bytes of data.
+ * @return		Pointer to the copy. Null if the arena is out of memory. */
+inline void* arena_push(Arena* a, const void* data, unsigned size)
+{
+	void* ptr = arena_alloc(a, size);
+
+	if(ptr)
+	{
+		memmove(ptr, data, size);
+	}
+
+	return ptr;
+}
+
+
+/* arena_mark ***********************************************************************************//**
+ * @brief		Returns the current position of the arena. */
+inline ArenaMark arena_mark(const Arena* a)
+{
+	return (ArenaMark){ .block = a->block, .ptr = a->ptr };
+}
+
+
+/* arena_reset_to *******************************************************************************//**
+ * @brief		Frees everything allocated since the mark was taken. Marks taken after the mark are
+ *				invalidated. */
+inline void arena_reset_to(Arena* a, ArenaMark mark)
+{
+	a->block = mark.block;
+	a->ptr   = mark.ptr;
+}
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // ARENA_H
+/******************************************* END OF FILE *******************************************/
@@ -0,0 +1,334 @@
+/************************************************************************************************//**
+ * @file		atomicbits.c
+ *
+ * @copyright	Copyright Kurt Hildebrand.
+ * @license		Licensed under the Apache License, Version 2.0 (the "License"); you may not use this
+ *				file except in compliance with the License. You may obtain a copy of the License at
+ *
+ *				http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *				Unless required by applicable law or agreed to in writing, software distributed under
+ *				the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF
+ *				ANY KIND, either express or implied. See the License for the specific language
+ *				governing permissions and limitations under the License.
+ *
+ ***************************************************************************************************/
+#include "atomicbits.h"
+#include "calc.h"
+
+
+/* Inline Function Instances --------------------------------------------------------------------- */
+extern unsigned atomicbits_count(const AtomicBits*);
+extern bool     atomicbits_value(const AtomicBits*, unsigned);
+
+
+/* Private Functions ----------------------------------------------------------------------------- */
+static uint64_t atomicbits_mask     (unsigned, unsigned, unsigned);
+static unsigned atomicbits_next     (const AtomicBits*, unsigned, bool);
+static unsigned atomicbits_claim_run(AtomicBits*, unsigned, unsigned);
+
+
+/* atomicbits_init ******************************************************************************//**
+ * @brief		Initializes the bit array with every bit cleared.
+ * @param[in]	b: the bit array to initialize.
+ * @param[in]	words: array of ATOMICBITS_WORDS(count) words.
+ * @param[in]	count: the number of bits in the bit array. */
+void atomicbits_init(AtomicBits* b, _Atomic uint64_t* words, unsigned count)
+{
+	b->words = words;
+	b->count = words ? count : 0;
+	atomic_init(&b->hint, 0);
+
+	atomicbits_clear_all(b);
+}
+
+
+/* atomicbits_clear_all *************************************************************************//**
+ * @brief		Clears every bit in the bit array. Must not be called while other threads are
+ *				claiming bits. */
+void atomicbits_clear_all(AtomicBits* b)
+{
+	unsigned i;
+
+	for(i = 0; i < b->count / 64; i++)
+	{
+		atomic_store_explicit(&b->words[i], 0, memory_order_relaxed);
+	}
+
+	/* Keep the unused bits of the last word set so they are never claimed */
+	if(b->count % 64)
+	{
+		atomic_store_explicit(&b->words[i], UINT64_MAX << (b->count % 64), memory_order_relaxed);
+	}
+
+	atomic_store_explicit(&b->hint, 0, memory_order_relaxed);
+	atomic_thread_fence(memory_order_seq_cst);
+}
+
+
+/* atomicbits_ones ******************************************************************************//**
+ * @brief		Returns the number of set bits. The count is a snapshot and may be stale by the time
+ *				it is returned if other threads are claiming and releasing bits. */
+unsigned atomicbits_ones(const AtomicBits* b)
+{
+	unsigned count = 0;
+	unsigned i;
+
+	for(i = 0; i < ATOMICBITS_WORDS(b->count); i++)
+	{
+		count += calc_popcount_u64(atomic_load_explicit(&b->words[i], memory_order_relaxed));
+	}
+
+	return b->count % 64 ? count - (64 - b->count % 64) : count;
+}
+
+
+/* atomicbits_test_and_set **********************************************************************//**
+ * @brief		Sets the bit at the specified index.
+ * @return		The previous value of the bit. A thread that sees false has claimed the bit. Returns
+ *				true if the index is out of range so the bit is never claimed. */
+bool atomicbits_test_and_set(AtomicBits* b, unsigned idx)
+{
+	uint64_t bit = (uint64_t)1 << (idx % 64);
+
+	if(idx >= b->count)
+	{
+		return true;
+	}
+
+	return (atomic_fetch_or_explicit(&b->words[idx / 64], bit, memory_order_acq_rel) & bit) != 0;
+}
+
+
+/* atomicbits_test_and_clear ********************************************************************//**
+ * @brief		Clears the bit at the specified index.
+ * @return		The previous value of the bit. A thread that sees true has released the bit. Returns
+ *				false if the index is out of range. */
+bool atomicbits_test_and_clear(AtomicBits* b, unsigned idx)
+{
+	uint64_t bit = (uint64_t)1 << (idx % 64);
+
+	if(idx >= b->count)
+	{
+		return false;
+	}
+
+	return (atomic_fetch_and_explicit(&b->words[idx / 64], ~bit, memory_order_acq_rel) & bit) != 0;
+}
+
+
+/* atomicbits_claim *****************************************************************************//**
+ * @brief		Finds a clear bit and sets it. The search starts at the word of the most recent claim
+ *				so threads do not rescan words that are already full.
+ * @return		The index of the claimed bit. -1u if every bit is set. */
+unsigned atomicbits_claim(AtomicBits* b)
+{
+	return atomicbits_claim_from(b, atomic_load_explicit(&b->hint, memory_order_relaxed) * 64);
+}
+
+
+/* atomicbits_claim_from ************************************************************************//**
+ * @brief		Finds the first clear bit at or after start, wrapping around to the start of the array,
+ *				and sets it. Threads that pass different starting points spread their claims over
+ *				different words and do not contend on the same compare and swap.
+ * @return		The index of the claimed bit. -1u if every bit is set. */
+unsigned atomicbits_claim_from(AtomicBits* b, unsigned start)
+{
+	unsigned words = ATOMICBITS_WORDS(b->count);
+	unsigned first = start < b->count ? start / 64 : 0;
+	unsigned shift = start < b->count ? start % 64 : 0;
+	unsigned i;
+
+	/* The first word is visited twice: bits from start on, then bits below start after wrapping */
+	for(i = 0; i <= words && words; i++)
+	{
+		unsigned w    = (first + i) % words;
+		uint64_t mask = UINT64_MAX;
+		uint64_t word = atomic_load_explicit(&b->words[w], memory_order_relaxed);
+
+		if(i == 0)
+		{
+			mask = UINT64_MAX << shift;
+		}
+		else if(i == words)
+		{
+			mask = ~(UINT64_MAX << shift);
+		}
+
+		while(~word & mask)
+		{
+			uint64_t bit = (~word & mask) & -(~word & mask);	/* Isolate the lowest clear bit */
+
+			if(atomic_compare_exchange_weak_explicit(
+				&b->words[w], &word, word | bit, memory_order_acq_rel, memory_order_relaxed))
+			{
+				if(atomic_load_explicit(&b->hint, memory_order_relaxed) != w)
+				{
+					atomic_store_explicit(&b->hint, w, memory_order_relaxed);
+				}
+
+				return w * 64 + calc_ctz_u64(bit);
+			}
+		}
+	}
+
+	return -1u;
+}
+
+
+/* atomicbits_claim_many ************************************************************************//**
+ * @brief		Finds the first run of count clear bits and sets them all. Runs that span words are
+ *				claimed one word at a time in increasing order. If another thread claims a bit of the
+ *				run first, the words already claimed are released and the search continues past the
+ *				conflicting bit. Other threads may briefly see those words as claimed.
+ * @return		The index of the first bit of the run. -1u if there is no run of count clear bits. */
+unsigned atomicbits_claim_many(AtomicBits* b, unsigned count)
+{
+	unsigned pos = 0;
+
+	if(count == 0 || count > b->count)
+	{
+		return -1u;
+	}
+
+	while(pos <= b->count - count)
+	{
+		unsigned first = atomicbits_next(b, pos, false);
+		unsigned end;
+
+		if(first > b->count - count)
+		{
+			return -1u;
+		}
+
+		/* Check the snapshot for a run before trying to claim it */
+		end = atomicbits_next(b, first, true);
+
+		if(end - first < count)
+		{
+			pos = end;
+		}
+		else if((pos = atomicbits_claim_run(b, first, count)) == -1u)
+		{
+			return first;
+		}
+		else
+		{
+			pos++;
+		}
+	}
+
+	return -1u;
+}
+
+
+/* atomicbits_clear_many ************************************************************************//**
+ * @brief		Clears count bits starting at the specified index, such as a run returned by
+ *				atomicbits_claim_many.
+ * @retval		true if the bits were cleared.
+ * @retval		false if the bits are out of range. */
+bool atomicbits_clear_many(AtomicBits* b, unsigned start, unsigned count)
+{
+	unsigned w;
+
+	if(start > b->count || count > b->count - start)
+	{
+		return false;
+	}
+
+	for(w = start / 64; count && w <= (start + count - 1) / 64; w++)
+	{
+		atomic_fetch_and_explicit(
+			&b->words[w], ~atomicbits_mask(w, start, start + count - 1), memory_order_release);
+	}
+
+	return true;
+}
+
+
+/* atomicbits_mask ******************************************************************************//**
+ * @brief		Returns the bits of word w that lie within first through last. */
+static uint64_t atomicbits_mask(unsigned w, unsigned first, unsigned last)
+{
+	uint64_t mask = UINT64_MAX;
+
+	if(w == first / 64)
+	{
+		mask &= UINT64_MAX << (first % 64);
+	}
+
+	if(w == last / 64)
+	{
+		mask &= UINT64_MAX >> (63 - last % 64);
+	}
+
+	return mask;
+}
+
+
+/* atomicbits_next ******************************************************************************//**
+ * @brief		Returns the index of the next bit with the value at or after idx in a snapshot of the
+ *				bit array. Returns the number of bits if there is none. */
+static unsigned atomicbits_next(const AtomicBits* b, unsigned idx, bool value)
+{
+	uint64_t invert = value ? 0 : UINT64_MAX;
+	unsigned w      = idx / 64;
+	uint64_t word;
+
+	if(idx >= b->count)
+	{
+		return b->count;
+	}
+
+	word  = atomic_load_explicit(&b->words[w], memory_order_relaxed) ^ invert;
+	word &= UINT64_MAX << (idx % 64);
+
+	while(word == 0)
+	{
+		if(++w >= ATOMICBITS_WORDS(b->count))
+		{
+			return b->count;
+		}
+
+		word = atomic_load_explicit(&b->words[w], memory_order_relaxed) ^ invert;
+	}
+
+	return calc_min(w * 64 + calc_ctz_u64(word), b->count);
+}
+
+
+/* atomicbits_claim_run *************************************************************************//**
+ * @brief		Claims count bits starting at first, one word at a time.
+ * @return		-1u if the run was claimed. Otherwise the index of a bit in the run that was already
+ *				set. Nothing is claimed in that case. */
+static unsigned atomicbits_claim_run(AtomicBits* b, unsigned first, unsigned count)
+{
+	unsigned last = first + count - 1;
+	unsigned w, i;
+
+	for(w = first / 64; w <= last / 64; w++)
+	{
+		uint64_t mask = atomicbits_mask(w, first, last);
+		uint64_t word = atomic_load_explicit(&b->words[w], memory_order_relaxed);
+
+		do {
+			if(word & mask)
+			{
+				/* Lost the race. Release the words claimed so far. */
+				for(i = first / 64; i < w; i++)
+				{
+					atomic_fetch_and_explicit(
+						&b->words[i], ~atomicbits_mask(i, first, last), memory_order_release);
+				}
+
+				return w * 64 + calc_ctz_u64(word & mask);
+			}
+		} while(!atomic_compare_exchange_weak_explicit(
+			&b->words[w], &word, word | mask, memory_order_acq_rel, memory_order_relaxed));
+	}
+
+	return -1u;
+}
+
+
+/******************************************* END OF FILE *******************************************/
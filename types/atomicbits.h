@@ -0,0 +1,88 @@
+/************************************************************************************************//**
+ * @file		atomicbits.h
+ *
+ * @copyright	Copyright 2022 Kurt Hildebrand.
+ * @license		Licensed under the Apache License, Version 2.0 (the "License"); you may not use this
+ * 				file except in compliance with the License. You may obtain a copy of the License at
+ *
+ * 				http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * 				Unless required by applicable law or agreed to in writing, software distributed under
+ * 				the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF
+ * 				ANY KIND, either express or implied. See the License for the specific language
+ * 				governing permissions and limitations under the License.
+ *
+ * @brief		Bit array whose bits can be tested, set, cleared and claimed by many threads at once.
+ *
+ ***************************************************************************************************/
+#ifndef ATOMICBITS_H
+#define ATOMICBITS_H
+
+#if __STDC_VERSION__ < 199901L
+#error Compile with C99 or higher!
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/* Includes -------------------------------------------------------------------------------------- */
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+
+/* Public Macros --------------------------------------------------------------------------------- */
+#define ATOMICBITS_WORDS(n)		(((n) + 63) / 64)	/* Number of 64-bit words for n bits */
+
+
+/* Public Types ---------------------------------------------------------------------------------- */
+/* AtomicBits ***********************************************************************************//**
+ * @brief		Bit array stored in 64-bit atomic words. A 1 bit marks a claimed id or slot. Claiming
+ *				finds a 0 bit with count trailing zeros and sets it with a compare and swap on its
+ *				word, so claims and releases are lock-free. The unused bits of the last word are kept
+ *				set so they are never claimed. */
+typedef struct {
+	_Atomic uint64_t* words;
+	unsigned          count;
+	_Atomic unsigned  hint;			/* Word of the most recent claim. Claims start searching here. */
+} AtomicBits;
+
+
+/* Public Functions ------------------------------------------------------------------------------ */
+       void     atomicbits_init          (AtomicBits*, _Atomic uint64_t*, unsigned);
+       void     atomicbits_clear_all     (AtomicBits*);
+inline unsigned atomicbits_count         (const AtomicBits* b) { return b->count; }
+       unsigned atomicbits_ones          (const AtomicBits*);
+inline bool     atomicbits_value         (const AtomicBits*, unsigned);
+       bool     atomicbits_test_and_set  (AtomicBits*, unsigned);
+       bool     atomicbits_test_and_clear(AtomicBits*, unsigned);
+       unsigned atomicbits_claim         (AtomicBits*);
+       unsigned atomicbits_claim_from    (AtomicBits*, unsigned);
+       unsigned atomicbits_claim_many    (AtomicBits*, unsigned);
+       bool     atomicbits_clear_many    (AtomicBits*, unsigned, unsigned);
+
+
+/* atomicbits_value *****************************************************************************//**
+ * @brief		Returns true if the bit at the specified index is set. Returns false if the bit is not
+ *				set or the index is out of range. */
+inline bool atomicbits_value(const AtomicBits* b, unsigned idx)
+{
+	if(idx < b->count)
+	{
+		return (atomic_load_explicit(&b->words[idx / 64], memory_order_acquire) >> (idx % 64)) & 1;
+	}
+	else
+	{
+		return false;
+	}
+}
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // ATOMICBITS_H
+/******************************************* END OF FILE *******************************************/
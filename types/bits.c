@@ -13,9 +13,11 @@
  * 				governing permissions and limitations under the License.
  *
  ***************************************************************************************************/
+#include <stdatomic.h>
 #include <string.h>
 
 #include "bits.h"
+#include "byteorder.h"
 #include "calc.h"
 
 
@@ -40,49 +42,42 @@ extern bool     bits_clear     (Bits*, unsigned);
 extern bool     bits_flip      (Bits*, unsigned);
 
 
-/* bits_zeros ***********************************************************************************//**
- * @brief		Returns the number of 0's in the bit array. */
-unsigned bits_zeros(const Bits* b)
-{
-	const uint8_t* ptr = (const uint8_t*)(b->ptr);
-	unsigned count = 0;
-	unsigned i;
+/* Private Macros -------------------------------------------------------------------------------- */
+#if defined(__x86_64__) && defined(__GNUC__) && !defined(__POPCNT__)
+#define BITS_POPCNT_DISPATCH	/* Choose a popcnt word loop at run time if the CPU supports it */
+#endif
 
-	/* Count bits 4 bytes at a time */
-	for(i = 0; i < bits_count(b); i += 32)
-	{
-		uint32_t temp = 0;
 
-		/* Check if 4 or more bytes remain. If so, just copy 4 bytes into temp. Just counting bits
-		 * does not require worrying about endianness. */
-		if(bits_count(b) - i >= 32)
-		{
-			memmove(&temp, &ptr[i/8], 4);
-		}
-		/* Less than 32 bits remain. Copy bytes manually and mask off unwanted bits. */
-		else
-		{
-			uint32_t mask = (UINT32_MAX << (bits_count(b) - i));
-			if(bits_count(b) - i > 0)  { temp |= (ptr[i/8 + 0] << 0);  }
-			if(bits_count(b) - i > 8)  { temp |= (ptr[i/8 + 1] << 8);  }
-			if(bits_count(b) - i > 16) { temp |= (ptr[i/8 + 2] << 16); }
-			if(bits_count(b) - i > 24) { temp |= (ptr[i/8 + 3] << 24); }
-			temp |= mask;
-		}
+/* Private Types --------------------------------------------------------------------------------- */
+typedef enum {
+	BITS_OP_AND,
+	BITS_OP_OR,
+	BITS_OP_XOR,
+	BITS_OP_ANDNOT,
+} BitsOp;
 
-		// temp = calc_popcount_u32(~temp);
-		// // temp = ~temp;
-		// // temp = ((temp >> 1)  & 0x55555555) + (temp & 0x55555555);
-		// // temp = ((temp >> 2)  & 0x33333333) + (temp & 0x33333333);
-		// // temp = ((temp >> 4)  & 0x0F0F0F0F) + (temp & 0x0F0F0F0F);
-		// // temp = ((temp >> 8)  & 0x00FF00FF) + (temp & 0x00FF00FF);
-		// // temp = ((temp >> 16) & 0x0000FFFF) + (temp & 0x0000FFFF);
-		// count += temp;
 
-		count += calc_popcount_u32(~temp);
-	}
+/* Private Functions ----------------------------------------------------------------------------- */
+static uint64_t bits_word    (const Bits*, unsigned);
+static unsigned bits_popcount(const uint8_t*, const uint8_t*, unsigned);
+static unsigned bits_popcount_words(const uint8_t*, const uint8_t*, unsigned);
+#if defined(BITS_POPCNT_DISPATCH)
+static unsigned bits_popcount_popcnt(const uint8_t*, const uint8_t*, unsigned);
+#endif
+static void     bits_combine (Bits*, const Bits*, BitsOp);
+
+
+/* Private Variables ----------------------------------------------------------------------------- */
+#if defined(BITS_POPCNT_DISPATCH)
+static _Atomic int bits_has_popcnt = -1;	/* 1 if the CPU has popcnt. 0 if not. -1 unknown */
+#endif
+
 
-	return count;
+/* bits_zeros ***********************************************************************************//**
+ * @brief		Returns the number of 0's in the bit array. */
+unsigned bits_zeros(const Bits* b)
+{
+	return bits_count(b) - bits_ones(b);
 }
 
 
@@ -90,44 +85,7 @@ unsigned bits_zeros(const Bits* b)
  * @brief		Returns the number of 1's in the bit array. */
 unsigned bits_ones(const Bits* b)
 {
-	const uint8_t* ptr = (const uint8_t*)(b->ptr);
-	unsigned count = 0;
-	unsigned i;
-
-	/* Count bits 4 bytes at a time */
-	for(i = 0; i < bits_count(b); i += 32)
-	{
-		uint32_t temp = 0;
-
-		/* Check if 4 or more bytes remain. If so, just copy 4 bytes into temp. Just counting bits
-		 * does not require worrying about endianness. */
-		if(bits_count(b) - i >= 32)
-		{
-			memmove(&temp, &ptr[i/8], 4);
-		}
-		/* Less than 32 bits remain. Copy bytes manually and mask off unwanted bits. */
-		else
-		{
-			uint32_t mask = (UINT32_MAX << (bits_count(b) - i));
-			if(bits_count(b) - i > 0)  { temp |= (ptr[i/8 + 0] << 0);  }
-			if(bits_count(b) - i > 8)  { temp |= (ptr[i/8 + 1] << 8);  }
-			if(bits_count(b) - i > 16) { temp |= (ptr[i/8 + 2] << 16); }
-			if(bits_count(b) - i > 24) { temp |= (ptr[i/8 + 3] << 24); }
-			temp &= ~mask;
-		}
-
-		// temp = calc_popcount_u32(temp);
-		// // temp = ((temp >> 1)  & 0x55555555) + (temp & 0x55555555);
-		// // temp = ((temp >> 2)  & 0x33333333) + (temp & 0x33333333);
-		// // temp = ((temp >> 4)  & 0x0F0F0F0F) + (temp & 0x0F0F0F0F);
-		// // temp = ((temp >> 8)  & 0x00FF00FF) + (temp & 0x00FF00FF);
-		// // temp = ((temp >> 16) & 0x0000FFFF) + (temp & 0x0000FFFF);
-		// count += temp;
-
-		count += calc_popcount_u32(temp);
-	}
-
-	return count;
+	return bits_popcount(b->ptr, 0, bits_count(b));
 }
 
 
@@ -139,23 +97,33 @@ unsigned bits_ones(const Bits* b)
  * @param[in]	value: the value of the search bit: false to find a 0 bit, true to find a 1 bit. */
 unsigned bits_next_value(Bits* b, unsigned idx, bool value)
 {
-	uint8_t* ptr = (uint8_t*)(b->ptr);
+	uint64_t invert = value ? 0 : UINT64_MAX;
+	uint64_t word;
+	unsigned w;
 
-	while(idx < bits_end(b))
+	if(idx >= bits_end(b))
 	{
-		if(value && (ptr[idx/8] & (1 << (idx % 8))) != 0)
-		{
-			return idx;
-		}
-		else if(!value && (ptr[idx/8] & (1 << (idx % 8))) == 0)
+		return -1u;
+	}
+
+	/* Search a word at a time. Inverting the word turns a search for 0 into a search for 1. Bits
+	 * past the end of the array are rejected by the final bounds check. */
+	w    = idx / 64;
+	word = (bits_word(b, w) ^ invert) & (UINT64_MAX << (idx % 64));
+
+	while(word == 0)
+	{
+		if(++w >= (bits_end(b) + 63) / 64)
 		{
-			return idx;
+			return -1u;
 		}
 
-		idx++;
+		word = bits_word(b, w) ^ invert;
 	}
 
-	return -1u;
+	idx = w * 64 + calc_ctz_u64(word);
+
+	return idx < bits_end(b) ? idx : -1u;
 }
 
 
@@ -167,28 +135,54 @@ unsigned bits_next_value(Bits* b, unsigned idx, bool value)
  * @param[in]	value: the value of the search bit: false to find a 0 bit, true to find a 1 bit. */
 unsigned bits_prev_value(Bits* b, unsigned idx, bool value)
 {
-	uint8_t* ptr = (uint8_t*)(b->ptr);
+	uint64_t invert = value ? 0 : UINT64_MAX;
+	uint64_t word;
+	unsigned w;
 
-	if(idx >= bits_end(b))
+	if(bits_end(b) == 0)
+	{
+		return -1u;
+	}
+	else if(idx >= bits_end(b))
 	{
 		idx = bits_end(b) - 1;
 	}
 
-	while(idx != -1u)
+	/* Mask off bits above idx. Since idx < count, bits past the end are never considered. */
+	w    = idx / 64;
+	word = (bits_word(b, w) ^ invert) & (UINT64_MAX >> (63 - idx % 64));
+
+	while(word == 0)
 	{
-		if(value && (ptr[idx/8] & (1 << (idx % 8))) != 0)
-		{
-			return idx;
-		}
-		else if(!value && (ptr[idx/8] & (1 << (idx % 8))) == 0)
+		if(w-- == 0)
 		{
-			return idx;
+			return -1u;
 		}
 
-		idx--;
+		word = bits_word(b, w) ^ invert;
+	}
+
+	return w * 64 + 63 - calc_clz_u64(word);
+}
+
+
+/* bits_next_run ********************************************************************************//**
+ * @brief		Returns the length of the run of equal bits starting at the specified index. Returns 0
+ *				if the index is out of range.
+ * @param[in]	b: the bit array to search.
+ * @param[in]	idx: the first bit of the run. */
+unsigned bits_next_run(Bits* b, unsigned idx)
+{
+	unsigned end;
+
+	if(idx >= bits_end(b))
+	{
+		return 0;
 	}
 
-	return -1u;
+	end = bits_next_value(b, idx, !bits_value(b, idx));
+
+	return (end == -1u ? bits_end(b) : end) - idx;
 }
 
 
@@ -377,4 +371,398 @@ bool bits_flip_many(Bits* b, unsigned start, unsigned count)
 }
 
 
+/* bits_and *************************************************************************************//**
+ * @brief		Computes d = d & s. Bits of d past the end of s are cleared. */
+void bits_and(Bits* d, const Bits* s)
+{
+	bits_combine(d, s, BITS_OP_AND);
+}
+
+
+/* bits_or **************************************************************************************//**
+ * @brief		Computes d = d | s. Bits of s past the end of d are ignored. */
+void bits_or(Bits* d, const Bits* s)
+{
+	bits_combine(d, s, BITS_OP_OR);
+}
+
+
+/* bits_xor *************************************************************************************//**
+ * @brief		Computes d = d ^ s. Bits of s past the end of d are ignored. */
+void bits_xor(Bits* d, const Bits* s)
+{
+	bits_combine(d, s, BITS_OP_XOR);
+}
+
+
+/* bits_andnot **********************************************************************************//**
+ * @brief		Computes d = d & ~s, clearing every bit of d that is set in s. */
+void bits_andnot(Bits* d, const Bits* s)
+{
+	bits_combine(d, s, BITS_OP_ANDNOT);
+}
+
+
+/* bits_count_and *******************************************************************************//**
+ * @brief		Returns the number of bits set in both a and b, which is the size of the intersection
+ *				of the two sets. Neither bit array is modified. */
+unsigned bits_count_and(const Bits* a, const Bits* b)
+{
+	unsigned count = bits_count(a) < bits_count(b) ? bits_count(a) : bits_count(b);
+
+	return bits_popcount(a->ptr, b->ptr, count);
+}
+
+
+/* bits_index_init ******************************************************************************//**
+ * @brief		Builds a rank and select index over a bit array.
+ * @param[in]	ix: the index to initialize.
+ * @param[in]	b: the bit array to index. Must outlive the index.
+ * @param[in]	words: array of BITS_INDEX_WORDS(bits_count(b)) words to hold the index. */
+void bits_index_init(BitsIndex* ix, Bits* b, uint64_t* words)
+{
+	ix->bits  = b;
+	ix->words = words;
+	ix->stale = 0;
+
+	bits_index_build(ix);
+}
+
+
+/* bits_index_update ****************************************************************************//**
+ * @brief		Marks the index stale from the superblock holding the changed bit. Call after writing
+ *				to the bit array, passing the lowest index written. */
+void bits_index_update(BitsIndex* ix, unsigned idx)
+{
+	ix->stale = calc_min(ix->stale, idx / 512);
+}
+
+
+/* bits_index_build *****************************************************************************//**
+ * @brief		Rebuilds the stale part of the index. Called by bits_rank and bits_select, so only
+ *				needed to control when the work is done. */
+void bits_index_build(BitsIndex* ix)
+{
+	const Bits* b      = ix->bits;
+	unsigned    supers = (bits_count(b) + 511) / 512;
+	unsigned    words  = (bits_count(b) + 63) / 64;
+	uint64_t    ones   = 0;
+	unsigned    s, j;
+
+	if(ix->stale > supers)
+	{
+		return;
+	}
+
+	/* Superblocks before the stale one are valid, so their count is the starting point */
+	ones = ix->stale ? ix->words[2 * ix->stale] : 0;
+
+	for(s = ix->stale; s < supers; s++)
+	{
+		uint64_t blocks = 0;
+		unsigned rel    = 0;
+
+		for(j = 0; j < 8 && s * 8 + j < words; j++)
+		{
+			uint64_t word = bits_word(b, s * 8 + j);
+
+			if(s * 8 + j == words - 1 && bits_count(b) % 64)
+			{
+				word &= UINT64_MAX >> (64 - bits_count(b) % 64);
+			}
+
+			if(j > 0)
+			{
+				blocks |= (uint64_t)rel << (9 * (j - 1));
+			}
+
+			rel += calc_popcount_u64(word);
+		}
+
+		for( ; j < 8; j++)
+		{
+			blocks |= (uint64_t)rel << (9 * (j - 1));
+		}
+
+		ix->words[2 * s + 0] = ones;
+		ix->words[2 * s + 1] = blocks;
+		ones += rel;
+	}
+
+	/* The entry past the last superblock holds the total */
+	ix->words[2 * supers]     = ones;
+	ix->words[2 * supers + 1] = 0;
+	ix->stale = -1u;
+}
+
+
+/* bits_rank ************************************************************************************//**
+ * @brief		Returns the number of 1's before the specified index. Returns the number of 1's in the
+ *				bit array if the index is out of range. */
+unsigned bits_rank(BitsIndex* ix, unsigned idx)
+{
+	const Bits* b = ix->bits;
+	unsigned    s, j;
+	uint64_t    rank;
+
+	bits_index_build(ix);
+
+	if(idx >= bits_count(b))
+	{
+		return ix->words[2 * ((bits_count(b) + 511) / 512)];
+	}
+
+	s    = idx / 512;
+	j    = (idx / 64) % 8;
+	rank = ix->words[2 * s];
+
+	if(j > 0)
+	{
+		rank += (ix->words[2 * s + 1] >> (9 * (j - 1))) & 0x1FF;
+	}
+
+	if(idx % 64)
+	{
+		rank += calc_popcount_u64(bits_word(b, idx / 64) & (UINT64_MAX >> (64 - idx % 64)));
+	}
+
+	return rank;
+}
+
+
+/* bits_select **********************************************************************************//**
+ * @brief		Returns the index of the k-th 1 counting from 0, which is the index i such that
+ *				bits_rank(i) == k and bit i is set. Returns -1u if there are not more than k 1's. */
+unsigned bits_select(BitsIndex* ix, unsigned k)
+{
+	const Bits* b  = ix->bits;
+	unsigned    lo = 0;
+	unsigned    hi = (bits_count(b) + 511) / 512;
+	unsigned    j;
+	uint64_t    word;
+
+	bits_index_build(ix);
+
+	if(k >= ix->words[2 * hi])
+	{
+		return -1u;
+	}
+
+	/* Find the last superblock with fewer than k+1 1's before it */
+	while(hi - lo > 1)
+	{
+		unsigned mid = lo + (hi - lo) / 2;
+
+		if(ix->words[2 * mid] <= k)
+		{
+			lo = mid;
+		}
+		else
+		{
+			hi = mid;
+		}
+	}
+
+	/* Find the block within the superblock */
+	k -= ix->words[2 * lo];
+
+	for(j = 7; j > 0 && ((ix->words[2 * lo + 1] >> (9 * (j - 1))) & 0x1FF) > k; j--);
+
+	if(j > 0)
+	{
+		k -= (ix->words[2 * lo + 1] >> (9 * (j - 1))) & 0x1FF;
+	}
+
+	/* Drop the lower k 1's of the word */
+	for(word = bits_word(b, lo * 8 + j); k; k--)
+	{
+		word &= word - 1;
+	}
+
+	return (lo * 8 + j) * 64 + calc_ctz_u64(word);
+}
+
+
+/* bits_word ************************************************************************************//**
+ * @brief		Returns the 64-bit word w of the bit array with bit 0 of the word being bit w*64 of the
+ *				array. Bytes past the end of the array read as 0. */
+static uint64_t bits_word(const Bits* b, unsigned w)
+{
+	const uint8_t* ptr   = (const uint8_t*)(b->ptr) + w * 8;
+	unsigned       bytes = (bits_count(b) + 7) / 8 - w * 8;
+	uint64_t       word  = 0;
+	unsigned       i;
+
+	if(bytes >= 8)
+	{
+		return le_get_u64(ptr);
+	}
+
+	for(i = 0; i < bytes; i++)
+	{
+		word |= (uint64_t)ptr[i] << (i * 8);
+	}
+
+	return word;
+}
+
+
+/* bits_popcount ********************************************************************************//**
+ * @brief		Returns the number of 1's in the first count bits of a, or of a & b if b is not null.
+ *				Bits are counted 64 at a time. Counting bits does not require worrying about
+ *				endianness. */
+static unsigned bits_popcount(const uint8_t* a, const uint8_t* b, unsigned count)
+{
+	unsigned total;
+	unsigned bytes = count / 8;
+	unsigned i     = bytes & ~7u;
+
+	#if defined(BITS_POPCNT_DISPATCH)
+	int has_popcnt = atomic_load_explicit(&bits_has_popcnt, memory_order_relaxed);
+
+	if(has_popcnt < 0)
+	{
+		__builtin_cpu_init();
+		has_popcnt = __builtin_cpu_supports("popcnt") != 0;
+		atomic_store_explicit(&bits_has_popcnt, has_popcnt, memory_order_relaxed);
+	}
+
+	total = has_popcnt ? bits_popcount_popcnt(a, b, i) : bits_popcount_words(a, b, i);
+	#else
+	total = bits_popcount_words(a, b, i);
+	#endif
+
+	for( ; i < bytes; i++)
+	{
+		total += calc_popcount_u16(b ? a[i] & b[i] : a[i]);
+	}
+
+	/* Mask off unused bits in the last byte */
+	if(count % 8)
+	{
+		total += calc_popcount_u16((b ? a[i] & b[i] : a[i]) & ~(UINT8_MAX << (count % 8)));
+	}
+
+	return total;
+}
+
+
+/* bits_popcount_words **************************************************************************//**
+ * @brief		Returns the number of 1's in the first bytes bytes of a, or of a & b if b is not null.
+ *				bytes must be a multiple of 8. */
+static unsigned bits_popcount_words(const uint8_t* a, const uint8_t* b, unsigned bytes)
+{
+	unsigned total = 0;
+	unsigned i;
+	uint64_t x, y;
+
+	for(i = 0; i < bytes; i += 8)
+	{
+		memmove(&x, &a[i], 8);
+
+		if(b)
+		{
+			memmove(&y, &b[i], 8);
+			x &= y;
+		}
+
+		total += calc_popcount_u64(x);
+	}
+
+	return total;
+}
+
+
+#if defined(BITS_POPCNT_DISPATCH)
+/* bits_popcount_popcnt *************************************************************************//**
+ * @brief		Same as bits_popcount_words but compiled for CPUs with the popcnt instruction. Only
+ *				called after __builtin_cpu_supports("popcnt") confirms the CPU has it. */
+__attribute__((target("popcnt")))
+static unsigned bits_popcount_popcnt(const uint8_t* a, const uint8_t* b, unsigned bytes)
+{
+	unsigned total = 0;
+	unsigned i;
+	uint64_t x, y;
+
+	for(i = 0; i < bytes; i += 8)
+	{
+		memmove(&x, &a[i], 8);
+
+		if(b)
+		{
+			memmove(&y, &b[i], 8);
+			x &= y;
+		}
+
+		total += (unsigned)__builtin_popcountll(x);
+	}
+
+	return total;
+}
+#endif
+
+
+/* bits_combine *********************************************************************************//**
+ * @brief		Combines s into d 64 bits at a time. Only bits below bits_count(d) are changed. Bits of
+ *				s past the end of d are ignored. Bits of d past the end of s are combined with 0. */
+static void bits_combine(Bits* d, const Bits* s, BitsOp op)
+{
+	uint8_t*       dst    = (uint8_t*)(d->ptr);
+	const uint8_t* src    = (const uint8_t*)(s->ptr);
+	unsigned       shared = bits_count(d) < bits_count(s) ? bits_count(d) : bits_count(s);
+	unsigned       bytes  = shared / 8;
+	unsigned       i;
+	uint64_t       x, y;
+
+	for(i = 0; i + 8 <= bytes; i += 8)
+	{
+		memmove(&x, &dst[i], 8);
+		memmove(&y, &src[i], 8);
+
+		switch(op)
+		{
+			case BITS_OP_AND:    x &=  y; break;
+			case BITS_OP_OR:     x |=  y; break;
+			case BITS_OP_XOR:    x ^=  y; break;
+			case BITS_OP_ANDNOT: x &= ~y; break;
+		}
+
+		memmove(&dst[i], &x, 8);
+	}
+
+	for( ; i < bytes; i++)
+	{
+		switch(op)
+		{
+			case BITS_OP_AND:    dst[i] &=  src[i]; break;
+			case BITS_OP_OR:     dst[i] |=  src[i]; break;
+			case BITS_OP_XOR:    dst[i] ^=  src[i]; break;
+			case BITS_OP_ANDNOT: dst[i] &= ~src[i]; break;
+		}
+	}
+
+	/* Combine the last shared byte without touching the bits past either array's end */
+	if(shared % 8)
+	{
+		uint8_t mask = ~(UINT8_MAX << (shared % 8));
+		uint8_t byte = dst[bytes];
+
+		switch(op)
+		{
+			case BITS_OP_AND:    byte &=  src[bytes]; break;
+			case BITS_OP_OR:     byte |=  src[bytes]; break;
+			case BITS_OP_XOR:    byte ^=  src[bytes]; break;
+			case BITS_OP_ANDNOT: byte &= ~src[bytes]; break;
+		}
+
+		dst[bytes] = (dst[bytes] & ~mask) | (byte & mask);
+	}
+
+	if(op == BITS_OP_AND && shared < bits_count(d))
+	{
+		bits_clear_many(d, shared, bits_count(d) - shared);
+	}
+}
+
+
 /******************************************* END OF FILE *******************************************/
@@ -32,6 +32,7 @@ extern "C" {
 
 /* Public Macros --------------------------------------------------------------------------------- */
 #define BIT_ARRAY_SIZE(n)	(((n) + 7) / 8)
+#define BITS_INDEX_WORDS(n)	(2 * (((n) + 511) / 512 + 1))	/* Words of a BitsIndex over n bits */
 
 
 /* Public Types ---------------------------------------------------------------------------------- */
@@ -41,6 +42,22 @@ typedef struct {
 } Bits;
 
 
+/* BitsIndex ************************************************************************************//**
+ * @brief		Rank and select index over a bit array. For each 512 bit superblock the index stores
+ *				two words: the number of 1's before the superblock and the number of 1's before each
+ *				of its eight 64 bit blocks packed into 9 bit fields. A rank is two table lookups and a
+ *				popcount. A select is a binary search over the superblocks followed by a scan of at
+ *				most eight blocks. The index uses 25% of the memory of the bit array.
+ *
+ *				The index is not updated when the bit array changes. Call bits_index_update with the
+ *				lowest changed bit and the index rebuilds from that superblock on the next query. */
+typedef struct {
+	Bits*     bits;
+	uint64_t* words;		/* BITS_INDEX_WORDS(bits_count(bits)) words */
+	unsigned  stale;		/* First superblock to rebuild. -1u if the index is up to date. */
+} BitsIndex;
+
+
 /* Public Functions ------------------------------------------------------------------------------ */
 inline void     bits_init      (Bits*, void*, unsigned);
 inline Bits     make_bits      (void*, unsigned);
@@ -56,6 +73,7 @@ inline unsigned bits_next_zero (Bits* b, unsigned idx) { return bits_next_value(
 inline unsigned bits_prev_zero (Bits* b, unsigned idx) { return bits_prev_value(b, idx, 0); }
 inline unsigned bits_next_one  (Bits* b, unsigned idx) { return bits_next_value(b, idx, 1); }
 inline unsigned bits_prev_one  (Bits* b, unsigned idx) { return bits_prev_value(b, idx, 1); }
+       unsigned bits_next_run  (Bits*, unsigned);
 
        void     bits_set_all   (Bits*);
        void     bits_clear_all (Bits*);
@@ -65,6 +83,18 @@ inline bool     bits_set_many  (Bits*, unsigned, unsigned);
 inline bool     bits_clear_many(Bits*, unsigned, unsigned);
        bool     bits_flip_many (Bits*, unsigned, unsigned);
 
+       void     bits_and       (Bits*, const Bits*);
+       void     bits_or        (Bits*, const Bits*);
+       void     bits_xor       (Bits*, const Bits*);
+       void     bits_andnot    (Bits*, const Bits*);
+       unsigned bits_count_and (const Bits*, const Bits*);
+
+       void     bits_index_init  (BitsIndex*, Bits*, uint64_t*);
+       void     bits_index_update(BitsIndex*, unsigned);
+       void     bits_index_build (BitsIndex*);
+       unsigned bits_rank        (BitsIndex*, unsigned);
+       unsigned bits_select      (BitsIndex*, unsigned);
+
 inline bool     bits_write     (Bits* b, bool w, unsigned i) { return bits_write_many(b, w, i, 1); }
 inline bool     bits_set       (Bits* b, unsigned i)         { return bits_set_many  (b, i, 1);    }
 inline bool     bits_clear     (Bits* b, unsigned i)         { return bits_clear_many(b, i, 1);    }
@@ -0,0 +1,343 @@
+/************************************************************************************************//**
+ * @file		bufferchain.c
+ *
+ * @copyright	Copyright 2022 Kurt Hildebrand.
+ * @license		Licensed under the Apache License, Version 2.0 (the "License"); you may not use this
+ * 				file except in compliance with the License. You may obtain a copy of the License at
+ *
+ * 				http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * 				Unless required by applicable law or agreed to in writing, software distributed under
+ * 				the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF
+ * 				ANY KIND, either express or implied. See the License for the specific language
+ * 				governing permissions and limitations under the License.
+ *
+ ***************************************************************************************************/
+#if defined(__linux__)
+#include <sys/uio.h>
+#endif
+
+#include "bufferchain.h"
+#include "calc.h"
+
+
+/* Inline Function Instances --------------------------------------------------------------------- */
+extern void     bufferchain_clear       (BufferChain*);
+extern unsigned bufferchain_count       (const BufferChain*);
+extern unsigned bufferchain_size        (const BufferChain*);
+extern Buffer*  bufferchain_segment     (const BufferChain*, unsigned);
+extern bool     bufferchain_empty       (const BufferChain*);
+
+
+/* Private Functions ----------------------------------------------------------------------------- */
+static Buffer* bufferchain_front(const BufferChain*);
+static bool    bufferchain_copy (const BufferChain*, void*, unsigned, unsigned);
+
+
+/* bufferchain_init *****************************************************************************//**
+ * @brief		Initializes an empty chain.
+ * @param[in]	c: the chain to initialize.
+ * @param[in]	segments: array of size Buffers to hold the chain's segment descriptors.
+ * @param[in]	size: the most segments in the chain. */
+bool bufferchain_init(BufferChain* c, Buffer* segments, unsigned size)
+{
+	if(!segments || !size)
+	{
+		return false;
+	}
+
+	c->segments = segments;
+	c->count    = 0;
+	c->size     = size;
+	return true;
+}
+
+
+/* bufferchain_length ***************************************************************************//**
+ * @brief		Returns the number of unread bytes in the chain. */
+unsigned bufferchain_length(const BufferChain* c)
+{
+	unsigned i;
+	unsigned length = 0;
+
+	for(i = 0; i < c->count; i++)
+	{
+		length += buffer_remaining(&c->segments[i]);
+	}
+
+	return length;
+}
+
+
+/* bufferchain_append ***************************************************************************//**
+ * @brief		Appends a segment to the end of the chain. The descriptor is copied, the data is not.
+ * @retval		false if the chain is full or the buffer is invalid. */
+bool bufferchain_append(BufferChain* c, const Buffer* b)
+{
+	if(c->count >= c->size || !buffer_is_valid(b))
+	{
+		return false;
+	}
+
+	c->segments[c->count++] = *b;
+	return true;
+}
+
+
+/* bufferchain_prepend **************************************************************************//**
+ * @brief		Inserts a segment at the front of the chain. The descriptor is copied, the data is not.
+ * @retval		false if the chain is full or the buffer is invalid. */
+bool bufferchain_prepend(BufferChain* c, const Buffer* b)
+{
+	if(c->count >= c->size || !buffer_is_valid(b))
+	{
+		return false;
+	}
+
+	memmove(&c->segments[1], &c->segments[0], c->count * sizeof(Buffer));
+	c->segments[0] = *b;
+	c->count++;
+	return true;
+}
+
+
+/* bufferchain_reserve_head *********************************************************************//**
+ * @brief		Reserves len bytes in front of the chain's data from the headroom of the first
+ *				segment.
+ * @return		Pointer to the reserved bytes. Null if the first segment's headroom is too small. */
+void* bufferchain_reserve_head(BufferChain* c, unsigned len)
+{
+	Buffer* b = bufferchain_segment(c, 0);
+
+	if(!b || (unsigned)(b->read - b->start) < len)
+	{
+		return 0;
+	}
+
+	b->read -= len;
+	return b->read;
+}
+
+
+/* bufferchain_push_head ************************************************************************//**
+ * @brief		Copies len bytes in front of the chain's data. See bufferchain_reserve_head. */
+bool bufferchain_push_head(BufferChain* c, const void* in, unsigned len)
+{
+	void* ptr = bufferchain_reserve_head(c, len);
+
+	if(ptr)
+	{
+		memmove(ptr, in, len);
+	}
+
+	return ptr != 0;
+}
+
+
+/* bufferchain_push_mem *************************************************************************//**
+ * @brief		Appends len bytes after the chain's data. The bytes fill the tailroom of the last
+ *				segment holding data and then the segments after it. Nothing is written unless all
+ *				len bytes fit. */
+bool bufferchain_push_mem(BufferChain* c, const void* in, unsigned len)
+{
+	const uint8_t* src   = in;
+	unsigned       first = c->count;
+	unsigned       room  = 0;
+	unsigned       i;
+
+	/* Find the last segment holding data */
+	while(first > 0 && buffer_remaining(&c->segments[first - 1]) == 0)
+	{
+		first--;
+	}
+
+	first = first > 0 ? first - 1 : 0;
+
+	for(i = first; i < c->count; i++)
+	{
+		room += buffer_tailroom(&c->segments[i]);
+	}
+
+	if(room < len)
+	{
+		return false;
+	}
+
+	for(i = first; len > 0; i++)
+	{
+		unsigned n = calc_min_uint(len, buffer_tailroom(&c->segments[i]));
+
+		buffer_push_mem(&c->segments[i], src, n);
+		src += n;
+		len -= n;
+	}
+
+	return true;
+}
+
+
+/* bufferchain_peek *****************************************************************************//**
+ * @brief		Returns a pointer to the first len bytes of the chain if they are contiguous in one
+ *				segment. Null otherwise. Use bufferchain_peek_mem for bytes spanning segments. */
+void* bufferchain_peek(const BufferChain* c, unsigned len)
+{
+	Buffer* b = bufferchain_front(c);
+
+	return b ? buffer_peek(b, len) : 0;
+}
+
+
+/* bufferchain_pop ******************************************************************************//**
+ * @brief		Removes the first len bytes of the chain if they are contiguous in one segment.
+ * @return		Pointer to the removed bytes. Null if the bytes span segments or the chain is too
+ *				short. */
+void* bufferchain_pop(BufferChain* c, unsigned len)
+{
+	Buffer* b = bufferchain_front(c);
+
+	return b ? buffer_pop(b, len) : 0;
+}
+
+
+/* bufferchain_peek_mem *************************************************************************//**
+ * @brief		Copies the first len bytes of the chain without removing them. */
+bool bufferchain_peek_mem(const BufferChain* c, void* out, unsigned len)
+{
+	return bufferchain_copy(c, out, 0, len);
+}
+
+
+/* bufferchain_pop_mem **************************************************************************//**
+ * @brief		Copies and removes the first len bytes of the chain. Out may be null to discard the
+ *				bytes.
+ * @retval		false if the chain holds fewer than len bytes. Nothing is removed. */
+bool bufferchain_pop_mem(BufferChain* c, void* out, unsigned len)
+{
+	unsigned i;
+
+	if(!bufferchain_copy(c, out, 0, len))
+	{
+		return false;
+	}
+
+	for(i = 0; len > 0; i++)
+	{
+		unsigned n = calc_min_uint(len, buffer_remaining(&c->segments[i]));
+
+		c->segments[i].read += n;
+		len -= n;
+	}
+
+	return true;
+}
+
+
+/* bufferchain_read_offset **********************************************************************//**
+ * @brief		Copies len bytes starting offset bytes into the chain's data without removing them. */
+bool bufferchain_read_offset(const BufferChain* c, void* out, unsigned offset, unsigned len)
+{
+	return bufferchain_copy(c, out, offset, len);
+}
+
+
+/* bufferchain_iovec ****************************************************************************//**
+ * @brief		Describes the chain's data as an array of struct iovec. Empty segments are skipped.
+ *				Only supported where struct iovec is available.
+ * @param[in]	c: the chain to describe.
+ * @param[out]	iov: receives one entry per segment holding data.
+ * @param[in]	count: the number of entries in iov.
+ * @return		The number of entries filled. 0 if the chain does not fit in count entries. */
+unsigned bufferchain_iovec(const BufferChain* c, struct iovec* iov, unsigned count)
+{
+	#if defined(__linux__)
+	unsigned i;
+	unsigned n = 0;
+
+	for(i = 0; i < c->count; i++)
+	{
+		const Buffer* b = &c->segments[i];
+
+		if(buffer_remaining(b) == 0)
+		{
+			continue;
+		}
+
+		if(n >= count)
+		{
+			return 0;
+		}
+
+		iov[n].iov_base = buffer_read(b);
+		iov[n].iov_len  = buffer_remaining(b);
+		n++;
+	}
+
+	return n;
+	#else
+	(void)c;
+	(void)iov;
+	(void)count;
+	return 0;
+	#endif
+}
+
+
+/* bufferchain_front ****************************************************************************//**
+ * @brief		Returns the first segment holding data. Null if the chain is empty. */
+static Buffer* bufferchain_front(const BufferChain* c)
+{
+	unsigned i;
+
+	for(i = 0; i < c->count; i++)
+	{
+		if(buffer_remaining(&c->segments[i]))
+		{
+			return &c->segments[i];
+		}
+	}
+
+	return 0;
+}
+
+
+/* bufferchain_copy *****************************************************************************//**
+ * @brief		Copies len bytes starting offset bytes into the chain's data. Out may be null.
+ * @retval		false if the chain holds fewer than offset + len bytes. */
+static bool bufferchain_copy(const BufferChain* c, void* out, unsigned offset, unsigned len)
+{
+	uint8_t* dest = out;
+	unsigned i;
+
+	if(bufferchain_length(c) < offset || bufferchain_length(c) - offset < len)
+	{
+		return false;
+	}
+
+	for(i = 0; len > 0; i++)
+	{
+		const Buffer* b = &c->segments[i];
+		unsigned      n = buffer_remaining(b);
+
+		if(offset >= n)
+		{
+			offset -= n;
+			continue;
+		}
+
+		n = calc_min_uint(len, n - offset);
+
+		if(dest)
+		{
+			memcpy(dest, buffer_read(b) + offset, n);
+			dest += n;
+		}
+
+		offset = 0;
+		len   -= n;
+	}
+
+	return true;
+}
+
+
+/******************************************* END OF FILE *******************************************/
@@ -0,0 +1,95 @@
+/************************************************************************************************//**
+ * @file		bufferchain.h
+ *
+ * @copyright	Copyright 2022 Kurt Hildebrand.
+ * @license		Licensed under the Apache License, Version 2.0 (the "License"); you may not use this
+ * 				file except in compliance with the License. You may obtain a copy of the License at
+ *
+ * 				http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * 				Unless required by applicable law or agreed to in writing, software distributed under
+ * 				the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF
+ * 				ANY KIND, either express or implied. See the License for the specific language
+ * 				governing permissions and limitations under the License.
+ *
+ * @brief		Scatter-gather chain of Buffers. A packet can be assembled from a header buffer and
+ *				one or more payload buffers without copying the payload. The chain holds copies of the
+ *				Buffer descriptors in a caller provided array. The bytes themselves are not copied.
+ *
+ *				The bytes in each segment are those between its read and write pointers, so the
+ *				space between a segment's start and its read pointer is headroom. A header can be
+ *				prepended into the headroom of the first segment with bufferchain_reserve_head.
+ *				Pushes append to the tailroom of the last segment holding data and continue into the
+ *				segments after it. Peeks and pops read from the front and may span segments.
+ *
+ *				bufferchain_iovec fills an array of struct iovec for readv, writev and sendmsg.
+ *
+ ***************************************************************************************************/
+#ifndef BUFFERCHAIN_H
+#define BUFFERCHAIN_H
+
+#if __STDC_VERSION__ < 199901L
+#error Compile with C99 or higher!
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/* Includes -------------------------------------------------------------------------------------- */
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "buffer.h"
+
+
+/* Public Types ---------------------------------------------------------------------------------- */
+struct iovec;
+
+
+typedef struct {
+	Buffer*  segments;
+	unsigned count;			/* Number of segments in use */
+	unsigned size;			/* Number of segments allocated */
+} BufferChain;
+
+
+/* Public Functions ------------------------------------------------------------------------------ */
+       bool     bufferchain_init        (BufferChain*, Buffer*, unsigned);
+inline void     bufferchain_clear       (BufferChain* c)       { c->count = 0;                       }
+inline unsigned bufferchain_count       (const BufferChain* c) { return c->count;                    }
+inline unsigned bufferchain_size        (const BufferChain* c) { return c->size;                     }
+inline Buffer*  bufferchain_segment     (const BufferChain*, unsigned);
+       unsigned bufferchain_length      (const BufferChain*);
+inline bool     bufferchain_empty       (const BufferChain* c) { return bufferchain_length(c) == 0;  }
+
+       bool     bufferchain_append      (BufferChain*, const Buffer*);
+       bool     bufferchain_prepend     (BufferChain*, const Buffer*);
+       void*    bufferchain_reserve_head(BufferChain*, unsigned);
+       bool     bufferchain_push_head   (BufferChain*, const void*, unsigned);
+       bool     bufferchain_push_mem    (BufferChain*, const void*, unsigned);
+
+       void*    bufferchain_peek        (const BufferChain*, unsigned);
+       void*    bufferchain_pop         (BufferChain*, unsigned);
+       bool     bufferchain_peek_mem    (const BufferChain*, void*, unsigned);
+       bool     bufferchain_pop_mem     (BufferChain*, void*, unsigned);
+       bool     bufferchain_read_offset (const BufferChain*, void*, unsigned, unsigned);
+
+       unsigned bufferchain_iovec       (const BufferChain*, struct iovec*, unsigned);
+
+
+/* bufferchain_segment **************************************************************************//**
+ * @brief		Returns the i'th segment. Null if i is not less than bufferchain_count. */
+inline Buffer* bufferchain_segment(const BufferChain* c, unsigned i)
+{
+	return i < c->count ? &c->segments[i] : 0;
+}
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // BUFFERCHAIN_H
+/******************************************* END OF FILE *******************************************/
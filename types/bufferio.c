@@ -0,0 +1,312 @@
+/************************************************************************************************//**
+ * @file		bufferio.c
+ *
+ * @copyright	Copyright 2022 Kurt Hildebrand.
+ * @license		Licensed under the Apache License, Version 2.0 (the "License"); you may not use this
+ * 				file except in compliance with the License. You may obtain a copy of the License at
+ *
+ * 				http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * 				Unless required by applicable law or agreed to in writing, software distributed under
+ * 				the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF
+ * 				ANY KIND, either express or implied. See the License for the specific language
+ * 				governing permissions and limitations under the License.
+ *
+ ***************************************************************************************************/
+#if defined(__linux__)
+#define _GNU_SOURCE
+#endif
+
+#if defined(__linux__)
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#endif
+
+#include "bufferio.h"
+#include "calc.h"
+
+
+/* Private Functions ----------------------------------------------------------------------------- */
+#if defined(__linux__)
+static unsigned bufferio_batch  (unsigned);
+static void     bufferio_written(Buffer*, unsigned, size_t);
+static void     bufferio_read   (Buffer*, unsigned, size_t);
+static unsigned bufferio_tail   (const BufferChain*);
+#endif
+
+
+/* buffer_read_fd *******************************************************************************//**
+ * @brief		Reads from a file descriptor into the buffer's tailroom. See buffer_readv. */
+long buffer_read_fd(Buffer* b, int fd)
+{
+	return buffer_readv(b, 1, fd);
+}
+
+
+/* buffer_write_fd ******************************************************************************//**
+ * @brief		Writes the buffer's unread bytes to a file descriptor. See buffer_writev. */
+long buffer_write_fd(Buffer* b, int fd)
+{
+	return buffer_writev(b, 1, fd);
+}
+
+
+/* buffer_readv *********************************************************************************//**
+ * @brief		Reads from a file descriptor into the tailroom of several buffers with one readv.
+ *				Each buffer is filled before the next. Write pointers are advanced by the bytes read.
+ * @param[in]	bufs: the buffers to fill.
+ * @param[in]	count: the number of buffers. At most BUFFERIO_BATCH are used.
+ * @param[in]	fd: the file descriptor to read from.
+ * @return		The number of bytes read. 0 at end of file. -1 on error. */
+long buffer_readv(Buffer* bufs, unsigned count, int fd)
+{
+	#if defined(__linux__)
+	struct iovec iov[BUFFERIO_BATCH];
+	unsigned     i;
+	ssize_t      n;
+
+	if((count = bufferio_batch(count)) == 0)
+	{
+		return 0;
+	}
+
+	for(i = 0; i < count; i++)
+	{
+		iov[i].iov_base = buffer_write(&bufs[i]);
+		iov[i].iov_len  = buffer_tailroom(&bufs[i]);
+	}
+
+	if((n = readv(fd, iov, count)) > 0)
+	{
+		bufferio_written(bufs, count, n);
+	}
+
+	return n;
+	#else
+	(void)bufs;
+	(void)count;
+	(void)fd;
+	return -1;
+	#endif
+}
+
+
+/* buffer_writev ********************************************************************************//**
+ * @brief		Writes the unread bytes of several buffers to a file descriptor with one writev. Read
+ *				pointers are advanced by the bytes written, so after a partial write the buffers hold
+ *				exactly the bytes which remain to be written.
+ * @param[in]	bufs: the buffers to drain.
+ * @param[in]	count: the number of buffers. At most BUFFERIO_BATCH are used.
+ * @param[in]	fd: the file descriptor to write to.
+ * @return		The number of bytes written. -1 on error. */
+long buffer_writev(Buffer* bufs, unsigned count, int fd)
+{
+	#if defined(__linux__)
+	struct iovec iov[BUFFERIO_BATCH];
+	unsigned     i;
+	ssize_t      n;
+
+	if((count = bufferio_batch(count)) == 0)
+	{
+		return 0;
+	}
+
+	for(i = 0; i < count; i++)
+	{
+		iov[i].iov_base = buffer_read(&bufs[i]);
+		iov[i].iov_len  = buffer_remaining(&bufs[i]);
+	}
+
+	if((n = writev(fd, iov, count)) > 0)
+	{
+		bufferio_read(bufs, count, n);
+	}
+
+	return n;
+	#else
+	(void)bufs;
+	(void)count;
+	(void)fd;
+	return -1;
+	#endif
+}
+
+
+/* buffer_recvmmsg ******************************************************************************//**
+ * @brief		Receives up to count datagrams with one recvmmsg, one datagram into the tailroom of
+ *				each buffer. Each buffer's write pointer is advanced by its datagram's length. A
+ *				datagram larger than the tailroom is truncated.
+ * @param[in]	bufs: the buffers to fill.
+ * @param[in]	count: the number of buffers. At most BUFFERIO_BATCH are used.
+ * @param[in]	fd: the socket to receive from.
+ * @param[in]	flags: flags passed to recvmmsg, such as MSG_DONTWAIT.
+ * @return		The number of datagrams received. -1 on error. */
+int buffer_recvmmsg(Buffer* bufs, unsigned count, int fd, int flags)
+{
+	#if defined(__linux__)
+	struct iovec   iov [BUFFERIO_BATCH];
+	struct mmsghdr msgs[BUFFERIO_BATCH];
+	unsigned       i;
+	int            n;
+
+	count = bufferio_batch(count);
+	memset(msgs, 0, count * sizeof(msgs[0]));
+
+	for(i = 0; i < count; i++)
+	{
+		iov[i].iov_base             = buffer_write(&bufs[i]);
+		iov[i].iov_len              = buffer_tailroom(&bufs[i]);
+		msgs[i].msg_hdr.msg_iov    = &iov[i];
+		msgs[i].msg_hdr.msg_iovlen = 1;
+	}
+
+	n = recvmmsg(fd, msgs, count, flags, 0);
+
+	for(i = 0; n > 0 && i < (unsigned)n; i++)
+	{
+		bufs[i].write += msgs[i].msg_len;
+	}
+
+	return n;
+	#else
+	(void)bufs;
+	(void)count;
+	(void)fd;
+	(void)flags;
+	return -1;
+	#endif
+}
+
+
+/* buffer_sendmmsg ******************************************************************************//**
+ * @brief		Sends up to count datagrams with one sendmmsg, one datagram holding the unread bytes
+ *				of each buffer. The read pointers of the buffers which were sent are advanced to
+ *				their write pointers.
+ * @param[in]	bufs: the buffers to send.
+ * @param[in]	count: the number of buffers. At most BUFFERIO_BATCH are used.
+ * @param[in]	fd: the socket to send on. Must be connected.
+ * @param[in]	flags: flags passed to sendmmsg, such as MSG_DONTWAIT.
+ * @return		The number of datagrams sent. -1 on error. */
+int buffer_sendmmsg(Buffer* bufs, unsigned count, int fd, int flags)
+{
+	#if defined(__linux__)
+	struct iovec   iov [BUFFERIO_BATCH];
+	struct mmsghdr msgs[BUFFERIO_BATCH];
+	unsigned       i;
+	int            n;
+
+	count = bufferio_batch(count);
+	memset(msgs, 0, count * sizeof(msgs[0]));
+
+	for(i = 0; i < count; i++)
+	{
+		iov[i].iov_base             = buffer_read(&bufs[i]);
+		iov[i].iov_len              = buffer_remaining(&bufs[i]);
+		msgs[i].msg_hdr.msg_iov    = &iov[i];
+		msgs[i].msg_hdr.msg_iovlen = 1;
+	}
+
+	n = sendmmsg(fd, msgs, count, flags);
+
+	for(i = 0; n > 0 && i < (unsigned)n; i++)
+	{
+		bufs[i].read = bufs[i].write;
+	}
+
+	return n;
+	#else
+	(void)bufs;
+	(void)count;
+	(void)fd;
+	(void)flags;
+	return -1;
+	#endif
+}
+
+
+/* bufferchain_read_fd **************************************************************************//**
+ * @brief		Reads from a file descriptor onto the end of a chain with one readv. The bytes fill
+ *				the tailroom of the last segment holding data and the segments after it, as with
+ *				bufferchain_push_mem. See buffer_readv. */
+long bufferchain_read_fd(BufferChain* c, int fd)
+{
+	#if defined(__linux__)
+	unsigned tail = bufferio_tail(c);
+
+	return buffer_readv(&c->segments[tail], c->count - tail, fd);
+	#else
+	(void)c;
+	(void)fd;
+	return -1;
+	#endif
+}
+
+
+/* bufferchain_write_fd *************************************************************************//**
+ * @brief		Writes the chain's data to a file descriptor with one writev. The bytes written are
+ *				removed from the front of the chain. See buffer_writev. */
+long bufferchain_write_fd(BufferChain* c, int fd)
+{
+	return buffer_writev(c->segments, c->count, fd);
+}
+
+
+#if defined(__linux__)
+/* bufferio_batch *******************************************************************************//**
+ * @brief		Limits a number of buffers to one batch. */
+static unsigned bufferio_batch(unsigned count)
+{
+	return calc_min_uint(count, BUFFERIO_BATCH);
+}
+
+
+/* bufferio_written *****************************************************************************//**
+ * @brief		Advances the write pointers of buffers filled in order with n bytes. */
+static void bufferio_written(Buffer* bufs, unsigned count, size_t n)
+{
+	unsigned i;
+
+	for(i = 0; i < count && n > 0; i++)
+	{
+		unsigned len = calc_min_uint(buffer_tailroom(&bufs[i]), n);
+
+		bufs[i].write += len;
+		n -= len;
+	}
+}
+
+
+/* bufferio_read ********************************************************************************//**
+ * @brief		Advances the read pointers of buffers drained in order of n bytes. */
+static void bufferio_read(Buffer* bufs, unsigned count, size_t n)
+{
+	unsigned i;
+
+	for(i = 0; i < count && n > 0; i++)
+	{
+		unsigned len = calc_min_uint(buffer_remaining(&bufs[i]), n);
+
+		bufs[i].read += len;
+		n -= len;
+	}
+}
+
+
+/* bufferio_tail ********************************************************************************//**
+ * @brief		Returns the index of the last segment holding data, or 0 if the chain is empty. */
+static unsigned bufferio_tail(const BufferChain* c)
+{
+	unsigned i = c->count;
+
+	while(i > 0 && buffer_remaining(&c->segments[i - 1]) == 0)
+	{
+		i--;
+	}
+
+	return i > 0 ? i - 1 : 0;
+}
+#endif
+
+
+/******************************************* END OF FILE *******************************************/
@@ -0,0 +1,73 @@
+/************************************************************************************************//**
+ * @file		bufferio.h
+ *
+ * @copyright	Copyright 2022 Kurt Hildebrand.
+ * @license		Licensed under the Apache License, Version 2.0 (the "License"); you may not use this
+ * 				file except in compliance with the License. You may obtain a copy of the License at
+ *
+ * 				http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * 				Unless required by applicable law or agreed to in writing, software distributed under
+ * 				the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF
+ * 				ANY KIND, either express or implied. See the License for the specific language
+ * 				governing permissions and limitations under the License.
+ *
+ * @brief		File descriptor I/O for Buffers and BufferChains. Reads append to a buffer's tailroom
+ *				and advance its write pointer. Writes send the bytes between a buffer's read and write
+ *				pointers and advance its read pointer. Partial transfers advance the pointers by the
+ *				number of bytes transferred, so a call can simply be repeated to continue.
+ *
+ *				The vectored functions move many buffers with one system call. buffer_readv and
+ *				buffer_writev treat an array of buffers as one stream. buffer_recvmmsg and
+ *				buffer_sendmmsg move one datagram per buffer. At most BUFFERIO_BATCH buffers are
+ *				handled per call.
+ *
+ *				Only supported on Linux. Elsewhere every function returns -1.
+ *
+ * @return		Functions return the number of bytes or datagrams transferred, 0 at end of file, or
+ *				-1 on error with errno set by the system call.
+ *
+ ***************************************************************************************************/
+#ifndef BUFFERIO_H
+#define BUFFERIO_H
+
+#if __STDC_VERSION__ < 199901L
+#error Compile with C99 or higher!
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/* Includes -------------------------------------------------------------------------------------- */
+#include "buffer.h"
+#include "bufferchain.h"
+
+
+/* Public Macros --------------------------------------------------------------------------------- */
+/* BUFFERIO_BATCH *******************************************************************************//**
+ * @brief		Most buffers moved by one vectored call. The iovec and mmsghdr arrays for a batch are
+ *				kept on the stack. */
+#if !defined(BUFFERIO_BATCH)
+#define BUFFERIO_BATCH 32
+#endif
+
+
+/* Public Functions ------------------------------------------------------------------------------ */
+long buffer_read_fd      (Buffer*, int);
+long buffer_write_fd     (Buffer*, int);
+long buffer_readv        (Buffer*, unsigned, int);
+long buffer_writev       (Buffer*, unsigned, int);
+int  buffer_recvmmsg     (Buffer*, unsigned, int, int);
+int  buffer_sendmmsg     (Buffer*, unsigned, int, int);
+long bufferchain_read_fd (BufferChain*, int);
+long bufferchain_write_fd(BufferChain*, int);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // BUFFERIO_H
+/******************************************* END OF FILE *******************************************/
@@ -0,0 +1,145 @@
+/************************************************************************************************//**
+ * @file		deque.c
+ *
+ * @copyright	Copyright 2022 Kurt Hildebrand.
+ * @license		Licensed under the Apache License, Version 2.0 (the "License"); you may not use this
+ * 				file except in compliance with the License. You may obtain a copy of the License at
+ *
+ * 				http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * 				Unless required by applicable law or agreed to in writing, software distributed under
+ * 				the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF
+ * 				ANY KIND, either express or implied. See the License for the specific language
+ * 				governing permissions and limitations under the License.
+ *
+ ***************************************************************************************************/
+#include "calc.h"
+#include "deque.h"
+
+
+/* Inline Function Instances --------------------------------------------------------------------- */
+extern bool     deque_init_range(Deque*, Range);
+extern unsigned deque_size      (const Deque*);
+extern unsigned deque_count     (const Deque*);
+extern bool     deque_empty     (const Deque*);
+
+
+/* deque_init ***********************************************************************************//**
+ * @brief		Initializes an empty deque.
+ * @param[in]	d: the deque to initialize.
+ * @param[in]	slots: array of size pointers.
+ * @param[in]	size: the capacity of the deque. Must be a power of two. */
+bool deque_init(Deque* d, _Atomic(void*)* slots, unsigned size)
+{
+	if(!slots || size == 0 || calc_popcount_u32(size) != 1)
+	{
+		return false;
+	}
+
+	d->slots = slots;
+	d->mask  = size - 1;
+	deque_clear(d);
+	return true;
+}
+
+
+/* deque_clear **********************************************************************************//**
+ * @brief		Removes all pointers from the deque.
+ * @warning		This function is not thread safe. */
+void deque_clear(Deque* d)
+{
+	atomic_store_explicit(&d->top,    0, memory_order_relaxed);
+	atomic_store_explicit(&d->bottom, 0, memory_order_relaxed);
+}
+
+
+/* deque_push ***********************************************************************************//**
+ * @brief		Pushes a pointer onto the bottom of the deque. Only the owner may push.
+ * @retval		false if the deque is full. */
+bool deque_push(Deque* d, void* ptr)
+{
+	unsigned b = atomic_load_explicit(&d->bottom, memory_order_relaxed);
+	unsigned t = atomic_load_explicit(&d->top,    memory_order_acquire);
+
+	if(b - t > d->mask)
+	{
+		return false;
+	}
+
+	atomic_store_explicit(&d->slots[b & d->mask], ptr, memory_order_relaxed);
+	atomic_store_explicit(&d->bottom, b + 1, memory_order_release);
+	return true;
+}
+
+
+/* deque_pop ************************************************************************************//**
+ * @brief		Pops the most recently pushed pointer from the bottom of the deque. Only the owner
+ *				may pop.
+ * @return		The pointer. Null if the deque is empty or a thief stole the last pointer. */
+void* deque_pop(Deque* d)
+{
+	unsigned b = atomic_load_explicit(&d->bottom, memory_order_relaxed) - 1;
+	void*    ptr;
+
+	/* Claim the bottom slot before looking at top. A thief that reads bottom after this store
+	 * will not take the slot. */
+	atomic_store_explicit(&d->bottom, b, memory_order_relaxed);
+	atomic_thread_fence(memory_order_seq_cst);
+
+	unsigned t = atomic_load_explicit(&d->top, memory_order_relaxed);
+
+	if((int)(b - t) < 0)
+	{
+		/* Empty */
+		atomic_store_explicit(&d->bottom, b + 1, memory_order_relaxed);
+		return 0;
+	}
+
+	ptr = atomic_load_explicit(&d->slots[b & d->mask], memory_order_relaxed);
+
+	if(b == t)
+	{
+		/* Last pointer. Race thieves for it by advancing top. */
+		if(!atomic_compare_exchange_strong_explicit(
+			&d->top, &t, t + 1, memory_order_seq_cst, memory_order_relaxed))
+		{
+			ptr = 0;
+		}
+
+		atomic_store_explicit(&d->bottom, b + 1, memory_order_relaxed);
+	}
+
+	return ptr;
+}
+
+
+/* deque_steal **********************************************************************************//**
+ * @brief		Steals the oldest pointer from the top of the deque. Any thread may steal.
+ * @return		The pointer. Null if the deque is empty or another thread won the race for the
+ *				pointer. */
+void* deque_steal(Deque* d)
+{
+	unsigned t = atomic_load_explicit(&d->top, memory_order_acquire);
+
+	atomic_thread_fence(memory_order_seq_cst);
+
+	unsigned b = atomic_load_explicit(&d->bottom, memory_order_acquire);
+
+	if((int)(b - t) <= 0)
+	{
+		return 0;
+	}
+
+	void* ptr = atomic_load_explicit(&d->slots[t & d->mask], memory_order_relaxed);
+
+	if(!atomic_compare_exchange_strong_explicit(
+		&d->top, &t, t + 1, memory_order_seq_cst, memory_order_relaxed))
+	{
+		return 0;
+	}
+
+	return ptr;
+}
+
+
+/******************************************* END OF FILE *******************************************/
@@ -0,0 +1,101 @@
+/************************************************************************************************//**
+ * @file		deque.h
+ *
+ * @copyright	Copyright 2022 Kurt Hildebrand.
+ * @license		Licensed under the Apache License, Version 2.0 (the "License"); you may not use this
+ * 				file except in compliance with the License. You may obtain a copy of the License at
+ *
+ * 				http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * 				Unless required by applicable law or agreed to in writing, software distributed under
+ * 				the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF
+ * 				ANY KIND, either express or implied. See the License for the specific language
+ * 				governing permissions and limitations under the License.
+ *
+ * @brief		Lock-free work stealing deque of pointers (Chase and Lev). One owner thread pushes
+ *				and pops at the bottom of the deque in LIFO order. Any number of thief threads steal
+ *				from the top in FIFO order. Owner operations only synchronize with thieves when the
+ *				deque is nearly empty.
+ *
+ *				The deque has a fixed capacity, which must be a power of two. deque_push fails when
+ *				the deque is full instead of growing.
+ *
+ ***************************************************************************************************/
+#ifndef DEQUE_H
+#define DEQUE_H
+
+#if __STDC_VERSION__ < 199901L
+#error Compile with C99 or higher!
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/* Includes -------------------------------------------------------------------------------------- */
+#include <stdatomic.h>
+#include <stdbool.h>
+
+#include "range.h"
+#include "utils.h"
+
+
+/* Public Types ---------------------------------------------------------------------------------- */
+typedef struct {
+	_Atomic(void*)* slots;
+	unsigned        mask;
+
+	_Alignas(CACHE_LINE_SIZE)
+	_Atomic unsigned top;		/* Next slot to steal. Written by thieves and the owner. */
+
+	_Alignas(CACHE_LINE_SIZE)
+	_Atomic unsigned bottom;	/* Next slot to push. Written by the owner. */
+} Deque;
+
+
+/* Public Functions ------------------------------------------------------------------------------ */
+       bool     deque_init      (Deque*, _Atomic(void*)*, unsigned);
+inline bool     deque_init_range(Deque*, Range);
+       void     deque_clear     (Deque*);
+inline unsigned deque_size      (const Deque* d) { return d->mask + 1; }
+inline unsigned deque_count     (const Deque*);
+inline bool     deque_empty     (const Deque* d) { return deque_count(d) == 0; }
+       bool     deque_push      (Deque*, void*);
+       void*    deque_pop       (Deque*);
+       void*    deque_steal     (Deque*);
+
+
+/* deque_init_range *****************************************************************************//**
+ * @brief		Initializes a deque over a range of pointers. */
+inline bool deque_init_range(Deque* d, Range r)
+{
+	if(range_elemsize(&r) != sizeof(_Atomic(void*)))
+	{
+		return false;
+	}
+	else
+	{
+		return deque_init(d, range_offset(&r, 0), range_count(&r));
+	}
+}
+
+
+/* deque_count **********************************************************************************//**
+ * @brief		Returns the number of pointers in the deque. The result is a snapshot when other
+ *				threads are using the deque. */
+inline unsigned deque_count(const Deque* d)
+{
+	unsigned b = atomic_load_explicit(&d->bottom, memory_order_relaxed);
+	unsigned t = atomic_load_explicit(&d->top,    memory_order_relaxed);
+
+	return (int)(b - t) > 0 ? b - t : 0;
+}
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // DEQUE_H
+/******************************************* END OF FILE *******************************************/
@@ -0,0 +1,230 @@
+/************************************************************************************************//**
+ * @file		futex.c
+ *
+ * @copyright	Copyright 2022 Kurt Hildebrand.
+ * @license		Licensed under the Apache License, Version 2.0 (the "License"); you may not use this
+ * 				file except in compliance with the License. You may obtain a copy of the License at
+ *
+ * 				http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * 				Unless required by applicable law or agreed to in writing, software distributed under
+ * 				the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF
+ * 				ANY KIND, either express or implied. See the License for the specific language
+ * 				governing permissions and limitations under the License.
+ *
+ ***************************************************************************************************/
+#if defined(__linux__)
+#define _GNU_SOURCE
+#endif
+
+#include <limits.h>
+#include <time.h>
+
+#if defined(__linux__)
+#include <linux/futex.h>
+#include <linux/membarrier.h>
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include "futex.h"
+
+
+/* Private Macros -------------------------------------------------------------------------------- */
+#define FUTEX_POLL	(1000u)		/* Microseconds between checks when futex_barrier is unavailable */
+
+
+/* Private Functions ----------------------------------------------------------------------------- */
+#if defined(__linux__)
+static int futex_membarrier(void);
+#endif
+
+
+/* Private Variables ----------------------------------------------------------------------------- */
+#if defined(__linux__)
+static _Atomic int futex_membarrier_cmd = -1;	/* membarrier command. 0 if unavailable. -1 unknown */
+#endif
+
+
+/* futex_now ************************************************************************************//**
+ * @brief		Returns the current time in microseconds. On Linux the monotonic clock is used. */
+uint64_t futex_now(void)
+{
+	struct timespec ts;
+
+	#if defined(__linux__)
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	#else
+	timespec_get(&ts, TIME_UTC);
+	#endif
+
+	return (uint64_t)ts.tv_sec * 1000000u + (uint64_t)ts.tv_nsec / 1000u;
+}
+
+
+/* futex_deadline *******************************************************************************//**
+ * @brief		Converts a relative timeout in microseconds into an absolute deadline for futex_wait.
+ * @param[in]	timeout: the timeout in microseconds or FUTEX_FOREVER.
+ * @return		The deadline. UINT64_MAX if the timeout is FUTEX_FOREVER. */
+uint64_t futex_deadline(unsigned timeout)
+{
+	if(timeout == FUTEX_FOREVER)
+	{
+		return UINT64_MAX;
+	}
+	else
+	{
+		return futex_now() + timeout;
+	}
+}
+
+
+/* futex_wait ***********************************************************************************//**
+ * @brief		Blocks the calling thread while the word at addr equals value. The thread may also
+ *				return early due to a spurious wakeup, so callers must recheck their condition.
+ * @param[in]	addr: the word to wait on.
+ * @param[in]	value: the value of the word which causes the thread to block.
+ * @param[in]	deadline: absolute deadline returned by futex_deadline.
+ * @retval		true if the thread was woken or the word did not equal value.
+ * @retval		false if the deadline passed. */
+bool futex_wait(_Atomic unsigned* addr, unsigned value, uint64_t deadline)
+{
+	#if defined(__linux__)
+	struct timespec  ts;
+	struct timespec* pts   = 0;
+	uint64_t         limit = deadline;
+
+	/* Without membarrier a notifier may miss this waiter, so wake up periodically to recheck */
+	if(atomic_load_explicit(&futex_membarrier_cmd, memory_order_relaxed) == 0)
+	{
+		uint64_t poll = futex_now() + FUTEX_POLL;
+
+		limit = poll < deadline ? poll : deadline;
+	}
+
+	if(limit != UINT64_MAX)
+	{
+		if(futex_now() >= deadline)
+		{
+			return false;
+		}
+
+		ts.tv_sec  = limit / 1000000u;
+		ts.tv_nsec = (limit % 1000000u) * 1000u;
+		pts        = &ts;
+	}
+
+	/* FUTEX_WAIT_BITSET takes an absolute CLOCK_MONOTONIC timeout so that spurious wakeups do not
+	 * extend the total time spent waiting. */
+	if(syscall(SYS_futex, (unsigned*)addr, FUTEX_WAIT_BITSET | FUTEX_PRIVATE_FLAG, value, pts, 0,
+		FUTEX_BITSET_MATCH_ANY) == 0)
+	{
+		return true;
+	}
+	else
+	{
+		/* EAGAIN: the word did not equal value. EINTR: interrupted by a signal. ETIMEDOUT: the
+		 * deadline passed. */
+		return deadline == UINT64_MAX || futex_now() < deadline;
+	}
+	#else
+	while(atomic_load_explicit(addr, memory_order_acquire) == value)
+	{
+		if(deadline != UINT64_MAX && futex_now() >= deadline)
+		{
+			return false;
+		}
+	}
+
+	return true;
+	#endif
+}
+
+
+/* futex_wake ***********************************************************************************//**
+ * @brief		Wakes up to count threads blocked in futex_wait on addr.
+ * @param[in]	addr: the word the threads are waiting on.
+ * @param[in]	count: the maximum number of threads to wake. */
+void futex_wake(_Atomic unsigned* addr, unsigned count)
+{
+	#if defined(__linux__)
+	syscall(SYS_futex, (unsigned*)addr, FUTEX_WAKE | FUTEX_PRIVATE_FLAG,
+		count > INT_MAX ? INT_MAX : (int)count, 0, 0, 0);
+	#else
+	(void)addr;
+	(void)count;
+	#endif
+}
+
+
+/* futex_barrier ********************************************************************************//**
+ * @brief		Runs a full memory barrier on every running thread of the process. A waiter calls
+ *				this after registering and before its last check, which pairs with notifiers that
+ *				check for waiters with only a compiler barrier after publishing. On Linux this uses
+ *				the membarrier system call. If membarrier is unavailable, futex_wait polls instead.
+ *				On other targets futex_wait always polls the word, so a local fence is enough. */
+void futex_barrier(void)
+{
+	atomic_thread_fence(memory_order_seq_cst);
+
+	#if defined(__linux__)
+	int cmd = futex_membarrier();
+
+	if(cmd)
+	{
+		syscall(SYS_membarrier, cmd, 0, 0);
+	}
+	#endif
+}
+
+
+/* futex_yield **********************************************************************************//**
+ * @brief		Gives up the rest of the calling thread's time slice. Used by loops which wait on
+ *				another thread without a futex to park on, so the other thread can run even when
+ *				both share a CPU. Does nothing on targets without a scheduler to yield to. */
+void futex_yield(void)
+{
+	#if defined(__linux__)
+	sched_yield();
+	#endif
+}
+
+
+#if defined(__linux__)
+/* futex_membarrier *****************************************************************************//**
+ * @brief		Returns the membarrier command used by futex_barrier, registering the process for
+ *				private expedited barriers on first use. Returns 0 if membarrier is unavailable. */
+static int futex_membarrier(void)
+{
+	int  cmd = atomic_load_explicit(&futex_membarrier_cmd, memory_order_acquire);
+	long query;
+
+	if(cmd >= 0)
+	{
+		return cmd;
+	}
+
+	query = syscall(SYS_membarrier, MEMBARRIER_CMD_QUERY, 0, 0);
+
+	if(query > 0 && (query & MEMBARRIER_CMD_PRIVATE_EXPEDITED) &&
+		syscall(SYS_membarrier, MEMBARRIER_CMD_REGISTER_PRIVATE_EXPEDITED, 0, 0) == 0)
+	{
+		cmd = MEMBARRIER_CMD_PRIVATE_EXPEDITED;
+	}
+	else if(query > 0 && (query & MEMBARRIER_CMD_GLOBAL))
+	{
+		cmd = MEMBARRIER_CMD_GLOBAL;
+	}
+	else
+	{
+		cmd = 0;
+	}
+
+	atomic_store_explicit(&futex_membarrier_cmd, cmd, memory_order_release);
+	return cmd;
+}
+#endif
+
+
+/******************************************* END OF FILE *******************************************/
@@ -0,0 +1,62 @@
+/************************************************************************************************//**
+ * @file		futex.h
+ *
+ * @copyright	Copyright 2022 Kurt Hildebrand.
+ * @license		Licensed under the Apache License, Version 2.0 (the "License"); you may not use this
+ * 				file except in compliance with the License. You may obtain a copy of the License at
+ *
+ * 				http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * 				Unless required by applicable law or agreed to in writing, software distributed under
+ * 				the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF
+ * 				ANY KIND, either express or implied. See the License for the specific language
+ * 				governing permissions and limitations under the License.
+ *
+ * @brief		Blocks a thread while an atomic word holds an expected value. On Linux, waiting threads
+ *				are parked in the kernel with the futex system call. On other targets, waiting threads
+ *				poll the word until it changes or the deadline passes.
+ *
+ *				A waiter registers itself, calls futex_barrier, and then checks its condition one last
+ *				time before parking. futex_barrier runs a memory barrier on every thread of the
+ *				process, so notifiers can check for registered waiters with a plain load after
+ *				publishing and need no fence on their fast path.
+ *
+ ***************************************************************************************************/
+#ifndef FUTEX_H
+#define FUTEX_H
+
+#if __STDC_VERSION__ < 199901L
+#error Compile with C99 or higher!
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/* Includes -------------------------------------------------------------------------------------- */
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+
+/* Public Macros --------------------------------------------------------------------------------- */
+#define FUTEX_FOREVER	(-1u)		/* Timeout which never expires */
+#define FUTEX_SPIN		(64u)		/* Number of retries before a waiting thread is parked */
+
+
+/* Public Functions ------------------------------------------------------------------------------ */
+uint64_t futex_now     (void);
+uint64_t futex_deadline(unsigned);
+bool     futex_wait    (_Atomic unsigned*, unsigned, uint64_t);
+void     futex_wake    (_Atomic unsigned*, unsigned);
+void     futex_barrier (void);
+void     futex_yield   (void);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // FUTEX_H
+/******************************************* END OF FILE *******************************************/
@@ -0,0 +1,327 @@
+/************************************************************************************************//**
+ * @file		hashtable.c
+ *
+ * @copyright	Copyright 2022 Kurt Hildebrand.
+ * @license		Licensed under the Apache License, Version 2.0 (the "License"); you may not use this
+ * 				file except in compliance with the License. You may obtain a copy of the License at
+ *
+ * 				http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * 				Unless required by applicable law or agreed to in writing, software distributed under
+ * 				the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF
+ * 				ANY KIND, either express or implied. See the License for the specific language
+ * 				governing permissions and limitations under the License.
+ *
+ ***************************************************************************************************/
+#include "hashtable.h"
+
+
+/* Inline Function Instances --------------------------------------------------------------------- */
+extern unsigned hashtable_size     (const HashTable*);
+extern unsigned hashtable_count    (const HashTable*);
+extern bool     hashtable_empty    (const HashTable*);
+extern bool     hashtable_resizing (const HashTable*);
+
+
+/* Private Functions ----------------------------------------------------------------------------- */
+static Link** hashtable_bucket      (const HashTable*, uint32_t);
+static bool   hashtable_in_old      (const HashTable*, uint32_t);
+static void*  hashtable_scan        (const HashTable*, unsigned);
+static void   hashtable_init_buckets(Link**, unsigned);
+
+
+/* hashtable_init *******************************************************************************//**
+ * @brief		Initializes an empty hash table.
+ * @param[in]	t: the hash table to initialize.
+ * @param[in]	buckets: array of size bucket heads.
+ * @param[in]	size: the number of buckets. Must be a power of 2.
+ * @param[in]	hash: callback which returns the hash of a node. Receives a Link pointer.
+ * @param[in]	compare: callback which compares a key with a node. Receives the key passed to
+ *				hashtable_find and a Link pointer. Returns 0 if the node matches the key.
+ * @retval		false if the size is not a power of 2 or a parameter is null. */
+bool hashtable_init(HashTable* t, Link** buckets, unsigned size, IHash hash, ICompare compare)
+{
+	if(!buckets || !size || (size & (size - 1)) || !hash || !compare)
+	{
+		return false;
+	}
+
+	t->buckets = buckets;
+	t->size    = size;
+	t->hash    = hash;
+	t->compare = compare;
+	hashtable_clear(t);
+
+	return true;
+}
+
+
+/* hashtable_clear ******************************************************************************//**
+ * @brief		Removes every node from the table and abandons any resize in progress. */
+void hashtable_clear(HashTable* t)
+{
+	hashtable_init_buckets(t->buckets, t->size);
+
+	t->old      = 0;
+	t->old_size = 0;
+	t->migrated = 0;
+	t->count    = 0;
+}
+
+
+/* hashtable_insert *****************************************************************************//**
+ * @brief		Inserts a node. Nodes with equal keys may be inserted more than once and are found in
+ *				insertion order. While the table is resizing, the insert also migrates
+ *				HASHTABLE_MIGRATE_BUCKETS old buckets.
+ * @return		The inserted node. */
+void* hashtable_insert(HashTable* t, Link* node)
+{
+	if(!node)
+	{
+		return 0;
+	}
+
+	hashtable_migrate(t, HASHTABLE_MIGRATE_BUCKETS);
+	linked_append(hashtable_bucket(t, t->hash(node)), node);
+	t->count++;
+
+	return node;
+}
+
+
+/* hashtable_find *******************************************************************************//**
+ * @brief		Finds the first node matching a key.
+ * @param[in]	t: the hash table to search.
+ * @param[in]	hash: the hash of the key. Must equal the hash of matching nodes.
+ * @param[in]	key: the key passed to the compare callback.
+ * @return		The first node matching the key. Null if there is none. */
+void* hashtable_find(const HashTable* t, uint32_t hash, const void* key)
+{
+	Link** bucket = hashtable_bucket(t, hash);
+	Link*  node;
+
+	for(node = linked_first(*bucket); node; node = linked_next(*bucket, node))
+	{
+		if(t->compare(key, node) == 0)
+		{
+			return node;
+		}
+	}
+
+	return 0;
+}
+
+
+/* hashtable_find_next **************************************************************************//**
+ * @brief		Finds the next node after node matching a key. Used to visit every node with the same
+ *				key starting from hashtable_find.
+ * @return		The next node matching the key. Null if there is none. */
+void* hashtable_find_next(const HashTable* t, const Link* node, const void* key)
+{
+	Link** bucket;
+
+	if(!node)
+	{
+		return 0;
+	}
+
+	bucket = hashtable_bucket(t, t->hash(node));
+
+	for(node = linked_next(*bucket, node); node; node = linked_next(*bucket, node))
+	{
+		if(t->compare(key, node) == 0)
+		{
+			return (void*)node;
+		}
+	}
+
+	return 0;
+}
+
+
+/* hashtable_remove *****************************************************************************//**
+ * @brief		Removes a node from the table. Does not migrate buckets, so the next node saved by
+ *				HASHTABLE_FOREACH remains valid.
+ * @warning		The node must be in the table.
+ * @return		The removed node. */
+void* hashtable_remove(HashTable* t, Link* node)
+{
+	if(!node)
+	{
+		return 0;
+	}
+
+	linked_remove(hashtable_bucket(t, t->hash(node)), node);
+	t->count--;
+
+	return node;
+}
+
+
+/* hashtable_resize *****************************************************************************//**
+ * @brief		Starts moving the table to a new bucket array. The current array keeps its nodes
+ *				until they are migrated and must not be reused while hashtable_resizing returns true.
+ * @param[in]	t: the hash table to resize.
+ * @param[in]	buckets: array of size bucket heads.
+ * @param[in]	size: the number of buckets. Must be a power of 2. May be larger or smaller than the
+ *				current size.
+ * @retval		false if the table is already resizing or the size is not a power of 2. */
+bool hashtable_resize(HashTable* t, Link** buckets, unsigned size)
+{
+	if(hashtable_resizing(t) || !buckets || !size || (size & (size - 1)))
+	{
+		return false;
+	}
+
+	hashtable_init_buckets(buckets, size);
+
+	t->old      = t->buckets;
+	t->old_size = t->size;
+	t->migrated = 0;
+	t->buckets  = buckets;
+	t->size     = size;
+
+	return true;
+}
+
+
+/* hashtable_migrate ****************************************************************************//**
+ * @brief		Moves the nodes of up to count old buckets into the new bucket array.
+ * @return		true if the table is no longer resizing. */
+bool hashtable_migrate(HashTable* t, unsigned count)
+{
+	Link* node;
+
+	while(hashtable_resizing(t) && count--)
+	{
+		Link** old = &t->old[t->migrated++];
+
+		while((node = linked_pop_front(old)) != 0)
+		{
+			linked_append(&t->buckets[t->hash(node) & (t->size - 1)], node);
+		}
+
+		if(t->migrated == t->old_size)
+		{
+			t->old      = 0;
+			t->old_size = 0;
+			t->migrated = 0;
+		}
+	}
+
+	return !hashtable_resizing(t);
+}
+
+
+/* hashtable_first ******************************************************************************//**
+ * @brief		Returns the first node in the table. Nodes are visited in no particular order. Null
+ *				if the table is empty. */
+void* hashtable_first(const HashTable* t)
+{
+	return hashtable_scan(t, 0);
+}
+
+
+/* hashtable_next *******************************************************************************//**
+ * @brief		Returns the node after node. Null if node is the last node. Inserting during iteration
+ *				may migrate buckets and cause nodes to be skipped or visited twice. Removing the
+ *				current node is safe if the next node was fetched first. */
+void* hashtable_next(const HashTable* t, const Link* node)
+{
+	uint32_t hash;
+	Link**   bucket;
+	Link*    next;
+
+	if(!node)
+	{
+		return 0;
+	}
+
+	hash   = t->hash(node);
+	bucket = hashtable_bucket(t, hash);
+
+	if((next = linked_next(*bucket, node)) != 0)
+	{
+		return next;
+	}
+
+	/* Old buckets are numbered before new buckets */
+	if(hashtable_in_old(t, hash))
+	{
+		return hashtable_scan(t, (hash & (t->old_size - 1)) + 1);
+	}
+	else
+	{
+		return hashtable_scan(t, t->old_size + (hash & (t->size - 1)) + 1);
+	}
+}
+
+
+/* hashtable_bucket *****************************************************************************//**
+ * @brief		Returns the bucket holding nodes with a hash. While resizing, nodes stay in their old
+ *				bucket until it is migrated. */
+static Link** hashtable_bucket(const HashTable* t, uint32_t hash)
+{
+	if(hashtable_in_old(t, hash))
+	{
+		return &t->old[hash & (t->old_size - 1)];
+	}
+	else
+	{
+		return &t->buckets[hash & (t->size - 1)];
+	}
+}
+
+
+/* hashtable_in_old *****************************************************************************//**
+ * @brief		Returns true if nodes with a hash are in an old bucket which has not been migrated. */
+static bool hashtable_in_old(const HashTable* t, uint32_t hash)
+{
+	return hashtable_resizing(t) && (hash & (t->old_size - 1)) >= t->migrated;
+}
+
+
+/* hashtable_scan *******************************************************************************//**
+ * @brief		Returns the first node in the first non-empty bucket at or after pos. Positions below
+ *				old_size are old buckets and the rest are new buckets. */
+static void* hashtable_scan(const HashTable* t, unsigned pos)
+{
+	if(pos < t->migrated)
+	{
+		pos = t->migrated;
+	}
+
+	for(; pos < t->old_size; pos++)
+	{
+		if(t->old[pos])
+		{
+			return t->old[pos];
+		}
+	}
+
+	for(pos -= t->old_size; pos < t->size; pos++)
+	{
+		if(t->buckets[pos])
+		{
+			return t->buckets[pos];
+		}
+	}
+
+	return 0;
+}
+
+
+/* hashtable_init_buckets ***********************************************************************//**
+ * @brief		Empties every bucket in an array. */
+static void hashtable_init_buckets(Link** buckets, unsigned size)
+{
+	unsigned i;
+
+	for(i = 0; i < size; i++)
+	{
+		linked_init(&buckets[i]);
+	}
+}
+
+
+/******************************************* END OF FILE *******************************************/
@@ -0,0 +1,101 @@
+/************************************************************************************************//**
+ * @file		hashtable.h
+ *
+ * @copyright	Copyright 2022 Kurt Hildebrand.
+ * @license		Licensed under the Apache License, Version 2.0 (the "License"); you may not use this
+ * 				file except in compliance with the License. You may obtain a copy of the License at
+ *
+ * 				http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * 				Unless required by applicable law or agreed to in writing, software distributed under
+ * 				the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF
+ * 				ANY KIND, either express or implied. See the License for the specific language
+ * 				governing permissions and limitations under the License.
+ *
+ * @brief		Intrusive chained hash table. Objects embed a Link and are chained into buckets which
+ *				are Link list heads in a caller provided array. The table never allocates.
+ *
+ *				The caller supplies two callbacks: hash, which returns the hash of a node, and compare,
+ *				which compares a key with a node and returns 0 if they match. Bucket arrays must have
+ *				a power of 2 size and the low bits of the hash select the bucket, so hashes should be
+ *				well mixed.
+ *
+ *				hashtable_resize moves the table to a new bucket array without stopping the world.
+ *				Nodes are moved a few buckets at a time by later calls to hashtable_insert or
+ *				hashtable_migrate. A lookup still searches exactly one bucket: the old bucket if it
+ *				has not been moved yet, otherwise the new one. The old array may be reused once
+ *				hashtable_resizing returns false.
+ *
+ ***************************************************************************************************/
+#ifndef HASHTABLE_H
+#define HASHTABLE_H
+
+#if __STDC_VERSION__ < 199901L
+#error Compile with C99 or higher!
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/* Includes -------------------------------------------------------------------------------------- */
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "compare.h"
+#include "linked.h"
+
+
+/* Public Macros --------------------------------------------------------------------------------- */
+/* HASHTABLE_MIGRATE_BUCKETS ********************************************************************//**
+ * @brief		Number of old buckets moved by each hashtable_insert while the table is resizing.
+ *				With the default of 2, doubling the table when count reaches size completes before
+ *				the table fills again. */
+#if !defined(HASHTABLE_MIGRATE_BUCKETS)
+#define HASHTABLE_MIGRATE_BUCKETS 2
+#endif
+
+#define HASHTABLE_FOREACH(t, ptr, next) \
+	for((ptr) = hashtable_first((t)), (next) = hashtable_next((t), (ptr)); (ptr) != 0; \
+		(ptr) = (next), (next) = hashtable_next((t), (next)))
+
+
+/* Public Types ---------------------------------------------------------------------------------- */
+typedef uint32_t (*IHash)(const void*);
+
+
+typedef struct {
+	Link**   buckets;
+	unsigned size;			/* Number of buckets. Power of 2 */
+	Link**   old;			/* Buckets being migrated. Null unless resizing */
+	unsigned old_size;
+	unsigned migrated;		/* Old buckets below this index are empty */
+	unsigned count;
+	IHash    hash;			/* Returns the hash of a node */
+	ICompare compare;		/* Compares a key with a node */
+} HashTable;
+
+
+/* Public Functions ------------------------------------------------------------------------------ */
+       bool     hashtable_init     (HashTable*, Link**, unsigned, IHash, ICompare);
+       void     hashtable_clear    (HashTable*);
+inline unsigned hashtable_size     (const HashTable* t) { return t->size;       }
+inline unsigned hashtable_count    (const HashTable* t) { return t->count;      }
+inline bool     hashtable_empty    (const HashTable* t) { return t->count == 0; }
+inline bool     hashtable_resizing (const HashTable* t) { return t->old != 0;   }
+       void*    hashtable_insert   (HashTable*, Link*);
+       void*    hashtable_find     (const HashTable*, uint32_t, const void*);
+       void*    hashtable_find_next(const HashTable*, const Link*, const void*);
+       void*    hashtable_remove   (HashTable*, Link*);
+       bool     hashtable_resize   (HashTable*, Link**, unsigned);
+       bool     hashtable_migrate  (HashTable*, unsigned);
+       void*    hashtable_first    (const HashTable*);
+       void*    hashtable_next     (const HashTable*, const Link*);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // HASHTABLE_H
+/******************************************* END OF FILE *******************************************/
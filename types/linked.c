@@ -16,6 +16,10 @@
 #include "linked.h"
 
 
+/* Private Macros -------------------------------------------------------------------------------- */
+#define LINKED_SORT_BINS	(32)	/* Enough bins to sort 2^32 nodes */
+
+
 /* Inline Function Instances --------------------------------------------------------------------- */
 extern void     linked_init         (Link**);
 extern bool     linked_empty        (const Link*);
@@ -38,6 +42,12 @@ extern void*    linked_push_after   (Link*, Link*);
 extern void*    linked_join         (Link*, Link*);
 
 
+/* Private Functions ----------------------------------------------------------------------------- */
+static Link* linked_open       (Link*);
+static void  linked_close      (Link**, Link*);
+static Link* linked_merge_chain(Link*, Link*, ICompare);
+
+
 /* linked_count *********************************************************************************//**
  * @brief		Returns the number of entries in the linked list. */
 unsigned linked_count(const Link* head)
@@ -76,4 +86,128 @@ void* linked_compare_insert(Link** head, Link* node, ICompare compare)
 }
 
 
+/* linked_sort **********************************************************************************//**
+ * @brief		Sorts the list with a bottom-up merge sort in O(n log n) time. The sort is stable and
+ *				does not allocate. Nodes which compare equal keep their order. */
+void linked_sort(Link** head, ICompare compare)
+{
+	Link*    bins[LINKED_SORT_BINS] = { 0 };	/* bins[i] holds a sorted run of 2^i nodes */
+	Link*    chain;
+	Link*    run;
+	unsigned i;
+
+	if(!head)
+	{
+		return;
+	}
+
+	chain = linked_open(*head);
+
+	while(chain)
+	{
+		run       = chain;
+		chain     = chain->next;
+		run->next = 0;
+
+		/* Carry the run up through the occupied bins. Older runs are merged first to keep the
+		 * sort stable. */
+		for(i = 0; i < LINKED_SORT_BINS - 1 && bins[i]; i++)
+		{
+			run     = linked_merge_chain(bins[i], run, compare);
+			bins[i] = 0;
+		}
+
+		bins[i] = bins[i] ? linked_merge_chain(bins[i], run, compare) : run;
+	}
+
+	for(run = 0, i = 0; i < LINKED_SORT_BINS; i++)
+	{
+		run = bins[i] ? linked_merge_chain(bins[i], run, compare) : run;
+	}
+
+	linked_close(head, run);
+}
+
+
+/* linked_merge *********************************************************************************//**
+ * @brief		Merges the sorted list b into the sorted list a. Nodes from a come before equal nodes
+ *				from b. List b is left empty. */
+void linked_merge(Link** a, Link** b, ICompare compare)
+{
+	if(!a || !b)
+	{
+		return;
+	}
+
+	linked_close(a, linked_merge_chain(linked_open(*a), linked_open(*b), compare));
+	linked_init(b);
+}
+
+
+/* linked_open **********************************************************************************//**
+ * @brief		Breaks the circular list and returns its first node. The nodes form a chain through
+ *				their next pointers ending with null. Prev pointers are left stale. */
+static Link* linked_open(Link* head)
+{
+	if(head)
+	{
+		head->prev->next = 0;
+	}
+
+	return head;
+}
+
+
+/* linked_close *********************************************************************************//**
+ * @brief		Rebuilds the prev pointers of a null terminated chain and makes it circular again. */
+static void linked_close(Link** head, Link* chain)
+{
+	Link* prev = chain;
+
+	*head = chain;
+
+	if(!chain)
+	{
+		return;
+	}
+
+	while(prev->next)
+	{
+		prev->next->prev = prev;
+		prev = prev->next;
+	}
+
+	prev->next  = chain;
+	chain->prev = prev;
+}
+
+
+/* linked_merge_chain ***************************************************************************//**
+ * @brief		Merges two sorted null terminated chains. Nodes from a win ties. */
+static Link* linked_merge_chain(Link* a, Link* b, ICompare compare)
+{
+	Link*  head = 0;
+	Link** tail = &head;
+
+	while(a && b)
+	{
+		if(compare(b, a) < 0)
+		{
+			*tail = b;
+			b     = b->next;
+		}
+		else
+		{
+			*tail = a;
+			a     = a->next;
+		}
+
+		tail = &(*tail)->next;
+	}
+
+	*tail = a ? a : b;
+	return head;
+}
+
+
 /******************************************* END OF FILE *******************************************/
@@ -93,6 +93,8 @@ inline void*    linked_prepend       (Link**, Link*);
 inline void*    linked_insert_before (Link**, Link*, Link*);
 inline void*    linked_insert_after  (Link**, Link*, Link*);
        void*    linked_compare_insert(Link**, Link*, ICompare);
+       void     linked_sort          (Link**, ICompare);
+       void     linked_merge         (Link**, Link**, ICompare);
 inline void*    linked_remove        (Link**, Link*);
 inline void*    linked_pop_front     (Link**);
 inline void*    linked_pop_back      (Link**);
@@ -0,0 +1,170 @@
+/************************************************************************************************//**
+ * @file		lrucache.c
+ *
+ * @copyright	Copyright 2022 Kurt Hildebrand.
+ * @license		Licensed under the Apache License, Version 2.0 (the "License"); you may not use this
+ * 				file except in compliance with the License. You may obtain a copy of the License at
+ *
+ * 				http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * 				Unless required by applicable law or agreed to in writing, software distributed under
+ * 				the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF
+ * 				ANY KIND, either express or implied. See the License for the specific language
+ * 				governing permissions and limitations under the License.
+ *
+ ***************************************************************************************************/
+#include "lrucache.h"
+
+
+/* Inline Function Instances --------------------------------------------------------------------- */
+extern void     lrucache_on_evict   (LruCache*, LruEvictFn, void*);
+extern unsigned lrucache_capacity   (const LruCache*);
+extern unsigned lrucache_count      (const LruCache*);
+extern bool     lrucache_empty      (const LruCache*);
+extern bool     lrucache_full       (const LruCache*);
+extern void*    lrucache_oldest     (const LruCache*);
+extern LruStats lrucache_stats      (const LruCache*);
+extern void     lrucache_reset_stats(LruCache*);
+
+
+/* lrucache_init ********************************************************************************//**
+ * @brief		Initializes an empty cache with no evict callback.
+ * @param[in]	c: the cache to initialize.
+ * @param[in]	buckets: array of nbuckets bucket heads for the index.
+ * @param[in]	nbuckets: the number of buckets. Must be a power of 2. About capacity is typical.
+ * @param[in]	capacity: the most entries the cache holds.
+ * @param[in]	hash: callback which returns the hash of an entry. Receives an LruLink pointer.
+ * @param[in]	compare: callback which compares a key with an entry. Receives the key passed to
+ *				lrucache_get and an LruLink pointer. Returns 0 if the entry matches the key.
+ * @retval		false if capacity is 0 or the index could not be initialized. */
+bool lrucache_init(
+	LruCache* c, Link** buckets, unsigned nbuckets, unsigned capacity, IHash hash,
+	ICompare compare)
+{
+	if(!capacity || !hashtable_init(&c->index, buckets, nbuckets, hash, compare))
+	{
+		return false;
+	}
+
+	linked_init(&c->recency);
+	c->capacity = capacity;
+	c->evict    = 0;
+	c->arg      = 0;
+	lrucache_reset_stats(c);
+
+	return true;
+}
+
+
+/* lrucache_clear *******************************************************************************//**
+ * @brief		Evicts every entry from the cache, passing each to the evict callback. */
+void lrucache_clear(LruCache* c)
+{
+	while(lrucache_evict(c)) { }
+}
+
+
+/* lrucache_get *********************************************************************************//**
+ * @brief		Looks up an entry and marks it most recently used. Counts a hit or a miss.
+ * @param[in]	c: the cache to search.
+ * @param[in]	hash: the hash of the key. Must equal the hash of a matching entry.
+ * @param[in]	key: the key passed to the compare callback.
+ * @return		The matching LruLink. Null if the key is not cached. */
+void* lrucache_get(LruCache* c, uint32_t hash, const void* key)
+{
+	LruLink* entry = hashtable_find(&c->index, hash, key);
+
+	if(entry)
+	{
+		c->stats.hits++;
+
+		if(linked_first(c->recency) != &entry->recency)
+		{
+			linked_remove (&c->recency, &entry->recency);
+			linked_prepend(&c->recency, &entry->recency);
+		}
+	}
+	else
+	{
+		c->stats.misses++;
+	}
+
+	return entry;
+}
+
+
+/* lrucache_peek ********************************************************************************//**
+ * @brief		Looks up an entry without changing its recency or the statistics. See lrucache_get. */
+void* lrucache_peek(const LruCache* c, uint32_t hash, const void* key)
+{
+	return hashtable_find(&c->index, hash, key);
+}
+
+
+/* lrucache_put *********************************************************************************//**
+ * @brief		Inserts an entry as the most recently used. Evicts the least recently used entry
+ *				first if the cache is full.
+ * @warning		The cache does not check for an existing entry with the same key. Call lrucache_get
+ *				first or remove the old entry.
+ * @return		The inserted entry. */
+void* lrucache_put(LruCache* c, LruLink* entry)
+{
+	if(!entry)
+	{
+		return 0;
+	}
+
+	if(lrucache_full(c))
+	{
+		lrucache_evict(c);
+	}
+
+	hashtable_insert(&c->index, &entry->hash);
+	linked_prepend(&c->recency, &entry->recency);
+
+	return entry;
+}
+
+
+/* lrucache_remove ******************************************************************************//**
+ * @brief		Removes an entry without calling the evict callback.
+ * @warning		The entry must be in the cache.
+ * @return		The removed entry. */
+void* lrucache_remove(LruCache* c, LruLink* entry)
+{
+	if(!entry)
+	{
+		return 0;
+	}
+
+	hashtable_remove(&c->index, &entry->hash);
+	linked_remove(&c->recency, &entry->recency);
+
+	return entry;
+}
+
+
+/* lrucache_evict *******************************************************************************//**
+ * @brief		Removes the least recently used entry and passes it to the evict callback.
+ * @retval		false if the cache is empty. */
+bool lrucache_evict(LruCache* c)
+{
+	LruLink* entry = lrucache_remove(c, lrucache_oldest(c));
+
+	if(!entry)
+	{
+		return false;
+	}
+
+	c->stats.evictions++;
+
+	if(c->evict)
+	{
+		c->evict(c->arg, entry);
+	}
+
+	return true;
+}
+
+
+/******************************************* END OF FILE *******************************************/
@@ -0,0 +1,124 @@
+/************************************************************************************************//**
+ * @file		lrucache.h
+ *
+ * @copyright	Copyright 2022 Kurt Hildebrand.
+ * @license		Licensed under the Apache License, Version 2.0 (the "License"); you may not use this
+ * 				file except in compliance with the License. You may obtain a copy of the License at
+ *
+ * 				http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * 				Unless required by applicable law or agreed to in writing, software distributed under
+ * 				the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF
+ * 				ANY KIND, either express or implied. See the License for the specific language
+ * 				governing permissions and limitations under the License.
+ *
+ * @brief		Fixed capacity least recently used cache of intrusive entries. Entries embed an
+ *				LruLink, which chains them into a HashTable index and a recency list. Lookups,
+ *				inserts and evictions are O(1) and the cache never allocates.
+ *
+ *				Putting an entry into a full cache first evicts the least recently used entry. The
+ *				evict callback is then called with the entry so its owner may release it. The cache
+ *				counts hits, misses and evictions to help size it.
+ *
+ *				The hash and compare callbacks receive a pointer to the entry's LruLink. For example:
+ *
+ *					typedef struct { uint32_t addr; LruLink lru; } Neighbor;
+ *
+ *					uint32_t neighbor_hash(const void* a)
+ *					{
+ *						return hash(CONTAINER_OF(a, Neighbor, lru)->addr);
+ *					}
+ *
+ ***************************************************************************************************/
+#ifndef LRUCACHE_H
+#define LRUCACHE_H
+
+#if __STDC_VERSION__ < 199901L
+#error Compile with C99 or higher!
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/* Includes -------------------------------------------------------------------------------------- */
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "hashtable.h"
+#include "linked.h"
+
+
+/* Public Types ---------------------------------------------------------------------------------- */
+typedef struct {
+	Link hash;			/* Must be first so the index's Link pointers are LruLink pointers */
+	Link recency;
+} LruLink;
+
+
+typedef void (*LruEvictFn)(void* arg, LruLink* entry);
+
+
+typedef struct {
+	uint32_t hits;
+	uint32_t misses;
+	uint32_t evictions;
+} LruStats;
+
+
+typedef struct {
+	HashTable  index;
+	Link*      recency;		/* Most recently used entry first */
+	unsigned   capacity;
+	LruEvictFn evict;		/* Called with each evicted entry. May be null */
+	void*      arg;
+	LruStats   stats;
+} LruCache;
+
+
+/* Public Functions ------------------------------------------------------------------------------ */
+       bool     lrucache_init       (LruCache*, Link**, unsigned, unsigned, IHash, ICompare);
+inline void     lrucache_on_evict   (LruCache*, LruEvictFn, void*);
+       void     lrucache_clear      (LruCache*);
+inline unsigned lrucache_capacity   (const LruCache* c) { return c->capacity;                     }
+inline unsigned lrucache_count      (const LruCache* c) { return hashtable_count(&c->index);      }
+inline bool     lrucache_empty      (const LruCache* c) { return lrucache_count(c) == 0;          }
+inline bool     lrucache_full       (const LruCache* c) { return lrucache_count(c) >= c->capacity; }
+       void*    lrucache_get        (LruCache*, uint32_t, const void*);
+       void*    lrucache_peek       (const LruCache*, uint32_t, const void*);
+       void*    lrucache_put        (LruCache*, LruLink*);
+       void*    lrucache_remove     (LruCache*, LruLink*);
+       bool     lrucache_evict      (LruCache*);
+inline void*    lrucache_oldest     (const LruCache*);
+inline LruStats lrucache_stats      (const LruCache* c) { return c->stats;                        }
+inline void     lrucache_reset_stats(LruCache* c)       { c->stats = (LruStats){ 0 };              }
+
+
+/* lrucache_on_evict ****************************************************************************//**
+ * @brief		Sets the callback called with each evicted entry. The entry is no longer in the cache
+ *				when the callback runs. */
+inline void lrucache_on_evict(LruCache* c, LruEvictFn fn, void* arg)
+{
+	c->evict = fn;
+	c->arg   = arg;
+}
+
+
+/* lrucache_oldest ******************************************************************************//**
+ * @brief		Returns the least recently used entry, which is the next to be evicted. Null if the
+ *				cache is empty. */
+inline void* lrucache_oldest(const LruCache* c)
+{
+	Link* last = linked_last(c->recency);
+
+	return last ? CONTAINER_OF(last, LruLink, recency) : 0;
+}
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // LRUCACHE_H
+/******************************************* END OF FILE *******************************************/
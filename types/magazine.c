@@ -0,0 +1,89 @@
+/************************************************************************************************//**
+ * @file		magazine.c
+ *
+ * @copyright	Copyright 2022 Kurt Hildebrand.
+ * @license		Licensed under the Apache License, Version 2.0 (the "License"); you may not use this
+ * 				file except in compliance with the License. You may obtain a copy of the License at
+ *
+ * 				http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * 				Unless required by applicable law or agreed to in writing, software distributed under
+ * 				the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF
+ * 				ANY KIND, either express or implied. See the License for the specific language
+ * 				governing permissions and limitations under the License.
+ *
+ ***************************************************************************************************/
+#include "magazine.h"
+
+
+/* Inline Function Instances --------------------------------------------------------------------- */
+extern void     magazine_init   (Magazine*, Pool*);
+extern unsigned magazine_count  (const Magazine*);
+extern void*    magazine_reserve(Magazine*);
+extern bool     magazine_release(Magazine*, void*);
+
+
+/* magazine_refill ******************************************************************************//**
+ * @brief		Reserves up to half a magazine of entries from the pool in one batch.
+ * @return		The number of entries added to the magazine. */
+unsigned magazine_refill(Magazine* m)
+{
+	unsigned count = MAGAZINE_SIZE / 2;
+
+	if(count > MAGAZINE_SIZE - m->count)
+	{
+		count = MAGAZINE_SIZE - m->count;
+	}
+
+	count = pool_reserve_many(m->pool, &m->entries[m->count], count);
+
+	if(count)
+	{
+		m->count += count;
+		m->refills++;
+	}
+
+	return count;
+}
+
+
+/* magazine_flush *******************************************************************************//**
+ * @brief		Releases up to count of the oldest entries in the magazine back to the pool in one
+ *				batch. The most recently released entries, which are most likely still in cache,
+ *				stay in the magazine.
+ * @return		The number of entries removed from the magazine. */
+unsigned magazine_flush(Magazine* m, unsigned count)
+{
+	unsigned i;
+
+	if(count > m->count)
+	{
+		count = m->count;
+	}
+
+	if(count)
+	{
+		pool_release_many(m->pool, m->entries, count);
+
+		for(i = count; i < m->count; i++)
+		{
+			m->entries[i - count] = m->entries[i];
+		}
+
+		m->count -= count;
+		m->flushes++;
+	}
+
+	return count;
+}
+
+
+/* magazine_drain *******************************************************************************//**
+ * @brief		Releases every cached entry back to the pool. Call before the owning thread exits. */
+void magazine_drain(Magazine* m)
+{
+	magazine_flush(m, m->count);
+}
+
+
+/******************************************* END OF FILE *******************************************/
@@ -0,0 +1,143 @@
+/************************************************************************************************//**
+ * @file		magazine.h
+ *
+ * @copyright	Copyright 2022 Kurt Hildebrand.
+ * @license		Licensed under the Apache License, Version 2.0 (the "License"); you may not use this
+ * 				file except in compliance with the License. You may obtain a copy of the License at
+ *
+ * 				http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * 				Unless required by applicable law or agreed to in writing, software distributed under
+ * 				the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF
+ * 				ANY KIND, either express or implied. See the License for the specific language
+ * 				governing permissions and limitations under the License.
+ *
+ * @brief		Per-thread cache of free pool entries. A magazine is a small stack of entries owned
+ *				by one thread. magazine_reserve and magazine_release only touch the stack. When the
+ *				stack runs empty it is refilled with half a magazine of entries from the shared
+ *				pool, and when it fills up half of it is flushed back, so the shared pool is only
+ *				touched once per MAGAZINE_SIZE / 2 operations in the common case.
+ *
+ *				A magazine is typically declared _Thread_local, one per pool:
+ *
+ *					static _Thread_local Magazine mag;
+ *
+ *					if(!mag.pool) { magazine_init(&mag, &pool); }
+ *					void* ptr = magazine_reserve(&mag);
+ *					...
+ *					magazine_release(&mag, ptr);
+ *					...
+ *					magazine_drain(&mag);	// Before the thread exits
+ *
+ ***************************************************************************************************/
+#ifndef MAGAZINE_H
+#define MAGAZINE_H
+
+#if __STDC_VERSION__ < 199901L
+#error Compile with C99 or higher!
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/* Includes -------------------------------------------------------------------------------------- */
+#include <stdbool.h>
+
+#include "pool.h"
+
+
+/* Public Macros --------------------------------------------------------------------------------- */
+#ifndef MAGAZINE_SIZE
+#define MAGAZINE_SIZE	(32)	/* Number of entries a magazine can hold. Must be at least 2. */
+#endif
+
+
+/* Public Types ---------------------------------------------------------------------------------- */
+/* Magazine *************************************************************************************//**
+ * @brief		Stack of free entries cached from a pool plus counters. The counters are only
+ *				written by the owning thread. */
+typedef struct {
+	Pool*    pool;
+	unsigned count;						/* Number of cached entries */
+	unsigned hits;						/* Reserves and releases served from the magazine */
+	unsigned refills;					/* Number of batches reserved from the pool */
+	unsigned flushes;					/* Number of batches released to the pool */
+	void*    entries[MAGAZINE_SIZE];
+} Magazine;
+
+
+/* Public Functions ------------------------------------------------------------------------------ */
+inline void     magazine_init   (Magazine*, Pool*);
+inline unsigned magazine_count  (const Magazine* m) { return m->count; }
+inline void*    magazine_reserve(Magazine*);
+inline bool     magazine_release(Magazine*, void*);
+       unsigned magazine_refill (Magazine*);
+       unsigned magazine_flush  (Magazine*, unsigned);
+       void     magazine_drain  (Magazine*);
+
+
+/* magazine_init ********************************************************************************//**
+ * @brief		Initializes an empty magazine in front of a pool. */
+inline void magazine_init(Magazine* m, Pool* pool)
+{
+	m->pool    = pool;
+	m->count   = 0;
+	m->hits    = 0;
+	m->refills = 0;
+	m->flushes = 0;
+}
+
+
+/* magazine_reserve *****************************************************************************//**
+ * @brief		Allocates an entry, refilling the magazine from the pool if it is empty.
+ * @return		Pointer to the reserved entry. Null if both the magazine and the pool are empty. */
+inline void* magazine_reserve(Magazine* m)
+{
+	if(m->count)
+	{
+		m->hits++;
+	}
+	else if(magazine_refill(m) == 0)
+	{
+		return 0;
+	}
+
+	return m->entries[--m->count];
+}
+
+
+/* magazine_release *****************************************************************************//**
+ * @brief		Deallocates an entry into the magazine, flushing half of the magazine back to the
+ *				pool if it is full.
+ * @note		Entries released twice are not detected until they are flushed to the pool.
+ * @retval		true if the entry was deallocated.
+ * @retval		false if the entry is not contained in the pool. */
+inline bool magazine_release(Magazine* m, void* ptr)
+{
+	if(range_offsetof(&m->pool->entries, ptr) >= pool_size(m->pool))
+	{
+		return false;
+	}
+
+	if(m->count < MAGAZINE_SIZE)
+	{
+		m->hits++;
+	}
+	else
+	{
+		magazine_flush(m, MAGAZINE_SIZE / 2);
+	}
+
+	m->entries[m->count++] = ptr;
+	return true;
+}
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // MAGAZINE_H
+/******************************************* END OF FILE *******************************************/
@@ -0,0 +1,124 @@
+/************************************************************************************************//**
+ * @file		mpscqueue.c
+ *
+ * @copyright	Copyright 2022 Kurt Hildebrand.
+ * @license		Licensed under the Apache License, Version 2.0 (the "License"); you may not use this
+ * 				file except in compliance with the License. You may obtain a copy of the License at
+ *
+ * 				http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * 				Unless required by applicable law or agreed to in writing, software distributed under
+ * 				the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF
+ * 				ANY KIND, either express or implied. See the License for the specific language
+ * 				governing permissions and limitations under the License.
+ *
+ ***************************************************************************************************/
+#include "mpscqueue.h"
+
+
+/* Inline Function Instances --------------------------------------------------------------------- */
+extern bool mpscqueue_empty(const MpscQueue*);
+
+
+/* mpscqueue_init *******************************************************************************//**
+ * @brief		Initializes an empty queue.
+ * @warning		This function is not thread safe. No producer or consumer may access the queue while
+ *				it is being initialized. */
+void mpscqueue_init(MpscQueue* q)
+{
+	atomic_init(&q->stub.next, 0);
+	atomic_init(&q->head, &q->stub);
+	q->tail = &q->stub;
+}
+
+
+/* mpscqueue_push *******************************************************************************//**
+ * @brief		Appends a node to the queue. May be called by any number of threads concurrently.
+ * @param[in]	q: the queue to push onto.
+ * @param[in]	node: the node to append. Must not already be in the queue. */
+void mpscqueue_push(MpscQueue* q, MpscLink* node)
+{
+	MpscLink* prev;
+
+	atomic_store_explicit(&node->next, 0, memory_order_relaxed);
+
+	/* Claim the end of the queue, then link the previous end to the node. Until the link is
+	 * stored the consumer sees the queue end at prev. */
+	prev = atomic_exchange_explicit(&q->head, node, memory_order_acq_rel);
+	atomic_store_explicit(&prev->next, node, memory_order_release);
+}
+
+
+/* mpscqueue_pop ********************************************************************************//**
+ * @brief		Removes the oldest node from the queue. Must only be called by the consumer.
+ * @return		The removed node. Null if the queue is empty or the next node has not been linked by
+ *				its producer yet. */
+MpscLink* mpscqueue_pop(MpscQueue* q)
+{
+	MpscLink* tail = q->tail;
+	MpscLink* next = atomic_load_explicit(&tail->next, memory_order_acquire);
+
+	/* Step over the stub */
+	if(tail == &q->stub)
+	{
+		if(!next)
+		{
+			return 0;
+		}
+
+		q->tail = next;
+		tail    = next;
+		next    = atomic_load_explicit(&tail->next, memory_order_acquire);
+	}
+
+	if(next)
+	{
+		q->tail = next;
+		return tail;
+	}
+
+	/* The tail has no successor. Unless it is also the most recently pushed node, a producer is
+	 * between its exchange and its link. */
+	if(tail != atomic_load_explicit(&q->head, memory_order_acquire))
+	{
+		return 0;
+	}
+
+	/* Push the stub behind the last node so the last node can be removed */
+	mpscqueue_push(q, &q->stub);
+	next = atomic_load_explicit(&tail->next, memory_order_acquire);
+
+	if(next)
+	{
+		q->tail = next;
+		return tail;
+	}
+
+	return 0;
+}
+
+
+/* mpscqueue_pop_many ***************************************************************************//**
+ * @brief		Removes up to count nodes from the queue in order. Must only be called by the
+ *				consumer.
+ * @param[in]	q: the queue to pop from.
+ * @param[out]	nodes: receives the removed nodes.
+ * @param[in]	count: the most nodes to remove.
+ * @return		The number of nodes removed. */
+unsigned mpscqueue_pop_many(MpscQueue* q, MpscLink** nodes, unsigned count)
+{
+	unsigned i;
+
+	for(i = 0; i < count; i++)
+	{
+		if(!(nodes[i] = mpscqueue_pop(q)))
+		{
+			break;
+		}
+	}
+
+	return i;
+}
+
+
+/******************************************* END OF FILE *******************************************/
@@ -0,0 +1,81 @@
+/************************************************************************************************//**
+ * @file		mpscqueue.h
+ *
+ * @copyright	Copyright 2022 Kurt Hildebrand.
+ * @license		Licensed under the Apache License, Version 2.0 (the "License"); you may not use this
+ * 				file except in compliance with the License. You may obtain a copy of the License at
+ *
+ * 				http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * 				Unless required by applicable law or agreed to in writing, software distributed under
+ * 				the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF
+ * 				ANY KIND, either express or implied. See the License for the specific language
+ * 				governing permissions and limitations under the License.
+ *
+ * @brief		Unbounded, intrusive multi-producer, single-consumer queue. Objects embed an MpscLink
+ *				and are linked through it, so pushing never allocates and never fails. Producers push
+ *				with a single atomic exchange, making push wait-free. Only one thread may pop.
+ *
+ *				The queue holds a stub node which is reinserted whenever the consumer removes the
+ *				last node. The queue must therefore not be moved or copied after it is initialized.
+ *
+ *				A producer which is preempted between its exchange and linking its node hides every
+ *				node pushed after it until it resumes. mpscqueue_pop returns null in that case even
+ *				though the queue is not empty.
+ *
+ ***************************************************************************************************/
+#ifndef MPSCQUEUE_H
+#define MPSCQUEUE_H
+
+#if __STDC_VERSION__ < 199901L
+#error Compile with C99 or higher!
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/* Includes -------------------------------------------------------------------------------------- */
+#include <stdatomic.h>
+#include <stdbool.h>
+
+#include "utils.h"
+
+
+/* Public Types ---------------------------------------------------------------------------------- */
+typedef struct MpscLink {
+	_Atomic(struct MpscLink*) next;
+} MpscLink;
+
+
+typedef struct {
+	_Alignas(CACHE_LINE_SIZE) _Atomic(MpscLink*) head;	/* Most recently pushed node */
+	_Alignas(CACHE_LINE_SIZE) MpscLink* tail;			/* Next node to pop. Consumer only */
+	MpscLink stub;
+} MpscQueue;
+
+
+/* Public Functions ------------------------------------------------------------------------------ */
+       void      mpscqueue_init    (MpscQueue*);
+inline bool      mpscqueue_empty   (const MpscQueue*);
+       void      mpscqueue_push    (MpscQueue*, MpscLink*);
+       MpscLink* mpscqueue_pop     (MpscQueue*);
+       unsigned  mpscqueue_pop_many(MpscQueue*, MpscLink**, unsigned);
+
+
+/* mpscqueue_empty ******************************************************************************//**
+ * @brief		Returns true if every pushed node has been popped. When called concurrently with
+ *				producers the result is a snapshot. */
+inline bool mpscqueue_empty(const MpscQueue* q)
+{
+	return atomic_load_explicit(&q->head, memory_order_acquire) == &q->stub;
+}
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // MPSCQUEUE_H
+/******************************************* END OF FILE *******************************************/
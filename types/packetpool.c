@@ -0,0 +1,111 @@
+/************************************************************************************************//**
+ * @file		packetpool.c
+ *
+ * @copyright	Copyright 2022 Kurt Hildebrand.
+ * @license		Licensed under the Apache License, Version 2.0 (the "License"); you may not use this
+ * 				file except in compliance with the License. You may obtain a copy of the License at
+ *
+ * 				http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * 				Unless required by applicable law or agreed to in writing, software distributed under
+ * 				the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF
+ * 				ANY KIND, either express or implied. See the License for the specific language
+ * 				governing permissions and limitations under the License.
+ *
+ ***************************************************************************************************/
+#include "packetpool.h"
+
+
+/* Inline Function Instances --------------------------------------------------------------------- */
+extern unsigned      pktpool_free (const PacketPool*);
+extern unsigned      pktpool_count(const PacketPool*);
+extern PacketHeader* pkt_header   (const PacketPool*, const void*);
+extern void          pkt_ref      (const PacketPool*, const Buffer*);
+extern bool          pkt_clone    (const PacketPool*, Buffer*, const Buffer*);
+extern unsigned      pkt_refs     (const PacketPool*, const Buffer*);
+extern unsigned      pkt_headroom (const PacketPool*, const Buffer*);
+extern unsigned      pkt_tailroom (const Buffer*);
+extern void*         pkt_prepend  (const PacketPool*, Buffer*, unsigned);
+
+
+/* pktpool_init *********************************************************************************//**
+ * @brief		Initializes a pool of packet buffers.
+ * @param[in]	p: the packet pool to initialize.
+ * @param[in]	mem: memory for count entries of PKTPOOL_ELEMSIZE(size) bytes, aligned to
+ *				PKT_HEADER_SIZE.
+ * @param[in]	count: the number of packets in the pool.
+ * @param[in]	size: the number of bytes of each packet, including headroom and tailroom.
+ * @param[in]	headroom: the number of bytes reserved in front of a new packet.
+ * @param[in]	bitmap: POOL_BITMAP_WORDS(count) words for the pool's free bitmap. May be null if
+ *				count is at most 64.
+ * @retval		false if the headroom does not fit in a packet or the pool could not be created. */
+bool pktpool_init(
+	PacketPool* p, void* mem, unsigned count, unsigned size, unsigned headroom,
+	_Atomic uint64_t* bitmap)
+{
+	Range entries = make_range(mem, count, PKTPOOL_ELEMSIZE(size));
+
+	if(!mem || ((uintptr_t)mem % PKT_HEADER_SIZE) != 0 || headroom > size)
+	{
+		return false;
+	}
+
+	p->headroom = headroom;
+
+	if(bitmap)
+	{
+		return pool_init_bitmap(&p->pool, entries, bitmap);
+	}
+	else
+	{
+		return pool_init_range(&p->pool, entries);
+	}
+}
+
+
+/* pkt_alloc ************************************************************************************//**
+ * @brief		Allocates a packet with one reference.
+ * @param[in]	p: the packet pool.
+ * @param[out]	b: buffer initialized to the empty packet, starting after the headroom and ending at
+ *				the end of the pool entry.
+ * @retval		false if the pool is empty. */
+bool pkt_alloc(PacketPool* p, Buffer* b)
+{
+	PacketHeader* hdr = pool_reserve(&p->pool);
+
+	if(!hdr)
+	{
+		return false;
+	}
+
+	atomic_store_explicit(&hdr->refs, 1, memory_order_relaxed);
+
+	buffer_init(b,
+		(uint8_t*)hdr + PKT_HEADER_SIZE + p->headroom,
+		0,
+		pool_elemsize(&p->pool) - PKT_HEADER_SIZE - p->headroom);
+
+	return true;
+}
+
+
+/* pkt_free *************************************************************************************//**
+ * @brief		Drops a reference to a packet. The packet is returned to the pool when the last
+ *				reference is dropped. The buffer is cleared either way.
+ * @retval		true if the packet was returned to the pool. */
+bool pkt_free(PacketPool* p, Buffer* b)
+{
+	PacketHeader* hdr = pkt_header(p, buffer_start(b));
+	bool          freed = false;
+
+	if(hdr && atomic_fetch_sub_explicit(&hdr->refs, 1, memory_order_acq_rel) == 1)
+	{
+		freed = pool_release(&p->pool, hdr);
+	}
+
+	buffer_init(b, 0, 0, 0);
+	return freed;
+}
+
+
+/******************************************* END OF FILE *******************************************/
@@ -0,0 +1,173 @@
+/************************************************************************************************//**
+ * @file		packetpool.h
+ *
+ * @copyright	Copyright 2022 Kurt Hildebrand.
+ * @license		Licensed under the Apache License, Version 2.0 (the "License"); you may not use this
+ * 				file except in compliance with the License. You may obtain a copy of the License at
+ *
+ * 				http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * 				Unless required by applicable law or agreed to in writing, software distributed under
+ * 				the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF
+ * 				ANY KIND, either express or implied. See the License for the specific language
+ * 				governing permissions and limitations under the License.
+ *
+ * @brief		Pool of fixed size, reference counted packet buffers. Each entry in the pool is laid
+ *				out as:
+ *
+ *					+--------+-----------+------------------------------+----------+
+ *					| header | headroom  | data                         | tailroom |
+ *					+--------+-----------+------------------------------+----------+
+ *
+ *				pkt_alloc hands out a Buffer whose start is placed after the headroom. IPPacket and
+ *				Ieee154_Frame can be initialized directly over that Buffer. Lower layers prepend
+ *				their headers into the headroom with pkt_prepend instead of moving the payload.
+ *				pkt_clone shares a packet by reference and the packet returns to the pool when the
+ *				last reference is dropped with pkt_free.
+ *
+ ***************************************************************************************************/
+#ifndef PACKETPOOL_H
+#define PACKETPOOL_H
+
+#if __STDC_VERSION__ < 199901L
+#error Compile with C99 or higher!
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/* Includes -------------------------------------------------------------------------------------- */
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "buffer.h"
+#include "pool.h"
+
+
+/* Public Macros --------------------------------------------------------------------------------- */
+#define PKT_HEADER_SIZE			(_Alignof(max_align_t))
+
+/* PKTPOOL_ELEMSIZE *****************************************************************************//**
+ * @brief		Returns the number of bytes of one pool entry holding size bytes of packet data,
+ *				including headroom. */
+#define PKTPOOL_ELEMSIZE(size)	\
+	((PKT_HEADER_SIZE + (size) + PKT_HEADER_SIZE - 1) / PKT_HEADER_SIZE * PKT_HEADER_SIZE)
+
+
+/* Public Types ---------------------------------------------------------------------------------- */
+typedef struct {
+	_Atomic unsigned refs;
+} PacketHeader;
+
+
+typedef struct {
+	Pool     pool;
+	unsigned headroom;		/* Bytes reserved in front of the data of a new packet */
+} PacketPool;
+
+
+/* Public Functions ------------------------------------------------------------------------------ */
+       bool          pktpool_init (PacketPool*, void*, unsigned, unsigned, unsigned, _Atomic uint64_t*);
+inline unsigned      pktpool_free (const PacketPool* p) { return pool_free(&p->pool); }
+inline unsigned      pktpool_count(const PacketPool* p) { return pool_count(&p->pool); }
+inline PacketHeader* pkt_header   (const PacketPool*, const void*);
+       bool          pkt_alloc    (PacketPool*, Buffer*);
+inline void          pkt_ref      (const PacketPool*, const Buffer*);
+inline bool          pkt_clone    (const PacketPool*, Buffer*, const Buffer*);
+       bool          pkt_free     (PacketPool*, Buffer*);
+inline unsigned      pkt_refs     (const PacketPool*, const Buffer*);
+inline unsigned      pkt_headroom (const PacketPool*, const Buffer*);
+inline unsigned      pkt_tailroom (const Buffer* b) { return buffer_free(b); }
+inline void*         pkt_prepend  (const PacketPool*, Buffer*, unsigned);
+
+
+/* pkt_header ***********************************************************************************//**
+ * @brief		Returns the header of the packet containing ptr. Null if ptr is not in the pool. */
+inline PacketHeader* pkt_header(const PacketPool* p, const void* ptr)
+{
+	unsigned idx = range_offsetof(&p->pool.entries, ptr);
+
+	return idx < pool_size(&p->pool) ? pool_entry(&p->pool, idx) : 0;
+}
+
+
+/* pkt_ref **************************************************************************************//**
+ * @brief		Adds a reference to a packet. */
+inline void pkt_ref(const PacketPool* p, const Buffer* b)
+{
+	PacketHeader* hdr = pkt_header(p, buffer_start(b));
+
+	if(hdr)
+	{
+		atomic_fetch_add_explicit(&hdr->refs, 1, memory_order_relaxed);
+	}
+}
+
+
+/* pkt_clone ************************************************************************************//**
+ * @brief		Initializes dest to refer to the same packet data as src and adds a reference. The
+ *				packet data is not copied. Each clone must be released with pkt_free.
+ * @retval		false if src is not a packet from the pool. */
+inline bool pkt_clone(const PacketPool* p, Buffer* dest, const Buffer* src)
+{
+	if(!pkt_header(p, buffer_start(src)))
+	{
+		return false;
+	}
+
+	pkt_ref(p, src);
+	*dest = *src;
+	return true;
+}
+
+
+/* pkt_refs *************************************************************************************//**
+ * @brief		Returns the number of references to a packet. */
+inline unsigned pkt_refs(const PacketPool* p, const Buffer* b)
+{
+	PacketHeader* hdr = pkt_header(p, buffer_start(b));
+
+	return hdr ? atomic_load_explicit(&hdr->refs, memory_order_relaxed) : 0;
+}
+
+
+/* pkt_headroom *********************************************************************************//**
+ * @brief		Returns the number of bytes that can be prepended to the packet. */
+inline unsigned pkt_headroom(const PacketPool* p, const Buffer* b)
+{
+	PacketHeader* hdr = pkt_header(p, buffer_start(b));
+
+	return hdr ? (unsigned)(buffer_start(b) - ((uint8_t*)hdr + PKT_HEADER_SIZE)) : 0;
+}
+
+
+/* pkt_prepend **********************************************************************************//**
+ * @brief		Grows the packet by len bytes at the front, using the headroom. The bytes already in
+ *				the packet are not moved.
+ * @warning		Clones share the packet's memory. Only prepend to a packet that is not shared, or
+ *				whose clones do not use the headroom.
+ * @return		Pointer to the len new bytes at the start of the packet. Null if there is not
+ *				enough headroom. */
+inline void* pkt_prepend(const PacketPool* p, Buffer* b, unsigned len)
+{
+	if(pkt_headroom(p, b) < len)
+	{
+		return 0;
+	}
+
+	b->start -= len;
+	b->read   = b->start;
+	return b->start;
+}
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // PACKETPOOL_H
+/******************************************* END OF FILE *******************************************/
@@ -19,18 +19,257 @@
 /* Inline Function Instances --------------------------------------------------------------------- */
 extern bool     pool_init           (Pool*, void*, unsigned, unsigned);
 extern bool     pool_init_range     (Pool*, Range);
-extern void     pool_clear          (Pool*);
 extern unsigned pool_size           (const Pool*);
 extern unsigned pool_elemsize       (const Pool*);
-extern unsigned pool_free           (const Pool*);
 extern unsigned pool_count          (const Pool*);
 extern bool     pool_empty          (const Pool*);
 extern bool     pool_full           (const Pool*);
 extern void*    pool_entry          (const Pool*, unsigned);
 extern bool     pool_idx_is_reserved(const Pool*, unsigned);
 extern bool     pool_ptr_is_reserved(const Pool*, void*);
-extern void*    pool_reserve        (Pool*);
-extern bool     pool_release        (Pool*, const void*);
+
+
+/* pool_init_bitmap *****************************************************************************//**
+ * @brief		Initializes a pool of any size.
+ * @param[in]	p: the pool to initialize.
+ * @param[in]	entries: the range of the pool's entries.
+ * @param[in]	bitmap: array of POOL_BITMAP_WORDS(range_count(&entries)) words to hold the pool's
+ *				free bitmap. */
+bool pool_init_bitmap(Pool* p, Range entries, _Atomic uint64_t* bitmap)
+{
+	if(range_count(&entries) == 0 || !bitmap)
+	{
+		return false;
+	}
+	else
+	{
+		p->entries = entries;
+		p->leaves  = (range_count(&entries) + 63) / 64;
+		p->leaf    = bitmap;
+		p->summary = bitmap + p->leaves;
+		pool_clear(p);
+		return true;
+	}
+}
+
+
+/* pool_clear ***********************************************************************************//**
+ * @brief       Deallocates all entries from the pool.
+ * @warning		This function is not thread safe. */
+void pool_clear(Pool* p)
+{
+	unsigned i;
+
+	for(i = 0; i < p->leaves; i++)
+	{
+		unsigned remaining = pool_size(p) - i * 64;
+
+		atomic_store_explicit(&p->leaf[i],
+			remaining >= 64 ? ~(uint64_t)0 : ((uint64_t)1 << remaining) - 1, memory_order_relaxed);
+	}
+
+	for(i = 0; i < (p->leaves + 63) / 64; i++)
+	{
+		unsigned remaining = p->leaves - i * 64;
+
+		atomic_store_explicit(&p->summary[i],
+			remaining >= 64 ? ~(uint64_t)0 : ((uint64_t)1 << remaining) - 1, memory_order_relaxed);
+	}
+
+	atomic_thread_fence(memory_order_seq_cst);
+}
+
+
+/* pool_free ************************************************************************************//**
+ * @brief		Returns the number of free entries. When called concurrently with pool_reserve or
+ *				pool_release, the result is a snapshot. */
+unsigned pool_free(const Pool* p)
+{
+	unsigned count = 0;
+	unsigned i;
+
+	for(i = 0; i < p->leaves; i++)
+	{
+		count += calc_popcount_u64(atomic_load_explicit(&p->leaf[i], memory_order_relaxed));
+	}
+
+	return count;
+}
+
+
+/* pool_reserve *********************************************************************************//**
+ * @brief		Allocates an entry from a pool.
+ * @return		Pointer to the reserved entry. Null if the pool is full. */
+void* pool_reserve(Pool* p)
+{
+	void* ptr = 0;
+
+	pool_reserve_many(p, &ptr, 1);
+
+	return ptr;
+}
+
+
+/* pool_reserve_many ****************************************************************************//**
+ * @brief		Allocates up to count entries from a pool. Entries sharing a leaf word are claimed
+ *				together with a single compare and swap.
+ * @param[in]	p: the pool to allocate from.
+ * @param[out]	ptrs: array of at least count pointers to receive the reserved entries.
+ * @param[in]	count: the maximum number of entries to reserve.
+ * @return		The number of entries reserved. Less than count if the pool ran out of entries. */
+unsigned pool_reserve_many(Pool* p, void** ptrs, unsigned count)
+{
+	unsigned reserved = 0;
+	unsigned s;
+
+	for(s = 0; s < (p->leaves + 63) / 64 && reserved < count; s++)
+	{
+		uint64_t summary = atomic_load_explicit(&p->summary[s], memory_order_seq_cst);
+
+		while(summary && reserved < count)
+		{
+			unsigned l    = s * 64 + calc_ctz_u64(summary);
+			uint64_t leaf = atomic_load_explicit(&p->leaf[l], memory_order_acquire);
+			uint64_t take = 0;
+
+			while(leaf)
+			{
+				/* Take the lowest free bits of the leaf, up to the number still needed */
+				uint64_t bits = leaf;
+				unsigned n;
+
+				for(take = 0, n = reserved; bits && n < count; n++)
+				{
+					take |= bits & (-bits);		/* Isolate the rightmost 1 bit */
+					bits &= bits - 1;
+				}
+
+				if(atomic_compare_exchange_weak_explicit(
+					&p->leaf[l], &leaf, leaf & ~take, memory_order_acq_rel, memory_order_acquire))
+				{
+					leaf &= ~take;
+					break;
+				}
+
+				take = 0;
+			}
+
+			while(take)
+			{
+				ptrs[reserved++] = range_offset(&p->entries, l * 64 + calc_ctz_u64(take));
+				take &= take - 1;
+			}
+
+			if(leaf == 0)
+			{
+				/* The leaf is empty. Clear its summary bit, then check the leaf again in case an
+				 * entry was released in between. pool_release only sets the summary bit when the
+				 * leaf goes from empty to non-empty, so the summary bit must be restored in that
+				 * case. */
+				uint64_t mask = (uint64_t)1 << (l % 64);
+
+				atomic_fetch_and_explicit(&p->summary[s], ~mask, memory_order_seq_cst);
+
+				if(atomic_load_explicit(&p->leaf[l], memory_order_seq_cst))
+				{
+					atomic_fetch_or_explicit(&p->summary[s], mask, memory_order_seq_cst);
+				}
+
+				summary &= ~mask;
+			}
+		}
+	}
+
+	return reserved;
+}
+
+
+/* pool_release *********************************************************************************//**
+ * @brief		Deallocates an entry from a pool.
+ * @param[in]	p: the pool containing the entry to deallocate.
+ * @param[in]	ptr: address of the entry to deallocate.
+ * @retval		true if the entry was deallocated successfully.
+ * @retval		false if the entry is not contained in the pool or the entry has already been
+ *				deallocated. */
+bool pool_release(Pool* p, const void* ptr)
+{
+	unsigned offset = range_offsetof(&p->entries, ptr);
+
+	if(offset >= pool_size(p))
+	{
+		return false;
+	}
+
+	uint64_t bit  = (uint64_t)1 << (offset % 64);
+	uint64_t leaf = atomic_fetch_or_explicit(&p->leaf[offset / 64], bit, memory_order_seq_cst);
+
+	if(leaf & bit)
+	{
+		return false;
+	}
+	else if(leaf == 0)
+	{
+		/* The leaf went from empty to non-empty */
+		atomic_fetch_or_explicit(
+			&p->summary[offset / 4096], (uint64_t)1 << ((offset / 64) % 64), memory_order_seq_cst);
+	}
+
+	return true;
+}
+
+
+/* pool_release_many ****************************************************************************//**
+ * @brief		Deallocates count entries from a pool. Consecutive entries sharing a leaf word are
+ *				released together with a single atomic or.
+ * @param[in]	p: the pool containing the entries to deallocate.
+ * @param[in]	ptrs: array of count entries to deallocate.
+ * @param[in]	count: the number of entries to deallocate.
+ * @return		The number of entries deallocated. Entries not contained in the pool or already
+ *				deallocated are skipped. */
+unsigned pool_release_many(Pool* p, void* const* ptrs, unsigned count)
+{
+	unsigned released = 0;
+	unsigned i = 0;
+
+	while(i < count)
+	{
+		unsigned offset = range_offsetof(&p->entries, ptrs[i++]);
+
+		if(offset >= pool_size(p))
+		{
+			continue;
+		}
+
+		unsigned l    = offset / 64;
+		uint64_t mask = (uint64_t)1 << (offset % 64);
+
+		/* Gather the following entries that fall in the same leaf */
+		while(i < count)
+		{
+			unsigned next = range_offsetof(&p->entries, ptrs[i]);
+
+			if(next >= pool_size(p) || next / 64 != l)
+			{
+				break;
+			}
+
+			mask |= (uint64_t)1 << (next % 64);
+			i++;
+		}
+
+		uint64_t leaf = atomic_fetch_or_explicit(&p->leaf[l], mask, memory_order_seq_cst);
+
+		released += calc_popcount_u64(mask & ~leaf);
+
+		if(leaf == 0)
+		{
+			atomic_fetch_or_explicit(
+				&p->summary[l / 64], (uint64_t)1 << (l % 64), memory_order_seq_cst);
+		}
+	}
+
+	return released;
+}
 
 
 /******************************************* END OF FILE *******************************************/
@@ -37,82 +37,76 @@ extern "C" {
 #include "range.h"
 
 
+/* Public Macros --------------------------------------------------------------------------------- */
+/* POOL_BITMAP_WORDS ****************************************************************************//**
+ * @brief		Returns the number of 64-bit words needed by pool_init_bitmap for a pool of size
+ *				entries: one leaf word per 64 entries and one summary word per 64 leaf words. */
+#define POOL_BITMAP_WORDS(size)		(((size) + 63) / 64 + ((size) + 4095) / 4096)
+
+
 /* Public Types ---------------------------------------------------------------------------------- */
+/* Pool *****************************************************************************************//**
+ * @brief		Fixed array of entries with a two level free bitmap. A 1 bit in a leaf word marks a
+ *				free entry. A 1 bit in a summary word marks a leaf word which may contain free
+ *				entries. Entries are reserved by finding a set summary bit and then claiming a set
+ *				leaf bit with count trailing zeros, so reserve and release are lock-free. Pools of up
+ *				to 64 entries use the bitmap stored in the pool itself. */
 typedef struct {
-	Key   key;
-	Range entries;
-	_Atomic uint32_t freemask;	/* Bitmask where a 1 bit indicates a free entry */
+	Key      key;
+	Range    entries;
+	unsigned leaves;				/* Number of leaf words */
+	_Atomic uint64_t* leaf;			/* Bitmask where a 1 bit indicates a free entry */
+	_Atomic uint64_t* summary;		/* Bitmask where a 1 bit indicates a leaf with free entries */
+	_Atomic uint64_t  local[2];		/* Bitmap for pools of up to 64 entries */
 } Pool;
 
 
 /* Public Functions ------------------------------------------------------------------------------ */
 inline bool     pool_init           (Pool*, void*, unsigned, unsigned);
 inline bool     pool_init_range     (Pool*, Range);
-inline void     pool_clear          (Pool*);
+       bool     pool_init_bitmap    (Pool*, Range, _Atomic uint64_t*);
+       void     pool_clear          (Pool*);
 inline unsigned pool_size           (const Pool* p) { return range_count(&p->entries);       }
 inline unsigned pool_elemsize       (const Pool* p) { return range_elemsize(&p->entries);    }
-inline unsigned pool_free           (const Pool* p) { return calc_popcount_u32(p->freemask); }
+       unsigned pool_free           (const Pool*);
 inline unsigned pool_count          (const Pool* p) { return pool_size(p) - pool_free(p);    }
 inline bool     pool_empty          (const Pool* p) { return pool_count(p) == 0;             }
-inline bool     pool_full           (const Pool* p) { return p->freemask == 0;               }
+inline bool     pool_full           (const Pool* p) { return pool_free(p) == 0;              }
 inline void*    pool_entry          (const Pool*, unsigned);
 inline bool     pool_idx_is_reserved(const Pool*, unsigned);
 inline bool     pool_ptr_is_reserved(const Pool*, void*);
-inline void*    pool_reserve        (Pool*);
-inline bool     pool_release        (Pool*, const void*);
+       void*    pool_reserve        (Pool*);
+       unsigned pool_reserve_many   (Pool*, void**, unsigned);
+       bool     pool_release        (Pool*, const void*);
+       unsigned pool_release_many   (Pool*, void* const*, unsigned);
 
 
 /* pool_init ************************************************************************************//**
- * @brief		Initializes a pool.
+ * @brief		Initializes a pool of up to 64 entries. Larger pools are initialized with
+ *				pool_init_bitmap.
  * @param[in]	p: the pool to initialize.
  * @param[in]	entries: pointer to the buffer holding the pool's entries.
  * @param[in]	size: the total number of possible entries.
  * @param[in]	elemsize: the size in bytes of one entry in the pool. */
 inline bool pool_init(Pool* p, void* entries, unsigned size, unsigned elemsize)
 {
-	if(size == 0 || size > 32)
-	{
-		return false;
-	}
-	else
-	{
-		range_init(&p->entries, entries, size, elemsize);
-		pool_clear(p);
-		return true;
-	}
+	return pool_init_range(p, make_range(entries, size, elemsize));
 }
 
 
 /* pool_init_range ******************************************************************************//**
- * @brief		Initializes a pool from a range of entries.
+ * @brief		Initializes a pool of up to 64 entries from a range of entries.
  * @param[in]	p: the pool to initialize.
  * @param[in]	entries: the range of the pool's entries. */
 inline bool pool_init_range(Pool* p, Range entries)
 {
-	if(range_count(&entries) == 0 || range_count(&entries) > 32)
+	if(range_count(&entries) > 64)
 	{
 		return false;
 	}
 	else
 	{
-		p->entries = entries;
-		pool_clear(p);
-		return true;
-	}
-}
-
-
-/* pool_cool ************************************************************************************//**
- * @brief       Deallocates all entries from the pool. */
-inline void pool_clear(Pool* p)
-{
-	if(range_count(&p->entries) == 0)
-	{
-		p->freemask = 0;
-	}
-	else
-	{
-		p->freemask = (0x1 << range_count(&p->entries)) - 1;
+		return pool_init_bitmap(p, entries, p->local);
 	}
 }
 
@@ -131,7 +125,9 @@ inline bool pool_idx_is_reserved(const Pool* p, unsigned idx)
 {
 	if(idx < range_count(&p->entries))
 	{
-		return (p->freemask & (0x1 << idx)) == 0;
+		uint64_t leaf = atomic_load_explicit(&p->leaf[idx / 64], memory_order_acquire);
+
+		return (leaf & ((uint64_t)1 << (idx % 64))) == 0;
 	}
 	else
 	{
@@ -148,58 +144,6 @@ inline bool pool_ptr_is_reserved(const Pool* p, void* ptr)
 }
 
 
-/* pool_reserve *********************************************************************************//**
- * @brief		Allocates an entry from a pool. */
-inline void* pool_reserve(Pool* p)
-{
-	uint32_t freemask;
-	uint32_t resmask;
-
-	do {
-		freemask = p->freemask;
-
-		if(freemask == 0)
-		{
-			return 0;
-		}
-
-		resmask = freemask & (-freemask);	/* Isolate the rightmost 1 bit */
-	} while(!atomic_compare_exchange_weak(&p->freemask, &freemask, freemask & ~(resmask)));
-
-	return range_offset(&p->entries, calc_log2(resmask));
-}
-
-
-/* pool_release *********************************************************************************//**
- * @brief		Deallocates an entry from a pool.
- * @param[in]	p: the pool containing the entry to deallocate.
- * @param[in]	ptr: address of the entry to deallocate.
- * @retval		true if the entry was deallocated successfully.
- * @retval		false if the entry is not contained in the pool or the entry has already been
- *				deallocated. */
-inline bool pool_release(Pool* p, const void* ptr)
-{
-	uint32_t freemask;
-	uint32_t offset = range_offsetof(&p->entries, ptr);
-
-	if(offset >= 32)
-	{
-		return false;
-	}
-
-	do {
-		freemask = p->freemask;
-
-		if(freemask & (0x1 << offset))
-		{
-			break;
-		}
-	} while(!atomic_compare_exchange_weak(&p->freemask, &freemask, freemask | (0x1 << offset)));
-
-	return true;
-}
-
-
 #ifdef __cplusplus
 }
 #endif
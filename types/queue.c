@@ -13,12 +13,16 @@
  * 				governing permissions and limitations under the License.
  *
  ***************************************************************************************************/
+#include "futex.h"
 #include "queue.h"
 
 
+/* Private Functions ----------------------------------------------------------------------------- */
+static void queue_notify(_Atomic unsigned*, _Atomic unsigned*, unsigned);
+
+
 /* Inline Function Instances --------------------------------------------------------------------- */
-extern bool     queue_init (Queue*, void* _Atomic*, unsigned);
-extern void     queue_clear(Queue*);
+extern bool     queue_init (Queue*, QueueSlot*, unsigned);
 extern Key      queue_key  (const Queue*);
 extern unsigned queue_size (const Queue*);
 extern unsigned queue_count(const Queue*);
@@ -29,35 +33,86 @@ extern void*    queue_entry(const Queue*, unsigned);
 extern void*    queue_next (const Queue*);
 
 
+/* queue_clear **********************************************************************************//**
+ * @brief		Removes all entries from the queue.
+ * @warning		This function is not thread safe. No producer or consumer may access the queue while
+ *				it is being cleared. */
+void queue_clear(Queue* q)
+{
+	unsigned i;
+
+	for(i = 0; i < queue_size(q); i++)
+	{
+		atomic_store_explicit(&q->slots[i].seq, i, memory_order_relaxed);
+		q->slots[i].ptr = 0;
+	}
+
+	atomic_store_explicit(&q->write,         0, memory_order_relaxed);
+	atomic_store_explicit(&q->read,          0, memory_order_relaxed);
+	atomic_store_explicit(&q->push_events,   0, memory_order_relaxed);
+	atomic_store_explicit(&q->empty_waiters, 0, memory_order_relaxed);
+	atomic_store_explicit(&q->pop_events,    0, memory_order_relaxed);
+	atomic_store_explicit(&q->full_waiters,  0, memory_order_relaxed);
+}
+
+
 /* queue_push ***********************************************************************************//**
- * @brief		Appends a pointer to the queue. */
+ * @brief		Appends a pointer to the queue.
+ * @param[in]	q: the queue to append to.
+ * @param[in]	ptr: the pointer to append.
+ * @retval		true if the pointer was appended.
+ * @retval		false if the queue is full. */
 bool queue_push(Queue* q, const void* ptr)
 {
-	unsigned write = q->write;
+	QueueSlot* slot;
+	unsigned   pos = atomic_load_explicit(&q->write, memory_order_relaxed);
 
-	while(write - q->read != queue_size(q))
+	while(1)
 	{
-		if(atomic_compare_exchange_weak(&q->write, &write, write + 1))
+		slot = &q->slots[pos & (queue_size(q)-1)];
+
+		int diff = (int)(atomic_load_explicit(&slot->seq, memory_order_acquire) - pos);
+
+		if(diff == 0)
 		{
-			q->entries[write & (queue_size(q)-1)] = (void*)ptr;
-			return true;
+			/* The slot is free for this lap. Claim the position. On failure, pos is updated to
+			 * the current write index. */
+			if(atomic_compare_exchange_weak_explicit(
+				&q->write, &pos, pos + 1, memory_order_relaxed, memory_order_relaxed))
+			{
+				break;
+			}
+		}
+		else if(diff < 0)
+		{
+			/* The slot still holds an entry from the previous lap. The queue is full. */
+			return false;
+		}
+		else
+		{
+			/* Another producer claimed this position. */
+			pos = atomic_load_explicit(&q->write, memory_order_relaxed);
 		}
 	}
 
-	return false;
+	slot->ptr = (void*)ptr;
+	atomic_store_explicit(&slot->seq, pos + 1, memory_order_release);
+	queue_notify(&q->push_events, &q->empty_waiters, 1);
+	return true;
 }
 
 
 /* queue_peek ***********************************************************************************//**
- * @brief		Copies the oldest pointer in the queue into the out parameter. */
+ * @brief		Copies the oldest pointer in the queue into the out parameter.
+ * @warning		With multiple consumers, the entry may be removed by another consumer before the
+ *				caller removes it. */
 bool queue_peek(const Queue* q, void* out)
 {
-	unsigned read  = q->read;
-	unsigned write = q->write;
+	void* ptr = queue_next(q);
 
-	if(write != read)
+	if(ptr)
 	{
-		memmove(out, &q->entries[read & (queue_size(q)-1)], sizeof(q->entries[0]));
+		memmove(out, &ptr, sizeof(ptr));
 		return true;
 	}
 	else
@@ -71,19 +126,9 @@ bool queue_peek(const Queue* q, void* out)
  * @brief		Removes the oldest entry in the queue. */
 bool queue_pop(Queue* q)
 {
-	unsigned read = q->read;
+	void* temp;
 
-	if(read != q->write)
-	{
-		// q->entries[read & (queue_size(q)-1)] = 0;
-		atomic_init(&q->entries[read & (queue_size(q)-1)], 0);
-		atomic_fetch_add(&q->read, 1);
-		return true;
-	}
-	else
-	{
-		return false;
-	}
+	return queue_get(q, &temp);
 }
 
 
@@ -95,22 +140,300 @@ bool queue_pop(Queue* q)
  * @retval		false is the queue is empty. */
 bool queue_get(Queue* q, void* out)
 {
-	unsigned read = q->read;
+	QueueSlot* slot;
+	unsigned   pos = atomic_load_explicit(&q->read, memory_order_relaxed);
+
+	while(1)
+	{
+		slot = &q->slots[pos & (queue_size(q)-1)];
+
+		int diff = (int)(atomic_load_explicit(&slot->seq, memory_order_acquire) - (pos + 1));
+
+		if(diff == 0)
+		{
+			/* The slot has been published for this lap. Claim the position. */
+			if(atomic_compare_exchange_weak_explicit(
+				&q->read, &pos, pos + 1, memory_order_relaxed, memory_order_relaxed))
+			{
+				break;
+			}
+		}
+		else if(diff < 0)
+		{
+			/* The slot has not been published yet. The queue is empty. */
+			return false;
+		}
+		else
+		{
+			/* Another consumer claimed this position. */
+			pos = atomic_load_explicit(&q->read, memory_order_relaxed);
+		}
+	}
+
+	void* ptr = slot->ptr;
+
+	/* Hand the slot back to producers for the next lap. */
+	atomic_store_explicit(&slot->seq, pos + queue_size(q), memory_order_release);
+	queue_notify(&q->pop_events, &q->full_waiters, 1);
+
+	memmove(out, &ptr, sizeof(ptr));
+	return true;
+}
+
+
+/* queue_push_many ******************************************************************************//**
+ * @brief		Appends up to count pointers to the queue. A block of contiguous free slots is claimed
+ *				with a single CAS on the write index and the pointers are then published in order.
+ * @param[in]	q: the queue to append to.
+ * @param[in]	in: array of count pointers to append.
+ * @param[in]	count: the maximum number of pointers to append.
+ * @return		The number of pointers appended. Less than count if the queue did not have enough free
+ *				slots. */
+unsigned queue_push_many(Queue* q, const void* in, unsigned count)
+{
+	unsigned pos = atomic_load_explicit(&q->write, memory_order_relaxed);
+	unsigned i;
+
+	if(count > queue_size(q))
+	{
+		count = queue_size(q);
+	}
+	else if(count == 0)
+	{
+		return 0;
+	}
 
-	while(read != q->write)
+	while(1)
 	{
-		void* temp = q->entries[read];
+		/* Count the free slots for this lap starting at pos */
+		for(i = 0; i < count; i++)
+		{
+			QueueSlot* slot = &q->slots[(pos + i) & (queue_size(q)-1)];
+
+			if(atomic_load_explicit(&slot->seq, memory_order_acquire) != pos + i)
+			{
+				break;
+			}
+		}
 
-		if(atomic_compare_exchange_weak(&q->read, &read, read + 1))
+		if(i == 0)
+		{
+			int diff = (int)(atomic_load_explicit(
+				&q->slots[pos & (queue_size(q)-1)].seq, memory_order_acquire) - pos);
+
+			if(diff < 0)
+			{
+				return 0;
+			}
+
+			/* Another producer claimed this position. */
+			pos = atomic_load_explicit(&q->write, memory_order_relaxed);
+		}
+		else if(atomic_compare_exchange_weak_explicit(
+			&q->write, &pos, pos + i, memory_order_relaxed, memory_order_relaxed))
+		{
+			break;
+		}
+	}
+
+	count = i;
+
+	for(i = 0; i < count; i++)
+	{
+		QueueSlot* slot = &q->slots[(pos + i) & (queue_size(q)-1)];
+
+		memmove(&slot->ptr, (const char*)in + i * sizeof(slot->ptr), sizeof(slot->ptr));
+		atomic_store_explicit(&slot->seq, pos + i + 1, memory_order_release);
+	}
+
+	queue_notify(&q->push_events, &q->empty_waiters, count);
+	return count;
+}
+
+
+/* queue_get_many *******************************************************************************//**
+ * @brief		Retrieves and removes up to count pointers from the queue. A block of contiguous
+ *				published slots is claimed with a single CAS on the read index.
+ * @param[in]	q: the queue from which to remove pointers.
+ * @param[out]	out: array to store up to count removed pointers.
+ * @param[in]	count: the maximum number of pointers to remove.
+ * @return		The number of pointers removed. */
+unsigned queue_get_many(Queue* q, void* out, unsigned count)
+{
+	unsigned pos = atomic_load_explicit(&q->read, memory_order_relaxed);
+	unsigned i;
+
+	if(count > queue_size(q))
+	{
+		count = queue_size(q);
+	}
+	else if(count == 0)
+	{
+		return 0;
+	}
+
+	while(1)
+	{
+		/* Count the published slots for this lap starting at pos */
+		for(i = 0; i < count; i++)
+		{
+			QueueSlot* slot = &q->slots[(pos + i) & (queue_size(q)-1)];
+
+			if(atomic_load_explicit(&slot->seq, memory_order_acquire) != pos + i + 1)
+			{
+				break;
+			}
+		}
+
+		if(i == 0)
+		{
+			int diff = (int)(atomic_load_explicit(
+				&q->slots[pos & (queue_size(q)-1)].seq, memory_order_acquire) - (pos + 1));
+
+			if(diff < 0)
+			{
+				return 0;
+			}
+
+			/* Another consumer claimed this position. */
+			pos = atomic_load_explicit(&q->read, memory_order_relaxed);
+		}
+		else if(atomic_compare_exchange_weak_explicit(
+			&q->read, &pos, pos + i, memory_order_relaxed, memory_order_relaxed))
+		{
+			break;
+		}
+	}
+
+	count = i;
+
+	for(i = 0; i < count; i++)
+	{
+		QueueSlot* slot = &q->slots[(pos + i) & (queue_size(q)-1)];
+
+		memmove((char*)out + i * sizeof(slot->ptr), &slot->ptr, sizeof(slot->ptr));
+		atomic_store_explicit(&slot->seq, pos + i + queue_size(q), memory_order_release);
+	}
+
+	queue_notify(&q->pop_events, &q->full_waiters, count);
+	return count;
+}
+
+
+/* queue_push_wait ******************************************************************************//**
+ * @brief		Appends a pointer to the queue, blocking while the queue is full.
+ * @param[in]	q: the queue to append to.
+ * @param[in]	ptr: the pointer to append.
+ * @param[in]	timeout: the maximum time to wait in microseconds or FUTEX_FOREVER.
+ * @retval		true if the pointer was appended.
+ * @retval		false if the queue remained full until the timeout expired. */
+bool queue_push_wait(Queue* q, const void* ptr, unsigned timeout)
+{
+	uint64_t deadline;
+	unsigned i;
+
+	for(i = 0; i < FUTEX_SPIN; i++)
+	{
+		if(queue_push(q, ptr))
 		{
-			memmove(out, &temp, sizeof(q->entries[0]));
-			// q->entries[read & (queue_size(q)-1)] = 0;
-			atomic_init(&q->entries[read & (queue_size(q)-1)], 0);
 			return true;
 		}
 	}
 
-	return false;
+	deadline = futex_deadline(timeout);
+
+	while(1)
+	{
+		unsigned events = atomic_load_explicit(&q->pop_events, memory_order_acquire);
+
+		/* Register as a waiter before checking the queue one last time. Any consumer which frees
+		 * a slot after this point will see the waiter and increment the events word. */
+		atomic_fetch_add_explicit(&q->full_waiters, 1, memory_order_seq_cst);
+		futex_barrier();
+
+		bool pushed = queue_push(q, ptr);
+
+		bool woken = pushed || futex_wait(&q->pop_events, events, deadline);
+
+		atomic_fetch_sub_explicit(&q->full_waiters, 1, memory_order_relaxed);
+
+		if(pushed)
+		{
+			return true;
+		}
+		else if(!woken)
+		{
+			return queue_push(q, ptr);
+		}
+	}
+}
+
+
+/* queue_get_wait *******************************************************************************//**
+ * @brief		Retrieves and removes a pointer from the queue, blocking while the queue is empty.
+ * @param[in]	q: the queue from which to remove an element.
+ * @param[out]	out: parameter to store a pointer to the removed entry.
+ * @param[in]	timeout: the maximum time to wait in microseconds or FUTEX_FOREVER.
+ * @retval		true if a pointer was removed from the queue.
+ * @retval		false if the queue remained empty until the timeout expired. */
+bool queue_get_wait(Queue* q, void* out, unsigned timeout)
+{
+	uint64_t deadline;
+	unsigned i;
+
+	for(i = 0; i < FUTEX_SPIN; i++)
+	{
+		if(queue_get(q, out))
+		{
+			return true;
+		}
+	}
+
+	deadline = futex_deadline(timeout);
+
+	while(1)
+	{
+		unsigned events = atomic_load_explicit(&q->push_events, memory_order_acquire);
+
+		/* Register as a waiter before checking the queue one last time. Any producer which
+		 * publishes an entry after this point will see the waiter and increment the events word. */
+		atomic_fetch_add_explicit(&q->empty_waiters, 1, memory_order_seq_cst);
+		futex_barrier();
+
+		bool got = queue_get(q, out);
+
+		bool woken = got || futex_wait(&q->push_events, events, deadline);
+
+		atomic_fetch_sub_explicit(&q->empty_waiters, 1, memory_order_relaxed);
+
+		if(got)
+		{
+			return true;
+		}
+		else if(!woken)
+		{
+			return queue_get(q, out);
+		}
+	}
+}
+
+
+/* queue_notify *********************************************************************************//**
+ * @brief		Wakes threads parked on the events word after count entries have been published or
+ *				removed. A thread only registers as a waiter after it finds the queue empty (or
+ *				full), so the system call is made only when the update takes the queue out of that
+ *				state. */
+static void queue_notify(_Atomic unsigned* events, _Atomic unsigned* waiters, unsigned count)
+{
+	/* Keep the waiter check after the slot update. No hardware fence is needed: waiters call
+	 * futex_barrier after registering, which pairs with this plain load. */
+	atomic_signal_fence(memory_order_seq_cst);
+
+	if(count && atomic_load_explicit(waiters, memory_order_relaxed))
+	{
+		atomic_fetch_add_explicit(events, 1, memory_order_release);
+		futex_wake(events, count);
+	}
 }
 
 
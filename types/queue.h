@@ -31,26 +31,52 @@ extern "C" {
 #include <stdint.h>
 
 #include "key.h"
+#include "utils.h"
 
 
 /* Public Types ---------------------------------------------------------------------------------- */
+/* QueueSlot ************************************************************************************//**
+ * @brief		An entry in a queue. The sequence number tracks which lap of the queue the slot
+ *				belongs to. A slot at position pos may be written when its sequence number equals pos
+ *				and may be read when its sequence number equals pos + 1. */
 typedef struct {
-	        Key      key;
-	        unsigned size;
-	_Atomic unsigned read;
-	_Atomic unsigned write;
-	void* _Atomic* entries;		/* Pointer to atomic void pointer */
+	_Atomic unsigned seq;
+	void* ptr;
+} QueueSlot;
+
+
+/* Queue ****************************************************************************************//**
+ * @brief		Bounded multi-producer, multi-consumer queue of pointers. Producers and consumers
+ *				claim positions with a CAS on the write and read indices respectively. A claimed
+ *				slot's pointer is only published to consumers (or returned to producers) by updating
+ *				the slot's sequence number so that half written entries are never observed. The read
+ *				and write indices are kept on separate cache lines. Threads may block on an empty or
+ *				full queue with queue_get_wait and queue_push_wait. */
+typedef struct {
+	Key        key;
+	unsigned   size;
+	QueueSlot* slots;
+
+	_Alignas(CACHE_LINE_SIZE) _Atomic unsigned write;
+	_Alignas(CACHE_LINE_SIZE) _Atomic unsigned read;
+
+	/* Blocking. The events words are incremented and woken when entries are pushed (or removed)
+	 * while at least one thread is parked waiting on the queue being empty (or full). */
+	_Alignas(CACHE_LINE_SIZE) _Atomic unsigned push_events;
+	_Atomic unsigned empty_waiters;
+	_Atomic unsigned pop_events;
+	_Atomic unsigned full_waiters;
 } Queue;
 
 
 /* Public Functions ------------------------------------------------------------------------------ */
-inline bool     queue_init (Queue*, void* _Atomic*, unsigned);
-inline void     queue_clear(Queue* q)                { q->read = q->write;                     }
+inline bool     queue_init (Queue*, QueueSlot*, unsigned);
+       void     queue_clear(Queue*);
 inline Key      queue_key  (const Queue* q)          { return q->key;                          }
 inline unsigned queue_size (const Queue* q)          { return q->size;                         }
-inline unsigned queue_count(const Queue* q)          { return q->write - q->read;              }
+inline unsigned queue_count(const Queue*);
 inline unsigned queue_free (const Queue* q)          { return queue_size(q) - queue_count(q);  }
-inline bool     queue_empty(const Queue* q)          { return q->write == q->read;             }
+inline bool     queue_empty(const Queue* q)          { return queue_count(q) == 0;             }
 inline bool     queue_full (const Queue* q)          { return queue_count(q) == queue_size(q); }
 inline void*    queue_entry(const Queue*, unsigned);
 inline void*    queue_next (const Queue* q)          { return queue_entry(q, 0);               }
@@ -59,23 +85,26 @@ inline void*    queue_next (const Queue* q)          { return queue_entry(q, 0);
        bool     queue_peek (const Queue*, void*);
        bool     queue_pop  (Queue*);
        bool     queue_get  (Queue*, void*);
+       unsigned queue_push_many(Queue*, const void*, unsigned);
+       unsigned queue_get_many (Queue*, void*, unsigned);
+       bool     queue_push_wait(Queue*, const void*, unsigned);
+       bool     queue_get_wait (Queue*, void*, unsigned);
 
 
 /* queue_init ***********************************************************************************//**
  * @brief		Initializes the queue. The queue stores pointers to entries.
  * @param[in]	q: the queue to initialize.
- * @param[in]	entries: pointer to an array of atomic void pointers.
+ * @param[in]	slots: array of size slots to hold the queue's entries.
  * @param[in]	size: the capacity of the queue. Must be a power of 2.
  * @retval		true if the queue was initialized successfully.
  * @retval		false if the size of the queue was not a power of 2. */
-inline bool queue_init(Queue* q, void* _Atomic* entries, unsigned size)
+inline bool queue_init(Queue* q, QueueSlot* slots, unsigned size)
 {
-	if(entries && size && !(size & (size-1)))
+	if(slots && size && !(size & (size-1)))
 	{
-		q->read    = 0;
-		q->write   = 0;
-		q->size    = size;
-		q->entries = entries;
+		q->size  = size;
+		q->slots = slots;
+		queue_clear(q);
 		return true;
 	}
 	else
@@ -85,17 +114,38 @@ inline bool queue_init(Queue* q, void* _Atomic* entries, unsigned size)
 }
 
 
+/* queue_count **********************************************************************************//**
+ * @brief		Returns the number of entries in the queue. When called concurrently with producers
+ *				or consumers, the count is a snapshot which includes entries that have been claimed
+ *				but not yet published or removed. */
+inline unsigned queue_count(const Queue* q)
+{
+	unsigned read  = atomic_load_explicit(&q->read,  memory_order_acquire);
+	unsigned write = atomic_load_explicit(&q->write, memory_order_acquire);
+	unsigned count = write - read;
+
+	/* Read is loaded first so the count is never negative. Producers may refill the queue between
+	 * the two loads, which can push the count past the size. */
+	return count > queue_size(q) ? queue_size(q) : count;
+}
+
+
 /* queue_entry **********************************************************************************//**
  * @brief		Returns the pointer at the specified index. The index is offset from the oldest entry
- * 				in the queue. That is, index 0 returns the next entry to be removed from the queue.
+ *				in the queue. That is, index 0 returns the next entry to be removed from the queue.
+ * @warning		The returned entry may be removed concurrently by another consumer.
  * @param[in]	q: the queue from which to retrieve an entry.
  * @param[in]	idx: the index of the entry.
- * @return		Pointer to the entry at the specified index. Null if the index is out of bounds. */
+ * @return		Pointer to the entry at the specified index. Null if the index is out of bounds or the
+ *				entry has not been published yet. */
 inline void* queue_entry(const Queue* q, unsigned idx)
 {
-	if(idx < queue_count(q))
+	unsigned pos = atomic_load_explicit(&q->read, memory_order_acquire) + idx;
+	const QueueSlot* slot = &q->slots[pos & (queue_size(q)-1)];
+
+	if(idx < queue_count(q) && atomic_load_explicit(&slot->seq, memory_order_acquire) == pos + 1)
 	{
-		return q->entries[(q->read + idx) & (queue_size(q)-1)];
+		return slot->ptr;
 	}
 	else
 	{
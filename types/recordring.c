@@ -0,0 +1,270 @@
+/************************************************************************************************//**
+ * @file		recordring.c
+ *
+ * @copyright	Copyright 2022 Kurt Hildebrand.
+ * @license		Licensed under the Apache License, Version 2.0 (the "License"); you may not use this
+ * 				file except in compliance with the License. You may obtain a copy of the License at
+ *
+ * 				http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * 				Unless required by applicable law or agreed to in writing, software distributed under
+ * 				the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF
+ * 				ANY KIND, either express or implied. See the License for the specific language
+ * 				governing permissions and limitations under the License.
+ *
+ ***************************************************************************************************/
+#include "futex.h"
+#include "recordring.h"
+
+
+/* Inline Function Instances --------------------------------------------------------------------- */
+extern Key      rr_key  (const RecordRing*);
+extern unsigned rr_size (const RecordRing*);
+extern unsigned rr_count(const RecordRing*);
+extern unsigned rr_free (const RecordRing*);
+extern bool     rr_empty(const RecordRing*);
+
+
+/* Private Functions ----------------------------------------------------------------------------- */
+static unsigned rr_claim_size(const RecordRing*, unsigned, unsigned);
+static void     rr_record    (const RecordRing*, RingRecord*, unsigned, unsigned, unsigned, unsigned);
+
+
+/* rr_init **************************************************************************************//**
+ * @brief		Initializes an empty record ring.
+ * @param[in]	rr: the record ring to initialize.
+ * @param[in]	data: the buffer to hold records. Must be aligned to RR_HEADER_SIZE bytes.
+ * @param[in]	size: the size of the buffer in bytes. Must be a power of 2 of at least
+ *				2 * RR_HEADER_SIZE bytes.
+ * @param[in]	mode: RR_SINGLE_PRODUCER or RR_MULTI_PRODUCER.
+ * @retval		true if the record ring was initialized successfully.
+ * @retval		false if the buffer is misaligned or the size is invalid. */
+bool rr_init(RecordRing* rr, void* data, unsigned size, RecordRingMode mode)
+{
+	if(data && ((uintptr_t)data % RR_HEADER_SIZE) == 0 &&
+		size >= 2 * RR_HEADER_SIZE && !(size & (size-1)))
+	{
+		rr->data = data;
+		rr->size = size;
+		rr->mode = mode;
+		rr_clear(rr);
+		return true;
+	}
+	else
+	{
+		return false;
+	}
+}
+
+
+/* rr_clear *************************************************************************************//**
+ * @brief		Removes all records from the record ring.
+ * @warning		This function is not thread safe. */
+void rr_clear(RecordRing* rr)
+{
+	atomic_store_explicit(&rr->head, 0, memory_order_relaxed);
+	atomic_store_explicit(&rr->tail, 0, memory_order_relaxed);
+	atomic_store_explicit(&rr->read, 0, memory_order_relaxed);
+}
+
+
+/* rr_reserve ***********************************************************************************//**
+ * @brief		Reserves a contiguous record of len bytes. The record's buffer is empty with len bytes
+ *				of space. The producer fills the buffer in place and then publishes the record with
+ *				rr_commit. In multi-producer mode, records are published in the order they were
+ *				reserved, so every reserved record must be committed.
+ * @param[in]	rr: the record ring to reserve from.
+ * @param[out]	rec: the reserved record.
+ * @param[in]	len: the maximum length of the record's payload in bytes.
+ * @retval		true if the record was reserved.
+ * @retval		false if the record ring does not have enough free space. */
+bool rr_reserve(RecordRing* rr, RingRecord* rec, unsigned len)
+{
+	unsigned head = atomic_load_explicit(&rr->head, memory_order_relaxed);
+	unsigned claim;
+
+	if(len > rr_size(rr) - RR_HEADER_SIZE)
+	{
+		return false;
+	}
+
+	while(1)
+	{
+		unsigned read = atomic_load_explicit(&rr->read, memory_order_acquire);
+
+		claim = rr_claim_size(rr, head, len);
+
+		if(claim > rr_size(rr) - (head - read))
+		{
+			return false;
+		}
+		else if(rr->mode == RR_SINGLE_PRODUCER)
+		{
+			atomic_store_explicit(&rr->head, head + claim, memory_order_relaxed);
+			break;
+		}
+		else if(atomic_compare_exchange_weak_explicit(
+			&rr->head, &head, head + claim, memory_order_relaxed, memory_order_relaxed))
+		{
+			break;
+		}
+	}
+
+	uint32_t header[2] = { claim, 0 };
+
+	memmove(&rr->data[head & (rr_size(rr)-1)], header, sizeof(header));
+
+	rr_record(rr, rec, head, claim, 0, len);
+
+	return true;
+}
+
+
+/* rr_commit ************************************************************************************//**
+ * @brief		Publishes a record reserved with rr_reserve to the consumer. The record's length is
+ *				the length of its buffer, which may be less than the reserved length.
+ * @param[in]	rr: the record ring to commit to.
+ * @param[in]	rec: the reserved record.
+ * @retval		true if the record was published.
+ * @retval		false if the record's buffer is invalid. */
+bool rr_commit(RecordRing* rr, RingRecord* rec)
+{
+	if(!buffer_is_valid(&rec->buffer))
+	{
+		return false;
+	}
+
+	uint32_t length = buffer_length(&rec->buffer);
+
+	memmove(&rr->data[(rec->head & (rr_size(rr)-1)) + 4], &length, sizeof(length));
+
+	/* Wait for producers which reserved earlier records to publish them. Yield after a short spin
+	 * so a preempted producer can run and finish its commit. */
+	if(rr->mode == RR_MULTI_PRODUCER)
+	{
+		unsigned i;
+
+		for(i = 0; atomic_load_explicit(&rr->tail, memory_order_acquire) != rec->head; i++)
+		{
+			if(i >= FUTEX_SPIN)
+			{
+				futex_yield();
+			}
+		}
+	}
+
+	atomic_store_explicit(&rr->tail, rec->next, memory_order_release);
+	return true;
+}
+
+
+/* rr_push **************************************************************************************//**
+ * @brief		Copies a record of len bytes into the record ring.
+ * @param[in]	rr: the record ring to copy into.
+ * @param[in]	in: the record's payload.
+ * @param[in]	len: the length of the payload in bytes.
+ * @retval		true if the record was copied into the record ring.
+ * @retval		false if the record ring does not have enough free space. */
+bool rr_push(RecordRing* rr, const void* in, unsigned len)
+{
+	RingRecord rec;
+
+	return rr_reserve(rr, &rec, len) && buffer_push_mem(&rec.buffer, in, len) &&
+		rr_commit(rr, &rec);
+}
+
+
+/* rr_peek **************************************************************************************//**
+ * @brief		Returns the oldest published record. The record's buffer spans the payload in the ring
+ *				and remains valid until the record is removed with rr_release.
+ * @param[in]	rr: the record ring to peek into.
+ * @param[out]	rec: the oldest record.
+ * @retval		true if a record was returned.
+ * @retval		false if the record ring is empty. */
+bool rr_peek(RecordRing* rr, RingRecord* rec)
+{
+	unsigned read = atomic_load_explicit(&rr->read, memory_order_relaxed);
+	unsigned tail = atomic_load_explicit(&rr->tail, memory_order_acquire);
+
+	if(read == tail)
+	{
+		return false;
+	}
+
+	uint32_t header[2];
+
+	memmove(header, &rr->data[read & (rr_size(rr)-1)], sizeof(header));
+
+	rr_record(rr, rec, read, header[0], header[1], header[1]);
+
+	return true;
+}
+
+
+/* rr_release ***********************************************************************************//**
+ * @brief		Removes the oldest record, returning its space to the producers.
+ * @param[in]	rr: the record ring to remove the record from.
+ * @param[in]	rec: the record returned by rr_peek.
+ * @retval		true if the record was removed.
+ * @retval		false if rec is not the oldest record. */
+bool rr_release(RecordRing* rr, const RingRecord* rec)
+{
+	if(rec->head == atomic_load_explicit(&rr->read, memory_order_relaxed) &&
+		rec->head != atomic_load_explicit(&rr->tail, memory_order_acquire))
+	{
+		atomic_store_explicit(&rr->read, rec->next, memory_order_release);
+		return true;
+	}
+	else
+	{
+		return false;
+	}
+}
+
+
+/* rr_claim_size ********************************************************************************//**
+ * @brief		Returns the number of ring bytes needed to store a record of len bytes at head. */
+static unsigned rr_claim_size(const RecordRing* rr, unsigned head, unsigned len)
+{
+	unsigned offset = head & (rr_size(rr)-1);
+	unsigned padded = (len + RR_HEADER_SIZE - 1) & ~(RR_HEADER_SIZE - 1);
+
+	if(offset + RR_HEADER_SIZE + padded <= rr_size(rr))
+	{
+		return RR_HEADER_SIZE + padded;
+	}
+	else
+	{
+		/* Skip to the start of the ring for the payload */
+		return rr_size(rr) - offset + padded;
+	}
+}
+
+
+/* rr_record ************************************************************************************//**
+ * @brief		Initializes a record to span the payload of the record whose header is at head. */
+static void rr_record(
+	const RecordRing* rr, RingRecord* rec, unsigned head, unsigned size, unsigned length,
+	unsigned capacity)
+{
+	unsigned offset = head & (rr_size(rr)-1);
+	uint8_t* header = &rr->data[offset];
+	uint8_t* payload;
+
+	/* The payload wrapped to the start of the ring if the record extends past the end */
+	if(offset + size > rr_size(rr))
+	{
+		payload = rr->data;
+	}
+	else
+	{
+		payload = header + RR_HEADER_SIZE;
+	}
+
+	buffer_init(&rec->buffer, payload, length, capacity);
+	rec->head = head;
+	rec->next = head + size;
+}
+
+
+/******************************************* END OF FILE *******************************************/
@@ -0,0 +1,138 @@
+/************************************************************************************************//**
+ * @file		recordring.h
+ *
+ * @copyright	Copyright 2022 Kurt Hildebrand.
+ * @license		Licensed under the Apache License, Version 2.0 (the "License"); you may not use this
+ * 				file except in compliance with the License. You may obtain a copy of the License at
+ *
+ * 				http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * 				Unless required by applicable law or agreed to in writing, software distributed under
+ * 				the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF
+ * 				ANY KIND, either express or implied. See the License for the specific language
+ * 				governing permissions and limitations under the License.
+ *
+ * @brief		Byte oriented ring buffer of variable length records. Each record is stored
+ *				contiguously behind an 8 byte header:
+ *
+ *					+----------+----------+-----------------------------+
+ *					| size     | length   | payload (padded to 8 bytes) |
+ *					+----------+----------+-----------------------------+
+ *
+ *				size is the total number of ring bytes consumed by the record, including the header.
+ *				length is the number of payload bytes. If the payload does not fit before the end of
+ *				the ring, the header stays at the end of the ring and the payload is placed at the
+ *				start of the ring. The skipped bytes are included in size.
+ *
+ ***************************************************************************************************/
+#ifndef RECORDRING_H
+#define RECORDRING_H
+
+#if __STDC_VERSION__ < 199901L
+#error Compile with C99 or higher!
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/* Includes -------------------------------------------------------------------------------------- */
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "buffer.h"
+#include "key.h"
+#include "utils.h"
+
+
+/* Public Macros --------------------------------------------------------------------------------- */
+#define RR_HEADER_SIZE	(8u)		/* Size of a record header. Also the alignment of records. */
+
+
+/* Public Types ---------------------------------------------------------------------------------- */
+typedef enum {
+	RR_SINGLE_PRODUCER,
+	RR_MULTI_PRODUCER,
+} RecordRingMode;
+
+
+/* RecordRing ***********************************************************************************//**
+ * @brief		Ring buffer of variable length records for one consumer and one or more producers.
+ *				Producers claim space by advancing head. Claimed records are published to the
+ *				consumer by advancing tail. In multi-producer mode, head is advanced with a CAS and
+ *				records are published in the order they were claimed. */
+typedef struct {
+	Key            key;
+	uint8_t*       data;
+	unsigned       size;
+	RecordRingMode mode;
+
+	/* Producers */
+	_Alignas(CACHE_LINE_SIZE) _Atomic unsigned head;
+	_Atomic unsigned tail;
+
+	/* Consumer */
+	_Alignas(CACHE_LINE_SIZE) _Atomic unsigned read;
+} RecordRing;
+
+
+/* RingRecord ***********************************************************************************//**
+ * @brief		A record reserved by a producer or peeked by the consumer. The buffer spans the
+ *				record's payload in the ring. head and next are the ring positions of the start of
+ *				the record and the start of the following record. */
+typedef struct {
+	Buffer   buffer;
+	unsigned head;
+	unsigned next;
+} RingRecord;
+
+
+/* Public Functions ------------------------------------------------------------------------------ */
+       bool     rr_init   (RecordRing*, void*, unsigned, RecordRingMode);
+       void     rr_clear  (RecordRing*);
+inline Key      rr_key    (const RecordRing* rr) { return rr->key;                 }
+inline unsigned rr_size   (const RecordRing* rr) { return rr->size;                }
+inline unsigned rr_count  (const RecordRing*);
+inline unsigned rr_free   (const RecordRing*);
+inline bool     rr_empty  (const RecordRing* rr) { return rr_count(rr) == 0;       }
+
+       bool     rr_reserve(RecordRing*, RingRecord*, unsigned);
+       bool     rr_commit (RecordRing*, RingRecord*);
+       bool     rr_push   (RecordRing*, const void*, unsigned);
+       bool     rr_peek   (RecordRing*, RingRecord*);
+       bool     rr_release(RecordRing*, const RingRecord*);
+
+
+/* rr_count *************************************************************************************//**
+ * @brief		Returns the number of ring bytes, including headers and padding, used by records
+ *				which have been published to the consumer. */
+inline unsigned rr_count(const RecordRing* rr)
+{
+	unsigned read = atomic_load_explicit(&rr->read, memory_order_acquire);
+	unsigned tail = atomic_load_explicit(&rr->tail, memory_order_acquire);
+
+	return tail - read;
+}
+
+
+/* rr_free **************************************************************************************//**
+ * @brief		Returns the number of ring bytes which have not been claimed by a producer. A record
+ *				needs RR_HEADER_SIZE bytes plus its padded length, and possibly the bytes up to the
+ *				end of the ring if it would otherwise wrap. */
+inline unsigned rr_free(const RecordRing* rr)
+{
+	unsigned read = atomic_load_explicit(&rr->read, memory_order_acquire);
+	unsigned head = atomic_load_explicit(&rr->head, memory_order_acquire);
+
+	return rr_size(rr) - (head - read);
+}
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // RECORDRING_H
+/******************************************* END OF FILE *******************************************/
@@ -13,6 +13,15 @@
  * 				governing permissions and limitations under the License.
  *
  ***************************************************************************************************/
+#if defined(__linux__)
+#define _GNU_SOURCE
+#endif
+
+#if defined(__linux__)
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
 #include "ringbuffer.h"
 
 
@@ -30,6 +39,17 @@ extern bool     rb_empty     (const RingBuffer*);
 extern bool     rb_full      (const RingBuffer*);
 extern void*    rb_entry     (const RingBuffer*, unsigned);
 extern void*    rb_next      (const RingBuffer*);
+extern unsigned rb_writable  (RingBuffer*, unsigned);
+extern unsigned rb_readable  (RingBuffer*, unsigned);
+extern void     rb_span      (const RingBuffer*, unsigned, unsigned, Range*, Range*);
+extern void     rb_notify    (_Atomic unsigned*, _Atomic unsigned*);
+
+extern unsigned rb_reserve_span(RingBuffer*, unsigned, Range*, Range*);
+extern bool     rb_commit      (RingBuffer*, unsigned);
+extern unsigned rb_peek_span   (RingBuffer*, unsigned, Range*, Range*);
+extern bool     rb_release     (RingBuffer*, unsigned);
+extern unsigned rb_reserve_buffer(RingBuffer*, unsigned, Buffer*);
+extern unsigned rb_peek_buffer   (RingBuffer*, unsigned, Buffer*);
 
 extern bool     rb_push_many (RingBuffer*, const void*, unsigned);
 extern bool     rb_pop_many  (RingBuffer*, unsigned);
@@ -42,4 +62,181 @@ extern bool     rb_pop       (RingBuffer*);
 extern bool     rb_get       (RingBuffer*, void*);
 
 
+/* rb_init_mirrored *****************************************************************************//**
+ * @brief		Initializes a ring buffer whose memory is mapped twice back to back. Any window of up to
+ *				size entries starting at any entry is contiguous, so rb_push_many, rb_pop_many and the
+ *				span functions never split a copy, and rb_peek_buffer can return the whole contents
+ *				of the ring buffer as a single buffer. Only supported on Linux.
+ * @param[in]	rb: the ring buffer to initialize.
+ * @param[in]	size: the capacity of the ring buffer. Must be a power of 2.
+ * @param[in]	elemsize: the size of an entry. size * elemsize must be a multiple of the page size.
+ * @retval		true if the ring buffer was initialized. Release it with rb_deinit_mirrored.
+ * @retval		false if the size is invalid or the memory could not be mapped. */
+bool rb_init_mirrored(RingBuffer* rb, unsigned size, unsigned elemsize)
+{
+	#if defined(__linux__)
+	size_t bytes = (size_t)size * elemsize;
+	long   page  = sysconf(_SC_PAGESIZE);
+
+	if(!size || (size & (size-1)) || !bytes || page <= 0 || bytes % page)
+	{
+		return false;
+	}
+
+	int fd = memfd_create("mistlib-ringbuffer", MFD_CLOEXEC);
+
+	if(fd < 0)
+	{
+		return false;
+	}
+
+	/* Reserve twice the address space, then map the same pages into both halves */
+	uint8_t* base = mmap(0, 2 * bytes, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+	if(ftruncate(fd, bytes) != 0 || base == MAP_FAILED ||
+		mmap(base,         bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0) != base ||
+		mmap(base + bytes, bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0) != base + bytes)
+	{
+		if(base != MAP_FAILED)
+		{
+			munmap(base, 2 * bytes);
+		}
+
+		close(fd);
+		return false;
+	}
+
+	close(fd);
+
+	range_init(&rb->range, base, size, elemsize);
+	rb->mirrored = true;
+	rb_clear(rb);
+	return true;
+	#else
+	(void)rb;
+	(void)size;
+	(void)elemsize;
+	return false;
+	#endif
+}
+
+
+/* rb_deinit_mirrored ***************************************************************************//**
+ * @brief		Unmaps the memory of a ring buffer initialized with rb_init_mirrored. */
+void rb_deinit_mirrored(RingBuffer* rb)
+{
+	#if defined(__linux__)
+	if(rb->mirrored)
+	{
+		munmap(range_at(rb_range(rb), 0), 2 * (size_t)rb_size(rb) * rb_elemsize(rb));
+		range_init(&rb->range, 0, 0, 0);
+		rb->mirrored = false;
+	}
+	#else
+	(void)rb;
+	#endif
+}
+
+
+/* rb_push_wait *********************************************************************************//**
+ * @brief		Copies a new element into the ring buffer, blocking while the ring buffer is full.
+ * @param[in]	rb: the ring buffer to place a new element on.
+ * @param[in]	in: the new element to place.
+ * @param[in]	timeout: the maximum time to wait in microseconds or FUTEX_FOREVER.
+ * @retval		true if the element was pushed.
+ * @retval		false if the ring buffer remained full until the timeout expired. */
+bool rb_push_wait(RingBuffer* rb, const void* in, unsigned timeout)
+{
+	uint64_t deadline;
+	unsigned i;
+
+	for(i = 0; i < FUTEX_SPIN; i++)
+	{
+		if(rb_push(rb, in))
+		{
+			return true;
+		}
+	}
+
+	deadline = futex_deadline(timeout);
+
+	while(1)
+	{
+		unsigned read = atomic_load_explicit(&rb->read, memory_order_acquire);
+
+		/* Register as a waiter before checking the ring buffer one last time. If the consumer
+		 * advances the read index after this point, it will either see the waiter and wake this
+		 * thread or futex_wait will return immediately because the read index changed. */
+		atomic_store_explicit(&rb->full_waiters, 1, memory_order_seq_cst);
+		futex_barrier();
+
+		bool pushed = rb_push(rb, in);
+
+		bool woken = pushed || futex_wait(&rb->read, read, deadline);
+
+		atomic_store_explicit(&rb->full_waiters, 0, memory_order_relaxed);
+
+		if(pushed)
+		{
+			return true;
+		}
+		else if(!woken)
+		{
+			return rb_push(rb, in);
+		}
+	}
+}
+
+
+/* rb_get_wait **********************************************************************************//**
+ * @brief		Retrieves and removes an element from the ring buffer, blocking while the ring buffer
+ *				is empty.
+ * @param[in]	rb: the ring buffer to remove an element from.
+ * @param[out]	out: buffer to store a copy of the next element.
+ * @param[in]	timeout: the maximum time to wait in microseconds or FUTEX_FOREVER.
+ * @retval		true if an element was retrieved and removed.
+ * @retval		false if the ring buffer remained empty until the timeout expired. */
+bool rb_get_wait(RingBuffer* rb, void* out, unsigned timeout)
+{
+	uint64_t deadline;
+	unsigned i;
+
+	for(i = 0; i < FUTEX_SPIN; i++)
+	{
+		if(rb_get(rb, out))
+		{
+			return true;
+		}
+	}
+
+	deadline = futex_deadline(timeout);
+
+	while(1)
+	{
+		unsigned write = atomic_load_explicit(&rb->write, memory_order_acquire);
+
+		/* Register as a waiter before checking the ring buffer one last time. If the producer
+		 * advances the write index after this point, it will either see the waiter and wake this
+		 * thread or futex_wait will return immediately because the write index changed. */
+		atomic_store_explicit(&rb->empty_waiters, 1, memory_order_seq_cst);
+		futex_barrier();
+
+		bool got = rb_get(rb, out);
+
+		bool woken = got || futex_wait(&rb->write, write, deadline);
+
+		atomic_store_explicit(&rb->empty_waiters, 0, memory_order_relaxed);
+
+		if(got)
+		{
+			return true;
+		}
+		else if(!woken)
+		{
+			return rb_get(rb, out);
+		}
+	}
+}
+
+
 /******************************************* END OF FILE *******************************************/
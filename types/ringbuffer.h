@@ -26,35 +26,74 @@ extern "C" {
 
 
 /* Includes -------------------------------------------------------------------------------------- */
+#include <stdatomic.h>
 #include <stdbool.h>
 
+#include "buffer.h"
+#include "futex.h"
 #include "key.h"
 #include "range.h"
+#include "utils.h"
 
 
 /* Public Types ---------------------------------------------------------------------------------- */
+/* RingBuffer ***********************************************************************************//**
+ * @brief		Ring buffer of fixed size elements. The ring buffer is safe to use from one producer
+ *				thread and one consumer thread concurrently. The write index is only modified by the
+ *				producer and the read index is only modified by the consumer. Each index is placed on
+ *				its own cache line together with the owning thread's cached copy of the opposite
+ *				index so that the shared indices are only reloaded when the cached copy indicates
+ *				that the ring buffer is full (producer) or empty (consumer). Threads may block on an
+ *				empty or full ring buffer with rb_get_wait and rb_push_wait, which park on the write
+ *				and read indices respectively. On Linux, rb_init_mirrored maps the ring buffer's
+ *				memory twice back to back so that any window of up to rb_size elements is contiguous.
+ */
 typedef struct {
 	Key key;
 	Range range;
-	unsigned write;
-	unsigned read;
+	bool mirrored;		/* The range's memory is mapped twice back to back */
+
+	/* Producer */
+	_Alignas(CACHE_LINE_SIZE) _Atomic unsigned write;
+	unsigned read_cache;
+
+	/* Consumer */
+	_Alignas(CACHE_LINE_SIZE) _Atomic unsigned read;
+	unsigned write_cache;
+
+	/* Blocking */
+	_Alignas(CACHE_LINE_SIZE) _Atomic unsigned empty_waiters;
+	_Atomic unsigned full_waiters;
 } RingBuffer;
 
 
 /* Public Functions ------------------------------------------------------------------------------ */
 inline bool     rb_init      (RingBuffer*, void*, unsigned, unsigned);
 inline bool     rb_init_range(RingBuffer*, Range);
+       bool     rb_init_mirrored  (RingBuffer*, unsigned, unsigned);
+       void     rb_deinit_mirrored(RingBuffer*);
 inline Range*   rb_range     (const RingBuffer*);
-inline void     rb_clear     (RingBuffer* rb)       { rb->write = 0; rb->read = 0;        }
+inline void     rb_clear     (RingBuffer*);
 inline Key      rb_key       (const RingBuffer* rb) { return rb->key;                     }
 inline unsigned rb_size      (const RingBuffer* rb) { return range_count(&rb->range);     }
 inline unsigned rb_elemsize  (const RingBuffer* rb) { return range_elemsize(&rb->range);  }
-inline unsigned rb_count     (const RingBuffer* rb) { return rb->write - rb->read;        }
+inline unsigned rb_count     (const RingBuffer*);
 inline unsigned rb_free      (const RingBuffer* rb) { return rb_size(rb) - rb_count(rb);  }
-inline bool     rb_empty     (const RingBuffer* rb) { return rb->write == rb->read;       }
+inline bool     rb_empty     (const RingBuffer* rb) { return rb_count(rb) == 0;           }
 inline bool     rb_full      (const RingBuffer* rb) { return rb_count(rb) == rb_size(rb); }
 inline void*    rb_entry     (const RingBuffer*, unsigned);
 inline void*    rb_next      (const RingBuffer* rb) { return rb_entry(rb, 0);             }
+inline unsigned rb_writable  (RingBuffer*, unsigned);
+inline unsigned rb_readable  (RingBuffer*, unsigned);
+inline void     rb_span      (const RingBuffer*, unsigned, unsigned, Range*, Range*);
+inline void     rb_notify    (_Atomic unsigned*, _Atomic unsigned*);
+
+inline unsigned rb_reserve_span(RingBuffer*, unsigned, Range*, Range*);
+inline bool     rb_commit      (RingBuffer*, unsigned);
+inline unsigned rb_peek_span   (RingBuffer*, unsigned, Range*, Range*);
+inline bool     rb_release     (RingBuffer*, unsigned);
+inline unsigned rb_reserve_buffer(RingBuffer*, unsigned, Buffer*);
+inline unsigned rb_peek_buffer   (RingBuffer*, unsigned, Buffer*);
 
 inline bool     rb_push_many (RingBuffer*, const void*, unsigned);
 inline bool     rb_pop_many  (RingBuffer*, unsigned);
@@ -65,6 +104,8 @@ inline bool     rb_peek      (const RingBuffer*, void*);
 inline bool     rb_peek_at   (const RingBuffer*, void*, unsigned);
 inline bool     rb_pop       (RingBuffer*);
 inline bool     rb_get       (RingBuffer*, void*);
+       bool     rb_push_wait (RingBuffer*, const void*, unsigned);
+       bool     rb_get_wait  (RingBuffer*, void*, unsigned);
 
 
 /* rb_init **************************************************************************************//**
@@ -85,8 +126,8 @@ inline bool rb_init(RingBuffer* rb, void* data, unsigned size, unsigned elemsize
 	if(size && !(size & (size-1)))
 	{
 		range_init(&rb->range, data, size, elemsize);
-		rb->read     = 0;
-		rb->write    = 0;
+		rb->mirrored = false;
+		rb_clear(rb);
 		return true;
 	}
 	else
@@ -112,9 +153,9 @@ inline bool rb_init_range(RingBuffer* rb, Range r)
 	 * explicitly checked because size & (size-1) incorrectly validates 0 as a power of 2. */
 	if(range_count(&r) && !(range_count(&r) & (range_count(&r)-1)))
 	{
-		rb->range = r;
-		rb->read  = 0;
-		rb->write = 0;
+		rb->range    = r;
+		rb->mirrored = false;
+		rb_clear(rb);
 		return true;
 	}
 	else
@@ -133,6 +174,34 @@ inline Range* rb_range(const RingBuffer* rb)
 }
 
 
+/* rb_clear *************************************************************************************//**
+ * @brief		Removes all elements from the ring buffer.
+ * @warning		This function is not thread safe. Neither the producer nor the consumer may access the
+ *				ring buffer while it is being cleared. */
+inline void rb_clear(RingBuffer* rb)
+{
+	atomic_store_explicit(&rb->write, 0, memory_order_relaxed);
+	atomic_store_explicit(&rb->read,  0, memory_order_relaxed);
+	atomic_store_explicit(&rb->empty_waiters, 0, memory_order_relaxed);
+	atomic_store_explicit(&rb->full_waiters,  0, memory_order_relaxed);
+	rb->read_cache  = 0;
+	rb->write_cache = 0;
+}
+
+
+/* rb_count *************************************************************************************//**
+ * @brief		Returns the number of elements in the ring buffer. When called concurrently with the
+ *				producer or consumer, the count is a snapshot which may be stale by the time it is
+ *				returned. */
+inline unsigned rb_count(const RingBuffer* rb)
+{
+	unsigned read  = atomic_load_explicit(&rb->read,  memory_order_acquire);
+	unsigned write = atomic_load_explicit(&rb->write, memory_order_acquire);
+
+	return write - read;
+}
+
+
 /* rb_entry *************************************************************************************//**
  * @brief		Returns a pointer to the entry at the specified index. The index is offset from the
  * 				oldest entry in the queue. That is, index 0 returns a pointer to the next entry to be
@@ -146,7 +215,9 @@ inline void* rb_entry(const RingBuffer* rb, unsigned idx)
 	{
 		Range* r = rb_range(rb);
 
-		return range_at(r, range_start(r) + ((rb->read + idx) & (rb_size(rb) - 1)));
+		unsigned read = atomic_load_explicit(&rb->read, memory_order_relaxed);
+
+		return range_at(r, range_start(r) + ((read + idx) & (rb_size(rb) - 1)));
 	}
 	else
 	{
@@ -155,6 +226,96 @@ inline void* rb_entry(const RingBuffer* rb, unsigned idx)
 }
 
 
+/* rb_writable **********************************************************************************//**
+ * @brief		Returns the number of free entries seen by the producer. The shared read index is
+ *				only reloaded if the producer's cached copy shows fewer than count free entries.
+ * @warning		This is an internal function and should only be called by the producer. */
+inline unsigned rb_writable(RingBuffer* rb, unsigned count)
+{
+	unsigned write = atomic_load_explicit(&rb->write, memory_order_relaxed);
+	unsigned free  = rb_size(rb) - (write - rb->read_cache);
+
+	if(free < count)
+	{
+		rb->read_cache = atomic_load_explicit(&rb->read, memory_order_acquire);
+		free = rb_size(rb) - (write - rb->read_cache);
+	}
+
+	return free;
+}
+
+
+/* rb_readable **********************************************************************************//**
+ * @brief		Returns the number of entries seen by the consumer. The shared write index is only
+ *				reloaded if the consumer's cached copy shows fewer than count entries.
+ * @warning		This is an internal function and should only be called by the consumer. */
+inline unsigned rb_readable(RingBuffer* rb, unsigned count)
+{
+	unsigned read  = atomic_load_explicit(&rb->read, memory_order_relaxed);
+	unsigned avail = rb->write_cache - read;
+
+	if(avail < count)
+	{
+		rb->write_cache = atomic_load_explicit(&rb->write, memory_order_acquire);
+		avail = rb->write_cache - read;
+	}
+
+	return avail;
+}
+
+
+/* rb_span **************************************************************************************//**
+ * @brief		Splits count entries starting at the free running index idx into at most two
+ *				contiguous slices of the ring buffer's range. The second slice is empty unless the
+ *				entries wrap around the end of the range. Mirrored ring buffers always return a single
+ *				slice, which may extend past the end of the range into the mirror.
+ * @warning		This is an internal function and should not be called by the user. */
+inline void rb_span(const RingBuffer* rb, unsigned idx, unsigned count, Range* first, Range* second)
+{
+	const Range* r = rb_range(rb);
+	unsigned start = range_start(r) + (idx & (rb_size(rb) - 1));
+	unsigned block = range_end(r) - start;
+
+	if(rb->mirrored)
+	{
+		/* The mirror makes the entries after the end of the range alias the start of the range */
+		Range mirror = *r;
+		mirror.end  += rb_size(rb);
+
+		range_slice(first,  &mirror, start, start + count);
+		range_slice(second, r, range_start(r), range_start(r));
+	}
+	else if(count <= block)
+	{
+		range_slice(first,  r, start, start + count);
+		range_slice(second, r, range_start(r), range_start(r));
+	}
+	else
+	{
+		range_slice(first,  r, start, range_end(r));
+		range_slice(second, r, range_start(r), range_start(r) + count - block);
+	}
+}
+
+
+/* rb_notify ************************************************************************************//**
+ * @brief		Wakes a thread parked on index after the index has been advanced. A thread only
+ *				registers as a waiter after it finds the ring buffer empty (or full), so the system
+ *				call is made only when the update takes the ring buffer out of that state.
+ * @warning		This is an internal function and should not be called by the user. */
+inline void rb_notify(_Atomic unsigned* index, _Atomic unsigned* waiters)
+{
+	/* Keep the waiter check after the index update. No hardware fence is needed: waiters call
+	 * futex_barrier after registering, which pairs with this plain load. */
+	atomic_signal_fence(memory_order_seq_cst);
+
+	if(atomic_load_explicit(waiters, memory_order_relaxed))
+	{
+		futex_wake(index, 1);
+	}
+}
+
+
 /* rb_push_many *********************************************************************************//**
  * @brief		Copies the specified number of elements into the ring buffer if there is enough
  * 				space.
@@ -165,39 +326,27 @@ inline void* rb_entry(const RingBuffer* rb, unsigned idx)
  * @retval		false if there was not enough space in the ring buffer. */
 inline bool rb_push_many(RingBuffer* rb, const void* in, unsigned count)
 {
-	if(rb_free(rb) < count)
+	Range first;
+	Range second;
+
+	if(rb_reserve_span(rb, count, &first, &second) < count)
 	{
 		return false;
 	}
 
-	/* Copy from s (source) -> r (ring buffer). Compute the number of entries remaining till the end
-	 * of the ringbuffer's array. */
-	      Range* r = rb_range(rb);
-	const Range  s = make_const_range(in, count, rb_elemsize(rb));
-	unsigned block = rb_size(rb) - (rb->write & (rb_size(rb)-1));
+	/* Copy from in -> ring buffer. The second span is only non-empty if the new elements wrap
+	 * around the end of the ring buffer's array. */
+	memmove(
+		range_at(&first, range_start(&first)),
+		in,
+		range_count(&first) * rb_elemsize(rb));
 
-	if(count <= block)
-	{
-		memmove(
-			range_at(r, rb->write & (rb_size(rb)-1)),
-			range_at(&s, 0),
-			count * rb_elemsize(rb));
-	}
-	else
-	{
-		memmove(
-			range_at(r, rb->write & (rb_size(rb)-1)),
-			range_at(&s, 0),
-			block * rb_elemsize(rb));
-
-		memmove(
-			range_at(r, (rb->write + block) & (rb_size(rb)-1)),
-			range_at(&s, block),
-			(count - block) * rb_elemsize(rb));
-	}
+	memmove(
+		range_at(&second, range_start(&second)),
+		(const char*)in + range_count(&first) * rb_elemsize(rb),
+		range_count(&second) * rb_elemsize(rb));
 
-	rb->write += count;
-	return true;
+	return rb_commit(rb, count);
 }
 
 
@@ -211,9 +360,12 @@ inline bool rb_push_many(RingBuffer* rb, const void* in, unsigned count)
  * 				this case, the ring buffer will be left unmodified. */
 inline bool rb_pop_many(RingBuffer* rb, unsigned count)
 {
-	if(rb_count(rb) >= count)
+	if(rb_readable(rb, count) >= count)
 	{
-		rb->read += count;
+		unsigned read = atomic_load_explicit(&rb->read, memory_order_relaxed);
+
+		atomic_store_explicit(&rb->read, read + count, memory_order_release);
+		rb_notify(&rb->read, &rb->full_waiters);
 		return true;
 	}
 	else
@@ -225,18 +377,21 @@ inline bool rb_pop_many(RingBuffer* rb, unsigned count)
 
 /* rb_reserve ***********************************************************************************//**
  * @brief		Reserves an entry from the ring buffer and returns a pointer to the entry.
- * @warning		This function is not thread safe (single producer, single consumer).
+ * @warning		The entry is made visible to the consumer immediately. When the producer and consumer
+ *				run on different threads, use rb_reserve_span and rb_commit instead.
  * @param[in]	rb: the ring buffer to operate on.
- * @param[in]	in: the new element to push onto ring buffer.
- * @retval		true if the new element was pushed onto the ring buffer.
- * @retval		false if the ring buffer is full. */
+ * @return		Pointer to the reserved entry. Null if the ring buffer is full. */
 inline void* rb_reserve(RingBuffer* rb)
 {
-	if(!rb_full(rb))
+	if(rb_writable(rb, 1))
 	{
 		Range* r = rb_range(rb);
+		unsigned write = atomic_load_explicit(&rb->write, memory_order_relaxed);
 
-		return range_at(r, range_start(r) + (rb->write++ & (rb_size(rb) - 1)));
+		atomic_store_explicit(&rb->write, write + 1, memory_order_release);
+		rb_notify(&rb->write, &rb->empty_waiters);
+
+		return range_at(r, range_start(r) + (write & (rb_size(rb) - 1)));
 	}
 	else
 	{
@@ -253,13 +408,15 @@ inline void* rb_reserve(RingBuffer* rb)
  * @retval		false if the operation failed. In this case the queue remains unchanged. */
 inline bool rb_push(RingBuffer* rb, const void* in)
 {
-	if(!rb_full(rb))
+	if(rb_writable(rb, 1))
 	{
 		Range* r = rb_range(rb);
+		unsigned write = atomic_load_explicit(&rb->write, memory_order_relaxed);
 
-		memmove(range_at(r, rb->write & (rb_size(rb) - 1)), in, rb_elemsize(rb));
+		memmove(range_at(r, range_start(r) + (write & (rb_size(rb) - 1))), in, rb_elemsize(rb));
 
-		rb->write++;
+		atomic_store_explicit(&rb->write, write + 1, memory_order_release);
+		rb_notify(&rb->write, &rb->empty_waiters);
 
 		return true;
 	}
@@ -313,15 +470,7 @@ inline bool rb_peek_at(const RingBuffer* rb, void* out, unsigned idx)
  * @retval		false if the ring buffer is empty. */
 inline bool rb_pop(RingBuffer* rb)
 {
-	if(!rb_empty(rb))
-	{
-		rb->read++;
-		return true;
-	}
-	else
-	{
-		return false;
-	}
+	return rb_pop_many(rb, 1);
 }
 
 
@@ -337,6 +486,140 @@ inline bool rb_get(RingBuffer* rb, void* out)
 }
 
 
+/* rb_reserve_span ******************************************************************************//**
+ * @brief		Reserves up to count free entries for the producer to fill in place. The reserved
+ *				entries are returned as at most two contiguous slices of the ring buffer's range. The
+ *				entries are not visible to the consumer until they are published with rb_commit.
+ * @param[in]	rb: the ring buffer to reserve entries from.
+ * @param[in]	count: the maximum number of entries to reserve.
+ * @param[out]	first: slice of reserved entries starting at the write index.
+ * @param[out]	second: slice of reserved entries that wrapped around to the start of the range.
+ *				Empty if the reserved entries do not wrap.
+ * @return		The number of entries reserved. Less than count if the ring buffer does not have
+ *				enough free entries. */
+inline unsigned rb_reserve_span(RingBuffer* rb, unsigned count, Range* first, Range* second)
+{
+	unsigned free  = rb_writable(rb, count);
+	unsigned write = atomic_load_explicit(&rb->write, memory_order_relaxed);
+
+	if(count > free)
+	{
+		count = free;
+	}
+
+	rb_span(rb, write, count, first, second);
+
+	return count;
+}
+
+
+/* rb_commit ************************************************************************************//**
+ * @brief		Publishes count entries previously filled by the producer to the consumer.
+ * @param[in]	rb: the ring buffer to commit entries to.
+ * @param[in]	count: the number of entries to publish.
+ * @retval		true if the entries were published.
+ * @retval		false if count is larger than the number of free entries. */
+inline bool rb_commit(RingBuffer* rb, unsigned count)
+{
+	if(rb_writable(rb, count) >= count)
+	{
+		unsigned write = atomic_load_explicit(&rb->write, memory_order_relaxed);
+
+		atomic_store_explicit(&rb->write, write + count, memory_order_release);
+		rb_notify(&rb->write, &rb->empty_waiters);
+		return true;
+	}
+	else
+	{
+		return false;
+	}
+}
+
+
+/* rb_peek_span *********************************************************************************//**
+ * @brief		Returns up to count of the oldest entries for the consumer to read in place. The
+ *				entries are returned as at most two contiguous slices of the ring buffer's range and
+ *				remain valid until they are removed with rb_release.
+ * @param[in]	rb: the ring buffer to peek into.
+ * @param[in]	count: the maximum number of entries to peek.
+ * @param[out]	first: slice of entries starting at the read index.
+ * @param[out]	second: slice of entries that wrapped around to the start of the range. Empty if the
+ *				entries do not wrap.
+ * @return		The number of entries returned. Less than count if the ring buffer contains fewer
+ *				entries. */
+inline unsigned rb_peek_span(RingBuffer* rb, unsigned count, Range* first, Range* second)
+{
+	unsigned avail = rb_readable(rb, count);
+	unsigned read  = atomic_load_explicit(&rb->read, memory_order_relaxed);
+
+	if(count > avail)
+	{
+		count = avail;
+	}
+
+	rb_span(rb, read, count, first, second);
+
+	return count;
+}
+
+
+/* rb_release ***********************************************************************************//**
+ * @brief		Removes count entries previously returned by rb_peek_span, returning their space to
+ *				the producer.
+ * @param[in]	rb: the ring buffer to release entries from.
+ * @param[in]	count: the number of entries to release.
+ * @retval		true if the entries were released.
+ * @retval		false if the ring buffer contains fewer than count entries. */
+inline bool rb_release(RingBuffer* rb, unsigned count)
+{
+	return rb_pop_many(rb, count);
+}
+
+
+/* rb_reserve_buffer ****************************************************************************//**
+ * @brief		Reserves up to count contiguous free entries and returns them as an empty buffer for
+ *				the producer to fill. The entries are published with rb_commit.
+ * @param[in]	rb: the ring buffer to reserve entries from.
+ * @param[in]	count: the maximum number of entries to reserve.
+ * @param[out]	b: buffer spanning the reserved entries.
+ * @return		The number of entries spanned by the buffer. Less than count if the ring buffer does
+ *				not have enough free entries or, unless the ring buffer is mirrored, if the entries
+ *				would wrap around the end of the range. */
+inline unsigned rb_reserve_buffer(RingBuffer* rb, unsigned count, Buffer* b)
+{
+	Range first;
+	Range second;
+
+	rb_reserve_span(rb, count, &first, &second);
+	buffer_init(b, range_at(&first, range_start(&first)), 0, range_count(&first) * rb_elemsize(rb));
+
+	return range_count(&first);
+}
+
+
+/* rb_peek_buffer *******************************************************************************//**
+ * @brief		Returns up to count of the oldest entries as a buffer so that buffer based parsers can
+ *				read the ring buffer's contents in place. The entries are removed with rb_release.
+ * @param[in]	rb: the ring buffer to peek into.
+ * @param[in]	count: the maximum number of entries to peek.
+ * @param[out]	b: buffer spanning the entries.
+ * @return		The number of entries spanned by the buffer. Less than count if the ring buffer
+ *				contains fewer entries or, unless the ring buffer is mirrored, if the entries wrap
+ *				around the end of the range. */
+inline unsigned rb_peek_buffer(RingBuffer* rb, unsigned count, Buffer* b)
+{
+	Range    first;
+	Range    second;
+	unsigned len;
+
+	rb_peek_span(rb, count, &first, &second);
+	len = range_count(&first) * rb_elemsize(rb);
+	buffer_init(b, range_at(&first, range_start(&first)), len, len);
+
+	return range_count(&first);
+}
+
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,1578 @@
+/************************************************************************************************//**
+ * @file		roaring.c
+ *
+ * @copyright	Copyright 2022 Kurt Hildebrand.
+ * @license		Licensed under the Apache License, Version 2.0 (the "License"); you may not use this
+ * 				file except in compliance with the License. You may obtain a copy of the License at
+ *
+ * 				http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * 				Unless required by applicable law or agreed to in writing, software distributed under
+ * 				the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF
+ * 				ANY KIND, either express or implied. See the License for the specific language
+ * 				governing permissions and limitations under the License.
+ *
+ ***************************************************************************************************/
+#include <string.h>
+
+#include "byteorder.h"
+#include "calc.h"
+#include "roaring.h"
+
+
+/* Private Macros -------------------------------------------------------------------------------- */
+#define ROARING_COOKIE			(12346)		/* Portable format without run containers */
+#define ROARING_COOKIE_RUNS		(12347)		/* Portable format with run containers */
+#define ROARING_OFFSETS_MIN		(4)			/* Fewest containers for which run bitmaps store offsets */
+
+
+/* Private Types --------------------------------------------------------------------------------- */
+typedef enum {
+	ROARING_OP_AND,
+	ROARING_OP_OR,
+	ROARING_OP_XOR,
+	ROARING_OP_ANDNOT,
+} RoaringOp;
+
+
+/* Inline Function Instances --------------------------------------------------------------------- */
+extern void roaring_clear(Roaring*);
+extern bool roaring_empty(const Roaring*);
+
+
+/* Private Functions ----------------------------------------------------------------------------- */
+static unsigned          roaring_find      (const Roaring*, uint16_t);
+static RoaringContainer* roaring_lookup    (const Roaring*, uint16_t);
+static bool              roaring_reserve   (Roaring*, unsigned);
+static RoaringContainer* roaring_insert    (Roaring*, unsigned, uint16_t);
+static void              roaring_erase     (Roaring*, unsigned);
+static bool              roaring_op        (Roaring*, const Roaring*, RoaringOp);
+
+static unsigned          container_lower   (const RoaringContainer*, uint16_t);
+static unsigned          container_run     (const RoaringContainer*, uint16_t);
+static bool              container_contains(const RoaringContainer*, uint16_t);
+static unsigned          container_rank    (const RoaringContainer*, uint16_t);
+static bool              container_next    (const RoaringContainer*, uint16_t, uint16_t*);
+static unsigned          container_runs    (const RoaringContainer*);
+static bool              container_reserve (Roaring*, RoaringContainer*, unsigned);
+static bool              container_copy    (Roaring*, RoaringContainer*, const RoaringContainer*);
+static bool              container_bitmap  (Roaring*, RoaringContainer*);
+static bool              container_array   (Roaring*, RoaringContainer*);
+static bool              container_to_runs (Roaring*, RoaringContainer*);
+static bool              container_mutable (Roaring*, RoaringContainer*);
+static bool              container_add     (Roaring*, RoaringContainer*, uint16_t);
+static bool              container_remove  (Roaring*, RoaringContainer*, uint16_t);
+static bool              container_merge   (Roaring*, RoaringContainer*, const RoaringContainer*,
+                                            RoaringOp);
+static bool              container_op      (Roaring*, RoaringContainer*, const RoaringContainer*,
+                                            RoaringOp);
+static unsigned          container_size    (const RoaringContainer*);
+
+static void              bitmap_range      (uint64_t*, unsigned, unsigned, RoaringOp);
+static void              bitmap_apply      (uint64_t*, const RoaringContainer*, RoaringOp);
+static unsigned          bitmap_card       (const uint64_t*);
+
+
+/* roaring_init *********************************************************************************//**
+ * @brief		Initializes an empty bitmap whose containers are allocated from the arena. */
+void roaring_init(Roaring* r, Arena* arena)
+{
+	r->arena      = arena;
+	r->containers = 0;
+	r->count      = 0;
+	r->capacity   = 0;
+}
+
+
+/* roaring_count ********************************************************************************//**
+ * @brief		Returns the number of values in the bitmap. */
+uint64_t roaring_count(const Roaring* r)
+{
+	uint64_t count = 0;
+	unsigned i;
+
+	for(i = 0; i < r->count; i++)
+	{
+		count += r->containers[i].card;
+	}
+
+	return count;
+}
+
+
+/* roaring_add **********************************************************************************//**
+ * @brief		Adds a value to the bitmap.
+ * @retval		true if the value is in the bitmap.
+ * @retval		false if the arena is out of memory. */
+bool roaring_add(Roaring* r, uint32_t value)
+{
+	uint16_t          key = value >> 16;
+	unsigned          idx = roaring_find(r, key);
+	RoaringContainer* c   = 0;
+
+	if(idx < r->count && r->containers[idx].key == key)
+	{
+		return container_add(r, &r->containers[idx], value & 0xFFFF);
+	}
+	else if((c = roaring_insert(r, idx, key)) == 0)
+	{
+		return false;
+	}
+	else if(!container_add(r, c, value & 0xFFFF))
+	{
+		roaring_erase(r, idx);
+		return false;
+	}
+	else
+	{
+		return true;
+	}
+}
+
+
+/* roaring_add_range ****************************************************************************//**
+ * @brief		Adds the values first through last to the bitmap. Chunks that were empty are stored as
+ *				run containers.
+ * @retval		true if the values are in the bitmap.
+ * @retval		false if the arena is out of memory. The range may be partially added. */
+bool roaring_add_range(Roaring* r, uint32_t first, uint32_t last)
+{
+	uint32_t key;
+
+	for(key = first >> 16; first <= last && key <= last >> 16; key++)
+	{
+		unsigned lo  = key == first >> 16 ? first & 0xFFFF : 0;
+		unsigned hi  = key == last  >> 16 ? last  & 0xFFFF : 0xFFFF;
+		unsigned idx = roaring_find(r, key);
+
+		if(idx < r->count && r->containers[idx].key == key)
+		{
+			RoaringContainer* c = &r->containers[idx];
+
+			if(!container_mutable(r, c) || (c->type == ROARING_ARRAY && !container_bitmap(r, c)))
+			{
+				return false;
+			}
+
+			bitmap_range(c->bitmap, lo, hi, ROARING_OP_OR);
+			c->card = bitmap_card(c->bitmap);
+		}
+		else
+		{
+			RoaringContainer* c = roaring_insert(r, idx, key);
+
+			if(!c)
+			{
+				return false;
+			}
+
+			c->type = ROARING_RUN;
+
+			if(!container_reserve(r, c, 1))
+			{
+				roaring_erase(r, idx);
+				return false;
+			}
+
+			c->runs[0] = (RoaringRun){ .start = lo, .length = hi - lo };
+			c->count   = 1;
+			c->card    = hi - lo + 1;
+		}
+	}
+
+	return true;
+}
+
+
+/* roaring_remove *******************************************************************************//**
+ * @brief		Removes a value from the bitmap.
+ * @retval		true if the value is not in the bitmap.
+ * @retval		false if the arena is out of memory. Removing from a run container converts it. */
+bool roaring_remove(Roaring* r, uint32_t value)
+{
+	uint16_t key = value >> 16;
+	unsigned idx = roaring_find(r, key);
+
+	if(idx >= r->count || r->containers[idx].key != key)
+	{
+		return true;
+	}
+	else if(!container_remove(r, &r->containers[idx], value & 0xFFFF))
+	{
+		return false;
+	}
+	else if(r->containers[idx].card == 0)
+	{
+		roaring_erase(r, idx);
+	}
+
+	return true;
+}
+
+
+/* roaring_contains *****************************************************************************//**
+ * @brief		Returns true if the value is in the bitmap. */
+bool roaring_contains(const Roaring* r, uint32_t value)
+{
+	const RoaringContainer* c = roaring_lookup(r, value >> 16);
+
+	return c && container_contains(c, value & 0xFFFF);
+}
+
+
+/* roaring_rank *********************************************************************************//**
+ * @brief		Returns the number of values in the bitmap less than or equal to value. */
+uint64_t roaring_rank(const Roaring* r, uint32_t value)
+{
+	uint16_t key  = value >> 16;
+	uint64_t rank = 0;
+	unsigned i;
+
+	for(i = 0; i < r->count && r->containers[i].key < key; i++)
+	{
+		rank += r->containers[i].card;
+	}
+
+	if(i < r->count && r->containers[i].key == key)
+	{
+		rank += container_rank(&r->containers[i], value & 0xFFFF);
+	}
+
+	return rank;
+}
+
+
+/* roaring_next *********************************************************************************//**
+ * @brief		Finds the smallest value in the bitmap greater than or equal to from. Iterate over the
+ *				bitmap with:
+ *
+ *				for(ok = roaring_next(r, 0, &v); ok; ok = v < UINT32_MAX && roaring_next(r, v+1, &v))
+ *
+ * @param[in]	r: the bitmap to search.
+ * @param[in]	from: the first value to consider.
+ * @param[out]	value: the value found.
+ * @retval		true if a value was found.
+ * @retval		false if no value is greater than or equal to from. */
+bool roaring_next(const Roaring* r, uint32_t from, uint32_t* value)
+{
+	uint16_t key = from >> 16;
+	unsigned idx = roaring_find(r, key);
+	uint16_t low;
+
+	if(idx < r->count && r->containers[idx].key == key)
+	{
+		if(container_next(&r->containers[idx], from & 0xFFFF, &low))
+		{
+			*value = ((uint32_t)key << 16) | low;
+			return true;
+		}
+
+		idx++;
+	}
+
+	/* Containers are never empty so the next container holds the next value */
+	if(idx < r->count && container_next(&r->containers[idx], 0, &low))
+	{
+		*value = ((uint32_t)r->containers[idx].key << 16) | low;
+		return true;
+	}
+
+	return false;
+}
+
+
+/* roaring_and **********************************************************************************//**
+ * @brief		Computes d = d & s.
+ * @retval		true if successful.
+ * @retval		false if the arena is out of memory. d may be partially updated. */
+bool roaring_and(Roaring* d, const Roaring* s)
+{
+	return roaring_op(d, s, ROARING_OP_AND);
+}
+
+
+/* roaring_or ***********************************************************************************//**
+ * @brief		Computes d = d | s.
+ * @retval		true if successful.
+ * @retval		false if the arena is out of memory. d may be partially updated. */
+bool roaring_or(Roaring* d, const Roaring* s)
+{
+	return roaring_op(d, s, ROARING_OP_OR);
+}
+
+
+/* roaring_xor **********************************************************************************//**
+ * @brief		Computes d = d ^ s.
+ * @retval		true if successful.
+ * @retval		false if the arena is out of memory. d may be partially updated. */
+bool roaring_xor(Roaring* d, const Roaring* s)
+{
+	return roaring_op(d, s, ROARING_OP_XOR);
+}
+
+
+/* roaring_andnot *******************************************************************************//**
+ * @brief		Computes d = d & ~s, removing every value of s from d.
+ * @retval		true if successful.
+ * @retval		false if the arena is out of memory. d may be partially updated. */
+bool roaring_andnot(Roaring* d, const Roaring* s)
+{
+	return roaring_op(d, s, ROARING_OP_ANDNOT);
+}
+
+
+/* roaring_optimize *****************************************************************************//**
+ * @brief		Converts every container to the type that stores its values in the fewest bytes.
+ * @retval		true if successful.
+ * @retval		false if the arena is out of memory. Containers that could not be converted are left
+ *				unchanged. */
+bool roaring_optimize(Roaring* r)
+{
+	bool     ok = true;
+	unsigned i;
+
+	for(i = 0; i < r->count; i++)
+	{
+		RoaringContainer* c         = &r->containers[i];
+		unsigned          run_size  = 2 + 4 * container_runs(c);
+		unsigned          best_size = c->card <= ROARING_ARRAY_MAX ? 2 * c->card : 8192;
+
+		if(run_size < best_size)
+		{
+			ok = (c->type == ROARING_RUN || container_to_runs(r, c)) && ok;
+		}
+		else if(c->card <= ROARING_ARRAY_MAX)
+		{
+			ok = (c->type == ROARING_ARRAY || container_array(r, c)) && ok;
+		}
+		else
+		{
+			ok = (c->type == ROARING_BITMAP || container_bitmap(r, c)) && ok;
+		}
+	}
+
+	return ok;
+}
+
+
+/* roaring_serialized_size **********************************************************************//**
+ * @brief		Returns the number of bytes roaring_serialize writes. */
+unsigned roaring_serialized_size(const Roaring* r)
+{
+	bool     runs = false;
+	unsigned size = 0;
+	unsigned i;
+
+	for(i = 0; i < r->count; i++)
+	{
+		runs  = runs || r->containers[i].type == ROARING_RUN;
+		size += container_size(&r->containers[i]);
+	}
+
+	/* Cookie, descriptive headers and offsets */
+	size += runs ? 4 + (r->count + 7) / 8 : 8;
+	size += 4 * r->count;
+	size += (!runs || r->count >= ROARING_OFFSETS_MIN) ? 4 * r->count : 0;
+
+	return size;
+}
+
+
+/* roaring_serialize ****************************************************************************//**
+ * @brief		Appends the bitmap to the buffer in the portable Roaring format. Bitmap containers
+ *				holding no more than ROARING_ARRAY_MAX values are written as arrays, as the format
+ *				requires.
+ * @retval		true if the bitmap was written.
+ * @retval		false if the buffer is too small. Nothing is written. */
+bool roaring_serialize(const Roaring* r, Buffer* b)
+{
+	unsigned size = roaring_serialized_size(r);
+	uint8_t* ptr  = buffer_reserve(b, size);
+	uint8_t* out  = ptr;
+	bool     runs = false;
+	unsigned offset;
+	unsigned i, j;
+
+	if(!ptr)
+	{
+		return false;
+	}
+
+	for(i = 0; i < r->count; i++)
+	{
+		runs = runs || r->containers[i].type == ROARING_RUN;
+	}
+
+	/* Cookie */
+	if(runs)
+	{
+		le_set_u32(out, ROARING_COOKIE_RUNS | ((r->count - 1) << 16));
+		out += 4;
+
+		memset(out, 0, (r->count + 7) / 8);
+
+		for(i = 0; i < r->count; i++)
+		{
+			out[i / 8] |= (r->containers[i].type == ROARING_RUN) << (i % 8);
+		}
+
+		out += (r->count + 7) / 8;
+	}
+	else
+	{
+		le_set_u32(out + 0, ROARING_COOKIE);
+		le_set_u32(out + 4, r->count);
+		out += 8;
+	}
+
+	/* Descriptive headers */
+	for(i = 0; i < r->count; i++)
+	{
+		le_set_u16(out + 0, r->containers[i].key);
+		le_set_u16(out + 2, r->containers[i].card - 1);
+		out += 4;
+	}
+
+	/* Offsets of each container from the start of the serialized bitmap */
+	if(!runs || r->count >= ROARING_OFFSETS_MIN)
+	{
+		offset = (out - ptr) + 4 * r->count;
+
+		for(i = 0; i < r->count; i++)
+		{
+			le_set_u32(out, offset);
+			offset += container_size(&r->containers[i]);
+			out    += 4;
+		}
+	}
+
+	/* Containers */
+	for(i = 0; i < r->count; i++)
+	{
+		const RoaringContainer* c = &r->containers[i];
+
+		if(c->type == ROARING_RUN)
+		{
+			le_set_u16(out, c->count);
+			out += 2;
+
+			for(j = 0; j < c->count; j++)
+			{
+				le_set_u16(out + 0, c->runs[j].start);
+				le_set_u16(out + 2, c->runs[j].length);
+				out += 4;
+			}
+		}
+		else if(c->card > ROARING_ARRAY_MAX)
+		{
+			for(j = 0; j < ROARING_BITMAP_WORDS; j++)
+			{
+				le_set_u64(out, c->bitmap[j]);
+				out += 8;
+			}
+		}
+		else if(c->type == ROARING_ARRAY)
+		{
+			for(j = 0; j < c->count; j++)
+			{
+				le_set_u16(out, c->array[j]);
+				out += 2;
+			}
+		}
+		else
+		{
+			for(j = 0; j < ROARING_BITMAP_WORDS; j++)
+			{
+				uint64_t word = c->bitmap[j];
+
+				for( ; word; word &= word - 1)
+				{
+					le_set_u16(out, j * 64 + calc_ctz_u64(word));
+					out += 2;
+				}
+			}
+		}
+	}
+
+	return true;
+}
+
+
+/* roaring_deserialize **************************************************************************//**
+ * @brief		Reads a bitmap in the portable Roaring format from the buffer, replacing the contents
+ *				of r. The serialized bytes are removed from the buffer.
+ * @retval		true if a valid bitmap was read.
+ * @retval		false if the data is malformed or the arena is out of memory. r is left empty and
+ *				the buffer is not modified. */
+bool roaring_deserialize(Roaring* r, Buffer* b)
+{
+	const uint8_t* ptr  = buffer_read(b);
+	const uint8_t* runs = 0;
+	unsigned       len  = buffer_remaining(b);
+	unsigned       pos;
+	unsigned       count;
+	unsigned       i, j;
+
+	roaring_clear(r);
+
+	/* Cookie */
+	if(len >= 4 && (le_get_u32(ptr) & 0xFFFF) == ROARING_COOKIE_RUNS)
+	{
+		count = (le_get_u32(ptr) >> 16) + 1;
+		runs  = ptr + 4;
+		pos   = 4 + (count + 7) / 8;
+	}
+	else if(len >= 8 && le_get_u32(ptr) == ROARING_COOKIE && le_get_u32(ptr + 4) <= 65536)
+	{
+		count = le_get_u32(ptr + 4);
+		pos   = 8;
+	}
+	else
+	{
+		return false;
+	}
+
+	/* Skip the descriptive headers and offsets. Containers are stored back to back. */
+	j    = pos;
+	pos += 4 * count;
+	pos += (!runs || count >= ROARING_OFFSETS_MIN) ? 4 * count : 0;
+
+	if(pos > len || !roaring_reserve(r, count))
+	{
+		return false;
+	}
+
+	for(i = 0; i < count; i++, j += 4)
+	{
+		RoaringContainer* c    = &r->containers[i];
+		unsigned          n    = 0;
+		unsigned          card = 0;
+		unsigned          k;
+
+		c->key      = le_get_u16(ptr + j);
+		c->card     = le_get_u16(ptr + j + 2) + 1;
+		c->count    = 0;
+		c->capacity = 0;
+		r->count    = i + 1;
+
+		if(i > 0 && c->key <= c[-1].key)
+		{
+			break;
+		}
+		else if(runs && (runs[i / 8] >> (i % 8)) & 1)
+		{
+			if(pos + 2 > len || pos + 2 + 4 * (n = le_get_u16(ptr + pos)) > len)
+			{
+				break;
+			}
+
+			c->type = ROARING_RUN;
+
+			if(n == 0 || !container_reserve(r, c, n))
+			{
+				break;
+			}
+
+			/* Runs must be sorted, separate and end within the chunk */
+			for(pos += 2, k = 0; k < n; k++, pos += 4)
+			{
+				unsigned start  = le_get_u16(ptr + pos);
+				unsigned length = le_get_u16(ptr + pos + 2);
+
+				if(start + length > 0xFFFF || (k > 0 && start <= c->runs[k-1].start + c->runs[k-1].length + 1u))
+				{
+					break;
+				}
+
+				c->runs[k] = (RoaringRun){ .start = start, .length = length };
+				card += length + 1;
+			}
+
+			if(k < n)
+			{
+				break;
+			}
+
+			c->count = k;
+		}
+		else if(c->card <= ROARING_ARRAY_MAX)
+		{
+			if(pos + 2 * c->card > len)
+			{
+				break;
+			}
+
+			c->type = ROARING_ARRAY;
+
+			if(!container_reserve(r, c, c->card))
+			{
+				break;
+			}
+
+			/* Values must be strictly increasing */
+			for(k = 0; k < c->card; k++, pos += 2)
+			{
+				c->array[k] = le_get_u16(ptr + pos);
+
+				if(k > 0 && c->array[k] <= c->array[k-1])
+				{
+					break;
+				}
+			}
+
+			if(k < c->card)
+			{
+				break;
+			}
+
+			c->count = k;
+			card     = k;
+		}
+		else
+		{
+			if(pos + 8 * ROARING_BITMAP_WORDS > len || !(c->bitmap = arena_alloc(r->arena, 8192)))
+			{
+				break;
+			}
+
+			c->type = ROARING_BITMAP;
+
+			for(k = 0; k < ROARING_BITMAP_WORDS; k++, pos += 8)
+			{
+				c->bitmap[k] = le_get_u64(ptr + pos);
+			}
+
+			card = bitmap_card(c->bitmap);
+		}
+
+		if(card != c->card)
+		{
+			break;
+		}
+	}
+
+	if(i < count)
+	{
+		roaring_clear(r);
+		return false;
+	}
+
+	buffer_pop(b, pos);
+	return true;
+}
+
+
+/* roaring_find *********************************************************************************//**
+ * @brief		Returns the index of the first container whose key is not less than key. */
+static unsigned roaring_find(const Roaring* r, uint16_t key)
+{
+	unsigned lo = 0;
+	unsigned hi = r->count;
+
+	while(lo < hi)
+	{
+		unsigned mid = lo + (hi - lo) / 2;
+
+		if(r->containers[mid].key < key)
+		{
+			lo = mid + 1;
+		}
+		else
+		{
+			hi = mid;
+		}
+	}
+
+	return lo;
+}
+
+
+/* roaring_lookup *******************************************************************************//**
+ * @brief		Returns the container with the key. Null if there is no such container. */
+static RoaringContainer* roaring_lookup(const Roaring* r, uint16_t key)
+{
+	unsigned idx = roaring_find(r, key);
+
+	return (idx < r->count && r->containers[idx].key == key) ? &r->containers[idx] : 0;
+}
+
+
+/* roaring_reserve ******************************************************************************//**
+ * @brief		Ensures the container table can hold capacity containers. The table is doubled when it
+ *				grows, leaving the old table in the arena. */
+static bool roaring_reserve(Roaring* r, unsigned capacity)
+{
+	RoaringContainer* containers;
+
+	if(capacity <= r->capacity)
+	{
+		return true;
+	}
+
+	capacity   = calc_max(capacity, calc_max(2 * r->capacity, 4u));
+	containers = arena_alloc(r->arena, capacity * sizeof(RoaringContainer));
+
+	if(!containers)
+	{
+		return false;
+	}
+
+	if(r->count)
+	{
+		memcpy(containers, r->containers, r->count * sizeof(RoaringContainer));
+	}
+
+	r->containers = containers;
+	r->capacity   = capacity;
+	return true;
+}
+
+
+/* roaring_insert *******************************************************************************//**
+ * @brief		Inserts an empty array container with the key at idx. Returns null if the arena is out
+ *				of memory. */
+static RoaringContainer* roaring_insert(Roaring* r, unsigned idx, uint16_t key)
+{
+	RoaringContainer* c;
+
+	if(!roaring_reserve(r, r->count + 1))
+	{
+		return 0;
+	}
+
+	c = &r->containers[idx];
+	memmove(c + 1, c, (r->count - idx) * sizeof(RoaringContainer));
+	r->count++;
+
+	*c = (RoaringContainer){ .key = key, .type = ROARING_ARRAY };
+	return c;
+}
+
+
+/* roaring_erase ********************************************************************************//**
+ * @brief		Removes the container at idx. */
+static void roaring_erase(Roaring* r, unsigned idx)
+{
+	r->count--;
+	memmove(&r->containers[idx], &r->containers[idx+1], (r->count - idx) * sizeof(RoaringContainer));
+}
+
+
+/* roaring_op ***********************************************************************************//**
+ * @brief		Combines s into d. Both container tables are sorted so they are walked together. */
+static bool roaring_op(Roaring* d, const Roaring* s, RoaringOp op)
+{
+	bool     ok = true;
+	unsigned i  = 0;
+	unsigned j  = 0;
+
+	if(d == s)
+	{
+		if(op == ROARING_OP_XOR || op == ROARING_OP_ANDNOT)
+		{
+			roaring_clear(d);
+		}
+
+		return true;
+	}
+
+	if(op == ROARING_OP_AND || op == ROARING_OP_ANDNOT)
+	{
+		unsigned n = 0;
+
+		/* Containers of d are combined with the matching container of s and compacted */
+		for(i = 0; i < d->count; i++)
+		{
+			RoaringContainer c = d->containers[i];
+
+			while(j < s->count && s->containers[j].key < c.key)
+			{
+				j++;
+			}
+
+			if(j < s->count && s->containers[j].key == c.key)
+			{
+				ok = container_op(d, &c, &s->containers[j], op) && ok;
+			}
+			else if(op == ROARING_OP_AND)
+			{
+				c.card = 0;
+			}
+
+			if(c.card)
+			{
+				d->containers[n++] = c;
+			}
+		}
+
+		d->count = n;
+	}
+	else
+	{
+		/* Containers of s are combined into d, inserting copies of those d does not have */
+		for(j = 0; j < s->count; j++)
+		{
+			const RoaringContainer* sc = &s->containers[j];
+
+			while(i < d->count && d->containers[i].key < sc->key)
+			{
+				i++;
+			}
+
+			if(i < d->count && d->containers[i].key == sc->key)
+			{
+				ok = container_op(d, &d->containers[i], sc, op) && ok;
+
+				if(d->containers[i].card == 0)
+				{
+					roaring_erase(d, i);
+				}
+				else
+				{
+					i++;
+				}
+			}
+			else
+			{
+				RoaringContainer* c = roaring_insert(d, i, sc->key);
+
+				if(c && container_copy(d, c, sc))
+				{
+					i++;
+				}
+				else
+				{
+					if(c)
+					{
+						roaring_erase(d, i);
+					}
+
+					ok = false;
+				}
+			}
+		}
+	}
+
+	return ok;
+}
+
+
+/* container_lower ******************************************************************************//**
+ * @brief		Returns the index of the first array value not less than low. */
+static unsigned container_lower(const RoaringContainer* c, uint16_t low)
+{
+	unsigned lo = 0;
+	unsigned hi = c->count;
+
+	while(lo < hi)
+	{
+		unsigned mid = lo + (hi - lo) / 2;
+
+		if(c->array[mid] < low)
+		{
+			lo = mid + 1;
+		}
+		else
+		{
+			hi = mid;
+		}
+	}
+
+	return lo;
+}
+
+
+/* container_run ********************************************************************************//**
+ * @brief		Returns the index of the first run starting after low. The run that could contain low
+ *				is the one before it. */
+static unsigned container_run(const RoaringContainer* c, uint16_t low)
+{
+	unsigned lo = 0;
+	unsigned hi = c->count;
+
+	while(lo < hi)
+	{
+		unsigned mid = lo + (hi - lo) / 2;
+
+		if(c->runs[mid].start <= low)
+		{
+			lo = mid + 1;
+		}
+		else
+		{
+			hi = mid;
+		}
+	}
+
+	return lo;
+}
+
+
+/* container_contains ***************************************************************************//**
+ * @brief		Returns true if the container holds low. */
+static bool container_contains(const RoaringContainer* c, uint16_t low)
+{
+	unsigned idx;
+
+	switch(c->type)
+	{
+		case ROARING_ARRAY:
+			idx = container_lower(c, low);
+			return idx < c->count && c->array[idx] == low;
+
+		case ROARING_BITMAP:
+			return (c->bitmap[low / 64] >> (low % 64)) & 1;
+
+		default:
+			idx = container_run(c, low);
+			return idx > 0 && low - c->runs[idx-1].start <= c->runs[idx-1].length;
+	}
+}
+
+
+/* container_rank *******************************************************************************//**
+ * @brief		Returns the number of values in the container less than or equal to low. */
+static unsigned container_rank(const RoaringContainer* c, uint16_t low)
+{
+	unsigned rank = 0;
+	unsigned i;
+
+	switch(c->type)
+	{
+		case ROARING_ARRAY:
+			i = container_lower(c, low);
+			return i + (i < c->count && c->array[i] == low);
+
+		case ROARING_BITMAP:
+			for(i = 0; i < low / 64; i++)
+			{
+				rank += calc_popcount_u64(c->bitmap[i]);
+			}
+
+			return rank + calc_popcount_u64(c->bitmap[i] & (UINT64_MAX >> (63 - low % 64)));
+
+		default:
+			for(i = 0; i < c->count && c->runs[i].start <= low; i++)
+			{
+				rank += calc_min((unsigned)c->runs[i].length, (unsigned)(low - c->runs[i].start)) + 1;
+			}
+
+			return rank;
+	}
+}
+
+
+/* container_next *******************************************************************************//**
+ * @brief		Finds the smallest value in the container not less than low. */
+static bool container_next(const RoaringContainer* c, uint16_t low, uint16_t* next)
+{
+	unsigned idx;
+	uint64_t word;
+
+	switch(c->type)
+	{
+		case ROARING_ARRAY:
+			idx = container_lower(c, low);
+
+			if(idx < c->count)
+			{
+				*next = c->array[idx];
+				return true;
+			}
+
+			return false;
+
+		case ROARING_BITMAP:
+			idx  = low / 64;
+			word = c->bitmap[idx] & (UINT64_MAX << (low % 64));
+
+			while(word == 0 && ++idx < ROARING_BITMAP_WORDS)
+			{
+				word = c->bitmap[idx];
+			}
+
+			if(word)
+			{
+				*next = idx * 64 + calc_ctz_u64(word);
+				return true;
+			}
+
+			return false;
+
+		default:
+			idx = container_run(c, low);
+
+			if(idx > 0 && low - c->runs[idx-1].start <= c->runs[idx-1].length)
+			{
+				*next = low;
+				return true;
+			}
+			else if(idx < c->count)
+			{
+				*next = c->runs[idx].start;
+				return true;
+			}
+
+			return false;
+	}
+}
+
+
+/* container_runs *******************************************************************************//**
+ * @brief		Returns the number of runs of consecutive values in the container. */
+static unsigned container_runs(const RoaringContainer* c)
+{
+	unsigned runs = 0;
+	uint64_t prev = 0;
+	unsigned i;
+
+	switch(c->type)
+	{
+		case ROARING_ARRAY:
+			for(i = 0; i < c->count; i++)
+			{
+				runs += (i == 0 || c->array[i] != c->array[i-1] + 1);
+			}
+
+			return runs;
+
+		case ROARING_BITMAP:
+			/* Count the set bits whose lower neighbour is clear */
+			for(i = 0; i < ROARING_BITMAP_WORDS; i++)
+			{
+				runs += calc_popcount_u64(c->bitmap[i] & ~((c->bitmap[i] << 1) | prev));
+				prev  = c->bitmap[i] >> 63;
+			}
+
+			return runs;
+
+		default:
+			return c->count;
+	}
+}
+
+
+/* container_reserve ****************************************************************************//**
+ * @brief		Ensures an array or run container can hold capacity values or runs. */
+static bool container_reserve(Roaring* r, RoaringContainer* c, unsigned capacity)
+{
+	unsigned size = c->type == ROARING_RUN ? sizeof(RoaringRun) : sizeof(uint16_t);
+	void*    data;
+
+	if(capacity <= c->capacity)
+	{
+		return true;
+	}
+
+	capacity = calc_max(capacity, calc_max(2 * c->capacity, 4u));
+	data     = arena_alloc(r->arena, capacity * size);
+
+	if(!data)
+	{
+		return false;
+	}
+
+	if(c->count)
+	{
+		memcpy(data, c->array, c->count * size);
+	}
+
+	c->array    = data;
+	c->capacity = capacity;
+	return true;
+}
+
+
+/* container_copy *******************************************************************************//**
+ * @brief		Copies the contents of s into the empty container d. */
+static bool container_copy(Roaring* r, RoaringContainer* d, const RoaringContainer* s)
+{
+	d->type = s->type;
+
+	if(s->type == ROARING_BITMAP)
+	{
+		if(!(d->bitmap = arena_alloc(r->arena, 8192)))
+		{
+			return false;
+		}
+
+		memcpy(d->bitmap, s->bitmap, 8192);
+	}
+	else if(container_reserve(r, d, s->count))
+	{
+		memcpy(d->array, s->array, s->count * (s->type == ROARING_RUN ? sizeof(RoaringRun) : 2));
+		d->count = s->count;
+	}
+	else
+	{
+		return false;
+	}
+
+	d->card = s->card;
+	return true;
+}
+
+
+/* container_bitmap *****************************************************************************//**
+ * @brief		Converts an array or run container to a bitmap container. */
+static bool container_bitmap(Roaring* r, RoaringContainer* c)
+{
+	uint64_t* bitmap = arena_alloc(r->arena, 8192);
+	unsigned  i;
+
+	if(!bitmap)
+	{
+		return false;
+	}
+
+	memset(bitmap, 0, 8192);
+
+	for(i = 0; i < c->count; i++)
+	{
+		if(c->type == ROARING_ARRAY)
+		{
+			bitmap[c->array[i] / 64] |= (uint64_t)1 << (c->array[i] % 64);
+		}
+		else
+		{
+			bitmap_range(bitmap, c->runs[i].start, c->runs[i].start + c->runs[i].length,
+				ROARING_OP_OR);
+		}
+	}
+
+	c->type     = ROARING_BITMAP;
+	c->bitmap   = bitmap;
+	c->count    = 0;
+	c->capacity = 0;
+	return true;
+}
+
+
+/* container_array ******************************************************************************//**
+ * @brief		Converts a bitmap or run container holding at most ROARING_ARRAY_MAX values to an
+ *				array container. */
+static bool container_array(Roaring* r, RoaringContainer* c)
+{
+	uint16_t* array = arena_alloc(r->arena, c->card * sizeof(uint16_t));
+	unsigned  n     = 0;
+	unsigned  i, v;
+
+	if(!array)
+	{
+		return false;
+	}
+
+	if(c->type == ROARING_BITMAP)
+	{
+		for(i = 0; i < ROARING_BITMAP_WORDS; i++)
+		{
+			uint64_t word = c->bitmap[i];
+
+			for( ; word; word &= word - 1)
+			{
+				array[n++] = i * 64 + calc_ctz_u64(word);
+			}
+		}
+	}
+	else
+	{
+		for(i = 0; i < c->count; i++)
+		{
+			for(v = c->runs[i].start; v <= c->runs[i].start + c->runs[i].length; v++)
+			{
+				array[n++] = v;
+			}
+		}
+	}
+
+	c->type     = ROARING_ARRAY;
+	c->array    = array;
+	c->count    = n;
+	c->capacity = n;
+	return true;
+}
+
+
+/* container_to_runs ****************************************************************************//**
+ * @brief		Converts an array or bitmap container to a run container. */
+static bool container_to_runs(Roaring* r, RoaringContainer* c)
+{
+	unsigned    count = container_runs(c);
+	RoaringRun* runs  = arena_alloc(r->arena, count * sizeof(RoaringRun));
+	unsigned    n     = 0;
+	uint16_t    low   = 0;
+
+	if(!runs)
+	{
+		return false;
+	}
+
+	/* Walk the runs by alternating between the next value in the container and the next gap */
+	while(n < count && container_next(c, low, &low))
+	{
+		unsigned end = low;
+
+		while(end < 0xFFFF && container_contains(c, end + 1))
+		{
+			end++;
+		}
+
+		runs[n++] = (RoaringRun){ .start = low, .length = end - low };
+
+		if(end == 0xFFFF)
+		{
+			break;
+		}
+
+		low = end + 1;
+	}
+
+	c->type     = ROARING_RUN;
+	c->runs     = runs;
+	c->count    = n;
+	c->capacity = count;
+	return true;
+}
+
+
+/* container_mutable ****************************************************************************//**
+ * @brief		Converts a run container to an array or bitmap container so values can be added and
+ *				removed one at a time. */
+static bool container_mutable(Roaring* r, RoaringContainer* c)
+{
+	if(c->type != ROARING_RUN)
+	{
+		return true;
+	}
+	else if(c->card <= ROARING_ARRAY_MAX)
+	{
+		return container_array(r, c);
+	}
+	else
+	{
+		return container_bitmap(r, c);
+	}
+}
+
+
+/* container_add ********************************************************************************//**
+ * @brief		Adds low to the container. A full array container is converted to a bitmap. */
+static bool container_add(Roaring* r, RoaringContainer* c, uint16_t low)
+{
+	unsigned idx;
+
+	if(container_contains(c, low))
+	{
+		return true;
+	}
+	else if(!container_mutable(r, c))
+	{
+		return false;
+	}
+
+	if(c->type == ROARING_ARRAY && c->count < ROARING_ARRAY_MAX)
+	{
+		if(!container_reserve(r, c, c->count + 1))
+		{
+			return false;
+		}
+
+		idx = container_lower(c, low);
+		memmove(&c->array[idx+1], &c->array[idx], (c->count - idx) * sizeof(uint16_t));
+		c->array[idx] = low;
+		c->count++;
+	}
+	else if(c->type == ROARING_ARRAY && !container_bitmap(r, c))
+	{
+		return false;
+	}
+
+	if(c->type == ROARING_BITMAP)
+	{
+		c->bitmap[low / 64] |= (uint64_t)1 << (low % 64);
+	}
+
+	c->card++;
+	return true;
+}
+
+
+/* container_remove *****************************************************************************//**
+ * @brief		Removes low from the container. */
+static bool container_remove(Roaring* r, RoaringContainer* c, uint16_t low)
+{
+	unsigned idx;
+
+	if(!container_contains(c, low))
+	{
+		return true;
+	}
+	else if(!container_mutable(r, c))
+	{
+		return false;
+	}
+
+	if(c->type == ROARING_ARRAY)
+	{
+		idx = container_lower(c, low);
+		memmove(&c->array[idx], &c->array[idx+1], (c->count - idx - 1) * sizeof(uint16_t));
+		c->count--;
+	}
+	else
+	{
+		c->bitmap[low / 64] &= ~((uint64_t)1 << (low % 64));
+	}
+
+	c->card--;
+	return true;
+}
+
+
+/* container_merge ******************************************************************************//**
+ * @brief		Merges the array container s into the array container d. The merge runs from the back
+ *				so it can be done in place once d has room for both arrays. */
+static bool container_merge(Roaring* r, RoaringContainer* d, const RoaringContainer* s, RoaringOp op)
+{
+	unsigned i = d->count;
+	unsigned j = s->count;
+	unsigned k = i + j;
+	unsigned total = k;
+
+	if(!container_reserve(r, d, total))
+	{
+		return false;
+	}
+
+	while(i > 0 && j > 0)
+	{
+		if(d->array[i-1] > s->array[j-1])
+		{
+			d->array[--k] = d->array[--i];
+		}
+		else if(d->array[i-1] < s->array[j-1])
+		{
+			d->array[--k] = s->array[--j];
+		}
+		else
+		{
+			if(op == ROARING_OP_OR)
+			{
+				d->array[--k] = d->array[i-1];
+			}
+
+			i--;
+			j--;
+		}
+	}
+
+	while(j > 0)
+	{
+		d->array[--k] = s->array[--j];
+	}
+
+	while(i > 0)
+	{
+		d->array[--k] = d->array[--i];
+	}
+
+	memmove(d->array, &d->array[k], (total - k) * sizeof(uint16_t));
+	d->count = total - k;
+	d->card  = total - k;
+	return true;
+}
+
+
+/* container_op *********************************************************************************//**
+ * @brief		Combines the container s into the container d. */
+static bool container_op(Roaring* r, RoaringContainer* d, const RoaringContainer* s, RoaringOp op)
+{
+	unsigned i, n;
+
+	if(!container_mutable(r, d))
+	{
+		return false;
+	}
+
+	/* Filter an array in place */
+	if(d->type == ROARING_ARRAY && (op == ROARING_OP_AND || op == ROARING_OP_ANDNOT))
+	{
+		for(i = 0, n = 0; i < d->count; i++)
+		{
+			if(container_contains(s, d->array[i]) == (op == ROARING_OP_AND))
+			{
+				d->array[n++] = d->array[i];
+			}
+		}
+
+		d->count = n;
+		d->card  = n;
+		return true;
+	}
+
+	/* Merge two arrays whose union is small enough to remain an array */
+	if(d->type == ROARING_ARRAY && s->type == ROARING_ARRAY &&
+	   d->count + s->count <= ROARING_ARRAY_MAX)
+	{
+		return container_merge(r, d, s, op);
+	}
+
+	/* The intersection of a bitmap and an array is a subset of the array */
+	if(d->type == ROARING_BITMAP && s->type == ROARING_ARRAY && op == ROARING_OP_AND)
+	{
+		uint16_t* array = arena_alloc(r->arena, s->count * sizeof(uint16_t));
+
+		if(!array)
+		{
+			return false;
+		}
+
+		for(i = 0, n = 0; i < s->count; i++)
+		{
+			if(container_contains(d, s->array[i]))
+			{
+				array[n++] = s->array[i];
+			}
+		}
+
+		d->type     = ROARING_ARRAY;
+		d->array    = array;
+		d->count    = n;
+		d->card     = n;
+		d->capacity = s->count;
+		return true;
+	}
+
+	/* Everything else is done on a bitmap */
+	if(d->type == ROARING_ARRAY && !container_bitmap(r, d))
+	{
+		return false;
+	}
+
+	bitmap_apply(d->bitmap, s, op);
+	d->card = bitmap_card(d->bitmap);
+	return true;
+}
+
+
+/* container_size *******************************************************************************//**
+ * @brief		Returns the number of bytes the container takes in the portable format. */
+static unsigned container_size(const RoaringContainer* c)
+{
+	if(c->type == ROARING_RUN)
+	{
+		return 2 + 4 * c->count;
+	}
+	else if(c->card > ROARING_ARRAY_MAX)
+	{
+		return 8 * ROARING_BITMAP_WORDS;
+	}
+	else
+	{
+		return 2 * c->card;
+	}
+}
+
+
+/* bitmap_range *********************************************************************************//**
+ * @brief		Sets, flips or clears the bits first through last of a bitmap container. */
+static void bitmap_range(uint64_t* bitmap, unsigned first, unsigned last, RoaringOp op)
+{
+	unsigned w;
+
+	for(w = first / 64; w <= last / 64; w++)
+	{
+		uint64_t mask = UINT64_MAX;
+
+		if(w == first / 64)
+		{
+			mask &= UINT64_MAX << (first % 64);
+		}
+
+		if(w == last / 64)
+		{
+			mask &= UINT64_MAX >> (63 - last % 64);
+		}
+
+		switch(op)
+		{
+			case ROARING_OP_OR:     bitmap[w] |=  mask; break;
+			case ROARING_OP_XOR:    bitmap[w] ^=  mask; break;
+			case ROARING_OP_ANDNOT: bitmap[w] &= ~mask; break;
+			case ROARING_OP_AND:    bitmap[w] &=  mask; break;
+		}
+	}
+}
+
+
+/* bitmap_apply *********************************************************************************//**
+ * @brief		Combines the container s into a bitmap. */
+static void bitmap_apply(uint64_t* bitmap, const RoaringContainer* s, RoaringOp op)
+{
+	unsigned prev = 0;
+	unsigned i;
+
+	if(s->type == ROARING_BITMAP)
+	{
+		for(i = 0; i < ROARING_BITMAP_WORDS; i++)
+		{
+			switch(op)
+			{
+				case ROARING_OP_AND:    bitmap[i] &=  s->bitmap[i]; break;
+				case ROARING_OP_OR:     bitmap[i] |=  s->bitmap[i]; break;
+				case ROARING_OP_XOR:    bitmap[i] ^=  s->bitmap[i]; break;
+				case ROARING_OP_ANDNOT: bitmap[i] &= ~s->bitmap[i]; break;
+			}
+		}
+	}
+	else if(op == ROARING_OP_AND)
+	{
+		/* Only runs reach here. Clear the gaps between them. */
+		for(i = 0; i < s->count; i++)
+		{
+			if(s->runs[i].start > prev)
+			{
+				bitmap_range(bitmap, prev, s->runs[i].start - 1, ROARING_OP_ANDNOT);
+			}
+
+			prev = s->runs[i].start + s->runs[i].length + 1;
+		}
+
+		if(prev <= 0xFFFF)
+		{
+			bitmap_range(bitmap, prev, 0xFFFF, ROARING_OP_ANDNOT);
+		}
+	}
+	else if(s->type == ROARING_ARRAY)
+	{
+		for(i = 0; i < s->count; i++)
+		{
+			bitmap_range(bitmap, s->array[i], s->array[i], op);
+		}
+	}
+	else
+	{
+		for(i = 0; i < s->count; i++)
+		{
+			bitmap_range(bitmap, s->runs[i].start, s->runs[i].start + s->runs[i].length, op);
+		}
+	}
+}
+
+
+/* bitmap_card **********************************************************************************//**
+ * @brief		Returns the number of bits set in a bitmap container. */
+static unsigned bitmap_card(const uint64_t* bitmap)
+{
+	unsigned card = 0;
+	unsigned i;
+
+	for(i = 0; i < ROARING_BITMAP_WORDS; i++)
+	{
+		card += calc_popcount_u64(bitmap[i]);
+	}
+
+	return card;
+}
+
+
+/******************************************* END OF FILE *******************************************/
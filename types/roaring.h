@@ -0,0 +1,120 @@
+/************************************************************************************************//**
+ * @file		roaring.h
+ *
+ * @copyright	Copyright 2022 Kurt Hildebrand.
+ * @license		Licensed under the Apache License, Version 2.0 (the "License"); you may not use this
+ * 				file except in compliance with the License. You may obtain a copy of the License at
+ *
+ * 				http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * 				Unless required by applicable law or agreed to in writing, software distributed under
+ * 				the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF
+ * 				ANY KIND, either express or implied. See the License for the specific language
+ * 				governing permissions and limitations under the License.
+ *
+ * @brief		Compressed bitmap of 32-bit values. The value space is split into chunks of 65536
+ *				values keyed by the high 16 bits of the value. Each chunk holding at least one value
+ *				is stored in a container chosen by its contents:
+ *
+ *				ROARING_ARRAY   Sorted array of the low 16 bits. Holds up to ROARING_ARRAY_MAX values.
+ *				ROARING_BITMAP  Bitmap of all 65536 values in the chunk.
+ *				ROARING_RUN     Sorted array of runs of consecutive values.
+ *
+ *				Containers are allocated from an arena and are never freed individually. A container
+ *				that grows or changes type leaves its old storage in the arena until the arena is
+ *				reset. roaring_optimize converts every container to its smallest type.
+ *
+ *				roaring_serialize writes the portable Roaring format, so serialized bitmaps can be
+ *				exchanged with other Roaring implementations.
+ *
+ ***************************************************************************************************/
+#ifndef ROARING_H
+#define ROARING_H
+
+#if __STDC_VERSION__ < 199901L
+#error Compile with C99 or higher!
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/* Includes -------------------------------------------------------------------------------------- */
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "arena.h"
+#include "buffer.h"
+
+
+/* Public Macros --------------------------------------------------------------------------------- */
+#define ROARING_ARRAY_MAX		(4096)		/* Most values stored in an array container */
+#define ROARING_BITMAP_WORDS	(1024)		/* Number of 64-bit words in a bitmap container */
+
+
+/* Public Types ---------------------------------------------------------------------------------- */
+typedef enum {
+	ROARING_ARRAY,
+	ROARING_BITMAP,
+	ROARING_RUN,
+} RoaringType;
+
+
+typedef struct {
+	uint16_t start;
+	uint16_t length;		/* The run holds the values start through start + length */
+} RoaringRun;
+
+
+typedef struct {
+	uint16_t key;			/* High 16 bits of every value in the container */
+	uint16_t type;			/* RoaringType */
+	uint32_t card;			/* Number of values in the container */
+	uint32_t count;			/* Number of array values or runs in use */
+	uint32_t capacity;		/* Number of array values or runs allocated */
+	union {
+		uint16_t*   array;
+		uint64_t*   bitmap;
+		RoaringRun* runs;
+	};
+} RoaringContainer;
+
+
+typedef struct {
+	Arena*            arena;
+	RoaringContainer* containers;	/* Sorted by key */
+	unsigned          count;
+	unsigned          capacity;
+} Roaring;
+
+
+/* Public Functions ------------------------------------------------------------------------------ */
+       void     roaring_init           (Roaring*, Arena*);
+inline void     roaring_clear          (Roaring* r) { r->count = 0; }
+inline bool     roaring_empty          (const Roaring* r) { return r->count == 0; }
+       uint64_t roaring_count          (const Roaring*);
+       bool     roaring_add            (Roaring*, uint32_t);
+       bool     roaring_add_range      (Roaring*, uint32_t, uint32_t);
+       bool     roaring_remove         (Roaring*, uint32_t);
+       bool     roaring_contains       (const Roaring*, uint32_t);
+       uint64_t roaring_rank           (const Roaring*, uint32_t);
+       bool     roaring_next           (const Roaring*, uint32_t, uint32_t*);
+
+       bool     roaring_and            (Roaring*, const Roaring*);
+       bool     roaring_or             (Roaring*, const Roaring*);
+       bool     roaring_xor            (Roaring*, const Roaring*);
+       bool     roaring_andnot         (Roaring*, const Roaring*);
+       bool     roaring_optimize       (Roaring*);
+
+       unsigned roaring_serialized_size(const Roaring*);
+       bool     roaring_serialize      (const Roaring*, Buffer*);
+       bool     roaring_deserialize    (Roaring*, Buffer*);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // ROARING_H
+/******************************************* END OF FILE *******************************************/
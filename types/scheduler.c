@@ -0,0 +1,355 @@
+/************************************************************************************************//**
+ * @file		scheduler.c
+ *
+ * @copyright	Copyright 2022 Kurt Hildebrand.
+ * @license		Licensed under the Apache License, Version 2.0 (the "License"); you may not use this
+ * 				file except in compliance with the License. You may obtain a copy of the License at
+ *
+ * 				http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * 				Unless required by applicable law or agreed to in writing, software distributed under
+ * 				the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF
+ * 				ANY KIND, either express or implied. See the License for the specific language
+ * 				governing permissions and limitations under the License.
+ *
+ ***************************************************************************************************/
+#if !defined(__STDC_NO_THREADS__)
+
+#include "futex.h"
+#include "scheduler.h"
+
+
+/* Private Macros -------------------------------------------------------------------------------- */
+#define SCHEDULER_IDLE_TIMEOUT	(1000u)		/* Microseconds an idle worker sleeps between checks */
+#define SCHEDULER_WAIT_TIMEOUT	(100u)		/* Microseconds scheduler_wait sleeps between checks */
+
+
+/* Private Types --------------------------------------------------------------------------------- */
+typedef struct {
+	Scheduler* sched;
+	void     (*fn)(void*, unsigned, unsigned);
+	void*      arg;
+	unsigned   begin;
+	unsigned   end;
+	unsigned   grain;
+} SchedulerFor;
+
+
+/* Private Functions ----------------------------------------------------------------------------- */
+static void  scheduler_stop    (Scheduler*, unsigned);
+static int   scheduler_worker  (void*);
+static Task* scheduler_find    (Scheduler*, SchedulerWorker*);
+static void  scheduler_run     (Task*);
+static void  scheduler_notify  (Scheduler*);
+static void  scheduler_for     (void*);
+
+
+/* Private Variables ----------------------------------------------------------------------------- */
+static _Thread_local SchedulerWorker* scheduler_self;	/* Worker owned by the calling thread */
+
+
+/* scheduler_init *******************************************************************************//**
+ * @brief		Initializes a scheduler and starts its worker threads.
+ * @param[in]	s: the scheduler to initialize.
+ * @param[in]	count: the number of worker threads. At most SCHEDULER_MAX_WORKERS.
+ * @retval		false if count is invalid or a thread could not be started. */
+bool scheduler_init(Scheduler* s, unsigned count)
+{
+	unsigned i;
+
+	if(count == 0 || count > SCHEDULER_MAX_WORKERS)
+	{
+		return false;
+	}
+
+	s->count = count;
+	queue_init(&s->queue, s->queue_slots, SCHEDULER_QUEUE_SIZE);
+	atomic_store_explicit(&s->events,   0,     memory_order_relaxed);
+	atomic_store_explicit(&s->sleepers, 0,     memory_order_relaxed);
+	atomic_store_explicit(&s->stop,     false, memory_order_relaxed);
+
+	for(i = 0; i < count; i++)
+	{
+		SchedulerWorker* w = &s->workers[i];
+
+		deque_init(&w->deque, w->slots, SCHEDULER_DEQUE_SIZE);
+		w->sched = s;
+		w->seed  = i + 1;
+	}
+
+	/* All deques are initialized before any worker can try to steal from them */
+	for(i = 0; i < count; i++)
+	{
+		if(thrd_create(&s->workers[i].thread, scheduler_worker, &s->workers[i]) != thrd_success)
+		{
+			scheduler_stop(s, i);
+			return false;
+		}
+	}
+
+	return true;
+}
+
+
+/* scheduler_deinit *****************************************************************************//**
+ * @brief		Stops and joins the worker threads. Tasks still queued are not run. */
+void scheduler_deinit(Scheduler* s)
+{
+	scheduler_stop(s, s->count);
+}
+
+
+/* scheduler_submit *****************************************************************************//**
+ * @brief		Submits a task to run fn(arg) on some thread of the scheduler.
+ * @param[in]	s: the scheduler.
+ * @param[in]	group: the group the task belongs to. Wait for it with scheduler_wait.
+ * @param[in]	task: storage for the task. Must stay valid until the group has been waited on.
+ * @param[in]	fn: the function to run.
+ * @param[in]	arg: argument passed to fn.
+ * @note		If the task cannot be queued because the deque or queue is full, it is run
+ *				immediately on the calling thread. */
+void scheduler_submit(Scheduler* s, TaskGroup* group, Task* task, TaskFn fn, void* arg)
+{
+	task->fn    = fn;
+	task->arg   = arg;
+	task->group = group;
+
+	atomic_fetch_add_explicit(&group->pending, 1, memory_order_relaxed);
+
+	SchedulerWorker* self = scheduler_self;
+
+	if(self && self->sched == s ? deque_push(&self->deque, task) : queue_push(&s->queue, task))
+	{
+		scheduler_notify(s);
+	}
+	else
+	{
+		scheduler_run(task);
+	}
+}
+
+
+/* scheduler_wait *******************************************************************************//**
+ * @brief		Returns when every task in the group has finished. The calling thread runs queued
+ *				tasks while it waits. */
+void scheduler_wait(Scheduler* s, TaskGroup* group)
+{
+	SchedulerWorker* self = scheduler_self && scheduler_self->sched == s ? scheduler_self : 0;
+	unsigned         pending;
+
+	while((pending = atomic_load_explicit(&group->pending, memory_order_acquire)) != 0)
+	{
+		Task* task = scheduler_find(s, self);
+
+		if(task)
+		{
+			scheduler_run(task);
+		}
+		else
+		{
+			futex_wait(&group->pending, pending, futex_deadline(SCHEDULER_WAIT_TIMEOUT));
+		}
+	}
+}
+
+
+/* scheduler_parallel_for ***********************************************************************//**
+ * @brief		Calls fn(arg, i, j) over subranges [i, j) covering [begin, end). The range is split
+ *				in halves until subranges are at most grain long, and the halves are submitted as
+ *				tasks so idle workers can steal them. Returns when every subrange has been
+ *				processed.
+ * @param[in]	s: the scheduler.
+ * @param[in]	begin: the first index.
+ * @param[in]	end: one past the last index.
+ * @param[in]	grain: the largest subrange passed to fn. 0 is treated as 1.
+ * @param[in]	fn: function called for each subrange.
+ * @param[in]	arg: argument passed to fn. */
+void scheduler_parallel_for(
+	Scheduler* s, unsigned begin, unsigned end, unsigned grain,
+	void (*fn)(void*, unsigned, unsigned), void* arg)
+{
+	SchedulerFor range = {
+		.sched = s,
+		.fn    = fn,
+		.arg   = arg,
+		.begin = begin,
+		.end   = end,
+		.grain = grain ? grain : 1,
+	};
+
+	if(begin < end)
+	{
+		scheduler_for(&range);
+	}
+}
+
+
+/* scheduler_stop *******************************************************************************//**
+ * @brief		Stops the workers and joins the first count worker threads. */
+static void scheduler_stop(Scheduler* s, unsigned count)
+{
+	unsigned i;
+
+	atomic_store_explicit(&s->stop, true, memory_order_seq_cst);
+	atomic_fetch_add_explicit(&s->events, 1, memory_order_seq_cst);
+	futex_wake(&s->events, -1u);
+
+	for(i = 0; i < count; i++)
+	{
+		thrd_join(s->workers[i].thread, 0);
+	}
+}
+
+
+/* scheduler_worker *****************************************************************************//**
+ * @brief		Main loop of a worker thread. */
+static int scheduler_worker(void* arg)
+{
+	SchedulerWorker* self = arg;
+	Scheduler*       s    = self->sched;
+
+	scheduler_self = self;
+
+	while(!atomic_load_explicit(&s->stop, memory_order_acquire))
+	{
+		Task* task = scheduler_find(s, self);
+
+		if(task)
+		{
+			scheduler_run(task);
+			continue;
+		}
+
+		/* Register as a sleeper, then look once more. A submitter increments events before it
+		 * checks for sleepers, so either this search sees its task or futex_wait sees the new
+		 * events value and returns immediately. */
+		unsigned events = atomic_load_explicit(&s->events, memory_order_seq_cst);
+
+		atomic_fetch_add_explicit(&s->sleepers, 1, memory_order_seq_cst);
+
+		if((task = scheduler_find(s, self)))
+		{
+			atomic_fetch_sub_explicit(&s->sleepers, 1, memory_order_relaxed);
+			scheduler_run(task);
+			continue;
+		}
+
+		if(!atomic_load_explicit(&s->stop, memory_order_seq_cst))
+		{
+			futex_wait(&s->events, events, futex_deadline(SCHEDULER_IDLE_TIMEOUT));
+		}
+
+		atomic_fetch_sub_explicit(&s->sleepers, 1, memory_order_relaxed);
+	}
+
+	return 0;
+}
+
+
+/* scheduler_find *******************************************************************************//**
+ * @brief		Finds a task to run. Pops from the worker's own deque, then takes from the shared
+ *				queue, then steals from the other workers starting at a random victim.
+ * @param[in]	s: the scheduler.
+ * @param[in]	self: the calling worker. Null if the calling thread is not a worker. */
+static Task* scheduler_find(Scheduler* s, SchedulerWorker* self)
+{
+	Task*    task = 0;
+	unsigned start;
+	unsigned i;
+
+	if(self && (task = deque_pop(&self->deque)))
+	{
+		return task;
+	}
+
+	if(queue_get(&s->queue, &task))
+	{
+		return task;
+	}
+
+	if(self)
+	{
+		/* xorshift32 */
+		self->seed ^= self->seed << 13;
+		self->seed ^= self->seed >> 17;
+		self->seed ^= self->seed << 5;
+		start = self->seed;
+	}
+	else
+	{
+		start = 0;
+	}
+
+	for(i = 0; i < s->count; i++)
+	{
+		SchedulerWorker* victim = &s->workers[(start + i) % s->count];
+
+		if(victim != self && (task = deque_steal(&victim->deque)))
+		{
+			return task;
+		}
+	}
+
+	return 0;
+}
+
+
+/* scheduler_run ********************************************************************************//**
+ * @brief		Runs a task and wakes threads waiting on its group if it was the group's last. */
+static void scheduler_run(Task* task)
+{
+	TaskGroup* group = task->group;
+
+	task->fn(task->arg);
+
+	if(atomic_fetch_sub_explicit(&group->pending, 1, memory_order_acq_rel) == 1)
+	{
+		futex_wake(&group->pending, -1u);
+	}
+}
+
+
+/* scheduler_notify *****************************************************************************//**
+ * @brief		Wakes one sleeping worker after a task has been submitted. */
+static void scheduler_notify(Scheduler* s)
+{
+	atomic_fetch_add_explicit(&s->events, 1, memory_order_seq_cst);
+
+	if(atomic_load_explicit(&s->sleepers, memory_order_seq_cst))
+	{
+		futex_wake(&s->events, 1);
+	}
+}
+
+
+/* scheduler_for ********************************************************************************//**
+ * @brief		Task body of scheduler_parallel_for. Splits off the upper half of the range as a new
+ *				task and recurses into the lower half until the range is at most grain long. */
+static void scheduler_for(void* arg)
+{
+	SchedulerFor* range = arg;
+
+	if(range->end - range->begin <= range->grain)
+	{
+		range->fn(range->arg, range->begin, range->end);
+	}
+	else
+	{
+		TaskGroup    group = { .pending = 0 };
+		Task         task;
+		SchedulerFor upper = *range;
+		SchedulerFor lower = *range;
+		unsigned     mid   = range->begin + (range->end - range->begin) / 2;
+
+		upper.begin = mid;
+		lower.end   = mid;
+
+		scheduler_submit(range->sched, &group, &task, scheduler_for, &upper);
+		scheduler_for(&lower);
+		scheduler_wait(range->sched, &group);
+	}
+}
+
+
+#endif // !defined(__STDC_NO_THREADS__)
+/******************************************* END OF FILE *******************************************/
@@ -0,0 +1,120 @@
+/************************************************************************************************//**
+ * @file		scheduler.h
+ *
+ * @copyright	Copyright 2022 Kurt Hildebrand.
+ * @license		Licensed under the Apache License, Version 2.0 (the "License"); you may not use this
+ * 				file except in compliance with the License. You may obtain a copy of the License at
+ *
+ * 				http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * 				Unless required by applicable law or agreed to in writing, software distributed under
+ * 				the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF
+ * 				ANY KIND, either express or implied. See the License for the specific language
+ * 				governing permissions and limitations under the License.
+ *
+ * @brief		Work stealing thread pool. Each worker thread owns a Deque. Tasks submitted by a
+ *				worker are pushed onto its own deque. Tasks submitted by other threads go into a
+ *				shared Queue. An idle worker pops from its own deque first, then takes from the
+ *				shared queue, then steals from the other workers. Workers that find no work sleep
+ *				on a futex until a task is submitted.
+ *
+ *				Tasks and task groups are provided by the caller, so the scheduler never allocates.
+ *				A task must stay valid until its group has been waited on. scheduler_wait runs other
+ *				tasks while it waits, so tasks may submit and wait on nested tasks.
+ *
+ *				The scheduler requires C11 threads and is not available when the compiler defines
+ *				__STDC_NO_THREADS__.
+ *
+ ***************************************************************************************************/
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#if __STDC_VERSION__ < 201112L
+#error Compile with C11 or higher!
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/* Includes -------------------------------------------------------------------------------------- */
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <threads.h>
+
+#include "deque.h"
+#include "queue.h"
+#include "utils.h"
+
+
+/* Public Macros --------------------------------------------------------------------------------- */
+#ifndef SCHEDULER_MAX_WORKERS
+#define SCHEDULER_MAX_WORKERS	(8)		/* Maximum number of worker threads */
+#endif
+
+#ifndef SCHEDULER_DEQUE_SIZE
+#define SCHEDULER_DEQUE_SIZE	(256)	/* Capacity of each worker's deque. Must be a power of two. */
+#endif
+
+#ifndef SCHEDULER_QUEUE_SIZE
+#define SCHEDULER_QUEUE_SIZE	(256)	/* Capacity of the queue of tasks from other threads */
+#endif
+
+
+/* Public Types ---------------------------------------------------------------------------------- */
+typedef void (*TaskFn)(void*);
+
+
+typedef struct {
+	_Atomic unsigned pending;	/* Number of submitted tasks which have not finished */
+} TaskGroup;
+
+
+typedef struct {
+	TaskFn     fn;
+	void*      arg;
+	TaskGroup* group;
+} Task;
+
+
+typedef struct Scheduler Scheduler;
+
+
+typedef struct {
+	Deque          deque;
+	_Atomic(void*) slots[SCHEDULER_DEQUE_SIZE];
+	Scheduler*     sched;
+	unsigned       seed;		/* State of the random victim selection */
+	thrd_t         thread;
+} SchedulerWorker;
+
+
+struct Scheduler {
+	SchedulerWorker workers[SCHEDULER_MAX_WORKERS];
+	unsigned        count;
+	Queue           queue;
+	QueueSlot       queue_slots[SCHEDULER_QUEUE_SIZE];
+
+	_Alignas(CACHE_LINE_SIZE)
+	_Atomic unsigned events;	/* Incremented whenever work is submitted. Idle workers wait on it. */
+	_Atomic unsigned sleepers;	/* Number of workers waiting on events */
+	_Atomic bool     stop;
+};
+
+
+/* Public Functions ------------------------------------------------------------------------------ */
+bool scheduler_init        (Scheduler*, unsigned);
+void scheduler_deinit      (Scheduler*);
+void scheduler_submit      (Scheduler*, TaskGroup*, Task*, TaskFn, void*);
+void scheduler_wait        (Scheduler*, TaskGroup*);
+void scheduler_parallel_for(Scheduler*, unsigned, unsigned, unsigned,
+                            void (*)(void*, unsigned, unsigned), void*);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SCHEDULER_H
+/******************************************* END OF FILE *******************************************/
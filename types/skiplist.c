@@ -0,0 +1,218 @@
+/************************************************************************************************//**
+ * @file		skiplist.c
+ *
+ * @copyright	Copyright 2022 Kurt Hildebrand.
+ * @license		Licensed under the Apache License, Version 2.0 (the "License"); you may not use this
+ * 				file except in compliance with the License. You may obtain a copy of the License at
+ *
+ * 				http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * 				Unless required by applicable law or agreed to in writing, software distributed under
+ * 				the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF
+ * 				ANY KIND, either express or implied. See the License for the specific language
+ * 				governing permissions and limitations under the License.
+ *
+ ***************************************************************************************************/
+#include "calc.h"
+#include "skiplist.h"
+
+
+/* Inline Function Instances --------------------------------------------------------------------- */
+extern void      skiplist_node_init(SkipLink*);
+extern unsigned  skiplist_count    (const SkipList*);
+extern SkipLink* skiplist_first    (const SkipList*);
+extern SkipLink* skiplist_next     (const SkipLink*);
+extern bool      skiplist_empty    (const SkipList*);
+
+
+/* Private Functions ----------------------------------------------------------------------------- */
+static unsigned  skiplist_height(SkipList*);
+static SkipLink* skiplist_search(const SkipList*, const void*, ICompare, bool, SkipLink**);
+
+
+/* skiplist_init ********************************************************************************//**
+ * @brief		Initializes an empty skip list.
+ * @param[in]	l: the skip list to initialize.
+ * @param[in]	compare: callback which compares two nodes. Receives SkipLink pointers. */
+void skiplist_init(SkipList* l, ICompare compare)
+{
+	unsigned i;
+
+	for(i = 0; i < SKIPLIST_LEVELS; i++)
+	{
+		atomic_init(&l->head.next[i], 0);
+	}
+
+	l->head.height = SKIPLIST_LEVELS;
+	l->count       = 0;
+	l->seed        = 0x9E3779B9u;
+	l->compare     = compare;
+}
+
+
+/* skiplist_insert ******************************************************************************//**
+ * @brief		Inserts a node in order. A node equal to existing nodes is inserted after them. The
+ *				node's tower is filled in before it is linked so readers never see a partial node.
+ * @return		The inserted node. */
+SkipLink* skiplist_insert(SkipList* l, SkipLink* node)
+{
+	SkipLink* preds[SKIPLIST_LEVELS];
+	unsigned  i;
+
+	if(!node)
+	{
+		return 0;
+	}
+
+	skiplist_search(l, node, l->compare, true, preds);
+	node->height = skiplist_height(l);
+
+	for(i = 0; i < node->height; i++)
+	{
+		atomic_store_explicit(&node->next[i],
+			atomic_load_explicit(&preds[i]->next[i], memory_order_relaxed), memory_order_relaxed);
+	}
+
+	/* Link from the bottom up. Once the node is reachable at level 0 it is in the list. */
+	for(i = 0; i < node->height; i++)
+	{
+		atomic_store_explicit(&preds[i]->next[i], node, memory_order_release);
+	}
+
+	l->count++;
+	return node;
+}
+
+
+/* skiplist_find ********************************************************************************//**
+ * @brief		Searches the list for a key.
+ * @param[in]	l: the skip list to search.
+ * @param[in]	key: the key to search for.
+ * @param[in]	comp: callback which compares the key with a node. If null, the list's comparison
+ *				callback is used and key must be a SkipLink pointer.
+ * @return		The first node equal to the key. Null if there is none. */
+SkipLink* skiplist_find(const SkipList* l, const void* key, ICompare comp)
+{
+	SkipLink* node;
+
+	comp = comp ? comp : l->compare;
+	node = skiplist_search(l, key, comp, false, 0);
+
+	return (node && comp(key, node) == 0) ? node : 0;
+}
+
+
+/* skiplist_lower_bound *************************************************************************//**
+ * @brief		Returns the first node not less than the key. Iterate from it with skiplist_next to
+ *				visit a range of keys. Null if every node is less than the key. See skiplist_find. */
+SkipLink* skiplist_lower_bound(const SkipList* l, const void* key, ICompare comp)
+{
+	return skiplist_search(l, key, comp ? comp : l->compare, false, 0);
+}
+
+
+/* skiplist_remove ******************************************************************************//**
+ * @brief		Removes a node from the list. The node is unlinked from the top down and keeps its
+ *				forward pointers, so readers standing on it can continue.
+ * @return		The removed node. Null if the node is not in the list. */
+SkipLink* skiplist_remove(SkipList* l, SkipLink* node)
+{
+	SkipLink* preds[SKIPLIST_LEVELS];
+	SkipLink* pred = &l->head;
+	int       level;
+
+	if(!node || node->height == 0 || node->height > SKIPLIST_LEVELS)
+	{
+		return 0;
+	}
+
+	for(level = SKIPLIST_LEVELS - 1; level >= 0; level--)
+	{
+		SkipLink* next = atomic_load_explicit(&pred->next[level], memory_order_relaxed);
+
+		/* Above the node's tower, stop before anything equal to the node since equal nodes may
+		 * follow it. Within the tower, step over equal nodes until the node itself is reached. */
+		while(next && next != node &&
+		      l->compare(node, next) >= ((unsigned)level < node->height ? 0 : 1))
+		{
+			pred = next;
+			next = atomic_load_explicit(&pred->next[level], memory_order_relaxed);
+		}
+
+		if((unsigned)level < node->height && next != node)
+		{
+			return 0;
+		}
+
+		preds[level] = pred;
+	}
+
+	for(level = node->height - 1; level >= 0; level--)
+	{
+		atomic_store_explicit(&preds[level]->next[level],
+			atomic_load_explicit(&node->next[level], memory_order_relaxed), memory_order_release);
+	}
+
+	node->height = 0;
+	l->count--;
+	return node;
+}
+
+
+/* skiplist_pop_front ***************************************************************************//**
+ * @brief		Removes the smallest node. Null if the list is empty. */
+SkipLink* skiplist_pop_front(SkipList* l)
+{
+	return skiplist_remove(l, skiplist_first(l));
+}
+
+
+/* skiplist_height ******************************************************************************//**
+ * @brief		Draws a tower height. Each additional level has a probability of 1/4. */
+static unsigned skiplist_height(SkipList* l)
+{
+	uint32_t x = l->seed;
+
+	/* xorshift32 */
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	l->seed = x;
+
+	return 1 + calc_ctz_u32(x | ((uint32_t)1 << (2 * (SKIPLIST_LEVELS - 1)))) / 2;
+}
+
+
+/* skiplist_search ******************************************************************************//**
+ * @brief		Finds the last node at each level that is less than the key, or not greater than the
+ *				key if after is true.
+ * @param[out]	preds: receives the node found at each level. May be null.
+ * @return		The node following the one found at level 0. */
+static SkipLink* skiplist_search(
+	const SkipList* l, const void* key, ICompare comp, bool after, SkipLink** preds)
+{
+	SkipLink* pred = (SkipLink*)&l->head;
+	SkipLink* next = 0;
+	int       level;
+
+	for(level = SKIPLIST_LEVELS - 1; level >= 0; level--)
+	{
+		next = atomic_load_explicit(&pred->next[level], memory_order_acquire);
+
+		while(next && comp(key, next) >= (after ? 0 : 1))
+		{
+			pred = next;
+			next = atomic_load_explicit(&pred->next[level], memory_order_acquire);
+		}
+
+		if(preds)
+		{
+			preds[level] = pred;
+		}
+	}
+
+	return next;
+}
+
+
+/******************************************* END OF FILE *******************************************/
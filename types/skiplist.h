@@ -0,0 +1,111 @@
+/************************************************************************************************//**
+ * @file		skiplist.h
+ *
+ * @copyright	Copyright 2022 Kurt Hildebrand.
+ * @license		Licensed under the Apache License, Version 2.0 (the "License"); you may not use this
+ * 				file except in compliance with the License. You may obtain a copy of the License at
+ *
+ * 				http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * 				Unless required by applicable law or agreed to in writing, software distributed under
+ * 				the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF
+ * 				ANY KIND, either express or implied. See the License for the specific language
+ * 				governing permissions and limitations under the License.
+ *
+ * @brief		Ordered intrusive skip list. Each node embeds a SkipLink tower of forward pointers.
+ *				Nodes get a random height so that each level holds about a quarter of the nodes of
+ *				the level below, giving O(log n) insert, find and remove without allocating.
+ *
+ *				One writer may modify the list while any number of readers search and iterate it.
+ *				Writers must be serialized by the caller. Pointers are published with release stores
+ *				and read with acquire loads, so a reader sees either the old or the new list. A
+ *				removed node keeps its forward pointers so a reader standing on it can continue, but
+ *				its memory must not be reused until no reader can still hold it.
+ *
+ ***************************************************************************************************/
+#ifndef SKIPLIST_H
+#define SKIPLIST_H
+
+#if __STDC_VERSION__ < 199901L
+#error Compile with C99 or higher!
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/* Includes -------------------------------------------------------------------------------------- */
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "compare.h"
+#include "utils.h"
+
+
+/* Public Macros --------------------------------------------------------------------------------- */
+/* SKIPLIST_LEVELS ******************************************************************************//**
+ * @brief		Height of the tallest tower. Lists stay O(log n) up to about 4^SKIPLIST_LEVELS nodes.
+ *				Targets with small lists may define a smaller value to save memory in every node. At
+ *				most 16. */
+#if !defined(SKIPLIST_LEVELS)
+#define SKIPLIST_LEVELS 8
+#endif
+
+/* Returns the structure containing a link, or null if the link is null. Evaluates link twice. */
+#define SKIPLIST_CONTAINER(link, type, field) \
+	((link) != 0 ? CONTAINER_OF(link, type, field) : 0)
+
+
+/* Public Types ---------------------------------------------------------------------------------- */
+typedef struct SkipLink {
+	_Atomic(struct SkipLink*) next[SKIPLIST_LEVELS];
+	unsigned height;
+} SkipLink;
+
+
+typedef struct {
+	SkipLink head;				/* Sentinel tower of full height that precedes every node */
+	unsigned count;
+	uint32_t seed;				/* State of the generator that draws tower heights */
+	ICompare compare;			/* Compares two SkipLink pointers */
+} SkipList;
+
+
+/* Public Functions ------------------------------------------------------------------------------ */
+       void      skiplist_init       (SkipList*, ICompare);
+inline void      skiplist_node_init  (SkipLink* n) { n->height = 0; }
+inline unsigned  skiplist_count      (const SkipList* l) { return l->count; }
+inline SkipLink* skiplist_first      (const SkipList*);
+inline SkipLink* skiplist_next       (const SkipLink*);
+inline bool      skiplist_empty      (const SkipList* l) { return skiplist_first(l) == 0; }
+       SkipLink* skiplist_insert     (SkipList*, SkipLink*);
+       SkipLink* skiplist_find       (const SkipList*, const void*, ICompare);
+       SkipLink* skiplist_lower_bound(const SkipList*, const void*, ICompare);
+       SkipLink* skiplist_remove     (SkipList*, SkipLink*);
+       SkipLink* skiplist_pop_front  (SkipList*);
+
+
+/* skiplist_first *******************************************************************************//**
+ * @brief		Returns the smallest node. Null if the list is empty. */
+inline SkipLink* skiplist_first(const SkipList* l)
+{
+	return atomic_load_explicit(&l->head.next[0], memory_order_acquire);
+}
+
+
+/* skiplist_next ********************************************************************************//**
+ * @brief		Returns the node after n. Null if n is the last node. */
+inline SkipLink* skiplist_next(const SkipLink* n)
+{
+	return n ? atomic_load_explicit(&n->next[0], memory_order_acquire) : 0;
+}
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SKIPLIST_H
+/******************************************* END OF FILE *******************************************/
@@ -0,0 +1,158 @@
+/************************************************************************************************//**
+ * @file		slotmap.c
+ *
+ * @copyright	Copyright 2022 Kurt Hildebrand.
+ * @license		Licensed under the Apache License, Version 2.0 (the "License"); you may not use this
+ * 				file except in compliance with the License. You may obtain a copy of the License at
+ *
+ * 				http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * 				Unless required by applicable law or agreed to in writing, software distributed under
+ * 				the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF
+ * 				ANY KIND, either express or implied. See the License for the specific language
+ * 				governing permissions and limitations under the License.
+ *
+ ***************************************************************************************************/
+#include <string.h>
+
+#include "slotmap.h"
+
+
+/* Inline Function Instances --------------------------------------------------------------------- */
+extern unsigned   slotmap_size     (const SlotMap*);
+extern unsigned   slotmap_count    (const SlotMap*);
+extern bool       slotmap_empty    (const SlotMap*);
+extern bool       slotmap_full     (const SlotMap*);
+extern void*      slotmap_get      (const SlotMap*, SlotHandle);
+extern bool       slotmap_contains (const SlotMap*, SlotHandle);
+extern void*      slotmap_at       (const SlotMap*, unsigned);
+extern SlotHandle slotmap_handle_at(const SlotMap*, unsigned);
+extern Range      slotmap_values   (const SlotMap*);
+
+
+/* slotmap_init *********************************************************************************//**
+ * @brief		Initializes an empty slot map.
+ * @param[in]	m: the slot map to initialize.
+ * @param[in]	values: array of size values.
+ * @param[in]	size: the maximum number of values. At most SLOTMAP_MAX_SIZE.
+ * @param[in]	elemsize: the size in bytes of one value.
+ * @param[in]	slots: array of size slots.
+ * @param[in]	bitmap: POOL_BITMAP_WORDS(size) words for the slot pool. May be null if size is at
+ *				most 64. */
+bool slotmap_init(
+	SlotMap* m, void* values, unsigned size, unsigned elemsize, SlotMapSlot* slots,
+	_Atomic uint64_t* bitmap)
+{
+	unsigned i;
+	Range    r = make_range(slots, size, sizeof(SlotMapSlot));
+
+	if(!values || !slots || size > SLOTMAP_MAX_SIZE)
+	{
+		return false;
+	}
+
+	if(!(bitmap ? pool_init_bitmap(&m->pool, r, bitmap) : pool_init_range(&m->pool, r)))
+	{
+		return false;
+	}
+
+	for(i = 0; i < size; i++)
+	{
+		slots[i].gen   = 1;
+		slots[i].dense = 0;
+		slots[i].owner = 0;
+	}
+
+	m->slots  = slots;
+	m->values = make_range(values, size, elemsize);
+	m->count  = 0;
+	return true;
+}
+
+
+/* slotmap_clear ********************************************************************************//**
+ * @brief		Removes every value. Outstanding handles become stale. */
+void slotmap_clear(SlotMap* m)
+{
+	while(m->count)
+	{
+		slotmap_remove(m, slotmap_handle_at(m, m->count - 1));
+	}
+}
+
+
+/* slotmap_insert *******************************************************************************//**
+ * @brief		Inserts a value.
+ * @param[in]	m: the slot map.
+ * @param[in]	value: the value to copy into the map. May be null to leave the value uninitialized.
+ * @param[out]	h: the handle of the new value.
+ * @return		Pointer to the value in the map. Null if the map is full. */
+void* slotmap_insert(SlotMap* m, const void* value, SlotHandle* h)
+{
+	SlotMapSlot* slot = pool_reserve(&m->pool);
+
+	if(!slot)
+	{
+		return 0;
+	}
+
+	uint32_t idx   = slot - m->slots;
+	uint32_t dense = m->count++;
+	void*    ptr   = range_offset(&m->values, dense);
+
+	slot->dense = dense;
+	m->slots[dense].owner = idx;
+
+	if(value)
+	{
+		memmove(ptr, value, range_elemsize(&m->values));
+	}
+
+	*h = (slot->gen << SLOTMAP_INDEX_BITS) | idx;
+	return ptr;
+}
+
+
+/* slotmap_remove *******************************************************************************//**
+ * @brief		Removes the value referenced by a handle. The last value in the dense array is moved
+ *				into the removed value's position.
+ * @retval		false if the handle is stale or invalid. */
+bool slotmap_remove(SlotMap* m, SlotHandle h)
+{
+	if(!slotmap_get(m, h))
+	{
+		return false;
+	}
+
+	uint32_t     idx  = h & SLOTMAP_INDEX_MASK;
+	SlotMapSlot* slot = &m->slots[idx];
+	uint32_t     hole = slot->dense;
+	uint32_t     last = --m->count;
+
+	if(hole != last)
+	{
+		uint32_t moved = m->slots[last].owner;
+
+		memmove(range_offset(&m->values, hole),
+		        range_offset(&m->values, last),
+		        range_elemsize(&m->values));
+
+		m->slots[hole].owner  = moved;
+		m->slots[moved].dense = hole;
+	}
+
+	/* Bump the generation so outstanding handles to this slot become stale. Generation 0 is
+	 * skipped so that SLOTMAP_NULL is never a valid handle. */
+	slot->gen = (slot->gen + 1) & SLOTMAP_GEN_MASK;
+
+	if(slot->gen == 0)
+	{
+		slot->gen = 1;
+	}
+
+	pool_release(&m->pool, slot);
+	return true;
+}
+
+
+/******************************************* END OF FILE *******************************************/
@@ -0,0 +1,149 @@
+/************************************************************************************************//**
+ * @file		slotmap.h
+ *
+ * @copyright	Copyright 2022 Kurt Hildebrand.
+ * @license		Licensed under the Apache License, Version 2.0 (the "License"); you may not use this
+ * 				file except in compliance with the License. You may obtain a copy of the License at
+ *
+ * 				http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * 				Unless required by applicable law or agreed to in writing, software distributed under
+ * 				the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF
+ * 				ANY KIND, either express or implied. See the License for the specific language
+ * 				governing permissions and limitations under the License.
+ *
+ * @brief		Fixed size table of values referenced by generational handles. A handle packs a slot
+ *				index and the slot's generation into 32 bits. Removing a value bumps the slot's
+ *				generation so stale handles no longer resolve, even after the slot is reused.
+ *
+ *				Values are stored densely at the front of the values array, so iterating over live
+ *				values is a linear scan. Slots are allocated from a Pool. Each slot records where
+ *				its value lives in the dense array, and each dense position records its slot. When a
+ *				value is removed, the last value is moved into the hole.
+ *
+ * @warning		Pointers to values are invalidated by slotmap_remove. Store handles instead.
+ *
+ ***************************************************************************************************/
+#ifndef SLOTMAP_H
+#define SLOTMAP_H
+
+#if __STDC_VERSION__ < 199901L
+#error Compile with C99 or higher!
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/* Includes -------------------------------------------------------------------------------------- */
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "pool.h"
+#include "range.h"
+
+
+/* Public Macros --------------------------------------------------------------------------------- */
+#define SLOTMAP_INDEX_BITS		(20u)
+#define SLOTMAP_INDEX_MASK		((1u << SLOTMAP_INDEX_BITS) - 1)
+#define SLOTMAP_GEN_MASK		((1u << (32 - SLOTMAP_INDEX_BITS)) - 1)
+#define SLOTMAP_MAX_SIZE		(SLOTMAP_INDEX_MASK + 1)
+#define SLOTMAP_NULL			(0u)	/* Never returned as a valid handle */
+
+
+/* Public Types ---------------------------------------------------------------------------------- */
+typedef uint32_t SlotHandle;
+
+
+typedef struct {
+	uint32_t gen;		/* Generation of the slot, never 0 */
+	uint32_t dense;		/* Position of the slot's value in the dense array */
+	uint32_t owner;		/* Slot owning the value at this position in the dense array */
+} SlotMapSlot;
+
+
+typedef struct {
+	Pool         pool;		/* Allocates slots */
+	SlotMapSlot* slots;
+	Range        values;	/* Dense array of live values */
+	unsigned     count;
+} SlotMap;
+
+
+/* Public Functions ------------------------------------------------------------------------------ */
+       bool       slotmap_init     (SlotMap*, void*, unsigned, unsigned, SlotMapSlot*, _Atomic uint64_t*);
+       void       slotmap_clear    (SlotMap*);
+inline unsigned   slotmap_size     (const SlotMap* m) { return pool_size(&m->pool); }
+inline unsigned   slotmap_count    (const SlotMap* m) { return m->count;            }
+inline bool       slotmap_empty    (const SlotMap* m) { return m->count == 0;       }
+inline bool       slotmap_full     (const SlotMap* m) { return m->count == slotmap_size(m); }
+       void*      slotmap_insert   (SlotMap*, const void*, SlotHandle*);
+       bool       slotmap_remove   (SlotMap*, SlotHandle);
+inline void*      slotmap_get      (const SlotMap*, SlotHandle);
+inline bool       slotmap_contains (const SlotMap* m, SlotHandle h) { return slotmap_get(m, h) != 0; }
+inline void*      slotmap_at       (const SlotMap*, unsigned);
+inline SlotHandle slotmap_handle_at(const SlotMap*, unsigned);
+inline Range      slotmap_values   (const SlotMap*);
+
+
+/* slotmap_get **********************************************************************************//**
+ * @brief		Returns a pointer to the value referenced by a handle. Null if the handle is stale
+ *				or invalid. */
+inline void* slotmap_get(const SlotMap* m, SlotHandle h)
+{
+	unsigned idx = h & SLOTMAP_INDEX_MASK;
+
+	if(idx < slotmap_size(m) && m->slots[idx].gen == (h >> SLOTMAP_INDEX_BITS) &&
+	   pool_idx_is_reserved(&m->pool, idx))
+	{
+		return range_offset(&m->values, m->slots[idx].dense);
+	}
+	else
+	{
+		return 0;
+	}
+}
+
+
+/* slotmap_at ***********************************************************************************//**
+ * @brief		Returns a pointer to the i'th live value. Values are in no particular order. Null if
+ *				i is not less than slotmap_count. */
+inline void* slotmap_at(const SlotMap* m, unsigned i)
+{
+	return i < m->count ? range_offset(&m->values, i) : 0;
+}
+
+
+/* slotmap_handle_at ****************************************************************************//**
+ * @brief		Returns the handle of the i'th live value. SLOTMAP_NULL if i is not less than
+ *				slotmap_count. */
+inline SlotHandle slotmap_handle_at(const SlotMap* m, unsigned i)
+{
+	if(i < m->count)
+	{
+		uint32_t idx = m->slots[i].owner;
+
+		return (m->slots[idx].gen << SLOTMAP_INDEX_BITS) | idx;
+	}
+	else
+	{
+		return SLOTMAP_NULL;
+	}
+}
+
+
+/* slotmap_values *******************************************************************************//**
+ * @brief		Returns a range over the live values. */
+inline Range slotmap_values(const SlotMap* m)
+{
+	return make_range_slice(&m->values, 0, m->count);
+}
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SLOTMAP_H
+/******************************************* END OF FILE *******************************************/
@@ -41,6 +41,15 @@ extern "C" {
 #endif
 
 
+/* CACHE_LINE_SIZE ******************************************************************************//**
+ * @brief		Size in bytes of a cache line. Members written concurrently by different threads are
+ *				aligned to this size so that they do not share a cache line. Targets without a data
+ *				cache may define a smaller value to save memory. */
+#if !defined(CACHE_LINE_SIZE)
+#define CACHE_LINE_SIZE 64
+#endif
+
+
 /* APPEND_NARGS *********************************************************************************//**
  * @brief		Concatenates a string with the number of arguments passed to the variadic macro. The
  *				format is base ## N or baseN where N is the number of arguments. Example: